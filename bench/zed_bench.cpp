@@ -0,0 +1,623 @@
+//
+// zed_bench.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_calibration_data.h"
+#include "zed_color_conversion.h"
+#include "zed_frame_queue.h"
+#include "zed_stereo_rectifier.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace zed;
+
+//
+// Microbenchmarks of the capture hot paths on synthetic YUV 4:2:2 frames, without a camera
+//
+// Every benchmark runs once per resolution and is reported once, with the share of the frame period its p99 latency
+// takes up at each of the resolution's frame rates. `--format csv` or `--format json` output can be diffed across commits
+//
+
+//
+// Parameters
+//
+#define kDefaultIterationCount 50
+#define kWarmupIterationCount 3
+#define kQueueCapacity 4
+
+struct BenchmarkOptions {
+    size_t iterationCount = kDefaultIterationCount;
+    size_t threadCount = 1;
+    string filter;
+    vector<Resolution> resolutions = {HD2K, HD1080, HD720, VGA};
+    string format = "table";
+};
+
+struct BenchmarkResult {
+    string name;
+    Resolution resolution;
+    uint64_t bytes; // Input bytes processed per iteration
+    uint64_t units; // Units processed per iteration (stereo pixels, or 1 for benchmarks timed per parse or per frame)
+    string unit;    // "px", "parse", or "frame"
+    vector<uint64_t> samples;
+
+    uint64_t percentile(double fraction) const {
+        return samples[min(samples.size() - 1, size_t(fraction * samples.size()))];
+    }
+
+    double mean() const {
+        double sum = 0;
+
+        for (uint64_t sample : samples) {
+            sum += sample;
+        }
+
+        return sum / samples.size();
+    }
+};
+
+#pragma mark - Helpers
+
+static vector<FrameRate> frameRatesFor(Resolution resolution) {
+    switch (resolution) {
+        case HD2K:
+            return {FPS_15};
+        case HD1080:
+            return {FPS_15, FPS_30};
+        case HD720:
+            return {FPS_15, FPS_30, FPS_60};
+        case VGA:
+            return {FPS_15, FPS_30, FPS_60, FPS_100};
+    }
+}
+
+// Side-by-side YUV 4:2:2 frame with a diagonal ramp in luma and slowly varying chroma
+static vector<uint8_t> syntheticFrame(StereoDimensions stereoDimensions) {
+    vector<uint8_t> frame(size_t(stereoDimensions.width) * stereoDimensions.height * 2);
+
+    for (size_t row = 0; row < size_t(stereoDimensions.height); row++) {
+        uint8_t* data = frame.data() + row * stereoDimensions.width * 2;
+
+        for (size_t column = 0; column < size_t(stereoDimensions.width); column += 2) {
+            data[column * 2] = uint8_t(row + column);
+            data[column * 2 + 1] = uint8_t(128 + (row >> 2));
+            data[column * 2 + 2] = uint8_t(row + column + 1);
+            data[column * 2 + 3] = uint8_t(128 - (column >> 3));
+        }
+    }
+
+    return frame;
+}
+
+// Calibration file contents with every resolution, in the format downloaded from Stereolabs
+static string syntheticCalibration() {
+    string contents;
+
+    for (int resolution = HD2K; resolution <= VGA; resolution++) {
+        StereoDimensions stereoDimensions = StereoDimensions(Resolution(resolution));
+        double scale = stereoDimensions.height / 376.0;
+        string suffix = array<string, 4>{"2K", "FHD", "HD", "VGA"}[resolution];
+
+        for (const char* camera : {"LEFT", "RIGHT"}) {
+            contents += format("[{}_CAM_{}]\n", camera, suffix);
+            contents += format("fx={}\nfy={}\n", 348.5 * scale, 348.4 * scale);
+            contents += format("cx={}\ncy={}\n", stereoDimensions.width / 4.0 + 1.5, stereoDimensions.height / 2.0 - 1.25);
+            contents += "k1=-0.171\nk2=0.0262\np1=0.0003\np2=-0.0002\nk3=0.0001\n\n";
+        }
+    }
+
+    contents += "[STEREO]\nBaseline=119.9\nTY=0.3\nTZ=-0.5\n";
+
+    for (const char* suffix : {"2K", "FHD", "HD", "VGA"}) {
+        contents += format("CV_{}=0.004\nRX_{}=0.002\nRZ_{}=-0.0015\n", suffix, suffix, suffix);
+    }
+
+    contents += "\n[MISC]\nSensor_ID=0\n";
+
+    return contents;
+}
+
+static bool isSelected(const BenchmarkOptions& options, const string& name) {
+    return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+static BenchmarkResult measure(const BenchmarkOptions& options,
+    const string& name,
+    Resolution resolution,
+    uint64_t bytes,
+    uint64_t units,
+    const string& unit,
+    const function<void()>& body) {
+
+    BenchmarkResult result = {name, resolution, bytes, units, unit, {}};
+    result.samples.reserve(options.iterationCount);
+
+    for (size_t i = 0; i < kWarmupIterationCount; i++) {
+        body();
+    }
+
+    for (size_t i = 0; i < options.iterationCount; i++) {
+        uint64_t start = steadyClockTimestamp();
+        body();
+        result.samples.push_back(steadyClockTimestamp() - start);
+    }
+
+    sort(result.samples.begin(), result.samples.end());
+
+    return result;
+}
+
+#pragma mark - Benchmarks
+
+static void benchmarkColorConversion(const BenchmarkOptions& options, Resolution resolution, const vector<uint8_t>& source, vector<BenchmarkResult>& results) {
+    StereoDimensions stereoDimensions = StereoDimensions(resolution);
+    size_t height = stereoDimensions.height;
+    size_t width = stereoDimensions.width;
+    size_t sourceRowBytes = width * 2;
+
+    // Every converter output: color space, frame layout, pyramid levels
+    struct ConversionPath {
+        ColorSpace colorSpace;
+        FrameLayout frameLayout;
+        size_t pyramidLevelCount;
+    };
+
+    const ConversionPath paths[] = {
+        {GREYSCALE, SIDE_BY_SIDE, 1},
+        {RGB, SIDE_BY_SIDE, 1},
+        {BGR, SIDE_BY_SIDE, 1},
+        {GREYSCALE, SEPARATE_EYES, 1},
+        {RGB, SEPARATE_EYES, 1},
+        {BGR, SEPARATE_EYES, 1},
+        {YUV, PLANAR, 1},
+        {GREYSCALE, SEPARATE_EYES, kMaxPyramidLevelCount},
+    };
+
+    for (InstructionSet instructionSet : {SCALAR, SSE4, AVX2, NEON}) {
+        if (!ColorConverter::isSupported(instructionSet)) {
+            continue;
+        }
+
+        ColorConverter colorConverter(options.threadCount, instructionSet);
+
+        for (const ConversionPath& path : paths) {
+            string name = format("convert/{}/{}/{}", colorSpaceToString(path.colorSpace), frameLayoutToString(path.frameLayout), instructionSetToString(instructionSet));
+
+            if (path.pyramidLevelCount > 1) {
+                name += format("/pyramid{}", path.pyramidLevelCount);
+            }
+
+            if (!isSelected(options, name)) {
+                continue;
+            }
+
+            size_t channels = path.colorSpace == YUV ? 2 : (path.colorSpace == GREYSCALE ? 1 : 3);
+            shared_ptr<FramePool> framePool = FramePool::create(1, height, width, channels, path.frameLayout, path.pyramidLevelCount);
+            Frame frame = framePool->acquire();
+
+            results.push_back(measure(options, name, resolution, source.size(), height * width, "px", [&] {
+                colorConverter.convert(source.data(), sourceRowBytes, frame, path.colorSpace);
+            }));
+        }
+    }
+}
+
+static void benchmarkRectification(const BenchmarkOptions& options, Resolution resolution, const vector<uint8_t>& source, vector<BenchmarkResult>& results) {
+    StereoDimensions stereoDimensions = StereoDimensions(resolution);
+    size_t height = stereoDimensions.height;
+    size_t width = stereoDimensions.width;
+
+    CalibrationData calibrationData;
+    calibrationData.parse(syntheticCalibration());
+
+    if (isSelected(options, "rectify/maps")) {
+        results.push_back(measure(options, "rectify/maps", resolution, 0, height * width, "px", [&] {
+            StereoRectifier stereoRectifier(calibrationData, stereoDimensions, options.threadCount);
+        }));
+    }
+
+    StereoRectifier stereoRectifier(calibrationData, stereoDimensions, options.threadCount);
+    vector<uint8_t> destination(height * width * 3);
+
+    // Remapping already converted frames
+    for (size_t channels : {1, 3}) {
+        string name = format("rectify/remap/{}", channels == 1 ? "Greyscale" : "RGB");
+
+        if (!isSelected(options, name)) {
+            continue;
+        }
+
+        vector<uint8_t> converted(height * width * channels, 128);
+
+        results.push_back(measure(options, name, resolution, converted.size(), height * width, "px", [&] {
+            stereoRectifier.rectify(converted.data(), destination.data(), channels);
+        }));
+    }
+
+    // Converting the whole frame, then remapping it, the baseline for the tiled path below
+    ColorConverter colorConverter(options.threadCount);
+
+    for (ColorSpace colorSpace : {GREYSCALE, RGB, BGR}) {
+        string name = format("rectify/two-pass/{}", colorSpaceToString(colorSpace));
+
+        if (!isSelected(options, name)) {
+            continue;
+        }
+
+        size_t channels = colorSpace == GREYSCALE ? 1 : 3;
+        vector<uint8_t> converted(height * width * channels);
+
+        results.push_back(measure(options, name, resolution, source.size(), height * width, "px", [&] {
+            colorConverter.convert(source.data(), width * 2, converted.data(), width * channels, height, width, colorSpace);
+            stereoRectifier.rectify(converted.data(), destination.data(), channels);
+        }));
+    }
+
+    // Decoding only the source pixels each tile samples while remapping
+    for (ColorSpace colorSpace : {GREYSCALE, RGB, BGR}) {
+        string name = format("rectify/yuv/{}", colorSpaceToString(colorSpace));
+
+        if (!isSelected(options, name)) {
+            continue;
+        }
+
+        size_t channels = colorSpace == GREYSCALE ? 1 : 3;
+
+        results.push_back(measure(options, name, resolution, source.size(), height * width, "px", [&] {
+            stereoRectifier.rectifyYUV(source.data(), width * 2, destination.data(), width * channels, colorSpace);
+        }));
+    }
+}
+
+static void benchmarkCalibrationParsing(const BenchmarkOptions& options, Resolution resolution, vector<BenchmarkResult>& results) {
+    if (!isSelected(options, "calibration/parse")) {
+        return;
+    }
+
+    string contents = syntheticCalibration();
+
+    results.push_back(measure(options, "calibration/parse", resolution, contents.size(), 1, "parse", [&] {
+        CalibrationData calibrationData;
+        calibrationData.parse(contents);
+        calibrationData.getStereoCalibration(resolution);
+    }));
+}
+
+// Latency from push to pop of frames handed from a producer thread to a waiting consumer
+static void benchmarkFrameQueue(const BenchmarkOptions& options, Resolution resolution, vector<BenchmarkResult>& results) {
+    StereoDimensions stereoDimensions = StereoDimensions(resolution);
+    size_t height = stereoDimensions.height;
+    size_t width = stereoDimensions.width;
+
+    for (BackpressurePolicy backpressurePolicy : {DROP_NEWEST, DROP_OLDEST, LATEST_ONLY, BLOCK_PRODUCER}) {
+        string name = format("queue/{}", backpressurePolicyToString(backpressurePolicy));
+
+        if (!isSelected(options, name)) {
+            continue;
+        }
+
+        shared_ptr<FramePool> framePool = FramePool::create(kQueueCapacity + 4, height, width, 2);
+        FrameQueue frameQueue(kQueueCapacity, backpressurePolicy);
+
+        BenchmarkResult result = {name, resolution, 0, 1, "frame", {}}; // Frames are handed off by reference, nothing is copied
+        size_t frameCount = options.iterationCount + kWarmupIterationCount;
+
+        thread producer([&] {
+            for (size_t i = 0; i < frameCount; i++) {
+                Frame frame;
+
+                // Frames are released by the consumer, wait for one to come back to the pool
+                while (!(frame = framePool->acquire()).isValid()) {
+                    this_thread::yield();
+                }
+
+                frame.setSequenceNumber(i);
+                frame.setTimestamp(steadyClockTimestamp());
+                frameQueue.push(std::move(frame));
+
+                // Let the consumer catch up, so every hand-off is measured rather than the backlog
+                while (frameQueue.getCount() > 0) {
+                    this_thread::yield();
+                }
+            }
+
+            frameQueue.close();
+        });
+
+        Frame frame;
+
+        while (frameQueue.pop(frame, chrono::milliseconds(100))) {
+            uint64_t latency = steadyClockTimestamp() - frame.getTimestamp();
+            uint64_t sequenceNumber = frame.getSequenceNumber();
+
+            if (sequenceNumber >= kWarmupIterationCount) {
+                result.samples.push_back(latency);
+            }
+
+            frame.release();
+
+            if (sequenceNumber + 1 == frameCount) {
+                break;
+            }
+        }
+
+        producer.join();
+
+        if (result.samples.empty()) {
+            cerr << format("No frames were handed off through the {} queue", backpressurePolicyToString(backpressurePolicy)) << endl;
+            continue;
+        }
+
+        sort(result.samples.begin(), result.samples.end());
+        results.push_back(std::move(result));
+    }
+}
+
+#pragma mark - Output
+
+// Frame rates budgets are reported for, each resolution has some of them
+static const array<FrameRate, 4> kReportedFrameRates = {FPS_15, FPS_30, FPS_60, FPS_100};
+
+struct ReportRow {
+    const BenchmarkResult* result;
+    double mean;
+    double megabytesPerSecond;
+    double nanosecondsPerUnit;
+    array<double, kReportedFrameRates.size()> budgetPercentages; // p99 latency as a share of the frame period, negative if the resolution lacks the rate
+};
+
+static vector<ReportRow> reportRows(const vector<BenchmarkResult>& results) {
+    vector<ReportRow> rows;
+
+    for (const BenchmarkResult& result : results) {
+        ReportRow row = {&result, result.mean(), 0, 0, {}};
+        row.megabytesPerSecond = result.bytes > 0 ? result.bytes / row.mean * 1e3 : 0;
+        row.nanosecondsPerUnit = row.mean / result.units;
+
+        vector<FrameRate> frameRates = frameRatesFor(result.resolution);
+
+        for (size_t i = 0; i < kReportedFrameRates.size(); i++) {
+            bool isSupported = find(frameRates.begin(), frameRates.end(), kReportedFrameRates[i]) != frameRates.end();
+            row.budgetPercentages[i] = isSupported ? result.percentile(0.99) * kReportedFrameRates[i] / 1e7 : -1;
+        }
+
+        rows.push_back(row);
+    }
+
+    return rows;
+}
+
+static void printTable(const vector<ReportRow>& rows) {
+    size_t nameWidth = string("Benchmark").size();
+
+    for (const ReportRow& row : rows) {
+        nameWidth = max(nameWidth, row.result->name.size());
+    }
+
+    string frameRates;
+
+    for (FrameRate frameRate : kReportedFrameRates) {
+        frameRates += format("{:>8}", format("{} FPS", int(frameRate)));
+    }
+
+    // Names are padded to the longest one
+    auto paddedName = [nameWidth](const string& name) {
+        return name + string(nameWidth - name.size(), ' ');
+    };
+
+    cout << format("{} {:>7} {:>10} {:>15} {:>11} {:>11} {}", paddedName("Benchmark"), "Res", "MB/s", "Mean", "p50 (us)", "p99 (us)", frameRates) << endl;
+
+    for (const ReportRow& row : rows) {
+        const BenchmarkResult& result = *row.result;
+
+        // Per pixel in nanoseconds, per parse or frame in microseconds
+        string mean = result.unit == "px" ? format("{:.3f} ns/px", row.nanosecondsPerUnit) : format("{:.1f} us/{}", row.nanosecondsPerUnit / 1e3, result.unit);
+        string budgets;
+
+        for (double budgetPercentage : row.budgetPercentages) {
+            budgets += budgetPercentage < 0 ? format("{:>8}", "-") : format("{:>7.1f}%", budgetPercentage);
+        }
+
+        cout << format("{} {:>7} {:>10.1f} {:>15} {:>11.1f} {:>11.1f} {}",
+                    paddedName(result.name),
+                    resolutionToString(result.resolution),
+                    row.megabytesPerSecond,
+                    mean,
+                    result.percentile(0.5) / 1e3,
+                    result.percentile(0.99) / 1e3,
+                    budgets)
+             << endl;
+    }
+}
+
+static void printCSV(const vector<ReportRow>& rows) {
+    cout << "benchmark,resolution,iterations,unit,megabytes_per_second,nanoseconds_per_unit,mean_ns,p50_ns,p99_ns";
+
+    for (FrameRate frameRate : kReportedFrameRates) {
+        cout << format(",budget_percentage_{}_fps", int(frameRate));
+    }
+
+    cout << endl;
+
+    for (const ReportRow& row : rows) {
+        const BenchmarkResult& result = *row.result;
+
+        cout << format("{},{},{},{},{:.3f},{:.4f},{:.0f},{},{}",
+            result.name,
+            resolutionToString(result.resolution),
+            result.samples.size(),
+            result.unit,
+            row.megabytesPerSecond,
+            row.nanosecondsPerUnit,
+            row.mean,
+            result.percentile(0.5),
+            result.percentile(0.99));
+
+        // Empty for frame rates the resolution doesn't have
+        for (double budgetPercentage : row.budgetPercentages) {
+            cout << (budgetPercentage < 0 ? string(",") : format(",{:.3f}", budgetPercentage));
+        }
+
+        cout << endl;
+    }
+}
+
+static void printJSON(const vector<ReportRow>& rows, const BenchmarkOptions& options) {
+    cout << "{\n";
+    cout << format("  \"instructionSet\": \"{}\",\n", instructionSetToString(ColorConverter::detectInstructionSet()));
+    cout << format("  \"threadCount\": {},\n", options.threadCount);
+    cout << "  \"results\": [\n";
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        const ReportRow& row = rows[i];
+        const BenchmarkResult& result = *row.result;
+
+        // Keyed by frame rate, only those the resolution has
+        string budgets;
+
+        for (size_t j = 0; j < kReportedFrameRates.size(); j++) {
+            if (row.budgetPercentages[j] >= 0) {
+                budgets += format("{}\"{}\": {:.3f}", budgets.empty() ? "" : ", ", int(kReportedFrameRates[j]), row.budgetPercentages[j]);
+            }
+        }
+
+        cout << format("    {{\"benchmark\": \"{}\", \"resolution\": \"{}\", \"iterations\": {}, \"unit\": \"{}\", "
+                       "\"megabytesPerSecond\": {:.3f}, \"nanosecondsPerUnit\": {:.4f}, \"meanNs\": {:.0f}, \"p50Ns\": {}, \"p99Ns\": {}, "
+                       "\"budgetPercentage\": {{{}}}}}{}",
+                    result.name,
+                    resolutionToString(result.resolution),
+                    result.samples.size(),
+                    result.unit,
+                    row.megabytesPerSecond,
+                    row.nanosecondsPerUnit,
+                    row.mean,
+                    result.percentile(0.5),
+                    result.percentile(0.99),
+                    budgets,
+                    i + 1 < rows.size() ? "," : "")
+             << endl;
+    }
+
+    cout << "  ]\n}" << endl;
+}
+
+#pragma mark - Main
+
+static void printUsage() {
+    cout << "Usage: zed_bench [options]\n"
+            "  --iterations <count>      Timed iterations per benchmark (default 50)\n"
+            "  --threads <count>         Conversion and rectification threads, 0 uses all cores (default 1)\n"
+            "  --resolution <name>       HD2K, HD1080, HD720, or VGA (repeatable, default all)\n"
+            "  --filter <text>           Only runs benchmarks whose name contains the text (e.g. convert/RGB, rectify, queue)\n"
+            "  --format <table|csv|json> Output format (default table)\n"
+         << endl;
+}
+
+static BenchmarkOptions parseOptions(int argc, char** argv) {
+    BenchmarkOptions options;
+    bool hasResolution = false;
+
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+
+        if (argument == "--help" || argument == "-h") {
+            printUsage();
+            exit(0);
+        }
+
+        if (i + 1 >= argc) {
+            throw runtime_error(format("Missing value for option: {}", argument));
+        }
+
+        string value = argv[++i];
+
+        if (argument == "--iterations") {
+            options.iterationCount = max(stoul(value), 1ul);
+        }
+        else if (argument == "--threads") {
+            options.threadCount = stoul(value);
+        }
+        else if (argument == "--filter") {
+            options.filter = value;
+        }
+        else if (argument == "--format" && (value == "table" || value == "csv" || value == "json")) {
+            options.format = value;
+        }
+        else if (argument == "--resolution") {
+            if (!hasResolution) {
+                options.resolutions.clear();
+                hasResolution = true;
+            }
+
+            bool isFound = false;
+
+            for (Resolution resolution : {HD2K, HD1080, HD720, VGA}) {
+                if (value == resolutionToString(resolution)) {
+                    options.resolutions.push_back(resolution);
+                    isFound = true;
+                }
+            }
+
+            if (!isFound) {
+                throw runtime_error(format("Unknown resolution: {}", value));
+            }
+        }
+        else {
+            throw runtime_error(format("Invalid option: {} {}", argument, value));
+        }
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch (const exception& error) {
+        cerr << error.what() << endl;
+        printUsage();
+        return 1;
+    }
+
+    vector<BenchmarkResult> results;
+
+    for (Resolution resolution : options.resolutions) {
+        cerr << format("Benchmarking {} ({})", resolutionToString(resolution), StereoDimensions(resolution).toString()) << endl;
+
+        vector<uint8_t> source = syntheticFrame(StereoDimensions(resolution));
+
+        benchmarkColorConversion(options, resolution, source, results);
+        benchmarkRectification(options, resolution, source, results);
+        benchmarkCalibrationParsing(options, resolution, results);
+        benchmarkFrameQueue(options, resolution, results);
+    }
+
+    vector<ReportRow> rows = reportRows(results);
+
+    if (options.format == "csv") {
+        printCSV(rows);
+    }
+    else if (options.format == "json") {
+        printJSON(rows, options);
+    }
+    else {
+        printTable(rows);
+    }
+
+    return 0;
+}
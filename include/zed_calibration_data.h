@@ -11,21 +11,81 @@
 #include "zed_video_capture_format.h"
 #include <filesystem>
 #include <map>
+#include <string_view>
+#include <variant>
 
 using namespace std;
 using namespace filesystem;
 
 namespace zed {
 
+    // Calibration files are downloaded from this URL followed by the numeric serial number
+    constexpr string_view kCalibrationDownloadURL = "https://www.stereolabs.com/developers/calib/?SN=";
+
+    // Pinhole intrinsics and Brown-Conrady lens distortion of one camera, in pixels at one resolution
+    struct CameraIntrinsics {
+        float fx = 0;
+        float fy = 0;
+        float cx = 0;
+        float cy = 0;
+        float k1 = 0;
+        float k2 = 0;
+        float k3 = 0;
+        float p1 = 0;
+        float p2 = 0;
+    };
+
+    // Calibration of the stereo pair at one resolution
+    struct StereoCalibration {
+        Resolution resolution = HD2K;
+        StereoDimensions stereoDimensions;
+
+        CameraIntrinsics left;
+        CameraIntrinsics right;
+
+        // Position of the right camera relative to the left (millimeters, x is the baseline)
+        float baseline = 0;
+        float ty = 0;
+        float tz = 0;
+
+        // Rotation of the right camera relative to the left (Rodrigues vector, radians)
+        float rx = 0;
+        float ry = 0;
+        float rz = 0;
+    };
+
     class CalibrationData {
 
     public:
-        // Loads calibration data for a given device serial number (downloading if necessary)
-        void load(const string& serialNumber);
+        // Loads calibration data for a given device serial number from the file cache, downloading it from `downloadURL`
+        // followed by the numeric serial number if necessary (any URL curl supports, e.g. `file://` for a local mirror)
+        void load(const string& serialNumber, string_view downloadURL = kCalibrationDownloadURL);
+
+        // Loads calibration data read from the device (see `FrameSource::readCalibration()`), and stores it in the file cache
+        // so the calibration stays available when the device can't be read
+        void loadFromDevice(const string& serialNumber, const string& contents);
+
+        // Loads calibration data from the contents of a calibration file (INI format, as returned by `toString()`),
+        // in a single pass that fills the typed calibration of every resolution in the file
+        void parse(const string& contents);
+
+        // Serial number and file the calibration was loaded from (empty when parsed from a string)
+        string getSerialNumber() const;
+        path getFilepath() const;
 
-        // Gets a calibration parameter for section and key
+        // 64-bit FNV-1a hash of the calibration file contents, changes whenever the file does
+        uint64_t getHash() const;
+
+        // Whether the calibration holds every parameter for a resolution
+        bool hasStereoCalibration(Resolution resolution) const;
+
+        // Typed calibration for a resolution, looked up without strings or allocation (throws if the resolution is missing)
+        const StereoCalibration& getStereoCalibration(Resolution resolution) const;
+        const StereoCalibration& getStereoCalibration(StereoDimensions stereoDimensions) const;
+
+        // Gets a calibration parameter for section and key (throws if it's missing)
         template <typename T> T get(const string& section, const string& key) {
-            return std::get<T>(data[section][key]);
+            return std::get<T>(getValue(section, key));
         }
 
         // String representatin of all calibration parameters
@@ -35,8 +95,24 @@ namespace zed {
         string calibrationString(StereoDimensions stereoDimensions);
 
     private:
+        // Contents of the calibration file, indexed into `data` only when parameters are accessed by name
+        string contents;
+        uint64_t hash = 0;
+
+        string serialNumber;
+        path filepath;
+
         // Data map of the form: [Section: [Key: Value]]
         map<string, map<string, variant<int, float>>> data;
+        bool isIndexed = false;
+
+        StereoCalibration stereoCalibrations[4];
+        uint32_t parameterMasks[4] = {}; // Bit per parameter found for each resolution
+
+        const variant<int, float>& getValue(const string& section, const string& key);
+
+        // Builds `data` from `contents`
+        void index();
 
         // Creates filepath to ~/.stereolabs/calibration/SN<numericSerialNumber>.conf
         path createFilepath(const string& numericSerialNumber);
@@ -47,9 +123,6 @@ namespace zed {
         // Curl write callback for saving data
         static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
 
-        // Trims leading and trailing whitespaces
-        void trim(string& str);
-
         // Removes non-numeric characters from string
         string removeNonNumeric(const std::string& input);
     };
@@ -0,0 +1,255 @@
+//
+// zed_camera_controls.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_CAMERA_CONTROLS_H
+#define ZED_CAMERA_CONTROLS_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    enum CameraControl {
+        BRIGHTNESS,
+        CONTRAST,
+        HUE,
+        SATURATION,
+        SHARPNESS,
+        WHITE_BALANCE_TEMPERATURE,
+        AUTO_WHITE_BALANCE_TEMPERATURE,
+        LED
+    };
+
+    constexpr size_t kCameraControlCount = 8;
+
+    constexpr string cameraControlToString(CameraControl cameraControl) {
+        switch (cameraControl) {
+            case BRIGHTNESS:
+                return "BRIGHTNESS";
+            case CONTRAST:
+                return "CONTRAST";
+            case HUE:
+                return "HUE";
+            case SATURATION:
+                return "SATURATION";
+            case SHARPNESS:
+                return "SHARPNESS";
+            case WHITE_BALANCE_TEMPERATURE:
+                return "WHITE_BALANCE_TEMPERATURE";
+            case AUTO_WHITE_BALANCE_TEMPERATURE:
+                return "AUTO_WHITE_BALANCE_TEMPERATURE";
+            case LED:
+                return "LED";
+        }
+    }
+
+    constexpr uint16_t cameraControlDefaultValue(CameraControl cameraControl) {
+        switch (cameraControl) {
+            case BRIGHTNESS:
+                return 4;
+            case CONTRAST:
+                return 4;
+            case HUE:
+                return 0;
+            case SATURATION:
+                return 4;
+            case SHARPNESS:
+                return 0;
+            case WHITE_BALANCE_TEMPERATURE:
+                return 4600;
+            case AUTO_WHITE_BALANCE_TEMPERATURE:
+                return 1;
+            case LED:
+                return 0;
+        }
+    }
+
+    // A batch of control changes, unset controls are left as they are
+    struct CameraSettings {
+        optional<uint16_t> brightness = nullopt;
+        optional<uint16_t> contrast = nullopt;
+        optional<uint16_t> hue = nullopt;
+        optional<uint16_t> saturation = nullopt;
+        optional<uint16_t> sharpness = nullopt;
+        optional<uint16_t> whiteBalanceTemperature = nullopt; // Turns automatic white balance off
+        optional<bool> autoWhiteBalanceTemperature = nullopt;
+        optional<bool> isLEDOn = nullopt;
+    };
+
+    //
+    // USB transport
+    //
+
+    // Control transfer on the camera's default pipe (`data` holds `length` bytes, filled by device-to-host transfers)
+    struct ControlTransfer {
+        uint8_t requestType;
+        uint8_t request;
+        uint16_t value;
+        uint16_t index;
+        uint16_t length;
+        uint8_t* data;
+    };
+
+    // Camera extension unit (XU) tasks are written, and read back, as buffers of this size
+    constexpr size_t kXUBufferSizeInBytes = 384;
+
+    enum XURequest {
+        XU_WRITE, // Sends a task
+        XU_READ   // Sends a task and reads back its result
+    };
+
+    // Largest flash read a single extension unit task returns (the buffer less the 17-byte result header)
+    constexpr size_t kFlashReadMaxLength = 367;
+
+    //
+    // Calibration record in the camera's flash
+    //
+    // A 16-byte little endian header (magic, contents length, FNV-1a checksum of the contents, reserved) followed by the
+    // contents of the calibration file (INI format, see CalibrationData)
+    //
+    // This is a placeholder layout defined by this library, not one the ZED firmware writes: shipping cameras don't store
+    // their calibration file in this form (it's downloaded by serial number), so they have no record and calibration falls
+    // back to the file cache and download. The record is written with `encodeFlashCalibration()`, for devices provisioned
+    // with it and for SimulatedControlTransport
+    //
+    constexpr uint32_t kFlashCalibrationAddress = 0x19000;
+    constexpr uint32_t kFlashCalibrationMagic = 0x4C41435A; // "ZCAL"
+    constexpr size_t kFlashCalibrationHeaderSize = 16;
+    constexpr size_t kFlashCalibrationMaxLength = 65536;
+
+    // Encodes calibration file contents as a flash record
+    vector<uint8_t> encodeFlashCalibration(const string& contents);
+
+    // Returns the calibration file contents of a flash record, throws if the record is missing, truncated, or corrupt
+    string decodeFlashCalibration(const uint8_t* record, size_t size);
+
+    //
+    // Sends control transfers to a camera, kept open for as long as the transport exists
+    //
+    class ControlTransport {
+
+    public:
+        virtual ~ControlTransport() = default;
+
+        // Performs a control transfer, throws if it fails
+        virtual void transfer(ControlTransfer& controlTransfer) = 0;
+    };
+
+    //
+    // Transport emulating a camera's UVC processing unit and extension unit GPIOs in memory, to exercise control
+    // sessions without a camera (every transfer is counted, and can be slowed down to the latency of a real device)
+    //
+    class SimulatedControlTransport : public ControlTransport {
+
+    public:
+        SimulatedControlTransport(chrono::nanoseconds transferLatency = chrono::nanoseconds(0));
+
+        void transfer(ControlTransfer& controlTransfer) override;
+
+        // Current value of a control on the simulated camera
+        uint16_t getDeviceValue(CameraControl cameraControl);
+
+        // Serves `image` to flash reads from `address` on, the rest of the flash reads as erased (0xff)
+        void setFlashImage(uint32_t address, vector<uint8_t> image);
+
+        // Number of transfers so far, all of them, UVC requests, and extension unit requests
+        uint64_t getTransferCount();
+        uint64_t getUVCTransferCount();
+        uint64_t getXUTransferCount();
+
+        // Time spent in transfers so far
+        chrono::nanoseconds getTransferDuration();
+
+        void resetCounts();
+
+    private:
+        mutex transportMutex;
+        chrono::nanoseconds transferLatency;
+
+        uint16_t uvcValues[16];
+        uint8_t gpioDirections[8];
+        uint8_t gpioValues[8];
+        uint8_t xuResponse[kXUBufferSizeInBytes];
+
+        uint32_t flashAddress;
+        vector<uint8_t> flashImage;
+
+        uint64_t uvcTransferCount;
+        uint64_t xuTransferCount;
+        chrono::nanoseconds transferDuration;
+
+        void handleXUTask(const uint8_t* task);
+    };
+
+    //
+    // Camera controls over a transport opened once for the capture's lifetime
+    //
+    // The last known value of each control is cached: reads are answered without a transfer (except the white balance
+    // temperature while automatic white balance may be changing it), and writes of the current value are skipped
+    //
+    class ControlSession {
+
+    public:
+        ControlSession(shared_ptr<ControlTransport> controlTransport);
+
+        ControlSession(const ControlSession&) = delete;
+        ControlSession& operator=(const ControlSession&) = delete;
+
+        uint16_t getControlValue(CameraControl cameraControl);
+        void setControlValue(CameraControl cameraControl, uint16_t value);
+
+        // Applies a batch of changes with the fewest transfers: unchanged controls are skipped, and automatic white balance
+        // is turned off (when needed) before a white balance temperature is written. Throws if the batch turns automatic
+        // white balance on and sets a temperature
+        void applySettings(const CameraSettings& cameraSettings);
+
+        // Sends an extension unit task in a `kXUBufferSizeInBytes` buffer, which XU_READ overwrites with the result
+        void sendXURequest(XURequest xuRequest, uint8_t* data);
+
+        // Reads `length` bytes of the camera's flash memory from `address`, in tasks of up to kFlashReadMaxLength bytes
+        // (other controls can be used in between)
+        void readFlash(uint32_t address, size_t length, uint8_t* output);
+
+        // Reads the calibration record at kFlashCalibrationAddress, returns the calibration file contents. The header shares
+        // the first read, so small records cost a single task. Returns an empty string if there's no record (remembered
+        // until `invalidate()`, so later calls cost no task), throws if the record is truncated or corrupt
+        string readCalibration();
+
+        // Forgets the cached values and whether the flash holds a calibration record (e.g. after the camera was changed by another application)
+        void invalidate();
+
+        // Number of transfers sent through the session, and reads answered from the cache
+        uint64_t getTransferCount();
+        uint64_t getCachedReadCount();
+
+    private:
+        shared_ptr<ControlTransport> controlTransport;
+        mutex sessionMutex;
+
+        optional<uint16_t> values[kCameraControlCount];
+        bool isLEDOutput;                // The LED GPIO is known to be configured as an output
+        bool isCalibrationRecordMissing; // The flash is known to hold no calibration record
+
+        uint64_t transferCount;
+        uint64_t cachedReadCount;
+
+        uint16_t readControl(CameraControl cameraControl);
+        void writeControl(CameraControl cameraControl, uint16_t value);
+        void transfer(ControlTransfer& controlTransfer);
+        void sendXUTask(XURequest xuRequest, uint8_t* data);
+        void readFlashChunk(uint32_t address, size_t length, uint8_t* output);
+    };
+}
+
+#endif
@@ -0,0 +1,56 @@
+//
+// zed_camera_frame_source.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_CAMERA_FRAME_SOURCE_H
+#define ZED_CAMERA_FRAME_SOURCE_H
+
+#include "zed_frame_source.h"
+
+using namespace std;
+
+namespace zed {
+
+    struct CameraFrameSourceImpl;
+
+    //
+    // Frames and controls of a ZED camera over AVFoundation and IOKit (macOS only)
+    //
+    // Each source captures on its own serial queue, so several cameras can be opened side by side in one process
+    //
+    class CameraFrameSource : public FrameSource {
+
+    public:
+        // Opens the camera with the given device ID or serial number (see `listDevices()`), or the first one when empty
+        CameraFrameSource(const string& device = "");
+        ~CameraFrameSource() override;
+
+        // ZED cameras attached to the system
+        static vector<DeviceInfo> listDevices();
+
+        void open(Resolution resolution, FrameRate frameRate, ColorSpace rawColorSpace) override;
+        void close() override;
+
+        void start(function<void(Frame)> rawFrameHandler) override;
+        void stop() override;
+
+        size_t getRawFrameCapacity() override;
+
+        string getDeviceID() override;
+        string getDeviceName() override;
+        string getDeviceSerialNumber() override;
+        string readCalibration() override;
+
+        uint16_t getControlValue(CameraControl cameraControl) override;
+        void setControlValue(CameraControl cameraControl, uint16_t value) override;
+        void applySettings(const CameraSettings& cameraSettings) override;
+
+    private:
+        CameraFrameSourceImpl* impl;
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+//
+// zed_capture_stats.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_CAPTURE_STATS_H
+#define ZED_CAPTURE_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+namespace zed {
+
+    // Summary of a latency histogram, in nanoseconds (percentiles are accurate to within 1/8 of their value)
+    struct LatencySummary {
+        uint64_t count = 0;
+        uint64_t mean = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+
+        string toString() const;
+    };
+
+    //
+    // Lock-free latency histogram
+    //
+    // Values land in log-linear buckets (8 per power of two), so recording is a handful of relaxed atomic
+    // increments and the histogram can be summarized from any thread while it's being recorded into
+    //
+    class LatencyHistogram {
+
+    public:
+        LatencyHistogram();
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void record(uint64_t nanoseconds);
+
+        LatencySummary summarize() const;
+
+        void reset();
+
+        static constexpr size_t kSubBucketBits = 3;
+        static constexpr size_t kSubBucketCount = 1 << kSubBucketBits;
+        static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+    private:
+        atomic<uint64_t> buckets[kBucketCount];
+        atomic<uint64_t> count;
+        atomic<uint64_t> sum;
+        atomic<uint64_t> minimum;
+        atomic<uint64_t> maximum;
+
+        static size_t bucketIndex(uint64_t nanoseconds);
+        static uint64_t bucketMidpoint(size_t index);
+    };
+
+    //
+    // Snapshot of a capture's counters and latencies
+    //
+    struct CaptureStats {
+        uint64_t capturedFrameCount = 0;  // Raw frames received from the frame source
+        uint64_t deliveredFrameCount = 0; // Frames handed to the application (callback or `grab()`)
+
+        uint64_t droppedFrameCount = 0;      // Sum of the drop counts below
+        uint64_t poolDroppedFrameCount = 0;  // No free frame buffer to convert into
+        uint64_t queueDroppedFrameCount = 0; // Dropped by the delivery / grab queue's backpressure policy
+
+        uint64_t blockedFrameCount = 0; // Frames that waited for room in a full BLOCK_PRODUCER queue
+        uint64_t backlogCount = 0;      // Frames processed but not yet delivered
+
+        LatencySummary sourceLatency;    // Capture timestamp until the pipeline receives the frame (USB, driver, source)
+        LatencySummary conversionTime;   // Color conversion / rectification
+        LatencySummary queueWait;        // Processed until delivered (main queue hop or grab queue)
+        LatencySummary callbackDuration; // Time spent in the frame callback
+        LatencySummary totalLatency;     // Capture timestamp until delivery
+
+        string toString() const;
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+//
+// zed_color_conversion.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_COLOR_CONVERSION_H
+#define ZED_COLOR_CONVERSION_H
+
+#include "zed_frame.h"
+#include "zed_thread_pool.h"
+#include "zed_video_capture_format.h"
+#include <array>
+#include <memory>
+
+using namespace std;
+
+namespace zed {
+
+    enum InstructionSet {
+        SCALAR, // Portable C++
+        SSE4,   // x86 SSE4.1
+        AVX2,   // x86 AVX2
+        NEON    // ARM NEON
+    };
+
+    class ColorConverter {
+
+    public:
+        // Creates a converter using the best instruction set for the running CPU,
+        // splitting each frame into row bands across `threadCount` threads (0 uses all available cores)
+        ColorConverter(size_t threadCount = 1);
+
+        // Creates a converter forced to a specific instruction set (throws if the CPU doesn't support it)
+        ColorConverter(size_t threadCount, InstructionSet instructionSet);
+
+        // Converts a YUV 4:2:2 (Y0, Cb, Y1, Cr) frame into the given color space
+        void convert(const uint8_t* source,
+            size_t sourceRowBytes,
+            uint8_t* destination,
+            size_t destinationRowBytes,
+            size_t height,
+            size_t width,
+            ColorSpace colorSpace);
+
+        // Converts a side-by-side YUV 4:2:2 frame into the given color space, writing straight into each of `destination`'s
+        // planes in the same pass (separate eye planes, or Y / U / V planes per eye for PLANAR YUV frames)
+        void convert(const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace);
+
+        // Converts a rectangle of each eye of a side-by-side YUV 4:2:2 frame with `sourceEyeWidth` pixel wide eyes, reading
+        // only those pixels, into `destination`'s planes (whose eyes are the size of the regions, with an even x and width)
+        void convert(const uint8_t* source,
+            size_t sourceRowBytes,
+            size_t sourceEyeWidth,
+            const array<EyeRegion, 2>& regions,
+            Frame& destination,
+            ColorSpace colorSpace);
+
+        InstructionSet getInstructionSet();
+        size_t getThreadCount();
+
+        // Detects the fastest instruction set supported by the running CPU
+        static InstructionSet detectInstructionSet();
+
+        // Whether the running CPU supports the given instruction set
+        static bool isSupported(InstructionSet instructionSet);
+
+    private:
+        InstructionSet instructionSet;
+        unique_ptr<ThreadPool> threadPool;
+
+        // Converts rows starting at each eye's source origin into `destination`'s planes and pyramid levels
+        void convertEyes(const uint8_t* const eyeSources[2], size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace);
+    };
+
+    constexpr string instructionSetToString(InstructionSet instructionSet) {
+        switch (instructionSet) {
+            case SCALAR:
+                return "Scalar";
+            case SSE4:
+                return "SSE4";
+            case AVX2:
+                return "AVX2";
+            case NEON:
+                return "NEON";
+        }
+    }
+}
+
+#endif
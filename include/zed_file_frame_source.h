@@ -0,0 +1,53 @@
+//
+// zed_file_frame_source.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_FILE_FRAME_SOURCE_H
+#define ZED_FILE_FRAME_SOURCE_H
+
+#include "zed_frame_source.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+using namespace filesystem;
+
+namespace zed {
+
+    //
+    // Replays a raw file of back-to-back side-by-side frames (no header, no padding between rows),
+    // in the raw color space and resolution it's opened with
+    //
+    class FileFrameSource : public PacedFrameSource {
+
+    public:
+        // `serialNumber` is reported as the device serial number (e.g. to load a calibration file for rectification)
+        FileFrameSource(const path& filepath, PlaybackSpeed playbackSpeed = NATIVE_SPEED, bool isLooping = false, const string& serialNumber = "");
+        ~FileFrameSource() override;
+
+        string getDeviceID() override;
+        string getDeviceName() override;
+        string getDeviceSerialNumber() override;
+
+        // Number of complete frames in the file for the opened mode
+        size_t getFrameCount();
+
+    protected:
+        void prepare() override;
+        bool produceFrame(uint8_t* data, size_t rowBytes, uint64_t frameIndex) override;
+
+    private:
+        path filepath;
+        bool isLooping;
+        string serialNumber;
+
+        ifstream file;
+        size_t frameSize;
+        size_t frameCount;
+    };
+}
+
+#endif
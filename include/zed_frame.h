@@ -0,0 +1,222 @@
+//
+// zed_frame.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_FRAME_H
+#define ZED_FRAME_H
+
+#include "zed_video_capture_format.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+using namespace std;
+
+namespace zed {
+
+    class FramePool;
+
+    // How a frame's pixels are laid out in memory
+    enum FrameLayout {
+        SIDE_BY_SIDE,  // One buffer with the left and right eyes side by side
+        SEPARATE_EYES, // Left and right eyes in separately allocated, 64-byte aligned planes
+        PLANAR         // Separate eyes, with YUV frames further split into Y, U, and V planes per eye (other color spaces as SEPARATE_EYES)
+    };
+
+    constexpr string frameLayoutToString(FrameLayout frameLayout) {
+        switch (frameLayout) {
+            case SIDE_BY_SIDE:
+                return "SIDE_BY_SIDE";
+            case SEPARATE_EYES:
+                return "SEPARATE_EYES";
+            case PLANAR:
+                return "PLANAR";
+        }
+    }
+
+    // One contiguous image in a frame buffer (the whole frame, an eye, or a Y / U / V component of an eye)
+    struct FramePlane {
+        uint8_t* data;
+        size_t height;
+        size_t width;
+        size_t channels;
+        size_t rowBytes;
+    };
+
+    constexpr size_t kMaxFramePlaneCount = 6;
+    constexpr size_t kMaxPyramidLevelCount = 4;
+
+    // Current steady clock time in nanoseconds, the clock all frame timestamps are expressed in
+    inline uint64_t steadyClockTimestamp() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Shared state behind Frame handles (one per pooled buffer, or one per wrapped external buffer)
+    struct FrameSlot {
+        uint8_t* data;
+        size_t height;
+        size_t width;
+        size_t channels;
+        size_t rowBytes;
+        uint64_t timestamp;
+        uint64_t sequenceNumber;
+        uint64_t processedTimestamp;
+        atomic<uint64_t> deliveryTimestamp;
+        Rectification rectification;
+
+        // Part of each source eye the frame's eyes cover (see `VideoCapture::setRegionOfInterest()`)
+        EyeRegion regions[2];
+
+        // Planes in order (left eye first), a single plane for side-by-side frames
+        FrameLayout layout;
+        size_t planeCount;
+        FramePlane planes[kMaxFramePlaneCount];
+
+        // Downsampled images per eye, level 1 onwards (level 0 is the frame itself)
+        size_t pyramidLevelCount;
+        FramePlane pyramidPlanes[kMaxPyramidLevelCount - 1][2];
+
+        atomic<uint32_t> referenceCount;
+
+        // Owning pool while the slot is handed out (keeps the pool alive until the last frame is released)
+        shared_ptr<FramePool> pool;
+        size_t poolIndex;
+
+        // Invoked when a wrapped external buffer is released
+        function<void()> releaseHandler;
+    };
+
+    //
+    // Reference-counted handle to a frame buffer
+    //
+    // Copies share the same buffer, which returns to its pool when the last copy is released or destroyed
+    //
+    class Frame {
+
+    public:
+        Frame();
+        Frame(const Frame& other);
+        Frame(Frame&& other) noexcept;
+        Frame& operator=(const Frame& other);
+        Frame& operator=(Frame&& other) noexcept;
+        ~Frame();
+
+        // Wraps an external buffer without copying, `releaseHandler` is invoked once the last copy is released
+        static Frame wrap(uint8_t* data, size_t height, size_t width, size_t channels, size_t rowBytes, function<void()> releaseHandler);
+
+        // The first plane: the whole frame when side by side, the left eye (or its Y plane) otherwise
+        uint8_t* getData() const;
+        size_t getHeight() const;
+        size_t getWidth() const;
+        size_t getChannels() const;
+        size_t getRowBytes() const;
+
+        FrameLayout getLayout() const;
+
+        // Number of separately stored planes (1 side by side, 2 for separate eyes, 6 for planar YUV)
+        size_t getPlaneCount() const;
+        FramePlane getPlane(size_t planeIndex) const;
+
+        // An eye's image, or its Y (0), U (1), or V (2) plane for planar YUV frames (a view into the shared buffer when side by side)
+        FramePlane getPlane(Eye eye, size_t componentIndex = 0) const;
+
+        // Number of pyramid levels including the full resolution frame (1 without a pyramid)
+        size_t getPyramidLevelCount() const;
+
+        // An eye's image at a pyramid level, each level half the width and height of the one before (level 0 is `getPlane(eye)`)
+        FramePlane getPyramidLevel(size_t level, Eye eye) const;
+
+        // Capture timestamp in steady clock nanoseconds (see `steadyClockTimestamp()`)
+        uint64_t getTimestamp() const;
+        void setTimestamp(uint64_t timestamp);
+
+        // Position of the frame in the source's stream, gaps mean frames were dropped along the way
+        uint64_t getSequenceNumber() const;
+        void setSequenceNumber(uint64_t sequenceNumber);
+
+        // Steady clock nanoseconds at which the frame was ready for delivery (after conversion)
+        uint64_t getProcessedTimestamp() const;
+        void setProcessedTimestamp(uint64_t processedTimestamp);
+
+        // Steady clock nanoseconds at which the frame was handed to the application (the first delivery, for frames shared between subscribers)
+        uint64_t getDeliveryTimestamp() const;
+        void setDeliveryTimestamp(uint64_t deliveryTimestamp);
+
+        // Whether the frame was rectified (RAW until set, see `VideoCapture::loadCalibrationAsync()`)
+        Rectification getRectification() const;
+        void setRectification(Rectification rectification);
+
+        // Rectangle of the source eye image that an eye of the frame was cropped from (the whole eye unless set,
+        // see `VideoCapture::setRegionOfInterest()`)
+        EyeRegion getRegion(Eye eye) const;
+        void setRegion(Eye eye, EyeRegion region);
+
+        // Whether the handle references a buffer
+        bool isValid() const;
+
+        // Releases this handle's reference to the buffer early
+        void release();
+
+    private:
+        friend class FramePool;
+
+        FrameSlot* slot;
+
+        Frame(FrameSlot* slot);
+    };
+
+    //
+    // Fixed-size pool of 64-byte aligned frame buffers, allocated once up front
+    //
+    class FramePool : public enable_shared_from_this<FramePool> {
+
+    public:
+        // Creates a pool of `capacity` buffers (at most kMaxFramePoolCapacity) for stereo frames of the given dimensions,
+        // with every plane of a separated layout and every pyramid level (1 to kMaxPyramidLevelCount, YUV frames have none)
+        // allocated at a 64-byte aligned address and row stride
+        static shared_ptr<FramePool> create(
+            size_t capacity, size_t height, size_t width, size_t channels, FrameLayout frameLayout = SIDE_BY_SIDE, size_t pyramidLevelCount = 1);
+
+        ~FramePool();
+
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        // Hands out a free buffer, or an invalid frame if all buffers are in use (never blocks)
+        Frame acquire();
+
+        size_t getCapacity();
+
+        // Number of buffers currently free
+        size_t getAvailableCount();
+
+        static constexpr size_t kMaxFramePoolCapacity = 64;
+
+    private:
+        size_t capacity;
+        size_t height;
+        size_t width;
+        size_t channels;
+        FrameLayout frameLayout;
+
+        uint8_t* storage;
+        unique_ptr<FrameSlot[]> slots;
+
+        // Bit i is set while buffer i is free
+        atomic<uint64_t> freeMask;
+
+        FramePool(size_t capacity, size_t height, size_t width, size_t channels, FrameLayout frameLayout, size_t pyramidLevelCount);
+
+        // Returns a buffer whose last frame was released
+        void recycle(FrameSlot* slot);
+
+        friend class Frame;
+    };
+}
+
+#endif
@@ -0,0 +1,130 @@
+//
+// zed_frame_queue.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_FRAME_QUEUE_H
+#define ZED_FRAME_QUEUE_H
+
+#include "zed_frame.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace zed {
+
+    // What happens to a new frame when the consumer falls behind and the queue is full
+    enum BackpressurePolicy {
+        DROP_NEWEST,   // The new frame is dropped, queued frames are kept (every kept frame is delivered in order)
+        DROP_OLDEST,   // The oldest queued frame is dropped to make room (the queue holds the most recent frames)
+        LATEST_ONLY,   // Only the most recent frame is kept, regardless of capacity (lowest latency)
+        BLOCK_PRODUCER // The producer waits for room, nothing is dropped (the source is slowed to the consumer's pace)
+    };
+
+    constexpr string backpressurePolicyToString(BackpressurePolicy backpressurePolicy) {
+        switch (backpressurePolicy) {
+            case DROP_NEWEST:
+                return "DROP_NEWEST";
+            case DROP_OLDEST:
+                return "DROP_OLDEST";
+            case LATEST_ONLY:
+                return "LATEST_ONLY";
+            case BLOCK_PRODUCER:
+                return "BLOCK_PRODUCER";
+        }
+    }
+
+    //
+    // Bounded single-producer / single-consumer frame queue
+    //
+    // Pushing and popping never take a lock, the consumer only sleeps on a condition variable when it waits
+    // on an empty queue (and the producer only when it waits on a full BLOCK_PRODUCER queue)
+    //
+    class FrameQueue {
+
+    public:
+        FrameQueue(size_t capacity, BackpressurePolicy backpressurePolicy = DROP_NEWEST);
+
+        FrameQueue(const FrameQueue&) = delete;
+        FrameQueue& operator=(const FrameQueue&) = delete;
+
+        // Producer: enqueues a frame, returns false if a frame was dropped to make room (or this frame was dropped)
+        bool push(Frame frame);
+
+        // Consumer: dequeues a frame without waiting, returns false if the queue is empty
+        bool pop(Frame& frame);
+
+        // Consumer: dequeues a frame, waiting up to `timeout` for one to arrive
+        bool pop(Frame& frame, chrono::nanoseconds timeout);
+
+        // Releases a producer blocked in `push()` and makes further pushes fail (e.g. before stopping the producer)
+        void close();
+
+        size_t getCapacity();
+        BackpressurePolicy getBackpressurePolicy();
+
+        // Number of frames waiting to be popped (a snapshot when called off the producer and consumer threads)
+        size_t getCount();
+
+        // Number of frames dropped since the queue was created
+        uint64_t getDroppedFrameCount();
+
+        // Number of pushes that had to wait for room (BLOCK_PRODUCER)
+        uint64_t getBlockedPushCount();
+
+    private:
+        size_t capacity;
+        BackpressurePolicy backpressurePolicy;
+
+        //
+        // DROP_NEWEST, DROP_OLDEST, BLOCK_PRODUCER: ring of `capacity` cells indexed by monotonic head / tail counters
+        //
+        // Each cell's sequence says whose turn it is (bounded queue after Dmitry Vyukov): `2 * position` when it's free
+        // for the push at `position`, `2 * position + 1` once that frame can be popped (doubled so a single cell can't
+        // look both full and free). Pops claim the head with a CAS, so the producer can pop the oldest frame itself under DROP_OLDEST
+        //
+        struct Cell {
+            atomic<size_t> sequence;
+            Frame frame;
+        };
+
+        unique_ptr<Cell[]> cells;
+        alignas(64) atomic<size_t> head; // Next frame to pop
+        alignas(64) atomic<size_t> tail; // Next cell to push into, written by the producer
+
+        //
+        // LATEST_ONLY: triple buffer, the producer and consumer each own one slot and swap through the middle one
+        //
+        Frame latestSlots[3];
+        alignas(64) atomic<uint8_t> latestMiddle; // Middle slot index, with kLatestFreshBit set while it holds an unpopped frame
+        uint8_t latestBack;                       // Owned by the producer
+        uint8_t latestFront;                      // Owned by the consumer
+
+        alignas(64) atomic<uint64_t> droppedFrameCount;
+        atomic<uint64_t> blockedPushCount;
+
+        //
+        // Consumer / producer wakeup
+        //
+        atomic<bool> isConsumerWaiting;
+        atomic<bool> isProducerWaiting;
+        atomic<bool> isClosed;
+        mutex waitMutex;
+        condition_variable waitCondition;
+        condition_variable spaceCondition;
+
+        bool tryPop(Frame& frame);
+        bool hasSpace(size_t position);
+        void waitForSpace(size_t position);
+        void wakeConsumer();
+        void wakeProducer();
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+//
+// zed_frame_source.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_FRAME_SOURCE_H
+#define ZED_FRAME_SOURCE_H
+
+#include "zed_camera_controls.h"
+#include "zed_frame.h"
+#include "zed_video_capture_format.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    // A device that can be opened by ID or serial number
+    struct DeviceInfo {
+        string deviceID;
+        string deviceName;
+        string serialNumber; // Empty if it can't be read (e.g. while another process holds the device)
+    };
+
+    //
+    // Source of raw side-by-side stereo frames
+    //
+    // Raw frames are delivered in the color space requested on open, either YUV (4:2:2, 2 channels) or GREYSCALE,
+    // everything else (conversion, rectification, queueing, and delivery) is handled by VideoCapture
+    //
+    class FrameSource {
+
+    public:
+        virtual ~FrameSource() = default;
+
+        // Opens the source for the given mode, throws if the mode is unavailable
+        virtual void open(Resolution resolution, FrameRate frameRate, ColorSpace rawColorSpace) = 0;
+        virtual void close() = 0;
+
+        // Starts delivering raw frames to `rawFrameHandler` on a thread owned by the source
+        virtual void start(function<void(Frame)> rawFrameHandler) = 0;
+        virtual void stop() = 0;
+
+        // Raw frames the source can lend at once, frames arriving while they're all held are dropped (0 if unlimited, the default)
+        virtual size_t getRawFrameCapacity();
+
+        virtual string getDeviceID();
+        virtual string getDeviceName();
+        virtual string getDeviceSerialNumber();
+
+        // Reads the calibration file contents stored on the device, empty for sources and devices that store none (the default).
+        // Throws if the device's calibration is stored but can't be read
+        virtual string readCalibration();
+
+        // Reads and writes camera controls, throws for sources without controls
+        virtual uint16_t getControlValue(CameraControl cameraControl);
+        virtual void setControlValue(CameraControl cameraControl, uint16_t value);
+
+        // Applies the controls set in `cameraSettings` (by default one `setControlValue()` each, automatic white balance first)
+        virtual void applySettings(const CameraSettings& cameraSettings);
+    };
+
+    enum PlaybackSpeed {
+        NATIVE_SPEED, // Frames are paced at the source's frame rate
+        MAX_SPEED     // Frames are produced as fast as the consumer allows
+    };
+
+    //
+    // Base for sources that produce frames on their own thread into a pool of raw frame buffers
+    //
+    // Subclasses must call `stop()` in their destructor, before the state `produceFrame()` relies on is destroyed
+    //
+    class PacedFrameSource : public FrameSource {
+
+    public:
+        PacedFrameSource(PlaybackSpeed playbackSpeed);
+        ~PacedFrameSource() override;
+
+        void open(Resolution resolution, FrameRate frameRate, ColorSpace rawColorSpace) override;
+        void close() override;
+
+        void start(function<void(Frame)> rawFrameHandler) override;
+        void stop() override;
+
+        size_t getRawFrameCapacity() override;
+
+    protected:
+        StereoDimensions stereoDimensions;
+        FrameRate frameRate;
+        ColorSpace rawColorSpace;
+
+        // Called from `open()` once the mode is set, throws if the mode is unavailable
+        virtual void prepare() {}
+
+        // Fills the next raw frame, returns false once the source is exhausted
+        virtual bool produceFrame(uint8_t* data, size_t rowBytes, uint64_t frameIndex) = 0;
+
+    private:
+        PlaybackSpeed playbackSpeed;
+        shared_ptr<FramePool> framePool;
+
+        thread producerThread;
+        atomic<bool> isRunning;
+        bool isOpen;
+
+        void run(function<void(Frame)> rawFrameHandler);
+    };
+}
+
+#endif
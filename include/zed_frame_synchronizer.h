@@ -0,0 +1,111 @@
+//
+// zed_frame_synchronizer.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_FRAME_SYNCHRONIZER_H
+#define ZED_FRAME_SYNCHRONIZER_H
+
+#include "zed_capture_stats.h"
+#include "zed_frame.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    // One frame from every source of a FrameSynchronizer, captured within its tolerance of each other
+    struct FrameSet {
+        vector<Frame> frames; // In the order of the sources
+        uint64_t timestamp;   // Earliest capture timestamp in the set
+        uint64_t skew;        // Latest minus earliest capture timestamp, nanoseconds
+    };
+
+    //
+    // Snapshot of a synchronizer's counters
+    //
+    struct SynchronizationStats {
+        uint64_t frameSetCount = 0;
+
+        // Matched sets dropped because the handler fell more than `bufferCapacity` sets behind
+        uint64_t droppedFrameSetCount = 0;
+
+        // Frames dropped without a match, per source: no frame from some other source was captured within the
+        // tolerance, or the frame waited behind `bufferCapacity` newer ones
+        vector<uint64_t> unmatchedFrameCounts;
+
+        // Mean capture time of each source relative to the first one in matched sets, nanoseconds (0 for the first source)
+        vector<int64_t> meanOffsets;
+
+        LatencySummary skew; // Spread of capture timestamps within a set
+
+        string toString() const;
+    };
+
+    //
+    // Matches frames across N sources by capture timestamp
+    //
+    // Frames are pushed from any thread (e.g. one subscriber or frame source thread per camera) and wait in a small buffer
+    // per source. Whenever every source has a frame waiting, the earliest ones are delivered as a set if they're within
+    // `tolerance` of each other, otherwise the earliest frame can't be part of any set and is dropped. Works with any
+    // frame source, as long as their timestamps share a clock (every source's frames are on the steady clock)
+    //
+    class FrameSynchronizer {
+
+    public:
+        // `frameSetHandler` is called one set at a time in capture order, on the thread whose frame completed a set, without
+        // the synchronizer's lock held (so it may call `getStats()` or `reset()`). Sets completed while it's running are handed
+        // to the thread already running it, so a slow handler never blocks another source's `push()`. Frames waiting for a match
+        // (and matched sets waiting for the handler) hold buffers from their source's pool, up to `bufferCapacity` per source
+        FrameSynchronizer(size_t sourceCount, chrono::nanoseconds tolerance, function<void(FrameSet)> frameSetHandler, size_t bufferCapacity = 2);
+
+        FrameSynchronizer(const FrameSynchronizer&) = delete;
+        FrameSynchronizer& operator=(const FrameSynchronizer&) = delete;
+
+        // Adds a frame from the source at `sourceIndex`, frames from one source must arrive in capture order
+        void push(size_t sourceIndex, Frame frame);
+
+        // Handler for a source's frames (e.g. `videoCapture.subscribe(BGR, synchronizer.sourceHandler(0))`)
+        function<void(Frame)> sourceHandler(size_t sourceIndex);
+
+        size_t getSourceCount();
+        chrono::nanoseconds getTolerance();
+
+        SynchronizationStats getStats();
+
+        // Drops the waiting frames and zeroes the counters
+        void reset();
+
+    private:
+        size_t sourceCount;
+        chrono::nanoseconds tolerance;
+        function<void(FrameSet)> frameSetHandler;
+        size_t bufferCapacity;
+
+        mutex synchronizerMutex;
+        vector<deque<Frame>> pendingFrames;
+        deque<FrameSet> readyFrameSets; // Matched, waiting for the handler
+        bool isDelivering;              // A thread is running the handler
+
+        uint64_t frameSetCount;
+        uint64_t droppedFrameSetCount;
+        vector<uint64_t> unmatchedFrameCounts;
+        vector<int64_t> offsetSums;
+        LatencyHistogram skew;
+
+        // Matches or drops waiting frames until some source has none left
+        void match();
+
+        // Runs the handler on the ready sets, unless another thread already is
+        void deliver(unique_lock<mutex>& lock);
+    };
+}
+
+#endif
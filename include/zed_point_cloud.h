@@ -0,0 +1,94 @@
+//
+// zed_point_cloud.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_POINT_CLOUD_H
+#define ZED_POINT_CLOUD_H
+
+#include "zed_calibration_data.h"
+#include "zed_color_conversion.h"
+#include "zed_stereo_rectifier.h"
+#include "zed_thread_pool.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // Points in structure-of-arrays layout, in meters in the rectified left camera frame (x right, y down, z forward)
+    //
+    // Dense clouds have a point per pixel in row-major order, with NaN coordinates where there's no valid point,
+    // compact clouds only hold the valid points (still in row-major order). Arrays are reused between frames,
+    // so only the first `count` elements are points
+    //
+    struct PointCloud {
+        size_t width = 0;
+        size_t height = 0;
+        size_t count = 0;
+
+        vector<float> x;
+        vector<float> y;
+        vector<float> z;
+
+        // Compact clouds with `hasPixelIndices`: pixel (row * width + column) of each point, to look up its color in the left image
+        vector<uint32_t> pixelIndices;
+    };
+
+    struct ReprojectionSettings {
+        float maxDepth = 0;           // Meters, farther points are invalid (0 keeps every point)
+        bool isCompact = false;       // Only keeps valid points
+        bool hasPixelIndices = false; // Records the pixel of each point of a compact cloud
+    };
+
+    //
+    // Turns disparity (see StereoMatcher) into metric depth and point clouds
+    //
+    // Depth is fx * baseline / disparity with the rectified focal length, rows are split into bands across a thread pool
+    // and reprojected with AVX2, SSE4, or NEON vectors
+    //
+    class DepthReprojector {
+
+    public:
+        // Reprojects with the calibration's baseline and the rectified left camera's focal length and principal point
+        DepthReprojector(const CalibrationData& calibrationData, StereoRectifier& stereoRectifier, size_t threadCount = 1);
+
+        // Reprojects with a rectified focal length and principal point (pixels) and a baseline (millimeters, as in the calibration file)
+        DepthReprojector(double focalLength, double centerX, double centerY, double baseline, size_t threadCount = 1);
+
+        // Creates a reprojector forced to a specific instruction set (throws if the CPU doesn't support it)
+        DepthReprojector(double focalLength, double centerX, double centerY, double baseline, size_t threadCount, InstructionSet instructionSet);
+
+        // Computes the depth of every pixel in meters (NaN where the disparity is invalid or the depth exceeds `maxDepth`)
+        void computeDepth(const int16_t* disparity, size_t disparityRowBytes, size_t height, size_t width, float* depth, size_t depthRowBytes, float maxDepth = 0);
+
+        // Reprojects every pixel with a valid disparity into `pointCloud`
+        void computePointCloud(const int16_t* disparity,
+            size_t disparityRowBytes,
+            size_t height,
+            size_t width,
+            PointCloud& pointCloud,
+            ReprojectionSettings settings = ReprojectionSettings());
+
+        InstructionSet getInstructionSet();
+        size_t getThreadCount();
+
+    private:
+        float focalLength;
+        float centerX;
+        float centerY;
+        float depthScale; // Depth times the fixed point disparity
+
+        InstructionSet instructionSet;
+        unique_ptr<ThreadPool> threadPool;
+
+        // Compact clouds are gathered per row band, then copied together
+        vector<PointCloud> bandClouds;
+    };
+}
+
+#endif
@@ -0,0 +1,152 @@
+//
+// zed_recording.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_RECORDING_H
+#define ZED_RECORDING_H
+
+#include "zed_calibration_data.h"
+#include "zed_frame.h"
+#include "zed_frame_queue.h"
+#include "zed_video_capture_format.h"
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace filesystem;
+
+namespace zed {
+
+    class MemoryMappedFile;
+
+    //
+    // Recording container layout
+    //
+    // [RecordingHeader | calibration text | frame index (RecordingIndexEntry per frame) | frames]
+    //
+    // Frames are stored back-to-back without row padding, each starting on a page boundary
+    //
+    constexpr char kRecordingMagic[8] = {'Z', 'E', 'D', 'R', 'E', 'C', 'O', 'R'};
+    constexpr uint32_t kRecordingVersion = 1;
+
+    struct RecordingHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t colorSpace;
+        int32_t width;
+        int32_t height;
+        uint32_t frameRate;
+        uint32_t channels;
+
+        uint64_t frameSize;   // Bytes of pixel data per frame
+        uint64_t frameStride; // Bytes between the start of consecutive frames
+        uint64_t maxFrameCount;
+        uint64_t frameCount;  // Frames written so far, updated after each frame and its index entry
+
+        uint64_t calibrationOffset;
+        uint64_t calibrationSize;
+        uint64_t indexOffset;
+        uint64_t dataOffset;
+
+        char serialNumber[32];
+    };
+
+    struct RecordingIndexEntry {
+        uint64_t timestamp; // Capture timestamp in nanoseconds
+        uint64_t offset;    // Byte offset of the frame from the start of the file
+    };
+
+    //
+    // Records frames into a preallocated, memory-mapped recording
+    //
+    // `record()` copies the frame into a buffer of the writer's own and hands it to a writer thread through a lock-free queue,
+    // so the capture thread never waits on the disk and a writer that falls behind never holds the source's buffers.
+    // Frames are dropped (and counted) if the writer falls more than a queue behind. The buffers are allocated up front,
+    // 17 frames (~190 MB at HD2K in YUV)
+    //
+    class RecordingWriter {
+
+    public:
+        // Creates a recording with room for `maxFrameCount` frames, allocated on disk up front
+        RecordingWriter(const path& filepath,
+            StereoDimensions stereoDimensions,
+            ColorSpace colorSpace,
+            FrameRate frameRate,
+            size_t maxFrameCount,
+            const string& serialNumber = "",
+            const string& calibration = "");
+
+        ~RecordingWriter();
+
+        RecordingWriter(const RecordingWriter&) = delete;
+        RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+        // Copies a frame and queues it for writing, returns false if it was dropped (never blocks)
+        bool record(const Frame& frame);
+
+        // Writes the remaining queued frames, flushes, and trims the file to the frames written
+        void finish();
+
+        size_t getRecordedFrameCount();
+        uint64_t getDroppedFrameCount();
+
+    private:
+        path filepath;
+        shared_ptr<MemoryMappedFile> mappedFile;
+        RecordingHeader* header;
+        RecordingIndexEntry* index;
+
+        shared_ptr<FramePool> framePool;
+        FrameQueue frameQueue;
+        thread writerThread;
+        atomic<bool> isFinishing;
+        bool isFinished;
+
+        atomic<size_t> recordedFrameCount;
+        atomic<uint64_t> backlogDroppedFrameCount; // No free buffer, the writer is behind
+        atomic<uint64_t> fullDroppedFrameCount;
+
+        void run();
+        void write(const Frame& frame);
+    };
+
+    //
+    // Zero-copy random access to the frames of a recording
+    //
+    class RecordingReader {
+
+    public:
+        RecordingReader(const path& filepath);
+
+        StereoDimensions getStereoDimensions();
+        ColorSpace getColorSpace();
+        FrameRate getFrameRate();
+        string getSerialNumber();
+
+        // Calibration stored with the recording, throws if none was stored
+        CalibrationData getCalibrationData();
+
+        size_t getFrameCount();
+        uint64_t getTimestamp(size_t frameIndex);
+
+        // Frame referencing the mapped file (valid after the reader is destroyed)
+        Frame getFrame(size_t frameIndex);
+
+        // Index of the frame whose timestamp is closest to `timestamp`
+        size_t findFrameIndex(uint64_t timestamp);
+
+    private:
+        shared_ptr<MemoryMappedFile> mappedFile;
+        const RecordingHeader* header;
+        const RecordingIndexEntry* index;
+        size_t frameCount;
+    };
+}
+
+#endif
@@ -0,0 +1,217 @@
+//
+// zed_sensor_data.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_SENSOR_DATA_H
+#define ZED_SENSOR_DATA_H
+
+#include "zed_frame.h"
+#include "zed_sensor_ring.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // ZED 2 / ZED 2i sensor HID report
+    //
+    // Sent by the camera's MCU at the IMU rate (~400 Hz), the magnetometer and environmental sensors refresh more slowly
+    // and flag whether each report carries a new reading. Multi-byte fields are little endian
+    //
+    constexpr uint16_t kSensorVendorID = 0x2B03;
+    constexpr uint16_t kSensorProductIDs[2] = {0xF881, 0xF883}; // ZED 2, ZED 2i
+    constexpr uint8_t kSensorReportID = 0x01;
+
+    // Report units
+    constexpr double kSensorTickNanoseconds = 39062.5;         // MCU clock period (25.6 kHz)
+    constexpr double kAccelerationScale = 8.0 * 9.8189 / 32768; // m/s^2 per unit (+/- 8 g)
+    constexpr double kAngularVelocityScale = 1000.0 / 32768;    // deg/s per unit (+/- 1000 deg/s)
+    constexpr double kMagneticFieldScale = 1.0 / 16;            // uT per unit
+    constexpr double kTemperatureScale = 0.01;                  // C per unit
+    constexpr double kPressureScale = 0.0001;                   // hPa per unit (0.01 before firmware 3.9)
+    constexpr double kHumidityScale = 0.01;                     // % per unit (1 / 1024 before firmware 3.9)
+    constexpr int16_t kInvalidTemperature = -27315;             // Absolute zero, reported when a temperature is unavailable
+    constexpr int64_t kSensorClockDriftPerReport = 200;         // Nanoseconds (80 ppm at 400 Hz)
+
+#pragma pack(push, 1)
+    struct SensorReport {
+        uint8_t reportID;             // kSensorReportID
+        uint8_t isIMUInvalid;         // 0 when the IMU reading is valid
+        uint64_t timestamp;           // MCU clock ticks (kSensorTickNanoseconds)
+        int16_t gyroscope[3];         // Raw angular velocity
+        int16_t accelerometer[3];     // Raw acceleration
+        uint8_t isFrameSync;          // 1 when the reading was taken at a video frame's exposure trigger
+        uint8_t syncCapabilities;     // Non-zero when frame synchronization is active
+        uint32_t frameSyncCount;      // Number of frames synchronized since power on
+        int16_t imuTemperature;       // 0.01 C
+        uint8_t magnetometerStatus;   // SensorStatus
+        int16_t magnetometer[3];      // Raw magnetic field
+        uint8_t isMoving;             // Motion interrupt from the IMU
+        uint32_t movingCount;
+        uint8_t isFalling;            // Free fall interrupt from the IMU
+        uint32_t fallingCount;
+        uint8_t environmentStatus;    // SensorStatus
+        int16_t temperature;          // 0.01 C
+        uint32_t pressure;            // kPressureScale
+        uint32_t humidity;            // kHumidityScale
+        int16_t leftCameraTemperature;  // 0.01 C
+        int16_t rightCameraTemperature; // 0.01 C
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(SensorReport) == 62, "Sensor reports are 62 bytes, within a 64-byte HID report");
+
+    // Whether a slower sensor's reading in a report is new
+    enum SensorStatus {
+        SENSOR_NOT_PRESENT = 0, // The camera has no such sensor (e.g. ZED Mini)
+        SENSOR_OLD_VALUE = 1,   // Same reading as the previous report
+        SENSOR_NEW_VALUE = 2    // New reading
+    };
+
+    //
+    // Samples
+    //
+    // Timestamps are steady clock nanoseconds, the clock frame timestamps are expressed in (see `steadyClockTimestamp()`),
+    // axes follow the IMU coordinate system (see the README)
+    //
+    struct IMUSample {
+        uint64_t timestamp;
+        float acceleration[3];    // m/s^2
+        float angularVelocity[3]; // deg/s
+        float temperature;        // C, NaN if unavailable
+        bool isFrameSync;         // Taken at a video frame's exposure trigger
+        bool isInterpolated;      // Interpolated between two readings to a requested time
+    };
+
+    struct MagnetometerSample {
+        uint64_t timestamp;
+        float magneticField[3]; // uT
+    };
+
+    struct EnvironmentSample {
+        uint64_t timestamp;
+        float temperature;            // C, NaN if unavailable
+        float pressure;               // hPa
+        float humidity;               // % relative humidity
+        float leftCameraTemperature;  // C, NaN if unavailable
+        float rightCameraTemperature; // C, NaN if unavailable
+    };
+
+    // The samples carried by one report
+    struct DecodedSensorReport {
+        uint64_t deviceTimestamp; // MCU clock in nanoseconds
+
+        bool hasIMUSample;
+        bool hasMagnetometerSample;
+        bool hasEnvironmentSample;
+
+        IMUSample imuSample;
+        MagnetometerSample magnetometerSample;
+        EnvironmentSample environmentSample;
+    };
+
+    //
+    // Decodes sensor HID reports into calibrated units, on steady clock timestamps
+    //
+    // The MCU clock is mapped to the steady clock by the smallest (least delayed) offset between a report's arrival and its
+    // MCU timestamp, which rises by at most kSensorClockDriftPerReport per report to follow drift between the clocks,
+    // so transport jitter doesn't reach the sample timestamps
+    //
+    class SensorReportDecoder {
+
+    public:
+        // `isLegacyFirmware`: firmware before 3.9 reports pressure and humidity with coarser scales
+        SensorReportDecoder(bool isLegacyFirmware = false);
+
+        // Decodes a report received at `arrivalTimestamp` (steady clock nanoseconds), returns false if it isn't a sensor report
+        bool decode(const uint8_t* report, size_t size, uint64_t arrivalTimestamp, DecodedSensorReport& decodedReport);
+
+        // Forgets the clock mapping (e.g. after reconnecting)
+        void reset();
+
+        bool isLegacyFirmware();
+
+    private:
+        bool legacyFirmware;
+
+        bool hasClockOffset;
+        int64_t clockOffset; // Steady clock minus MCU clock, nanoseconds
+        uint64_t previousDeviceTimestamp;
+
+        uint64_t mapTimestamp(uint64_t deviceTimestamp, uint64_t arrivalTimestamp);
+    };
+
+    //
+    // Sensor samples shared between the thread decoding reports and any number of readers
+    //
+    // The decoding thread appends to lock-free rings per sensor, which readers search by timestamp without ever blocking it,
+    // so high-rate sensor parsing never contends with frame delivery
+    //
+    class SensorStream {
+
+    public:
+        // Keeps the latest `imuCapacity` IMU samples (~10 s at 400 Hz by default) and `imuCapacity / 8` of each slower sensor
+        SensorStream(size_t imuCapacity = 4096, bool isLegacyFirmware = false);
+
+        SensorStream(const SensorStream&) = delete;
+        SensorStream& operator=(const SensorStream&) = delete;
+
+        // Producer (one thread): decodes a HID report received at `arrivalTimestamp` and publishes its samples,
+        // returns false if it isn't a sensor report. Feed recorded or synthetic bytes the same way
+        bool pushReport(const uint8_t* report, size_t size, uint64_t arrivalTimestamp = steadyClockTimestamp());
+
+        // Producer: publishes already decoded samples
+        void pushIMUSample(const IMUSample& imuSample);
+        void pushMagnetometerSample(const MagnetometerSample& magnetometerSample);
+        void pushEnvironmentSample(const EnvironmentSample& environmentSample);
+
+        // Interpolates the IMU to `timestamp`, returns false if it isn't between two held samples (not received yet or overwritten)
+        bool getIMUSample(uint64_t timestamp, IMUSample& imuSample);
+
+        // Fills `imuSamples` with the IMU interpolated to `startTimestamp`, every reading strictly in between, and the IMU
+        // interpolated to `endTimestamp`. Returns false if the interval isn't fully covered yet (or was overwritten),
+        // in which case `imuSamples` holds the covered part
+        bool getIMUSamples(uint64_t startTimestamp, uint64_t endTimestamp, vector<IMUSample>& imuSamples);
+
+        // The IMU between the exposures of two frames (frame timestamps shifted by the exposure offset)
+        bool getIMUSamples(const Frame& previousFrame, const Frame& frame, vector<IMUSample>& imuSamples);
+
+        bool getLatestIMUSample(IMUSample& imuSample);
+        bool getLatestMagnetometerSample(MagnetometerSample& magnetometerSample);
+        bool getLatestEnvironmentSample(EnvironmentSample& environmentSample);
+
+        // Time from the middle of a frame's exposure to its timestamp (nanoseconds, 0 by default), subtracted from frame timestamps
+        // to sync them with the IMU
+        int64_t getExposureOffset();
+        void setExposureOffset(int64_t exposureOffset);
+
+        // Number of decoded reports, and of rejected ones
+        uint64_t getReportCount();
+        uint64_t getInvalidReportCount();
+
+    private:
+        SensorReportDecoder decoder;
+
+        SensorRing<IMUSample> imuRing;
+        SensorRing<MagnetometerSample> magnetometerRing;
+        SensorRing<EnvironmentSample> environmentRing;
+
+        atomic<int64_t> exposureOffset;
+        atomic<uint64_t> reportCount;
+        atomic<uint64_t> invalidReportCount;
+
+        // Finds the held samples around `timestamp`, returns false unless `before.timestamp <= timestamp <= after.timestamp`
+        bool findIMUSamples(uint64_t timestamp, IMUSample& before, IMUSample& after);
+    };
+
+    // Linear interpolation between two IMU samples, at `timestamp` between theirs
+    IMUSample interpolateIMUSample(const IMUSample& before, const IMUSample& after, uint64_t timestamp);
+}
+
+#endif
@@ -0,0 +1,148 @@
+//
+// zed_sensor_ring.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_SENSOR_RING_H
+#define ZED_SENSOR_RING_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // Lock-free single-producer / multi-reader ring of timestamped samples
+    //
+    // The producer never waits: each push overwrites the oldest sample. Readers copy samples out by position and
+    // detect overwrites with a per-slot sequence (a seqlock), so reading never blocks or slows down the producer.
+    // Samples must be trivially copyable, with a `uint64_t timestamp` that increases from one push to the next
+    //
+    template <typename Sample> class SensorRing {
+        static_assert(is_trivially_copyable_v<Sample>, "Sensor samples must be trivially copyable");
+
+    public:
+        // Creates a ring holding the latest `capacity` samples (rounded up to a power of two)
+        SensorRing(size_t capacity) {
+            if (capacity == 0) {
+                throw runtime_error(format("Invalid sensor ring capacity: {}", capacity));
+            }
+
+            this->capacity = bit_ceil(capacity);
+            mask = this->capacity - 1;
+            slots = make_unique<Slot[]>(this->capacity);
+
+            for (size_t i = 0; i < this->capacity; i++) {
+                slots[i].sequence.store(0, memory_order_relaxed);
+            }
+
+            writeCount.store(0, memory_order_relaxed);
+        }
+
+        SensorRing(const SensorRing&) = delete;
+        SensorRing& operator=(const SensorRing&) = delete;
+
+        // Producer: appends a sample, overwriting the oldest once the ring is full
+        void push(const Sample& sample) {
+            uint64_t position = writeCount.load(memory_order_relaxed);
+            Slot& slot = slots[position & mask];
+
+            // Odd while the slot is being written, `2 * (position + 1)` once it holds the sample at `position`
+            slot.sequence.store(2 * position + 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+
+            memcpy(slot.sample, &sample, sizeof(Sample));
+
+            slot.sequence.store(2 * position + 2, memory_order_release);
+            writeCount.store(position + 1, memory_order_release);
+        }
+
+        // Reader: copies the sample at `position`, returns false if it hasn't been written yet or was overwritten
+        bool read(uint64_t position, Sample& sample) const {
+            const Slot& slot = slots[position & mask];
+            uint64_t expectedSequence = 2 * position + 2;
+
+            if (slot.sequence.load(memory_order_acquire) != expectedSequence) {
+                return false;
+            }
+
+            memcpy(&sample, slot.sample, sizeof(Sample));
+            atomic_thread_fence(memory_order_acquire);
+
+            return slot.sequence.load(memory_order_relaxed) == expectedSequence;
+        }
+
+        // Reader: copies the most recent sample, returns false if the ring is empty
+        bool readLatest(Sample& sample) const {
+            while (true) {
+                uint64_t count = writeCount.load(memory_order_acquire);
+
+                if (count == 0) {
+                    return false;
+                }
+
+                if (read(count - 1, sample)) {
+                    return true;
+                }
+            }
+        }
+
+        // Reader: position of the first sample with a timestamp at or after `timestamp` (`getWriteCount()` if there's none yet),
+        // never earlier than the oldest sample still held
+        uint64_t lowerBound(uint64_t timestamp) const {
+            uint64_t end = writeCount.load(memory_order_acquire);
+            uint64_t begin = end > capacity ? end - capacity : 0;
+            Sample sample;
+
+            while (begin < end) {
+                uint64_t middle = begin + (end - begin) / 2;
+
+                if (!read(middle, sample)) {
+                    // Overwritten while searching, only later samples are left
+                    begin = middle + 1;
+                }
+                else if (sample.timestamp < timestamp) {
+                    begin = middle + 1;
+                }
+                else {
+                    end = middle;
+                }
+            }
+
+            return begin;
+        }
+
+        // Total number of samples pushed, the position of the next sample
+        uint64_t getWriteCount() const {
+            return writeCount.load(memory_order_acquire);
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+    private:
+        struct Slot {
+            atomic<uint64_t> sequence;
+            alignas(Sample) unsigned char sample[sizeof(Sample)];
+        };
+
+        size_t capacity;
+        size_t mask;
+        unique_ptr<Slot[]> slots;
+
+        alignas(64) atomic<uint64_t> writeCount;
+    };
+}
+
+#endif
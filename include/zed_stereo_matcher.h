@@ -0,0 +1,129 @@
+//
+// zed_stereo_matcher.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_STEREO_MATCHER_H
+#define ZED_STEREO_MATCHER_H
+
+#include "zed_color_conversion.h"
+#include "zed_frame.h"
+#include "zed_thread_pool.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // Disparity output
+    //
+    // Disparities are int16 fixed point with kDisparityFractionBits fractional bits (16 x disparity in pixels, as in OpenCV),
+    // pixels without a reliable match are set to kInvalidDisparity
+    //
+    constexpr int kDisparityFractionBits = 4;
+    constexpr int16_t kInvalidDisparity = INT16_MIN;
+
+    enum StereoMatchingMode {
+        BLOCK_MATCHING, // Matching costs summed over a square window, fastest
+        SEMI_GLOBAL     // Matching costs aggregated along 5 paths with smoothness penalties (single pass semi-global matching), more complete and accurate
+    };
+
+    enum MatchingCost {
+        CENSUS,             // Hamming distance between 5x5 census transforms, robust to exposure differences between the cameras
+        ABSOLUTE_DIFFERENCE // Absolute intensity difference, truncated at 63
+    };
+
+    struct StereoMatcherSettings {
+        StereoMatchingMode mode = SEMI_GLOBAL;
+        MatchingCost matchingCost = CENSUS;
+
+        int minDisparity = 0;
+        int disparityCount = 64; // Number of disparities searched from `minDisparity`, a multiple of 16
+
+        int blockSize = 7; // BLOCK_MATCHING window width and height, odd, up to 11
+
+        // SEMI_GLOBAL penalties for disparity changes of 1 and of more than 1 pixel between neighbors (0 picks defaults for the matching cost)
+        int smallPenalty = 0;
+        int largePenalty = 0;
+
+        int uniquenessRatio = 10;    // Percent by which the best cost must beat the next best disparity (0 disables the check)
+        bool isSubpixel = true;      // Refines disparities to 1/16 pixel with a parabola through the neighboring costs
+        int leftRightTolerance = 1;  // Largest difference from the right-to-left match (negative disables the check)
+    };
+
+    struct StereoMatcherBand;
+
+    //
+    // Stereo disparity from rectified greyscale image pairs
+    //
+    // Rows are split into bands across a thread pool, each band computing its matching costs one row at a time,
+    // so the working set of a band stays in cache. Cost aggregation runs on AVX2, SSE4, or NEON vectors of disparities
+    //
+    class StereoMatcher {
+
+    public:
+        // Creates a matcher using the best instruction set for the running CPU, across `threadCount` threads (0 uses all available cores)
+        StereoMatcher(StereoMatcherSettings settings = StereoMatcherSettings(), size_t threadCount = 1);
+
+        // Creates a matcher forced to a specific instruction set (throws if the CPU doesn't support it)
+        StereoMatcher(StereoMatcherSettings settings, size_t threadCount, InstructionSet instructionSet);
+
+        ~StereoMatcher();
+
+        StereoMatcher(const StereoMatcher&) = delete;
+        StereoMatcher& operator=(const StereoMatcher&) = delete;
+
+        // Computes the disparity of every left image pixel into `disparity` (int16, see kDisparityFractionBits)
+        void compute(const uint8_t* left,
+            size_t leftRowBytes,
+            const uint8_t* right,
+            size_t rightRowBytes,
+            size_t height,
+            size_t width,
+            int16_t* disparity,
+            size_t disparityRowBytes);
+
+        // Computes the disparity of the left eye of a rectified GREYSCALE frame (any layout)
+        void compute(Frame& frame, int16_t* disparity, size_t disparityRowBytes);
+
+        StereoMatcherSettings getSettings();
+        InstructionSet getInstructionSet();
+        size_t getThreadCount();
+
+    private:
+        StereoMatcherSettings settings;
+        InstructionSet instructionSet;
+        unique_ptr<ThreadPool> threadPool;
+
+        // Census transforms of both images
+        vector<uint32_t> leftCensus;
+        vector<uint32_t> rightCensus;
+
+        // Working buffers per row band, reused between frames
+        vector<unique_ptr<StereoMatcherBand>> bands;
+    };
+
+    constexpr string stereoMatchingModeToString(StereoMatchingMode mode) {
+        switch (mode) {
+            case BLOCK_MATCHING:
+                return "BLOCK_MATCHING";
+            case SEMI_GLOBAL:
+                return "SEMI_GLOBAL";
+        }
+    }
+
+    constexpr string matchingCostToString(MatchingCost matchingCost) {
+        switch (matchingCost) {
+            case CENSUS:
+                return "CENSUS";
+            case ABSOLUTE_DIFFERENCE:
+                return "ABSOLUTE_DIFFERENCE";
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,194 @@
+//
+// zed_stereo_rectifier.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_STEREO_RECTIFIER_H
+#define ZED_STEREO_RECTIFIER_H
+
+#include "zed_calibration_data.h"
+#include "zed_color_conversion.h"
+#include "zed_frame.h"
+#include "zed_thread_pool.h"
+#include "zed_video_capture_format.h"
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace filesystem;
+
+namespace zed {
+
+    class MemoryMappedFile;
+
+    //
+    // Fixed-point remap parameters
+    //
+    // Source coordinates are stored as int16 integer parts plus a packed 5-bit x / 5-bit y fraction,
+    // the fraction indexes a table of 4 bilinear weights that sum to 2^kRemapWeightBits
+    //
+    constexpr int kRemapFractionBits = 5;
+    constexpr int kRemapFractionCount = 1 << kRemapFractionBits;
+    constexpr int kRemapWeightBits = 14;
+
+    struct RemapMap {
+        const int16_t* coordinates = nullptr; // (x, y) integer source coordinates per destination pixel
+        const uint16_t* fractions = nullptr;  // (yFraction << kRemapFractionBits) | xFraction per destination pixel
+    };
+
+    // Smallest rectangle holding the integer source coordinates of a group of destination pixels
+    struct RemapBounds {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    //
+    // Rectification cache layout
+    //
+    // [RectificationCacheHeader | left coordinates | left fractions | right coordinates | right fractions]
+    //
+    // Stored next to the calibration file as SN<serial>_<resolution>.rectification, tables start on 64-byte boundaries
+    //
+    constexpr char kRectificationCacheMagic[8] = {'Z', 'E', 'D', 'R', 'E', 'C', 'T', 'F'};
+    constexpr uint32_t kRectificationCacheVersion = 1;
+
+    struct RectificationCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t remapFractionBits;
+
+        char serialNumber[32];
+        uint64_t calibrationHash; // CalibrationData::getHash() of the calibration the maps were computed from
+        int32_t width;
+        int32_t height;
+
+        double leftProjectionMatrix[12];
+        double rightProjectionMatrix[12];
+        double disparityToDepthMatrix[16];
+
+        uint64_t coordinatesOffsets[2]; // Per eye
+        uint64_t fractionsOffsets[2];
+        uint64_t fileSize;
+    };
+
+    class StereoRectifier {
+
+    public:
+        // Computes rectification maps for the given calibration and stereo dimensions,
+        // remapping in tiles across `threadCount` threads (0 uses all available cores)
+        //
+        // When the calibration was loaded from a file, the maps and matrices are mapped from a cache next to it instead
+        // (computed and written the first time), which is rebuilt whenever the calibration file changes
+        StereoRectifier(CalibrationData& calibrationData, StereoDimensions stereoDimensions, size_t threadCount = 1);
+
+        ~StereoRectifier();
+
+        StereoRectifier(const StereoRectifier&) = delete;
+        StereoRectifier& operator=(const StereoRectifier&) = delete;
+
+        // Rectifies a side-by-side stereo frame with 1 or 3 interleaved channels
+        void rectify(const uint8_t* source, uint8_t* destination, size_t channels);
+
+        // Rectifies one eye with 1 or 3 interleaved channels
+        void rectify(Eye eye, const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, size_t channels);
+
+        // Decodes and rectifies a side-by-side YUV 4:2:2 frame tile by tile, without a full-frame intermediate, into GREYSCALE, RGB, or BGR
+        void rectifyYUV(const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, ColorSpace colorSpace);
+
+        // Decodes and rectifies a side-by-side YUV 4:2:2 frame tile by tile, writing straight into each of `destination`'s planes
+        void rectifyYUV(const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace);
+
+        // Decodes and rectifies one eye of a side-by-side YUV 4:2:2 frame tile by tile into GREYSCALE, RGB, or BGR
+        void rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, ColorSpace colorSpace);
+
+        // Decodes and rectifies a rectangle of each rectified eye, remapping only those pixels, into `destination`'s planes
+        // (whose eyes are the size of the regions)
+        void rectifyYUV(const uint8_t* source, size_t sourceRowBytes, const array<EyeRegion, 2>& regions, Frame& destination, ColorSpace colorSpace);
+
+        //
+        // Single eye variants of the frame paths that run on the calling thread instead of the rectifier's thread pool,
+        // so threads rectifying frames of their own don't wait for each other (e.g. VideoCapture's THREAD_POOL delivery)
+        //
+        void rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace);
+        void rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, const array<EyeRegion, 2>& regions, Frame& destination, ColorSpace colorSpace);
+
+        // Rectified 3x4 projection matrices (row-major)
+        array<double, 12> getLeftProjectionMatrix();
+        array<double, 12> getRightProjectionMatrix();
+
+        // 4x4 disparity-to-depth mapping matrix (row-major)
+        array<double, 16> getDisparityToDepthMatrix();
+
+        StereoDimensions getStereoDimensions();
+
+        // Remap tables for an eye
+        const RemapMap& getRemapMap(Eye eye);
+
+        // Whether the maps were mapped from an existing rectification cache rather than computed
+        bool isLoadedFromCache();
+
+        // Rectification cache for a calibration loaded from a file and stereo dimensions (empty if the calibration has no file)
+        static path cacheFilepath(const CalibrationData& calibrationData, StereoDimensions stereoDimensions);
+
+        // Looks up the 4 bilinear weights (top left, top right, bottom left, bottom right) for a packed fraction
+        static const int16_t* remapWeights(uint16_t fraction);
+
+    private:
+        StereoDimensions stereoDimensions;
+        size_t eyeWidth;
+        size_t eyeHeight;
+
+        array<double, 12> leftProjectionMatrix;
+        array<double, 12> rightProjectionMatrix;
+        array<double, 16> disparityToDepthMatrix;
+
+        RemapMap leftMap;
+        RemapMap rightMap;
+
+        // Per remap tile of each eye, found once so tiles sampling only inside the image skip the border checks
+        vector<RemapBounds> tileBounds[2];
+
+        // Storage behind the remap tables, the mapped cache file or memory when the maps aren't cached
+        shared_ptr<MemoryMappedFile> cacheFile;
+        vector<int16_t> coordinateStorage;
+        vector<uint16_t> fractionStorage;
+        bool isCached;
+
+        // Maps the cache file if it matches the calibration, returns false if it's missing or stale
+        bool loadCache(const path& filepath, const CalibrationData& calibrationData);
+
+        // Allocates the maps to compute, in a new cache file at `filepath` (or in memory if there's none or it can't be created)
+        void allocateMaps(const path& filepath, int16_t* coordinates[2], uint16_t* fractions[2]);
+
+        // Completes a new cache file's header and moves it into place at `filepath`
+        void storeCache(const path& filepath, const CalibrationData& calibrationData);
+
+        unique_ptr<ThreadPool> threadPool;
+        InstructionSet instructionSet; // Of the row conversion in the YUV paths
+
+        // Finds the bounds of every remap tile once the maps are computed or loaded
+        void computeTileBounds();
+
+        // Runs `tileTask(eye, x0, y0, x1, y1, bounds)` for every remap tile of the given eyes across the thread pool
+        void forEachTile(size_t eyeCount, Eye firstEye, const function<void(Eye, size_t, size_t, size_t, size_t, const RemapBounds&)>& tileTask);
+
+        // Decodes and rectifies `regions` of the given eyes into `destination`'s planes and pyramid levels,
+        // across the thread pool or on the calling thread
+        void rectifyYUVRegions(const uint8_t* source,
+            size_t sourceRowBytes,
+            const array<EyeRegion, 2>& regions,
+            Frame& destination,
+            ColorSpace colorSpace,
+            size_t eyeCount,
+            Eye firstEye,
+            bool isParallel);
+    };
+}
+
+#endif
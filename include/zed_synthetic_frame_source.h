@@ -0,0 +1,48 @@
+//
+// zed_synthetic_frame_source.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_SYNTHETIC_FRAME_SOURCE_H
+#define ZED_SYNTHETIC_FRAME_SOURCE_H
+
+#include "zed_frame_source.h"
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // Generates moving test patterns at any resolution and frame rate, without a camera
+    //
+    // Each eye shows a scrolling diagonal ramp and a moving square, with the right eye shifted by a fixed disparity
+    //
+    class SyntheticFrameSource : public PacedFrameSource {
+
+    public:
+        // `serialNumber` is reported as the device serial number (e.g. to load a calibration file for rectification)
+        SyntheticFrameSource(PlaybackSpeed playbackSpeed = NATIVE_SPEED, const string& serialNumber = "");
+        ~SyntheticFrameSource() override;
+
+        string getDeviceID() override;
+        string getDeviceName() override;
+        string getDeviceSerialNumber() override;
+
+    protected:
+        void prepare() override;
+        bool produceFrame(uint8_t* data, size_t rowBytes, uint64_t frameIndex) override;
+
+    private:
+        string serialNumber;
+
+        // One row of the ramp pattern, long enough to be copied from any phase
+        vector<uint8_t> rampRow;
+        size_t eyeWidth;
+        size_t disparity;
+    };
+}
+
+#endif
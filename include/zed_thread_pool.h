@@ -0,0 +1,72 @@
+//
+// zed_thread_pool.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_THREAD_POOL_H
+#define ZED_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace zed {
+
+    class ThreadPool {
+
+    public:
+        // Creates a pool that runs work on `threadCount` threads (0 uses all available cores)
+        ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Number of threads work is split across (including the calling thread)
+        size_t getThreadCount();
+
+        // Invokes `task(index)` for every index in [0, count) and blocks until all have completed. If a task throws,
+        // the indices not started yet are skipped, and the first exception is rethrown once the running tasks have returned
+        void parallelFor(size_t count, const function<void(size_t)>& task);
+
+    private:
+        vector<thread> workers;
+
+        mutex jobMutex;
+        mutex stateMutex;
+        condition_variable workCondition;
+        condition_variable doneCondition;
+
+        const function<void(size_t)>* currentTask;
+        size_t taskCount;
+        size_t nextTaskIndex;
+        size_t completedTaskCount;
+        uint64_t generation;
+        bool isStopping;
+        exception_ptr taskException; // First exception thrown by a task of the current job
+
+        // Runs tasks from the current job until none are left (expects `stateMutex` to be held)
+        void runTasks(unique_lock<mutex>& lock);
+
+        // Worker thread entry point
+        void workerLoop();
+    };
+
+    // Pins the calling thread to the core at `cpuIndex`, returns whether it took effect (on macOS it's an affinity tag,
+    // a scheduling hint that Apple silicon doesn't support)
+    bool setCurrentThreadAffinity(size_t cpuIndex);
+
+    // Raises the calling thread's priority for latency-sensitive work (user-interactive QoS on macOS, SCHED_FIFO
+    // elsewhere, which needs privileges), returns whether it took effect
+    bool setCurrentThreadHighPriority();
+}
+
+#endif
@@ -10,20 +10,81 @@
 
 #include "zed_video_capture_format.h"
 #include "zed_calibration_data.h"
+#include "zed_capture_stats.h"
+#include "zed_frame.h"
+#include "zed_frame_queue.h"
+#include "zed_frame_source.h"
+#include <chrono>
+#include <filesystem>
 #include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 
 using namespace std;
+using namespace filesystem;
 
 namespace zed {
 
+    // Where `start()` invokes the frame callback
+    enum DeliveryMode {
+        MAIN_QUEUE,       // On the main dispatch queue, one frame per block (macOS only, the default there)
+        INLINE,           // On the frame source's thread right after conversion, nothing waits (the default elsewhere)
+        DEDICATED_THREAD, // On one high-priority thread, fed through the delivery queue
+        THREAD_POOL       // Frames are converted on a pool of threads, and delivered one at a time in capture order
+    };
+
+    constexpr string deliveryModeToString(DeliveryMode deliveryMode) {
+        switch (deliveryMode) {
+            case MAIN_QUEUE:
+                return "MAIN_QUEUE";
+            case INLINE:
+                return "INLINE";
+            case DEDICATED_THREAD:
+                return "DEDICATED_THREAD";
+            case THREAD_POOL:
+                return "THREAD_POOL";
+        }
+    }
+
+    struct DeliveryOptions {
+#ifdef __APPLE__
+        DeliveryMode deliveryMode = MAIN_QUEUE;
+#else
+        DeliveryMode deliveryMode = INLINE;
+#endif
+
+        // THREAD_POOL threads (0 uses all available cores)
+        size_t threadCount = 0;
+
+        // Cores the delivery threads are pinned to, one per thread in turn (empty leaves them to the scheduler,
+        // see `setCurrentThreadAffinity()`)
+        vector<size_t> cpuAffinity = {};
+    };
+
     struct VideoCaptureImpl;
 
     class VideoCapture {
 
     public:
+#ifdef __APPLE__
+        // Captures from a ZED camera
         VideoCapture();
+
+        // Captures from the ZED camera with the given device ID or serial number (see `listDevices()`)
+        VideoCapture(const string& device);
+
+        // ZED cameras attached to the system
+        static vector<DeviceInfo> listDevices();
+#endif
+
+        // Captures from any frame source (e.g. SyntheticFrameSource or FileFrameSource)
+        VideoCapture(shared_ptr<FrameSource> frameSource);
         ~VideoCapture();
 
+        VideoCapture(const VideoCapture&) = delete;
+        VideoCapture& operator=(const VideoCapture&) = delete;
+
         string getDeviceID();
         string getDeviceName();
         string getDeviceSerialNumber();
@@ -68,9 +129,39 @@ namespace zed {
         void turnOffLED();
         void toggleLED();
 
-        StereoDimensions open(ColorSpace colorSpace);
+        // Applies several control changes at once, with one transfer per changed control (controls already at the
+        // requested value are skipped). Setting a white balance temperature turns automatic white balance off
+        void applySettings(const CameraSettings& cameraSettings);
+
+        // Sets the number of threads used for color conversion (0 uses all available cores), call before `open()`
+        void setConversionThreadCount(size_t threadCount);
+
+        // Sets how delivered frames are laid out (SIDE_BY_SIDE by default), call before `open()`. Separated layouts are
+        // written directly by the conversion pass into 64-byte aligned planes per eye (see `Frame::getPlane()`),
+        // so native frames are then copied once rather than shared
+        void setFrameLayout(FrameLayout frameLayout);
+
+        // Sets the number of pyramid levels delivered with each frame, including the full resolution frame (1, no pyramid,
+        // by default, up to kMaxPyramidLevelCount, YUV frames have none), call before `open()`. Each level halves the previous one per eye (2x2 average),
+        // built by the conversion pass while the rows it downsamples are still in cache (see `Frame::getPyramidLevel()`)
+        void setPyramidLevelCount(size_t levelCount);
+
+        // Converts and delivers only a rectangle of each eye to the capture's own callback or `grab()` (subscribers still
+        // get whole frames), in pixels of the eye, or of the rectified eye once frames are rectified. Only those pixels are
+        // read and converted, into compact frames the size of the regions (see `Frame::getRegion()`). Both regions have
+        // the same size, with an even x and width. Takes effect from the next frame, call after `open()`
+        void setRegionOfInterest(EyeRegion leftRegion, EyeRegion rightRegion);
+
+        // Crops both eyes to the same region
+        void setRegionOfInterest(EyeRegion region);
+
+        // Delivers whole frames again from the next frame
+        void clearRegionOfInterest();
 
-        template <Resolution resolution, FrameRate frameRate> StereoDimensions open(ColorSpace colorSpace) {
+        // Opens the stream, with RECTIFIED decoding and rectifying frames straight from the native YUV 4:2:2 buffer
+        StereoDimensions open(ColorSpace colorSpace, Rectification rectification = RAW);
+
+        template <Resolution resolution, FrameRate frameRate> StereoDimensions open(ColorSpace colorSpace, Rectification rectification = RAW) {
             // Verify frame rate for resolution at compile-time
             if constexpr (resolution == HD2K) {
                 static_assert(frameRate == FPS_15, "Invalid frame rate for HD2K resolution, available frame rates: FPS_15");
@@ -90,19 +181,95 @@ namespace zed {
                 static_assert(false, "Unsupported resolution");
             }
 
-            return open(resolution, frameRate, colorSpace);
+            return open(resolution, frameRate, colorSpace, rectification);
         }
 
         void close();
 
-        void start(function<void(uint8_t*, size_t, size_t, size_t)> frameProcessor);
+        // Delivers each frame as a reference-counted handle, frames can be kept beyond the callback without copying
+        // (on the main queue on macOS, where up to `queueCapacity` frames wait under `backpressurePolicy`,
+        // and on the frame source's thread elsewhere, where nothing waits)
+        void start(function<void(Frame)> frameProcessor, BackpressurePolicy backpressurePolicy = DROP_NEWEST, size_t queueCapacity = 16);
+
+        // Delivers each frame as described by `deliveryOptions`. Up to `queueCapacity` frames wait under `backpressurePolicy`
+        // for the main queue or the dedicated thread, or for a pool thread to convert them (THREAD_POOL, where each
+        // thread also converts its frame, and the callback is never called concurrently). THREAD_POOL frames wait unconverted,
+        // holding the source's raw buffers, so fewer wait if the source can't lend `queueCapacity` of them
+        void start(function<void(Frame)> frameProcessor,
+            const DeliveryOptions& deliveryOptions,
+            BackpressurePolicy backpressurePolicy = DROP_NEWEST,
+            size_t queueCapacity = 16);
+
+        // Delivers each frame as a raw buffer that is only valid for the duration of the callback. Only SIDE_BY_SIDE frames
+        // fit in one buffer, throws for other frame layouts (use the Frame callback to get each plane)
+        void start(function<void(uint8_t*, size_t, size_t, size_t)> frameProcessor, BackpressurePolicy backpressurePolicy = DROP_NEWEST, size_t queueCapacity = 16);
+
+        // Delivers each frame as a raw buffer as described by `deliveryOptions`, throws for frame layouts other than SIDE_BY_SIDE
+        void start(function<void(uint8_t*, size_t, size_t, size_t)> frameProcessor,
+            const DeliveryOptions& deliveryOptions,
+            BackpressurePolicy backpressurePolicy = DROP_NEWEST,
+            size_t queueCapacity = 16);
+
+        // Starts capturing into a queue of `queueCapacity` frames for polling with `grab()` / `retrieve()`,
+        // frames are handed over on the capture thread without a hop to the main queue
+        void start(BackpressurePolicy backpressurePolicy = DROP_NEWEST, size_t queueCapacity = 4);
+
         void stop();
 
+        // Waits up to `timeout` for the next frame, returns false if none arrived
+        bool grab(chrono::milliseconds timeout = chrono::milliseconds(1000));
+
+        // Returns the most recently grabbed frame
+        Frame retrieve();
+
+        // Adds a consumer that receives every frame in `colorSpace` on its own thread, through its own queue of `queueCapacity`
+        // frames under `backpressurePolicy`, so a slow subscriber only drops its own frames. Each color space is converted
+        // at most once per frame and shared read-only between subscribers (and the capture's own consumer), YUV subscribers
+        // get the native unrectified frames. Frames arrive while the capture is started, call after `open()`
+        size_t subscribe(ColorSpace colorSpace, function<void(Frame)> frameProcessor, BackpressurePolicy backpressurePolicy = DROP_NEWEST, size_t queueCapacity = 4);
+
+        // Stops a subscriber's deliveries and waits for its callback to return (unless called from that callback)
+        void unsubscribe(size_t subscriptionID);
+
+        // Number of frames a subscriber's backpressure policy dropped
+        uint64_t getSubscriberDroppedFrameCount(size_t subscriptionID);
+
+        // Number of frames dropped by the backpressure policy (see `getStats()` for all counters)
+        uint64_t getDroppedFrameCount();
+
+        // Counters and latency histograms for the capture so far, cheap enough to poll while capturing
+        CaptureStats getStats();
+
+        // Zeroes the counters and histograms (e.g. after warm-up)
+        void resetStats();
+
+        // Records the native frames (before conversion) to a memory-mapped recording with room for `maxFrameCount` frames,
+        // the capture thread never waits on the disk (see `RecordingWriter`), call after `open()`
+        void startRecording(const path& filepath, size_t maxFrameCount);
+
+        // Writes the remaining queued frames and closes the recording
+        void stopRecording();
+
+        bool isRecording();
+
+        // Number of frames left out of the recording because the writer fell behind or the recording was full
+        uint64_t getRecordingDroppedFrameCount();
+
+        // Reads the calibration from the device, or the file cache, downloading it if necessary (see `setCalibrationDownloadURL()`)
         CalibrationData getCalibrationData();
 
+        // Loads the calibration and precomputes the rectification maps on a background thread, call after `open()` (RAW,
+        // in GREYSCALE, RGB, or BGR). Frames keep flowing unrectified meanwhile, and are rectified from the first one
+        // processed after the maps are ready (see `Frame::getRectification()`). The future holds the calibration once
+        // it's in use, or the error that kept the capture unrectified. `close()` waits for a load in progress
+        future<CalibrationData> loadCalibrationAsync();
+
+        // Sets the URL calibration files are downloaded from, followed by the numeric serial number (kCalibrationDownloadURL by default)
+        void setCalibrationDownloadURL(const string& downloadURL);
+
     private:
         VideoCaptureImpl* impl;
-        StereoDimensions open(Resolution resolution, FrameRate frameRate, ColorSpace colorSpace);
+        StereoDimensions open(Resolution resolution, FrameRate frameRate, ColorSpace colorSpace, Rectification rectification);
     };
 }
 
@@ -35,6 +35,16 @@ namespace zed {
         BGR        // 3 channels                        (8-bit)
     };
 
+    enum Rectification {
+        RAW,      // Frames as captured by the sensors
+        RECTIFIED // Frames undistorted and rectified with the device calibration (GREYSCALE, RGB, and BGR only)
+    };
+
+    enum Eye {
+        LEFT, // Left half of a side-by-side stereo frame
+        RIGHT // Right half of a side-by-side stereo frame
+    };
+
     struct StereoDimensions {
 
         int width;
@@ -45,7 +55,7 @@ namespace zed {
             height = 0;
         }
 
-        StereoDimensions(Resolution resolution) {
+        StereoDimensions(Resolution resolution) : StereoDimensions() {
             switch (resolution) {
                 case HD2K:
                     width = 2208 * 2;
@@ -71,6 +81,18 @@ namespace zed {
         }
     };
 
+    // Rectangle within one eye's image, in pixels from its top left corner
+    struct EyeRegion {
+        size_t x = 0;
+        size_t y = 0;
+        size_t width = 0;
+        size_t height = 0;
+
+        constexpr string toString() const {
+            return format("{} x {} at ({}, {})", width, height, x, y);
+        }
+    };
+
     constexpr string resolutionToString(Resolution resolution) {
         switch (resolution) {
             case HD2K:
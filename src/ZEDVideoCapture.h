@@ -5,6 +5,9 @@
 // Created by Christian Bator on 01/11/2025
 //
 
+#include "../include/zed_camera_controls.h"
+#include "../include/zed_frame.h"
+#include "../include/zed_frame_source.h"
 #include "../include/zed_video_capture_format.h"
 #include <Foundation/Foundation.h>
 
@@ -40,15 +43,35 @@
 - (void)resetWhiteBalanceTemperature;
 - (void)resetAutoWhiteBalanceTemperature;
 
+// Applies a batch of control changes, skipping controls that already have the requested value
+- (void)applySettings:(const zed::CameraSettings&)cameraSettings;
+
+// Calibration file contents stored in the camera's flash (throws if missing or corrupt)
+- (std::string)readCalibration;
+
 @property (nonatomic, readonly) BOOL isLEDOn;
 - (void)turnOnLED;
 - (void)turnOffLED;
 - (void)toggleLED;
 
+// ZED cameras attached to the system (serial numbers are empty when they can't be read)
++ (std::vector<zed::DeviceInfo>)availableDevices;
+
+// Opens the stream of the first ZED camera with raw frames in `colorSpace` (YUV or GREYSCALE)
 - (BOOL)openWithResolution:(zed::Resolution)resolution frameRate:(zed::FrameRate)frameRate colorSpace:(zed::ColorSpace)colorSpace;
+
+// Opens the stream of the ZED camera with the given device ID or serial number (the first one when nil)
+- (BOOL)openWithResolution:(zed::Resolution)resolution
+                 frameRate:(zed::FrameRate)frameRate
+                colorSpace:(zed::ColorSpace)colorSpace
+                    device:(NSString* _Nullable)deviceIDOrSerialNumber;
 - (void)close;
 
-- (void)start:(void (^_Nonnull)(uint8_t* _Nonnull, size_t, size_t, size_t))frameProcessingBlock;
+// Invokes `frameProcessingBlock` on the capture queue for each raw frame, each frame references its pixel buffer without copying
+- (void)start:(void (^_Nonnull)(zed::Frame))frameProcessingBlock;
 - (void)stop;
 
+// Raw frames the capture can lend at once, frames arriving while they're all held are dropped
+@property (nonatomic, readonly) NSUInteger rawFrameCapacity;
+
 @end
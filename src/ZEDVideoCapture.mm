@@ -6,8 +6,9 @@
 //
 
 #import "ZEDVideoCapture.h"
+#import "../include/zed_camera_controls.h"
+#import "../include/zed_color_conversion.h"
 #import <AVFoundation/AVFoundation.h>
-#import <Accelerate/Accelerate.h>
 #import <CoreGraphics/CoreGraphics.h>
 #import <CoreMedia/CoreMedia.h>
 #import <CoreVideo/CoreVideo.h>
@@ -15,45 +16,99 @@
 #import <IOKit/IOCFPlugIn.h>
 #import <IOKit/IOKitLib.h>
 #import <IOKit/usb/IOUSBLib.h>
+#include <format>
+#include <stdexcept>
 
 //
-// UVC Interface
+// Greyscale
 //
-#define kUVCUnitID 3
-#define kUVCControlValueSizeInBytes 2
-
-typedef NS_ENUM(UInt8, UVCRequestType) { UVCRequestTypeIn = 0xa1, UVCRequestTypeOut = 0x21 };
-typedef NS_ENUM(UInt8, UVCRequest) { UVCRequestGetCurrent = 0x81, UVCRequestSetCurrent = 0x01 };
+#define kLumaFramePoolCapacity 4
 
 //
-// UVC Control Codes
+// Serial Number
 //
-typedef NS_ENUM(UInt8, UVCControlCode) {
-    UVCBrightness = 2,
-    UVCContrast = 3,
-    UVCHue = 6,
-    UVCSaturation = 7,
-    UVCSharpness = 8,
-    UVCWhiteBalanceTemperature = 10,
-    UVCAutoWhiteBalanceTemperature = 11
-};
+#define kSerialNumberAddress 0x18000
+#define kSerialNumberSizeInBytes 6
 
 //
-// ZED Extension Unit Interface
+// IOKitControlTransport
 //
-#define kXUID 4
-#define kXUControlSelector 2
-#define kXUBufferSizeInBytes 384
+// Control transfers over the camera's USB device and UVC interfaces, both opened once for the capture's lifetime
+// (UVC processing unit requests go to the video control interface, extension unit requests to the device)
+//
+class IOKitControlTransport : public zed::ControlTransport {
 
-typedef NS_ENUM(UInt8, XURequestType) { XURequestTypeIn = 0xa0, XURequestTypeOut = 0x20 };
-typedef NS_ENUM(UInt8, XURequest) { XUReadRequest, XUWriteRequest };
-typedef NS_ENUM(UInt8, GPIONumber) { GPIONumberLED = 2 };
-typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn = 1 };
+public:
+    IOKitControlTransport(IOUSBDeviceInterface300** deviceInterface, IOUSBInterfaceInterface300** uvcInterface) {
+        this->deviceInterface = deviceInterface;
+        this->uvcInterface = uvcInterface;
 
-//
-// Parameters
-//
-#define kMaxFrameBacklog 15
+        // Exclusive access means the system already holds the device open, requests still go through
+        IOReturn result = (*deviceInterface)->USBDeviceOpen(deviceInterface);
+
+        if (result != kIOReturnSuccess && result != kIOReturnExclusiveAccess) {
+            (*deviceInterface)->Release(deviceInterface);
+            throw std::runtime_error("Failed to open USB device for control requests");
+        }
+
+        isDeviceOpen = result == kIOReturnSuccess;
+
+        result = (*uvcInterface)->USBInterfaceOpen(uvcInterface);
+
+        if (result != kIOReturnSuccess && result != kIOReturnExclusiveAccess) {
+            close();
+            throw std::runtime_error("Failed to open USB interface for control requests");
+        }
+
+        isInterfaceOpen = result == kIOReturnSuccess;
+    }
+
+    ~IOKitControlTransport() override {
+        close();
+    }
+
+    void transfer(zed::ControlTransfer& controlTransfer) override {
+        IOUSBDevRequest request = {.bmRequestType = controlTransfer.requestType,
+            .bRequest = controlTransfer.request,
+            .wValue = controlTransfer.value,
+            .wIndex = controlTransfer.index,
+            .wLength = controlTransfer.length,
+            .pData = controlTransfer.data};
+
+        bool isInterfaceRequest = (controlTransfer.requestType & 0x1f) == kUSBInterface;
+        IOReturn result = isInterfaceRequest ? (*uvcInterface)->ControlRequest(uvcInterface, 0, &request)
+                                             : (*deviceInterface)->DeviceRequest(deviceInterface, &request);
+
+        if (result != kIOReturnSuccess) {
+            throw std::runtime_error(std::format("Failed to send control request {:#x} to unit {} (IOReturn {:#x})",
+                controlTransfer.request,
+                controlTransfer.index >> 8,
+                (uint32_t)result));
+        }
+    }
+
+private:
+    IOUSBDeviceInterface300** deviceInterface;
+    IOUSBInterfaceInterface300** uvcInterface; // Released by ZEDVideoCapture
+    bool isDeviceOpen = false;
+    bool isInterfaceOpen = false;
+
+    void close() {
+        if (isInterfaceOpen) {
+            (*uvcInterface)->USBInterfaceClose(uvcInterface);
+            isInterfaceOpen = false;
+        }
+
+        if (deviceInterface) {
+            if (isDeviceOpen) {
+                (*deviceInterface)->USBDeviceClose(deviceInterface);
+            }
+
+            (*deviceInterface)->Release(deviceInterface);
+            deviceInterface = nil;
+        }
+    }
+};
 
 //
 // ZEDVideoCapture
@@ -69,24 +124,42 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 @property (nonatomic, strong, nullable) AVCaptureDevice* device;
 @property (nonatomic, strong, nullable) AVCaptureDeviceFormat* desiredFormat;
 @property (nonatomic, assign) CMTime desiredFrameDuration;
-@property (nonatomic, strong, nullable) void (^frameProcessingBlock)(uint8_t* data, size_t height, size_t width, size_t channels);
+@property (nonatomic, strong, nullable) void (^frameProcessingBlock)(zed::Frame frame);
 
 @property (nonatomic, strong, nonnull) dispatch_queue_t frameProcessingQueue;
-@property (nonatomic, assign) int frameBacklogCount;
+@property (nonatomic, assign) uint64_t frameSequenceNumber;
 
 @property (nonatomic, assign) io_service_t usbDevice;
 @property (nonatomic, assign) IOUSBInterfaceInterface300** uvcInterface;
 
-@property (nonatomic, assign) vImage_Buffer sourceImageBuffer;
-@property (nonatomic, assign) vImage_Buffer destinationImageBuffer;
-@property (nonatomic, strong, nonnull) NSLock *destinationImageBufferLock;
-
 @property (nonatomic, assign) BOOL isOpen;
 @property (nonatomic, assign) BOOL isRunning;
 
 @end
 
-@implementation ZEDVideoCapture
+// Serial number stored in the camera's flash, nil if there is none
+static NSString* _Nullable readSerialNumber(zed::ControlSession& controlSession) {
+    uint8_t data[kSerialNumberSizeInBytes] = {0};
+
+    controlSession.readFlash(kSerialNumberAddress, kSerialNumberSizeInBytes, data);
+
+    if (data[0] != 'O' || data[1] != 'V') {
+        return nil;
+    }
+
+    int intValue = (data[2] << 24) + (data[3] << 16) + (data[4] << 8) + data[5];
+
+    return [NSString stringWithFormat:@"%x", intValue];
+}
+
+@implementation ZEDVideoCapture {
+    // GREYSCALE frames are deinterleaved from the native 4:2:2 buffers into pooled buffers
+    std::shared_ptr<zed::FramePool> _lumaFramePool;
+    std::unique_ptr<zed::ColorConverter> _lumaConverter;
+
+    // Camera controls, with the USB interfaces held open while the capture is open
+    std::shared_ptr<zed::ControlSession> _controlSession;
+}
 
 #pragma mark - Public Interface
 
@@ -102,8 +175,6 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     _defaultAutoWhiteBalanceTemperature = YES;
 
     _frameProcessingQueue = dispatch_queue_create("co.bator.zed-video-capture-mac", DISPATCH_QUEUE_SERIAL);
-    _frameBacklogCount = 0;
-    _destinationImageBufferLock = [[NSLock alloc] init];
 
     _isOpen = NO;
     _isRunning = NO;
@@ -111,7 +182,27 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     return self;
 }
 
++ (std::vector<zed::DeviceInfo>)availableDevices {
+    std::vector<zed::DeviceInfo> devices;
+    ZEDVideoCapture* videoCapture = [[ZEDVideoCapture alloc] init];
+
+    for (AVCaptureDevice* device in [ZEDVideoCapture zedDevices]) {
+        NSString* serialNumber = [videoCapture serialNumberForDevice:device];
+
+        devices.push_back({[device.uniqueID UTF8String], [device.localizedName UTF8String], serialNumber ? [serialNumber UTF8String] : ""});
+    }
+
+    return devices;
+}
+
 - (BOOL)openWithResolution:(zed::Resolution)resolution frameRate:(zed::FrameRate)frameRate colorSpace:(zed::ColorSpace)colorSpace {
+    return [self openWithResolution:resolution frameRate:frameRate colorSpace:colorSpace device:nil];
+}
+
+- (BOOL)openWithResolution:(zed::Resolution)resolution
+                 frameRate:(zed::FrameRate)frameRate
+                colorSpace:(zed::ColorSpace)colorSpace
+                    device:(NSString* _Nullable)deviceIDOrSerialNumber {
     //
     // Initialization
     //
@@ -119,6 +210,10 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
         @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Attempted to open an already open ZEDVideoCapture instance" userInfo:nil];
     }
 
+    if (colorSpace != zed::YUV && colorSpace != zed::GREYSCALE) {
+        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Raw frames are only available in the YUV and GREYSCALE color spaces" userInfo:nil];
+    }
+
     AVCaptureSession* session = [[AVCaptureSession alloc] init];
     [session beginConfiguration];
 
@@ -129,21 +224,17 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     //
     AVCaptureDevice* device = nil;
 
-    NSArray* zedDevices = [AVCaptureDeviceDiscoverySession discoverySessionWithDeviceTypes:@[AVCaptureDeviceTypeExternal]
-                                                                                 mediaType:AVMediaTypeVideo
-                                                                                  position:AVCaptureDevicePositionUnspecified]
-                              .devices;
-
-    for (AVCaptureDevice* zedDevice in zedDevices) {
-        NSString* deviceName = zedDevice.localizedName;
-        if ([deviceName rangeOfString:@"ZED" options:NSCaseInsensitiveSearch].location != NSNotFound) {
+    for (AVCaptureDevice* zedDevice in [ZEDVideoCapture zedDevices]) {
+        // Device IDs are matched first, serial numbers are only read when needed
+        if (!deviceIDOrSerialNumber || [zedDevice.uniqueID isEqualToString:deviceIDOrSerialNumber] ||
+            [[self serialNumberForDevice:zedDevice] isEqualToString:deviceIDOrSerialNumber]) {
             device = zedDevice;
             break;
         }
     }
 
     if (!device) {
-        NSLog(@"Failed to find a ZED device");
+        NSLog(@"Failed to find a ZED device%@", deviceIDOrSerialNumber ? [NSString stringWithFormat:@" matching %@", deviceIDOrSerialNumber] : @"");
         return NO;
     }
 
@@ -165,6 +256,14 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
         return NO;
     }
 
+    std::shared_ptr<zed::ControlSession> controlSession = [self openControlSessionForUSBDevice:usbDevice uvcInterface:uvcInterface];
+
+    if (!controlSession) {
+        (*uvcInterface)->Release(uvcInterface);
+        IOObjectRelease(usbDevice);
+        return NO;
+    }
+
     //
     // Format Detection
     //
@@ -230,26 +329,13 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     NSMutableDictionary* outputVideoSettings =
         @{(id)kCVPixelBufferWidthKey: @(stereoDimensions.width), (id)kCVPixelBufferHeightKey: @(stereoDimensions.height)}.mutableCopy;
 
-    switch (colorSpace) {
-        case zed::YUV:
-            outputVideoSettings[(id)kCVPixelBufferPixelFormatTypeKey] = @(kCVPixelFormatType_422YpCbCr8_yuvs);
-            break;
-        case zed::GREYSCALE:
-            outputVideoSettings[(id)kCVPixelBufferPixelFormatTypeKey] = @(kCVPixelFormatType_420YpCbCr8BiPlanarFullRange);
-            break;
-        case zed::RGB:
-        case zed::BGR:
-            _sourceImageBuffer.height = stereoDimensions.height;
-            _sourceImageBuffer.width = stereoDimensions.width;
-            _sourceImageBuffer.rowBytes = stereoDimensions.width * 4;
-
-            _destinationImageBuffer.height = stereoDimensions.height;
-            _destinationImageBuffer.width = stereoDimensions.width;
-            _destinationImageBuffer.rowBytes = stereoDimensions.width * 3;
-            _destinationImageBuffer.data = malloc(stereoDimensions.height * stereoDimensions.width * 3);
-
-            outputVideoSettings[(id)kCVPixelBufferPixelFormatTypeKey] = colorSpace == zed::RGB ? @(kCVPixelFormatType_32ARGB) : @(kCVPixelFormatType_32BGRA);
-            break;
+    // Always the native 4:2:2 format, any other format makes the system transcode every frame
+    // (greyscale is extracted from it, see `captureOutput:didOutputSampleBuffer:fromConnection:`)
+    outputVideoSettings[(id)kCVPixelBufferPixelFormatTypeKey] = @(kCVPixelFormatType_422YpCbCr8_yuvs);
+
+    if (colorSpace == zed::GREYSCALE) {
+        _lumaFramePool = zed::FramePool::create(kLumaFramePoolCapacity, stereoDimensions.height, stereoDimensions.width, 1);
+        _lumaConverter = std::make_unique<zed::ColorConverter>(1);
     }
 
     output.videoSettings = outputVideoSettings;
@@ -275,6 +361,7 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 
     _usbDevice = usbDevice;
     _uvcInterface = uvcInterface;
+    _controlSession = controlSession;
 
     NSLog(@"Stream opened for %@ (stereo dimensions: %s, frame rate: %d fps, "
           @"color space: %s)",
@@ -288,6 +375,73 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     return YES;
 }
 
++ (NSArray<AVCaptureDevice*>* _Nonnull)zedDevices {
+    NSArray* devices = [AVCaptureDeviceDiscoverySession discoverySessionWithDeviceTypes:@[AVCaptureDeviceTypeExternal]
+                                                                              mediaType:AVMediaTypeVideo
+                                                                               position:AVCaptureDevicePositionUnspecified]
+                           .devices;
+
+    NSMutableArray<AVCaptureDevice*>* zedDevices = [NSMutableArray array];
+
+    for (AVCaptureDevice* device in devices) {
+        if ([device.localizedName rangeOfString:@"ZED" options:NSCaseInsensitiveSearch].location != NSNotFound) {
+            [zedDevices addObject:device];
+        }
+    }
+
+    return zedDevices;
+}
+
+- (std::shared_ptr<zed::ControlSession>)openControlSessionForUSBDevice:(io_service_t)usbDevice uvcInterface:(IOUSBInterfaceInterface300**)uvcInterface {
+    IOUSBDeviceInterface300** deviceInterface = [self findDeviceInterfaceForUSBDevice:usbDevice];
+
+    if (!deviceInterface) {
+        NSLog(@"Failed to find a USB device interface");
+        return nullptr;
+    }
+
+    try {
+        return std::make_shared<zed::ControlSession>(std::make_shared<IOKitControlTransport>(deviceInterface, uvcInterface));
+    }
+    catch (const std::exception& error) {
+        NSLog(@"%s", error.what());
+        return nullptr;
+    }
+}
+
+// Reads a camera's serial number over a short-lived control session, nil if it can't be read
+- (NSString* _Nullable)serialNumberForDevice:(AVCaptureDevice*)device {
+    io_service_t usbDevice = [self findUSBDeviceWithID:device.uniqueID];
+
+    if (!usbDevice) {
+        return nil;
+    }
+
+    NSString* serialNumber = nil;
+    IOUSBInterfaceInterface300** uvcInterface = [self findUVCInterfaceForUSBDevice:usbDevice];
+
+    if (uvcInterface) {
+        std::shared_ptr<zed::ControlSession> controlSession = [self openControlSessionForUSBDevice:usbDevice uvcInterface:uvcInterface];
+
+        if (controlSession) {
+            try {
+                serialNumber = readSerialNumber(*controlSession);
+            }
+            catch (const std::exception& error) {
+                NSLog(@"Failed to read the serial number of %@: %s", device.localizedName, error.what());
+            }
+        }
+
+        // Closes the USB interfaces before the UVC interface is released
+        controlSession.reset();
+        (*uvcInterface)->Release(uvcInterface);
+    }
+
+    IOObjectRelease(usbDevice);
+
+    return serialNumber;
+}
+
 - (io_service_t)findUSBDeviceWithID:(NSString*)uniqueID {
     io_iterator_t usbDeviceIterator;
     kern_return_t usbQueryResult = IOServiceGetMatchingServices(kIOMainPortDefault, IOServiceMatching(kIOUSBDeviceClassName), &usbDeviceIterator);
@@ -340,6 +494,26 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     return usbDevice;
 }
 
+- (IOUSBDeviceInterface300** _Nullable)findDeviceInterfaceForUSBDevice:(io_service_t)usbDevice {
+    IOCFPlugInInterface** plugInInterface = nil;
+    SInt32 score;
+    kern_return_t kernelResult = IOCreatePlugInInterfaceForService(usbDevice, kIOUSBDeviceUserClientTypeID, kIOCFPlugInInterfaceID, &plugInInterface, &score);
+
+    if ((kernelResult != kIOReturnSuccess) || !plugInInterface) {
+        return nil;
+    }
+
+    IOUSBDeviceInterface300** deviceInterface = nil;
+    IOReturn ioResult = (*plugInInterface)->QueryInterface(plugInInterface, CFUUIDGetUUIDBytes(kIOUSBDeviceInterfaceID), (LPVOID*)&deviceInterface);
+    IODestroyPlugInInterface(plugInInterface);
+
+    if ((ioResult != 0) || !deviceInterface) {
+        return nil;
+    }
+
+    return deviceInterface;
+}
+
 - (IOUSBInterfaceInterface300** _Nullable)findUVCInterfaceForUSBDevice:(io_service_t)usbDevice {
     IOCFPlugInInterface** plugInInterface = nil;
     SInt32 score;
@@ -405,6 +579,9 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
         _device = nil;
         _session = nil;
 
+        // Closes the USB interfaces before the UVC interface is released
+        _controlSession.reset();
+
         if (_uvcInterface) {
             (*_uvcInterface)->Release(_uvcInterface);
         }
@@ -417,19 +594,17 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 
         _usbDevice = 0;
 
-        if (_destinationImageBuffer.data) {
-            free(_destinationImageBuffer.data);
-            _destinationImageBuffer.data = nil;
-        }
-
         _deviceID = nil;
         _deviceName = nil;
 
+        _lumaFramePool.reset();
+        _lumaConverter.reset();
+
         _isOpen = NO;
     }
 }
 
-- (void)start:(void (^)(uint8_t*, size_t, size_t, size_t))frameProcessingBlock {
+- (void)start:(void (^)(zed::Frame))frameProcessingBlock {
     if (!_isOpen) {
         @throw [NSException exceptionWithName:@"ZEDVideoCaptureRuntimeError"
                                        reason:@"Attempted to start an unopened ZEDVideoCapture, "
@@ -444,6 +619,7 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
     }
 
     _frameProcessingBlock = [frameProcessingBlock copy];
+    _frameSequenceNumber = 0;
 
     NSAssert(_session != nil, @"Unexpectedly found nil session in `start()`");
     [_session startRunning];
@@ -465,115 +641,46 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
         return;
     }
 
-    if (_frameBacklogCount > kMaxFrameBacklog) {
-        NSLog(@"Warning: dropped frame (backlog of %d frames)", _frameBacklogCount);
-        return;
-    }
-
-    _frameBacklogCount++;
-
-    __weak ZEDVideoCapture* weakSelf = self;
-
     CVPixelBufferRef pixelBuffer = CMSampleBufferGetImageBuffer(sampleBuffer);
     CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+    CFRetain(pixelBuffer);
 
     size_t height = CVPixelBufferGetHeight(pixelBuffer);
     size_t width = CVPixelBufferGetWidth(pixelBuffer);
 
-    if (_colorSpace == zed::YUV) {
-        CFRetain(pixelBuffer);
-        uint8_t* yuvData = (uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer);
-
-        dispatch_async(dispatch_get_main_queue(), ^{
-            if (weakSelf && weakSelf.frameProcessingBlock) {
-                weakSelf.frameProcessingBlock(yuvData, height, width, 2);
-                
-                dispatch_async(weakSelf.frameProcessingQueue, ^{
-                    if (weakSelf) {
-                        weakSelf.frameBacklogCount--;
-                    }
-                });
-            }
+    // The frame references the pixel buffer, which stays locked until the last copy of the frame is released
+    uint8_t* data = (uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer);
+    size_t rowBytes = CVPixelBufferGetBytesPerRow(pixelBuffer);
 
-            CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-            CFRelease(pixelBuffer);
-        });
-    }
-    else if (_colorSpace == zed::GREYSCALE) {
-        CFRetain(pixelBuffer);
-        uint8_t* greyscaleData = (uint8_t*)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0);
-        
-        dispatch_async(dispatch_get_main_queue(), ^{
-            if (weakSelf && weakSelf.frameProcessingBlock) {
-                weakSelf.frameProcessingBlock(greyscaleData, height, width, 1);
-                
-                dispatch_async(weakSelf.frameProcessingQueue, ^{
-                    if (weakSelf) {
-                        weakSelf.frameBacklogCount--;
-                    }
-                });
-            }
-
-            CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-            CFRelease(pixelBuffer);
-        });
-    }
-    else if (_colorSpace == zed::RGB) {
-        _sourceImageBuffer.data = (uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer);
-
-        [_destinationImageBufferLock lock];
-        vImage_Error conversionError = vImageConvert_ARGB8888toRGB888(&_sourceImageBuffer, &_destinationImageBuffer, kvImageNoFlags);
+    zed::Frame frame = zed::Frame::wrap(data, height, width, 2, rowBytes, [pixelBuffer]() {
         CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-        [_destinationImageBufferLock unlock];
-
-        if (conversionError < 0) {
-            @throw [NSException exceptionWithName:@"ZEDVideoCaptureRuntimeError" reason:@"Failed to convert video frame to RGB color space" userInfo:nil];
-        }
+        CFRelease(pixelBuffer);
+    });
 
-        uint8_t* rgbData = (uint8_t*)_destinationImageBuffer.data;
+    if (_colorSpace == zed::GREYSCALE) {
+        zed::Frame lumaFrame = _lumaFramePool->acquire();
 
-        dispatch_async(dispatch_get_main_queue(), ^{
-            if (weakSelf && weakSelf.frameProcessingBlock) {
-                [weakSelf.destinationImageBufferLock lock];
-                weakSelf.frameProcessingBlock(rgbData, height, width, 3);
-                [weakSelf.destinationImageBufferLock unlock];
+        if (!lumaFrame.isValid()) {
+            NSLog(@"Dropped greyscale frame (all %d frame buffers in use)", kLumaFramePoolCapacity);
+            return;
+        }
 
-                dispatch_async(weakSelf.frameProcessingQueue, ^{
-                    if (weakSelf) {
-                        weakSelf.frameBacklogCount--;
-                    }
-                });
-            }
-        });
+        _lumaConverter->convert(data, rowBytes, lumaFrame, zed::GREYSCALE);
+        frame = lumaFrame;
     }
-    else if (_colorSpace == zed::BGR) {
-        _sourceImageBuffer.data = (uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer);
 
-        [_destinationImageBufferLock lock];
-        vImage_Error conversionError = vImageConvert_BGRA8888toBGR888(&_sourceImageBuffer, &_destinationImageBuffer, kvImageNoFlags);
-        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-        [_destinationImageBufferLock unlock];
+    // The presentation time is on the host time clock, carry its age over to the steady clock shared by all frame timestamps
+    CMTime frameAge = CMTimeSubtract(CMClockGetTime(CMClockGetHostTimeClock()), CMSampleBufferGetPresentationTimeStamp(sampleBuffer));
+    int64_t frameAgeNanoseconds = CMTimeConvertScale(frameAge, 1000000000, kCMTimeRoundingMethod_Default).value;
+    frame.setTimestamp(zed::steadyClockTimestamp() - (uint64_t)MAX(frameAgeNanoseconds, 0));
+    frame.setSequenceNumber(_frameSequenceNumber++);
 
-        if (conversionError < 0) {
-            @throw [NSException exceptionWithName:@"ZEDVideoCaptureRuntimeError" reason:@"Failed to convert video frame to BGR color space" userInfo:nil];
-        }
+    _frameProcessingBlock(frame);
+}
 
-        uint8_t* bgrData = (uint8_t*)_destinationImageBuffer.data;
-
-        dispatch_async(dispatch_get_main_queue(), ^{
-            if (weakSelf && weakSelf.frameProcessingBlock) {
-                [weakSelf.destinationImageBufferLock lock];
-                weakSelf.frameProcessingBlock(bgrData, height, width, 3);
-                [weakSelf.destinationImageBufferLock unlock];
-                
-                dispatch_async(weakSelf.frameProcessingQueue, ^{
-                    if (weakSelf) {
-                        weakSelf.frameBacklogCount--;
-                    }
-                });
-            }
-        });
-    }
+- (NSUInteger)rawFrameCapacity {
+    // Greyscale frames come from the luma pool, YUV frames hold pixel buffers AVFoundation has only a few of to spare
+    return kLumaFramePoolCapacity;
 }
 
 - (void)stop {
@@ -591,99 +698,109 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 }
 
 - (UInt16)brightness {
-    return [self getValueForControl:UVCBrightness];
+    return _controlSession->getControlValue(zed::BRIGHTNESS);
 }
 
 - (void)setBrightness:(UInt16)brightness {
-    [self setValue:brightness forControl:UVCBrightness];
+    _controlSession->setControlValue(zed::BRIGHTNESS, brightness);
 }
 
 - (void)resetBrightness {
-    [self setValue:self.defaultBrightness forControl:UVCBrightness];
+    _controlSession->setControlValue(zed::BRIGHTNESS, self.defaultBrightness);
 }
 
 - (UInt16)contrast {
-    return [self getValueForControl:UVCContrast];
+    return _controlSession->getControlValue(zed::CONTRAST);
 }
 
 - (void)setContrast:(UInt16)contrast {
-    [self setValue:contrast forControl:UVCContrast];
+    _controlSession->setControlValue(zed::CONTRAST, contrast);
 }
 
 - (void)resetContrast {
-    [self setValue:self.defaultContrast forControl:UVCContrast];
+    _controlSession->setControlValue(zed::CONTRAST, self.defaultContrast);
 }
 
 - (UInt16)hue {
-    return [self getValueForControl:UVCHue];
+    return _controlSession->getControlValue(zed::HUE);
 }
 
 - (void)setHue:(UInt16)hue {
-    [self setValue:hue forControl:UVCHue];
+    _controlSession->setControlValue(zed::HUE, hue);
 }
 
 - (void)resetHue {
-    [self setValue:self.defaultHue forControl:UVCHue];
+    _controlSession->setControlValue(zed::HUE, self.defaultHue);
 }
 
 - (UInt16)saturation {
-    return [self getValueForControl:UVCSaturation];
+    return _controlSession->getControlValue(zed::SATURATION);
 }
 
 - (void)setSaturation:(UInt16)saturation {
-    [self setValue:saturation forControl:UVCSaturation];
+    _controlSession->setControlValue(zed::SATURATION, saturation);
 }
 
 - (void)resetSaturation {
-    [self setValue:self.defaultSaturation forControl:UVCSaturation];
+    _controlSession->setControlValue(zed::SATURATION, self.defaultSaturation);
 }
 
 - (UInt16)sharpness {
-    return [self getValueForControl:UVCSharpness];
+    return _controlSession->getControlValue(zed::SHARPNESS);
 }
 
 - (void)setSharpness:(UInt16)sharpness {
-    [self setValue:sharpness forControl:UVCSharpness];
+    _controlSession->setControlValue(zed::SHARPNESS, sharpness);
 }
 
 - (void)resetSharpness {
-    [self setValue:self.defaultSharpness forControl:UVCSharpness];
+    _controlSession->setControlValue(zed::SHARPNESS, self.defaultSharpness);
 }
 
 - (UInt16)whiteBalanceTemperature {
-    return [self getValueForControl:UVCWhiteBalanceTemperature];
+    return _controlSession->getControlValue(zed::WHITE_BALANCE_TEMPERATURE);
 }
 
 - (void)setWhiteBalanceTemperature:(UInt16)whiteBalanceTemperature {
-    self.autoWhiteBalanceTemperature = NO;
-    [self setValue:whiteBalanceTemperature forControl:UVCWhiteBalanceTemperature];
+    zed::CameraSettings cameraSettings;
+    cameraSettings.whiteBalanceTemperature = whiteBalanceTemperature;
+    _controlSession->applySettings(cameraSettings);
 }
 
 - (void)resetWhiteBalanceTemperature {
-    self.autoWhiteBalanceTemperature = NO;
-    [self setValue:self.defaultWhiteBalanceTemperature forControl:UVCWhiteBalanceTemperature];
+    self.whiteBalanceTemperature = self.defaultWhiteBalanceTemperature;
 }
 
 - (BOOL)autoWhiteBalanceTemperature {
-    return [self getValueForControl:UVCAutoWhiteBalanceTemperature];
+    return _controlSession->getControlValue(zed::AUTO_WHITE_BALANCE_TEMPERATURE) != 0;
 }
 
 - (void)setAutoWhiteBalanceTemperature:(BOOL)autoWhiteBalanceTemperature {
-    [self setValue:autoWhiteBalanceTemperature forControl:UVCAutoWhiteBalanceTemperature];
+    _controlSession->setControlValue(zed::AUTO_WHITE_BALANCE_TEMPERATURE, autoWhiteBalanceTemperature);
 }
 
 - (void)resetAutoWhiteBalanceTemperature {
-    [self setValue:self.defaultAutoWhiteBalanceTemperature forControl:UVCAutoWhiteBalanceTemperature];
+    _controlSession->setControlValue(zed::AUTO_WHITE_BALANCE_TEMPERATURE, self.defaultAutoWhiteBalanceTemperature);
+}
+
+- (std::string)readCalibration {
+    if (!_controlSession) {
+        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Attempted to read calibration on non-open ZedVideoCapture" userInfo:nil];
+    }
+
+    return _controlSession->readCalibration();
+}
+
+- (void)applySettings:(const zed::CameraSettings&)cameraSettings {
+    _controlSession->applySettings(cameraSettings);
 }
 
 - (void)turnOnLED {
-    [self setGPIO:GPIONumberLED direction:GPIODirectionOut];
-    [self setGPIO:GPIONumberLED value:1];
+    _controlSession->setControlValue(zed::LED, 1);
 }
 
 - (void)turnOffLED {
-    [self setGPIO:GPIONumberLED direction:GPIODirectionOut];
-    [self setGPIO:GPIONumberLED value:0];
+    _controlSession->setControlValue(zed::LED, 0);
 }
 
 - (void)toggleLED {
@@ -696,11 +813,7 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 }
 
 - (BOOL)isLEDOn {
-    [self setGPIO:GPIONumberLED direction:GPIODirectionIn];
-    uint8_t uint8Value = [self getGPIOValue:GPIONumberLED];
-    [self setGPIO:GPIONumberLED direction:GPIODirectionOut];
-
-    return uint8Value != 0;
+    return _controlSession->getControlValue(zed::LED) != 0;
 }
 
 - (NSString* _Nonnull)deviceID {
@@ -720,166 +833,17 @@ typedef NS_ENUM(UInt8, GPIODirection) { GPIODirectionOut = 0, GPIODirectionIn =
 }
 
 - (NSString* _Nonnull)deviceSerialNumber {
-    if (!_usbDevice) {
+    if (!_controlSession) {
         @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Attempted to read deviceSerialNumber on non-open ZedVideoCapture" userInfo:nil];
     }
 
-    const int maxSerialNumberLengthInBytes = 6;
-    const int serialNumberStartAddress = 0x18000;
-
-    uint8_t data[maxSerialNumberLengthInBytes] = {0};
+    NSString* serialNumber = readSerialNumber(*_controlSession);
 
-    [self getFlashProgramDataAtIndex:serialNumberStartAddress length:maxSerialNumberLengthInBytes output:data];
-
-    if (data[0] != 'O' || data[1] != 'V') {
+    if (!serialNumber) {
         @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to read serial number" userInfo:nil];
     }
 
-    int intValue = (data[2] << 24) + (data[3] << 16) + (data[4] << 8) + data[5];
-
-    return [NSString stringWithFormat:@"%x", intValue];
-}
-
-#pragma mark - Private
-
-- (UInt16)getValueForControl:(UInt16)control {
-    IOReturn result = (*_uvcInterface)->USBInterfaceOpen(_uvcInterface);
-
-    if (result != kIOReturnSuccess && result != kIOReturnExclusiveAccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to open USB interface for get control value request" userInfo:nil];
-    }
-
-    UInt16 data = 0;
-
-    IOUSBDevRequest controlRequest = {.bmRequestType = UVCRequestTypeIn,
-        .bRequest = UVCRequestGetCurrent,
-        .wValue = UInt16(control << 8),
-        .wIndex = kUVCUnitID << 8,
-        .wLength = kUVCControlValueSizeInBytes,
-        .pData = &data};
-
-    result = (*_uvcInterface)->ControlRequest(_uvcInterface, 0, &controlRequest);
-
-    if (result != kIOReturnSuccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to send UVC get value request" userInfo:nil];
-    }
-
-    (*_uvcInterface)->USBInterfaceClose(_uvcInterface);
-
-    return data;
-}
-
-- (void)setValue:(UInt16)value forControl:(UInt16)control {
-    IOReturn result = (*_uvcInterface)->USBInterfaceOpen(_uvcInterface);
-
-    if (result != kIOReturnSuccess && result != kIOReturnExclusiveAccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to open USB interface for set control value request" userInfo:nil];
-    }
-
-    IOUSBDevRequest controlRequest = {.bmRequestType = UVCRequestTypeOut,
-        .bRequest = UVCRequestSetCurrent,
-        .wValue = UInt16(control << 8),
-        .wIndex = kUVCUnitID << 8,
-        .wLength = kUVCControlValueSizeInBytes,
-        .pData = &value};
-
-    result = (*_uvcInterface)->ControlRequest(_uvcInterface, 0, &controlRequest);
-
-    if (result != kIOReturnSuccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to send UVC set value request" userInfo:nil];
-    }
-
-    (*_uvcInterface)->USBInterfaceClose(_uvcInterface);
-}
-
-- (void)setGPIO:(GPIONumber)gpioNumber direction:(GPIODirection)direction {
-    UInt8 data[kXUBufferSizeInBytes] = {0x50, 0x10, gpioNumber, direction};
-    [self sendXURequest:XUWriteRequest data:data];
-}
-
-- (void)setGPIO:(GPIONumber)gpioNumber value:(UInt8)value {
-    UInt8 data[kXUBufferSizeInBytes] = {0x50, 0x12, gpioNumber, value};
-    [self sendXURequest:XUWriteRequest data:data];
-}
-
-- (UInt8)getGPIOValue:(GPIONumber)gpioNumber {
-    UInt8 data[kXUBufferSizeInBytes] = {0x51, 0x13, gpioNumber};
-    [self sendXURequest:XUReadRequest data:data];
-
-    return data[17];
-}
-
-- (void)getFlashProgramDataAtIndex:(int)index length:(int)length output:(UInt8*)output {
-    uint8_t data[kXUBufferSizeInBytes] = {0x51, 0xa1, 0x03};
-    data[5] = (index >> 24) & 0xff;
-    data[6] = (index >> 16) & 0xff;
-    data[7] = (index >> 8) & 0xff;
-    data[8] = index & 0xff;
-
-    int packVal = 36864 + length;
-    data[9] = (packVal >> 8) & 0xff;
-    data[10] = packVal & 0xff;
-    data[11] = (length >> 8) & 0xff;
-    data[12] = length & 0xff;
-
-    [self sendXURequest:XUReadRequest data:data];
-
-    memcpy(output, &data[17], length);
-}
-
-- (void)sendXURequest:(XURequest)xuRequest data:(UInt8*)data {
-    IOCFPlugInInterface** plugInInterface = nil;
-    SInt32 score;
-    kern_return_t kernelResult = IOCreatePlugInInterfaceForService(_usbDevice, kIOUSBDeviceUserClientTypeID, kIOCFPlugInInterfaceID, &plugInInterface, &score);
-
-    if ((kernelResult != kIOReturnSuccess) || !plugInInterface) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to create USB plugin interface for extension unit request" userInfo:nil];
-    }
-
-    IOUSBDeviceInterface300** deviceInterface = nil;
-    IOReturn ioResult = (*plugInInterface)->QueryInterface(plugInInterface, CFUUIDGetUUIDBytes(kIOUSBDeviceInterfaceID), (LPVOID*)&deviceInterface);
-    IODestroyPlugInInterface(plugInInterface);
-
-    if ((ioResult != 0) || !deviceInterface) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to find USB interface for extension unit request" userInfo:nil];
-    }
-
-    IOReturn result = (*deviceInterface)->USBDeviceOpen(deviceInterface);
-
-    if (result != kIOReturnSuccess && result != kIOReturnExclusiveAccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to open USB interface for extension unit request" userInfo:nil];
-    }
-
-    IOUSBDevRequest setTaskRequest = {.bmRequestType = XURequestTypeOut,
-        .bRequest = UVCRequestSetCurrent,
-        .wValue = kXUControlSelector << 8,
-        .wIndex = kXUID << 8,
-        .wLength = kXUBufferSizeInBytes,
-        .pData = data};
-
-    result = (*deviceInterface)->DeviceRequest(deviceInterface, &setTaskRequest);
-
-    if (result != kIOReturnSuccess) {
-        @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to send extension unit set task request" userInfo:nil];
-    }
-
-    if (xuRequest == XUReadRequest) {
-        IOUSBDevRequest getDataRequest = {.bmRequestType = XURequestTypeIn,
-            .bRequest = UVCRequestGetCurrent,
-            .wValue = kXUControlSelector << 8,
-            .wIndex = kXUID << 8,
-            .wLength = kXUBufferSizeInBytes,
-            .pData = data};
-
-        result = (*deviceInterface)->DeviceRequest(deviceInterface, &getDataRequest);
-
-        if (result != kIOReturnSuccess) {
-            @throw [NSException exceptionWithName:@"ZEDCameraRuntimeError" reason:@"Failed to send extension unit get data request" userInfo:nil];
-        }
-    }
-
-    (*deviceInterface)->USBDeviceClose(deviceInterface);
-    (*deviceInterface)->Release(deviceInterface);
+    return serialNumber;
 }
 
 - (void)dealloc {
@@ -6,28 +6,226 @@
 //
 
 #include "../include/zed_calibration_data.h"
+#include <cmath>
 #include <curl/curl.h>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unistd.h>
 
 using namespace std;
 using namespace filesystem;
 
 namespace zed {
 
+#pragma mark - Parsing
+
+    //
+    // Single pass over the contents of a calibration file: lines are scanned in place as string views,
+    // numbers are parsed without allocating or throwing
+    //
+    namespace {
+
+        //
+        // Parameters
+        //
+        // Bits of `parameterMasks`, a resolution is complete once every bit is set
+        //
+#define kLeftParameterShift 0
+#define kRightParameterShift 9
+#define kRotationParameterShift 18
+#define kStereoParameterShift 21
+#define kCompleteParameterMask 0xFFFFFF
+
+        constexpr string_view kIntrinsicKeys[9] = {"fx", "fy", "cx", "cy", "k1", "k2", "k3", "p1", "p2"};
+        constexpr string_view kRotationKeys[3] = {"RX_", "CV_", "RZ_"}; // CV is the rotation about y
+        constexpr string_view kStereoKeys[3] = {"Baseline", "TY", "TZ"};
+
+        // Calibration file suffixes, indexed by Resolution
+        constexpr string_view kResolutionSuffixes[4] = {"2K", "FHD", "HD", "VGA"};
+
+        string_view trimmed(string_view text) {
+            size_t start = 0;
+            size_t end = text.size();
+
+            while (start < end && (text[start] == ' ' || text[start] == '\t' || text[start] == '\r')) {
+                start++;
+            }
+
+            while (end > start && (text[end - 1] == ' ' || text[end - 1] == '\t' || text[end - 1] == '\r')) {
+                end--;
+            }
+
+            return text.substr(start, end - start);
+        }
+
+        // Returns the resolution of a calibration file suffix (e.g. "FHD"), or -1
+        int resolutionIndex(string_view suffix) {
+            for (int i = 0; i < 4; i++) {
+                if (suffix == kResolutionSuffixes[i]) {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+
+        bool parseInt(string_view text, int& value) {
+            size_t i = 0;
+            bool isNegative = false;
+
+            if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+                isNegative = text[i++] == '-';
+            }
+
+            if (i == text.size()) {
+                return false;
+            }
+
+            int64_t result = 0;
+            for (; i < text.size(); i++) {
+                if (text[i] < '0' || text[i] > '9') {
+                    return false;
+                }
+
+                result = result * 10 + (text[i] - '0');
+
+                if (result > INT32_MAX) {
+                    return false;
+                }
+            }
+
+            value = int(isNegative ? -result : result);
+            return true;
+        }
+
+        // Decimal number with optional fraction and exponent (e.g. "-1.5e-3")
+        bool parseFloat(string_view text, float& value) {
+            size_t i = 0;
+            bool isNegative = false;
+
+            if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+                isNegative = text[i++] == '-';
+            }
+
+            double mantissa = 0;
+            int exponent = 0;
+            size_t digitCount = 0;
+
+            for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++, digitCount++) {
+                mantissa = mantissa * 10 + (text[i] - '0');
+            }
+
+            if (i < text.size() && text[i] == '.') {
+                for (i++; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++, digitCount++) {
+                    mantissa = mantissa * 10 + (text[i] - '0');
+                    exponent--;
+                }
+            }
+
+            if (digitCount == 0) {
+                return false;
+            }
+
+            if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+                int exponentValue;
+                if (!parseInt(text.substr(i + 1), exponentValue)) {
+                    return false;
+                }
+
+                exponent += exponentValue;
+                i = text.size();
+            }
+
+            if (i != text.size()) {
+                return false;
+            }
+
+            // Dividing by an exact power of ten keeps short fractions correctly rounded
+            double result = exponent < 0 ? mantissa / pow(10.0, -exponent) : mantissa * pow(10.0, exponent);
+            value = float(isNegative ? -result : result);
+            return true;
+        }
+
+        // Calls `visitor(section, key, value)` for each key=value line, skipping empty lines and comments (lines starting with ';' or '#')
+        template <typename Visitor> void forEachParameter(string_view contents, Visitor visitor) {
+            string_view section;
+            size_t position = 0;
+
+            while (position < contents.size()) {
+                size_t lineEnd = contents.find('\n', position);
+                if (lineEnd == string_view::npos) {
+                    lineEnd = contents.size();
+                }
+
+                string_view line = trimmed(contents.substr(position, lineEnd - position));
+                position = lineEnd + 1;
+
+                if (line.empty() || line[0] == ';' || line[0] == '#') {
+                    continue;
+                }
+
+                if (line[0] == '[' && line.back() == ']') {
+                    section = line.substr(1, line.size() - 2);
+                    continue;
+                }
+
+                size_t separator = line.find('=');
+                if (separator != string_view::npos) {
+                    visitor(section, trimmed(line.substr(0, separator)), trimmed(line.substr(separator + 1)));
+                }
+            }
+        }
+    }
+
+#pragma mark - File Cache
+
+    // Writes `contents` to `filepath` unless it already holds them, under a per-process name that is renamed into place
+    // so a concurrent load never reads a partial file. Returns whether the file holds the contents, warns if it doesn't
+    static bool storeCachedContents(const path& filepath, const string& contents) {
+        error_code error;
+
+        if (exists(filepath, error) && file_size(filepath, error) == contents.size()) {
+            ifstream file(filepath, ios::binary);
+            string cachedContents(contents.size(), '\0');
+
+            if (file.read(cachedContents.data(), cachedContents.size()) && cachedContents == contents) {
+                return true;
+            }
+        }
+
+        path temporaryFilepath = path(filepath.string() + format(".{}.tmp", getpid()));
+
+        ofstream file(temporaryFilepath, ios::binary);
+        file.write(contents.data(), contents.size());
+        file.close();
+
+        if (file) {
+            rename(temporaryFilepath, filepath, error);
+        }
+
+        if (!file || error) {
+            remove(temporaryFilepath, error);
+            cerr << "Warning: failed to cache calibration data at " << filepath.string() << endl;
+            return false;
+        }
+
+        return true;
+    }
+
 #pragma mark - Public
 
-    void CalibrationData::load(const string& serialNumber) {
+    void CalibrationData::load(const string& serialNumber, string_view downloadURL) {
         string numericSerialNumber = removeNonNumeric(serialNumber);
         path filepath = createFilepath(numericSerialNumber);
 
         if (!exists(filepath)) {
             cout << "Calibration data not found for " << serialNumber << ", downloading..." << endl;
-            string url = "https://www.stereolabs.com/developers/calib/?SN=" + numericSerialNumber;
+            string url = string(downloadURL) + numericSerialNumber;
             downloadFile(url, filepath);
         }
 
@@ -37,53 +235,154 @@ namespace zed {
             throw runtime_error(format("Unable to open file: {}", filepath.string()));
         }
 
-        string line, currentSection;
-        while (getline(file, line)) {
-            trim(line);
+        string contents(file_size(filepath), '\0');
+        file.read(contents.data(), contents.size());
+        file.close();
 
-            // Ignore empty lines and comments (lines starting with ';' or '#')
-            if (line.empty() || line[0] == ';' || line[0] == '#') {
-                continue;
-            }
+        parse(contents);
 
-            // Check for section headers
-            if (line[0] == '[' && line[line.size() - 1] == ']') {
-                currentSection = line.substr(1, line.size() - 2);
+        this->serialNumber = numericSerialNumber;
+        this->filepath = filepath;
+    }
+
+    void CalibrationData::loadFromDevice(const string& serialNumber, const string& contents) {
+        string numericSerialNumber = removeNonNumeric(serialNumber);
+
+        parse(contents);
+
+        this->serialNumber = numericSerialNumber;
+
+        // The device's copy is in use either way, failing to cache it only loses the fallback for when the device can't be read
+        try {
+            path filepath = createFilepath(numericSerialNumber);
+
+            if (storeCachedContents(filepath, contents)) {
+                this->filepath = filepath;
             }
-            else {
-                // Parse key=value pairs
-                size_t pos = line.find('=');
-                if (pos != string::npos) {
-                    string key = line.substr(0, pos);
-                    trim(key);
+        }
+        catch (const exception& error) {
+            cerr << "Warning: failed to cache calibration data (" << error.what() << ")" << endl;
+        }
+    }
 
-                    string value = line.substr(pos + 1);
-                    trim(value);
+    void CalibrationData::parse(const string& contents) {
+        this->contents = contents;
+        data.clear();
+        isIndexed = false;
+        serialNumber.clear();
+        filepath.clear();
 
-                    size_t pos;
-                    int intValue = stoi(value, &pos);
+        hash = 0xCBF29CE484222325;
+        for (char character : contents) {
+            hash = (hash ^ uint8_t(character)) * 0x100000001B3;
+        }
 
-                    if (pos == value.size()) {
-                        data[currentSection][key] = intValue;
-                        continue;
-                    }
+        for (int i = 0; i < 4; i++) {
+            stereoCalibrations[i] = StereoCalibration();
+            stereoCalibrations[i].resolution = Resolution(i);
+            stereoCalibrations[i].stereoDimensions = StereoDimensions(Resolution(i));
+            parameterMasks[i] = 0;
+        }
 
-                    float floatValue = stof(value, &pos);
+        // Shared by every resolution
+        float stereoValues[3] = {};
+        uint32_t stereoMask = 0;
+
+        forEachParameter(this->contents, [&](string_view section, string_view key, string_view text) {
+            float value;
+            if (!parseFloat(text, value)) {
+                return;
+            }
 
-                    if (pos == value.size()) {
-                        data[currentSection][key] = floatValue;
-                        continue;
+            if (section == "STEREO") {
+                for (int i = 0; i < 3; i++) {
+                    if (key == kStereoKeys[i]) {
+                        stereoValues[i] = value;
+                        stereoMask |= 1 << i;
+                        return;
                     }
 
-                    cerr << "Unsupported value: " << value << " for key: " << key << endl;
+                    if (key.starts_with(kRotationKeys[i])) {
+                        int index = resolutionIndex(key.substr(kRotationKeys[i].size()));
+                        if (index >= 0) {
+                            float* rotation[3] = {&stereoCalibrations[index].rx, &stereoCalibrations[index].ry, &stereoCalibrations[index].rz};
+                            *rotation[i] = value;
+                            parameterMasks[index] |= 1 << (kRotationParameterShift + i);
+                        }
+                        return;
+                    }
                 }
+
+                return;
+            }
+
+            bool isLeft = section.starts_with("LEFT_CAM_");
+            if (!isLeft && !section.starts_with("RIGHT_CAM_")) {
+                return;
             }
+
+            int index = resolutionIndex(section.substr(isLeft ? 9 : 10));
+            if (index < 0) {
+                return;
+            }
+
+            CameraIntrinsics& intrinsics = isLeft ? stereoCalibrations[index].left : stereoCalibrations[index].right;
+            float* parameters[9] = {&intrinsics.fx, &intrinsics.fy, &intrinsics.cx, &intrinsics.cy, &intrinsics.k1, &intrinsics.k2, &intrinsics.k3, &intrinsics.p1, &intrinsics.p2};
+
+            for (int i = 0; i < 9; i++) {
+                if (key == kIntrinsicKeys[i]) {
+                    *parameters[i] = value;
+                    parameterMasks[index] |= 1 << ((isLeft ? kLeftParameterShift : kRightParameterShift) + i);
+                    return;
+                }
+            }
+        });
+
+        for (int i = 0; i < 4; i++) {
+            stereoCalibrations[i].baseline = stereoValues[0];
+            stereoCalibrations[i].ty = stereoValues[1];
+            stereoCalibrations[i].tz = stereoValues[2];
+            parameterMasks[i] |= stereoMask << kStereoParameterShift;
         }
+    }
 
-        file.close();
+    string CalibrationData::getSerialNumber() const {
+        return serialNumber;
+    }
+
+    path CalibrationData::getFilepath() const {
+        return filepath;
+    }
+
+    uint64_t CalibrationData::getHash() const {
+        return hash;
+    }
+
+    bool CalibrationData::hasStereoCalibration(Resolution resolution) const {
+        return parameterMasks[resolution] == kCompleteParameterMask;
+    }
+
+    const StereoCalibration& CalibrationData::getStereoCalibration(Resolution resolution) const {
+        if (!hasStereoCalibration(resolution)) {
+            throw runtime_error(format("Incomplete calibration data for resolution: {}", resolutionToString(resolution)));
+        }
+
+        return stereoCalibrations[resolution];
+    }
+
+    const StereoCalibration& CalibrationData::getStereoCalibration(StereoDimensions stereoDimensions) const {
+        for (int i = 0; i < 4; i++) {
+            if (stereoCalibrations[i].stereoDimensions.width == stereoDimensions.width && stereoCalibrations[i].stereoDimensions.height == stereoDimensions.height) {
+                return getStereoCalibration(Resolution(i));
+            }
+        }
+
+        throw runtime_error("No calibration data for StereoDimensions: " + stereoDimensions.toString());
     }
 
     string CalibrationData::toString() {
+        index();
+
         stringstream result;
 
         for (const auto& outerPair : data) {
@@ -116,6 +415,44 @@ namespace zed {
 
 #pragma mark - Private
 
+    const variant<int, float>& CalibrationData::getValue(const string& section, const string& key) {
+        index();
+
+        auto sectionEntry = data.find(section);
+        if (sectionEntry != data.end()) {
+            auto valueEntry = sectionEntry->second.find(key);
+            if (valueEntry != sectionEntry->second.end()) {
+                return valueEntry->second;
+            }
+        }
+
+        throw runtime_error(format("Missing calibration parameter: [{}] {}", section, key));
+    }
+
+    void CalibrationData::index() {
+        if (isIndexed) {
+            return;
+        }
+
+        forEachParameter(contents, [this](string_view section, string_view key, string_view text) {
+            int intValue;
+            if (parseInt(text, intValue)) {
+                data[string(section)][string(key)] = intValue;
+                return;
+            }
+
+            float floatValue;
+            if (parseFloat(text, floatValue)) {
+                data[string(section)][string(key)] = floatValue;
+                return;
+            }
+
+            cerr << "Unsupported value: " << text << " for key: " << key << endl;
+        });
+
+        isIndexed = true;
+    }
+
     path CalibrationData::createFilepath(const string& numericSerialNumber) {
         const char* homeDirectory = getenv("HOME");
         if (!homeDirectory) {
@@ -137,7 +474,10 @@ namespace zed {
     }
 
     void CalibrationData::downloadFile(const string& url, const path& filepath) {
-        curl_global_init(CURL_GLOBAL_DEFAULT);
+        // Initialized once per process, curl_global_cleanup() isn't thread safe and is left to process exit
+        static once_flag curlInitialization;
+        call_once(curlInitialization, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
         CURL* curl = curl_easy_init();
 
         if (!curl) {
@@ -147,27 +487,28 @@ namespace zed {
         ofstream outFile(filepath, ios::binary);
 
         if (!outFile.is_open()) {
+            curl_easy_cleanup(curl);
             throw runtime_error(format("Failed to open file for writing: {}", filepath.string()));
         }
 
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
         curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &outFile);
 
         CURLcode res = curl_easy_perform(curl);
 
+        outFile.close();
+        curl_easy_cleanup(curl);
+
         if (res != CURLE_OK) {
-            throw runtime_error(format("Failed to open file for writing: {}", filepath.string()));
-        }
-        else {
-            cout << "Successfully downloaded calibration data to " << filepath.string() << endl;
+            // A partial file would be taken for the cached calibration on the next load
+            remove(filepath);
+            throw runtime_error(format("Failed to download calibration data from {}: {}", url, curl_easy_strerror(res)));
         }
 
-        outFile.close();
-
-        curl_easy_cleanup(curl);
-        curl_global_cleanup();
+        cout << "Successfully downloaded calibration data to " << filepath.string() << endl;
     }
 
     size_t CalibrationData::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
@@ -177,17 +518,6 @@ namespace zed {
         return totalSize;
     }
 
-    void CalibrationData::trim(string& str) {
-        size_t start = str.find_first_not_of(" \t");
-        size_t end = str.find_last_not_of(" \t");
-        if (start != string::npos && end != string::npos) {
-            str = str.substr(start, end - start + 1);
-        }
-        else {
-            str.clear();
-        }
-    }
-
     string CalibrationData::removeNonNumeric(const string& input) {
         string result;
         for (char ch : input) {
@@ -0,0 +1,518 @@
+//
+// zed_camera_controls.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_camera_controls.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+//
+// UVC Interface
+//
+#define kUVCUnitID 3
+#define kUVCControlValueSizeInBytes 2
+#define kUVCRequestTypeIn 0xa1
+#define kUVCRequestTypeOut 0x21
+#define kUVCRequestGetCurrent 0x81
+#define kUVCRequestSetCurrent 0x01
+
+//
+// ZED Extension Unit Interface
+//
+#define kXUID 4
+#define kXUControlSelector 2
+#define kXURequestTypeIn 0xa0
+#define kXURequestTypeOut 0x20
+#define kXUResultOffset 17
+
+//
+// Extension Unit Tasks
+//
+#define kXUWriteTask 0x50
+#define kXUReadTask 0x51
+#define kXUSetGPIODirection 0x10
+#define kXUSetGPIOValue 0x12
+#define kXUGetGPIOValue 0x13
+#define kXUReadFlash 0xa1
+#define kGPIONumberLED 2
+#define kGPIODirectionOut 0
+#define kGPIODirectionIn 1
+
+namespace zed {
+
+    static_assert(kFlashReadMaxLength == kXUBufferSizeInBytes - kXUResultOffset);
+
+#pragma mark - Helpers
+
+    static uint8_t uvcControlCode(CameraControl cameraControl) {
+        switch (cameraControl) {
+            case BRIGHTNESS:
+                return 2;
+            case CONTRAST:
+                return 3;
+            case HUE:
+                return 6;
+            case SATURATION:
+                return 7;
+            case SHARPNESS:
+                return 8;
+            case WHITE_BALANCE_TEMPERATURE:
+                return 10;
+            case AUTO_WHITE_BALANCE_TEMPERATURE:
+                return 11;
+            case LED:
+                throw runtime_error("The LED isn't a UVC control");
+        }
+    }
+
+    static void writeLittleEndian(uint8_t* data, uint32_t value) {
+        for (size_t i = 0; i < 4; i++) {
+            data[i] = (value >> (8 * i)) & 0xff;
+        }
+    }
+
+    static uint32_t readLittleEndian(const uint8_t* data) {
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    static uint32_t flashChecksum(const uint8_t* data, size_t size) {
+        uint32_t hash = 0x811C9DC5;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 0x01000193;
+        }
+
+        return hash;
+    }
+
+#pragma mark - Flash Calibration
+
+    vector<uint8_t> encodeFlashCalibration(const string& contents) {
+        if (contents.size() > kFlashCalibrationMaxLength) {
+            throw runtime_error(format("Calibration too large for flash: {} bytes (up to {})", contents.size(), kFlashCalibrationMaxLength));
+        }
+
+        vector<uint8_t> record(kFlashCalibrationHeaderSize + contents.size(), 0);
+        memcpy(record.data() + kFlashCalibrationHeaderSize, contents.data(), contents.size());
+
+        writeLittleEndian(&record[0], kFlashCalibrationMagic);
+        writeLittleEndian(&record[4], uint32_t(contents.size()));
+        writeLittleEndian(&record[8], flashChecksum(record.data() + kFlashCalibrationHeaderSize, contents.size()));
+
+        return record;
+    }
+
+    string decodeFlashCalibration(const uint8_t* record, size_t size) {
+        if (size < kFlashCalibrationHeaderSize || readLittleEndian(record) != kFlashCalibrationMagic) {
+            throw runtime_error("No calibration record in flash");
+        }
+
+        size_t length = readLittleEndian(record + 4);
+
+        if (length > kFlashCalibrationMaxLength) {
+            throw runtime_error(format("Invalid calibration record length in flash: {}", length));
+        }
+
+        if (size < kFlashCalibrationHeaderSize + length) {
+            throw runtime_error(format("Truncated calibration record in flash: {} of {} bytes", size - kFlashCalibrationHeaderSize, length));
+        }
+
+        const uint8_t* contents = record + kFlashCalibrationHeaderSize;
+
+        if (flashChecksum(contents, length) != readLittleEndian(record + 8)) {
+            throw runtime_error("Corrupt calibration record in flash (checksum mismatch)");
+        }
+
+        return string(reinterpret_cast<const char*>(contents), length);
+    }
+
+#pragma mark - SimulatedControlTransport
+
+    SimulatedControlTransport::SimulatedControlTransport(chrono::nanoseconds transferLatency) {
+        this->transferLatency = transferLatency;
+
+        memset(uvcValues, 0, sizeof(uvcValues));
+        memset(gpioDirections, kGPIODirectionIn, sizeof(gpioDirections));
+        memset(gpioValues, 0, sizeof(gpioValues));
+        memset(xuResponse, 0, sizeof(xuResponse));
+        flashAddress = 0;
+
+        for (CameraControl cameraControl : {BRIGHTNESS, CONTRAST, HUE, SATURATION, SHARPNESS, WHITE_BALANCE_TEMPERATURE, AUTO_WHITE_BALANCE_TEMPERATURE}) {
+            uvcValues[uvcControlCode(cameraControl)] = cameraControlDefaultValue(cameraControl);
+        }
+
+        resetCounts();
+    }
+
+    void SimulatedControlTransport::transfer(ControlTransfer& controlTransfer) {
+        auto start = chrono::steady_clock::now();
+
+        if (transferLatency.count() > 0) {
+            this_thread::sleep_for(transferLatency);
+        }
+
+        lock_guard<mutex> lock(transportMutex);
+
+        uint8_t selector = controlTransfer.value >> 8;
+        uint8_t unitID = controlTransfer.index >> 8;
+
+        if (unitID == kUVCUnitID && controlTransfer.length == kUVCControlValueSizeInBytes && selector < 16) {
+            if (controlTransfer.requestType == kUVCRequestTypeOut && controlTransfer.request == kUVCRequestSetCurrent) {
+                memcpy(&uvcValues[selector], controlTransfer.data, kUVCControlValueSizeInBytes);
+            }
+            else if (controlTransfer.requestType == kUVCRequestTypeIn && controlTransfer.request == kUVCRequestGetCurrent) {
+                memcpy(controlTransfer.data, &uvcValues[selector], kUVCControlValueSizeInBytes);
+            }
+            else {
+                throw runtime_error(format("Unsupported UVC request: {:#x} {:#x}", controlTransfer.requestType, controlTransfer.request));
+            }
+
+            uvcTransferCount++;
+        }
+        else if (unitID == kXUID && selector == kXUControlSelector && controlTransfer.length == kXUBufferSizeInBytes) {
+            if (controlTransfer.requestType == kXURequestTypeOut && controlTransfer.request == kUVCRequestSetCurrent) {
+                handleXUTask(controlTransfer.data);
+            }
+            else if (controlTransfer.requestType == kXURequestTypeIn && controlTransfer.request == kUVCRequestGetCurrent) {
+                memcpy(controlTransfer.data, xuResponse, kXUBufferSizeInBytes);
+            }
+            else {
+                throw runtime_error(format("Unsupported extension unit request: {:#x} {:#x}", controlTransfer.requestType, controlTransfer.request));
+            }
+
+            xuTransferCount++;
+        }
+        else {
+            throw runtime_error(format("Unsupported control transfer to unit {}, selector {}", unitID, selector));
+        }
+
+        transferDuration += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    }
+
+    uint16_t SimulatedControlTransport::getDeviceValue(CameraControl cameraControl) {
+        lock_guard<mutex> lock(transportMutex);
+
+        if (cameraControl == LED) {
+            return gpioValues[kGPIONumberLED];
+        }
+
+        return uvcValues[uvcControlCode(cameraControl)];
+    }
+
+    void SimulatedControlTransport::setFlashImage(uint32_t address, vector<uint8_t> image) {
+        lock_guard<mutex> lock(transportMutex);
+
+        flashAddress = address;
+        flashImage = std::move(image);
+    }
+
+    uint64_t SimulatedControlTransport::getTransferCount() {
+        lock_guard<mutex> lock(transportMutex);
+        return uvcTransferCount + xuTransferCount;
+    }
+
+    uint64_t SimulatedControlTransport::getUVCTransferCount() {
+        lock_guard<mutex> lock(transportMutex);
+        return uvcTransferCount;
+    }
+
+    uint64_t SimulatedControlTransport::getXUTransferCount() {
+        lock_guard<mutex> lock(transportMutex);
+        return xuTransferCount;
+    }
+
+    chrono::nanoseconds SimulatedControlTransport::getTransferDuration() {
+        lock_guard<mutex> lock(transportMutex);
+        return transferDuration;
+    }
+
+    void SimulatedControlTransport::resetCounts() {
+        lock_guard<mutex> lock(transportMutex);
+
+        uvcTransferCount = 0;
+        xuTransferCount = 0;
+        transferDuration = chrono::nanoseconds(0);
+    }
+
+    void SimulatedControlTransport::handleXUTask(const uint8_t* task) {
+        uint8_t gpioNumber = task[2] & 0x7;
+
+        memcpy(xuResponse, task, kXUBufferSizeInBytes);
+
+        if (task[0] == kXUWriteTask && task[1] == kXUSetGPIODirection) {
+            gpioDirections[gpioNumber] = task[3];
+        }
+        else if (task[0] == kXUWriteTask && task[1] == kXUSetGPIOValue) {
+            if (gpioDirections[gpioNumber] == kGPIODirectionOut) {
+                gpioValues[gpioNumber] = task[3];
+            }
+        }
+        else if (task[0] == kXUReadTask && task[1] == kXUGetGPIOValue) {
+            xuResponse[kXUResultOffset] = gpioValues[gpioNumber];
+        }
+        else if (task[0] == kXUReadTask && task[1] == kXUReadFlash) {
+            uint32_t address = (uint32_t(task[5]) << 24) | (uint32_t(task[6]) << 16) | (uint32_t(task[7]) << 8) | task[8];
+            size_t length = min((size_t(task[11]) << 8) | task[12], kFlashReadMaxLength);
+
+            // Erased flash outside the image
+            memset(xuResponse + kXUResultOffset, 0xff, kXUBufferSizeInBytes - kXUResultOffset);
+
+            for (size_t i = 0; i < length; i++) {
+                uint64_t offset = uint64_t(address) + i - flashAddress;
+
+                if (address + i >= flashAddress && offset < flashImage.size()) {
+                    xuResponse[kXUResultOffset + i] = flashImage[offset];
+                }
+            }
+        }
+        else {
+            throw runtime_error(format("Unsupported extension unit task: {:#x} {:#x}", task[0], task[1]));
+        }
+    }
+
+#pragma mark - ControlSession
+
+    ControlSession::ControlSession(shared_ptr<ControlTransport> controlTransport) {
+        if (!controlTransport) {
+            throw runtime_error("Missing control transport for control session");
+        }
+
+        this->controlTransport = std::move(controlTransport);
+        isLEDOutput = false;
+        isCalibrationRecordMissing = false;
+        transferCount = 0;
+        cachedReadCount = 0;
+    }
+
+    uint16_t ControlSession::getControlValue(CameraControl cameraControl) {
+        lock_guard<mutex> lock(sessionMutex);
+
+        // Automatic white balance keeps changing the temperature, so it's only cached once automatic white balance is known to be off
+        bool isVolatile = cameraControl == WHITE_BALANCE_TEMPERATURE && values[AUTO_WHITE_BALANCE_TEMPERATURE] != uint16_t(0);
+
+        if (values[cameraControl].has_value() && !isVolatile) {
+            cachedReadCount++;
+            return *values[cameraControl];
+        }
+
+        uint16_t value = readControl(cameraControl);
+
+        if (!isVolatile) {
+            values[cameraControl] = value;
+        }
+
+        return value;
+    }
+
+    void ControlSession::setControlValue(CameraControl cameraControl, uint16_t value) {
+        lock_guard<mutex> lock(sessionMutex);
+        writeControl(cameraControl, value);
+    }
+
+    void ControlSession::applySettings(const CameraSettings& cameraSettings) {
+        if (cameraSettings.whiteBalanceTemperature.has_value() && cameraSettings.autoWhiteBalanceTemperature.value_or(false)) {
+            throw runtime_error("Conflicting camera settings: a white balance temperature with automatic white balance");
+        }
+
+        lock_guard<mutex> lock(sessionMutex);
+
+        // Automatic white balance goes first, a manual temperature only takes effect once it's off
+        if (cameraSettings.autoWhiteBalanceTemperature.has_value()) {
+            writeControl(AUTO_WHITE_BALANCE_TEMPERATURE, *cameraSettings.autoWhiteBalanceTemperature);
+        }
+        else if (cameraSettings.whiteBalanceTemperature.has_value()) {
+            writeControl(AUTO_WHITE_BALANCE_TEMPERATURE, false);
+        }
+
+        const pair<CameraControl, const optional<uint16_t>&> controls[] = {
+            {WHITE_BALANCE_TEMPERATURE, cameraSettings.whiteBalanceTemperature},
+            {BRIGHTNESS, cameraSettings.brightness},
+            {CONTRAST, cameraSettings.contrast},
+            {HUE, cameraSettings.hue},
+            {SATURATION, cameraSettings.saturation},
+            {SHARPNESS, cameraSettings.sharpness},
+        };
+
+        for (const auto& [cameraControl, value] : controls) {
+            if (value.has_value()) {
+                writeControl(cameraControl, *value);
+            }
+        }
+
+        if (cameraSettings.isLEDOn.has_value()) {
+            writeControl(LED, *cameraSettings.isLEDOn);
+        }
+    }
+
+    void ControlSession::sendXURequest(XURequest xuRequest, uint8_t* data) {
+        lock_guard<mutex> lock(sessionMutex);
+        sendXUTask(xuRequest, data);
+    }
+
+    void ControlSession::readFlash(uint32_t address, size_t length, uint8_t* output) {
+        for (size_t offset = 0; offset < length; offset += kFlashReadMaxLength) {
+            readFlashChunk(address + uint32_t(offset), min(length - offset, kFlashReadMaxLength), output + offset);
+        }
+    }
+
+    string ControlSession::readCalibration() {
+        {
+            lock_guard<mutex> lock(sessionMutex);
+
+            if (isCalibrationRecordMissing) {
+                return "";
+            }
+        }
+
+        vector<uint8_t> record(kFlashReadMaxLength);
+        readFlash(kFlashCalibrationAddress, record.size(), record.data());
+
+        if (readLittleEndian(record.data()) != kFlashCalibrationMagic) {
+            lock_guard<mutex> lock(sessionMutex);
+            isCalibrationRecordMissing = true;
+
+            return "";
+        }
+
+        size_t recordSize = kFlashCalibrationHeaderSize + min(size_t(readLittleEndian(record.data() + 4)), kFlashCalibrationMaxLength);
+
+        if (recordSize > record.size()) {
+            size_t readSize = record.size();
+            record.resize(recordSize);
+            readFlash(kFlashCalibrationAddress + uint32_t(readSize), recordSize - readSize, record.data() + readSize);
+        }
+
+        return decodeFlashCalibration(record.data(), record.size());
+    }
+
+    void ControlSession::invalidate() {
+        lock_guard<mutex> lock(sessionMutex);
+
+        for (optional<uint16_t>& value : values) {
+            value.reset();
+        }
+
+        isLEDOutput = false;
+        isCalibrationRecordMissing = false;
+    }
+
+    uint64_t ControlSession::getTransferCount() {
+        lock_guard<mutex> lock(sessionMutex);
+        return transferCount;
+    }
+
+    uint64_t ControlSession::getCachedReadCount() {
+        lock_guard<mutex> lock(sessionMutex);
+        return cachedReadCount;
+    }
+
+#pragma mark - Private
+
+    uint16_t ControlSession::readControl(CameraControl cameraControl) {
+        if (cameraControl == LED) {
+            // The GPIO is read as an input, then restored as an output so the LED keeps its state
+            uint8_t setInput[kXUBufferSizeInBytes] = {kXUWriteTask, kXUSetGPIODirection, kGPIONumberLED, kGPIODirectionIn};
+            uint8_t getValue[kXUBufferSizeInBytes] = {kXUReadTask, kXUGetGPIOValue, kGPIONumberLED};
+            uint8_t setOutput[kXUBufferSizeInBytes] = {kXUWriteTask, kXUSetGPIODirection, kGPIONumberLED, kGPIODirectionOut};
+
+            isLEDOutput = false;
+            sendXUTask(XU_WRITE, setInput);
+            sendXUTask(XU_READ, getValue);
+            sendXUTask(XU_WRITE, setOutput);
+            isLEDOutput = true;
+
+            return getValue[kXUResultOffset] != 0;
+        }
+
+        uint16_t value = 0;
+
+        ControlTransfer controlTransfer = {kUVCRequestTypeIn,
+            kUVCRequestGetCurrent,
+            uint16_t(uvcControlCode(cameraControl) << 8),
+            kUVCUnitID << 8,
+            kUVCControlValueSizeInBytes,
+            reinterpret_cast<uint8_t*>(&value)};
+
+        transfer(controlTransfer);
+
+        return value;
+    }
+
+    void ControlSession::writeControl(CameraControl cameraControl, uint16_t value) {
+        // The temperature the camera holds under automatic white balance isn't known, so it's always written
+        bool isVolatile = cameraControl == WHITE_BALANCE_TEMPERATURE && values[AUTO_WHITE_BALANCE_TEMPERATURE] != uint16_t(0);
+
+        if (values[cameraControl] == value && !isVolatile) {
+            return;
+        }
+
+        // Unknown until the write succeeds
+        values[cameraControl].reset();
+
+        if (cameraControl == LED) {
+            if (!isLEDOutput) {
+                uint8_t setOutput[kXUBufferSizeInBytes] = {kXUWriteTask, kXUSetGPIODirection, kGPIONumberLED, kGPIODirectionOut};
+                sendXUTask(XU_WRITE, setOutput);
+                isLEDOutput = true;
+            }
+
+            uint8_t setValue[kXUBufferSizeInBytes] = {kXUWriteTask, kXUSetGPIOValue, kGPIONumberLED, uint8_t(value != 0)};
+            sendXUTask(XU_WRITE, setValue);
+
+            values[LED] = value != 0;
+            return;
+        }
+
+        ControlTransfer controlTransfer = {kUVCRequestTypeOut,
+            kUVCRequestSetCurrent,
+            uint16_t(uvcControlCode(cameraControl) << 8),
+            kUVCUnitID << 8,
+            kUVCControlValueSizeInBytes,
+            reinterpret_cast<uint8_t*>(&value)};
+
+        transfer(controlTransfer);
+
+        values[cameraControl] = value;
+    }
+
+    void ControlSession::transfer(ControlTransfer& controlTransfer) {
+        transferCount++;
+        controlTransport->transfer(controlTransfer);
+    }
+
+    void ControlSession::sendXUTask(XURequest xuRequest, uint8_t* data) {
+        ControlTransfer setTask = {kXURequestTypeOut, kUVCRequestSetCurrent, kXUControlSelector << 8, kXUID << 8, kXUBufferSizeInBytes, data};
+        transfer(setTask);
+
+        if (xuRequest == XU_READ) {
+            ControlTransfer getResult = {kXURequestTypeIn, kUVCRequestGetCurrent, kXUControlSelector << 8, kXUID << 8, kXUBufferSizeInBytes, data};
+            transfer(getResult);
+        }
+    }
+
+    void ControlSession::readFlashChunk(uint32_t address, size_t length, uint8_t* output) {
+        uint8_t data[kXUBufferSizeInBytes] = {kXUReadTask, kXUReadFlash, 0x03};
+        data[5] = (address >> 24) & 0xff;
+        data[6] = (address >> 16) & 0xff;
+        data[7] = (address >> 8) & 0xff;
+        data[8] = address & 0xff;
+
+        size_t packedLength = 36864 + length;
+        data[9] = (packedLength >> 8) & 0xff;
+        data[10] = packedLength & 0xff;
+        data[11] = (length >> 8) & 0xff;
+        data[12] = length & 0xff;
+
+        sendXURequest(XU_READ, data);
+
+        memcpy(output, &data[kXUResultOffset], length);
+    }
+}
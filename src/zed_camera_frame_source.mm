@@ -0,0 +1,143 @@
+//
+// zed_camera_frame_source.mm
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_camera_frame_source.h"
+#import "ZEDVideoCapture.h"
+
+using namespace std;
+
+namespace zed {
+
+    struct CameraFrameSourceImpl {
+        ZEDVideoCapture* wrapped;
+        NSString* device;
+
+        CameraFrameSourceImpl(const string& device) {
+            wrapped = [[ZEDVideoCapture alloc] init];
+            this->device = device.empty() ? nil : [NSString stringWithUTF8String:device.c_str()];
+        };
+    };
+
+    CameraFrameSource::CameraFrameSource(const string& device) {
+        impl = new CameraFrameSourceImpl(device);
+    }
+
+    vector<DeviceInfo> CameraFrameSource::listDevices() {
+        return [ZEDVideoCapture availableDevices];
+    }
+
+    CameraFrameSource::~CameraFrameSource() {
+        [impl->wrapped close];
+        delete impl;
+    }
+
+    void CameraFrameSource::open(Resolution resolution, FrameRate frameRate, ColorSpace rawColorSpace) {
+        bool result = [impl->wrapped openWithResolution:resolution frameRate:frameRate colorSpace:rawColorSpace device:impl->device];
+
+        if (!result) {
+            throw runtime_error("Failed to open ZEDVideoCapture stream");
+        }
+    }
+
+    void CameraFrameSource::close() {
+        [impl->wrapped close];
+    }
+
+    void CameraFrameSource::start(function<void(Frame)> rawFrameHandler) {
+        void (^frameProcessingBlock)(Frame) = ^(Frame frame) {
+            rawFrameHandler(frame);
+        };
+
+        [impl->wrapped start:frameProcessingBlock];
+    }
+
+    void CameraFrameSource::stop() {
+        [impl->wrapped stop];
+    }
+
+    size_t CameraFrameSource::getRawFrameCapacity() {
+        return impl->wrapped.rawFrameCapacity;
+    }
+
+    string CameraFrameSource::getDeviceID() {
+        string deviceID = [impl->wrapped.deviceID UTF8String];
+        return deviceID;
+    }
+
+    string CameraFrameSource::getDeviceName() {
+        string deviceName = [impl->wrapped.deviceName UTF8String];
+        return deviceName;
+    }
+
+    string CameraFrameSource::getDeviceSerialNumber() {
+        string deviceSerialNumber = [impl->wrapped.deviceSerialNumber UTF8String];
+        return deviceSerialNumber;
+    }
+
+    string CameraFrameSource::readCalibration() {
+        return [impl->wrapped readCalibration];
+    }
+
+    uint16_t CameraFrameSource::getControlValue(CameraControl cameraControl) {
+        switch (cameraControl) {
+            case BRIGHTNESS:
+                return impl->wrapped.brightness;
+            case CONTRAST:
+                return impl->wrapped.contrast;
+            case HUE:
+                return impl->wrapped.hue;
+            case SATURATION:
+                return impl->wrapped.saturation;
+            case SHARPNESS:
+                return impl->wrapped.sharpness;
+            case WHITE_BALANCE_TEMPERATURE:
+                return impl->wrapped.whiteBalanceTemperature;
+            case AUTO_WHITE_BALANCE_TEMPERATURE:
+                return impl->wrapped.autoWhiteBalanceTemperature;
+            case LED:
+                return impl->wrapped.isLEDOn;
+        }
+    }
+
+    void CameraFrameSource::setControlValue(CameraControl cameraControl, uint16_t value) {
+        switch (cameraControl) {
+            case BRIGHTNESS:
+                [impl->wrapped setBrightness:value];
+                break;
+            case CONTRAST:
+                [impl->wrapped setContrast:value];
+                break;
+            case HUE:
+                [impl->wrapped setHue:value];
+                break;
+            case SATURATION:
+                [impl->wrapped setSaturation:value];
+                break;
+            case SHARPNESS:
+                [impl->wrapped setSharpness:value];
+                break;
+            case WHITE_BALANCE_TEMPERATURE:
+                [impl->wrapped setWhiteBalanceTemperature:value];
+                break;
+            case AUTO_WHITE_BALANCE_TEMPERATURE:
+                [impl->wrapped setAutoWhiteBalanceTemperature:value != 0];
+                break;
+            case LED:
+                if (value != 0) {
+                    [impl->wrapped turnOnLED];
+                }
+                else {
+                    [impl->wrapped turnOffLED];
+                }
+                break;
+        }
+    }
+
+    void CameraFrameSource::applySettings(const CameraSettings& cameraSettings) {
+        [impl->wrapped applySettings:cameraSettings];
+    }
+}
@@ -0,0 +1,164 @@
+//
+// zed_capture_stats.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_capture_stats.h"
+#include <algorithm>
+#include <bit>
+#include <format>
+
+using namespace std;
+
+namespace zed {
+
+#pragma mark - LatencySummary
+
+    static string formatNanoseconds(uint64_t nanoseconds) {
+        if (nanoseconds < 1'000) {
+            return format("{} ns", nanoseconds);
+        }
+        else if (nanoseconds < 1'000'000) {
+            return format("{:.1f} us", nanoseconds / 1e3);
+        }
+        else {
+            return format("{:.2f} ms", nanoseconds / 1e6);
+        }
+    }
+
+    string LatencySummary::toString() const {
+        if (count == 0) {
+            return "no samples";
+        }
+
+        return format("n = {}, mean = {}, p50 = {}, p90 = {}, p99 = {}, min = {}, max = {}",
+            count,
+            formatNanoseconds(mean),
+            formatNanoseconds(p50),
+            formatNanoseconds(p90),
+            formatNanoseconds(p99),
+            formatNanoseconds(min),
+            formatNanoseconds(max));
+    }
+
+#pragma mark - LatencyHistogram
+
+    LatencyHistogram::LatencyHistogram() {
+        reset();
+    }
+
+    void LatencyHistogram::record(uint64_t nanoseconds) {
+        buckets[bucketIndex(nanoseconds)].fetch_add(1, memory_order_relaxed);
+        count.fetch_add(1, memory_order_relaxed);
+        sum.fetch_add(nanoseconds, memory_order_relaxed);
+
+        uint64_t currentMin = minimum.load(memory_order_relaxed);
+        while (nanoseconds < currentMin && !minimum.compare_exchange_weak(currentMin, nanoseconds, memory_order_relaxed)) {}
+
+        uint64_t currentMax = maximum.load(memory_order_relaxed);
+        while (nanoseconds > currentMax && !maximum.compare_exchange_weak(currentMax, nanoseconds, memory_order_relaxed)) {}
+    }
+
+    LatencySummary LatencyHistogram::summarize() const {
+        LatencySummary summary;
+
+        // Buckets are summed rather than trusting `count`, so percentiles stay consistent while values are recorded
+        uint64_t bucketCounts[kBucketCount];
+        uint64_t totalCount = 0;
+
+        for (size_t i = 0; i < kBucketCount; i++) {
+            bucketCounts[i] = buckets[i].load(memory_order_relaxed);
+            totalCount += bucketCounts[i];
+        }
+
+        if (totalCount == 0) {
+            return summary;
+        }
+
+        summary.count = totalCount;
+        summary.mean = sum.load(memory_order_relaxed) / max(count.load(memory_order_relaxed), uint64_t(1));
+        summary.min = minimum.load(memory_order_relaxed);
+        summary.max = maximum.load(memory_order_relaxed);
+
+        auto percentile = [&](double fraction) {
+            uint64_t rank = max(uint64_t(fraction * totalCount + 0.5), uint64_t(1));
+            uint64_t cumulativeCount = 0;
+
+            for (size_t i = 0; i < kBucketCount; i++) {
+                cumulativeCount += bucketCounts[i];
+
+                if (cumulativeCount >= rank) {
+                    return clamp(bucketMidpoint(i), summary.min, max(summary.min, summary.max));
+                }
+            }
+
+            return summary.max;
+        };
+
+        summary.p50 = percentile(0.50);
+        summary.p90 = percentile(0.90);
+        summary.p99 = percentile(0.99);
+
+        return summary;
+    }
+
+    void LatencyHistogram::reset() {
+        for (size_t i = 0; i < kBucketCount; i++) {
+            buckets[i].store(0, memory_order_relaxed);
+        }
+
+        count.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        minimum.store(UINT64_MAX, memory_order_relaxed);
+        maximum.store(0, memory_order_relaxed);
+    }
+
+    size_t LatencyHistogram::bucketIndex(uint64_t nanoseconds) {
+        if (nanoseconds < kSubBucketCount) {
+            return nanoseconds;
+        }
+
+        // The leading bit picks the bucket group, the next kSubBucketBits bits pick the bucket within it
+        size_t exponent = 63 - countl_zero(nanoseconds);
+        size_t subBucket = (nanoseconds >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+
+        return (exponent - kSubBucketBits + 1) * kSubBucketCount + subBucket;
+    }
+
+    uint64_t LatencyHistogram::bucketMidpoint(size_t index) {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+
+        size_t exponent = index / kSubBucketCount + kSubBucketBits - 1;
+        uint64_t subBucket = index % kSubBucketCount;
+        uint64_t bucketWidth = uint64_t(1) << (exponent - kSubBucketBits);
+
+        return (kSubBucketCount + subBucket) * bucketWidth + bucketWidth / 2;
+    }
+
+#pragma mark - CaptureStats
+
+    string CaptureStats::toString() const {
+        return format("Frames: captured = {}, delivered = {}, dropped = {} (pool = {}, queue = {}), blocked = {}, backlog = {}\n"
+                      "Source latency:    {}\n"
+                      "Conversion time:   {}\n"
+                      "Queue wait:        {}\n"
+                      "Callback duration: {}\n"
+                      "Total latency:     {}",
+            capturedFrameCount,
+            deliveredFrameCount,
+            droppedFrameCount,
+            poolDroppedFrameCount,
+            queueDroppedFrameCount,
+            blockedFrameCount,
+            backlogCount,
+            sourceLatency.toString(),
+            conversionTime.toString(),
+            queueWait.toString(),
+            callbackDuration.toString(),
+            totalLatency.toString());
+    }
+}
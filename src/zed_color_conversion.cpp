@@ -0,0 +1,557 @@
+//
+// zed_color_conversion.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_color_conversion.h"
+#include "zed_image_pyramid.h"
+#include "zed_yuv_conversion.h"
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZED_X86 1
+#include <immintrin.h>
+#define ZED_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define ZED_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace zed {
+
+    typedef void (*RowSplitter)(const uint8_t* source, uint8_t* luma, uint8_t* cb, uint8_t* cr, size_t width);
+
+#pragma mark - Scalar
+
+    template <bool isBGR> static void convertRowToRGBScalar(const uint8_t* source, uint8_t* destination, size_t width) {
+        for (size_t x = 0; x + 1 < width; x += 2) {
+            const uint8_t* yuyv = source + x * 2;
+            convertYUVPixel<isBGR>(yuyv[0], yuyv[1], yuyv[3], destination + x * 3);
+            convertYUVPixel<isBGR>(yuyv[2], yuyv[1], yuyv[3], destination + x * 3 + 3);
+        }
+    }
+
+    static void convertRowToGreyscaleScalar(const uint8_t* source, uint8_t* destination, size_t width) {
+        for (size_t x = 0; x < width; x++) {
+            destination[x] = source[x * 2];
+        }
+    }
+
+    static void copyRow(const uint8_t* source, uint8_t* destination, size_t width) {
+        memcpy(destination, source, width * 2);
+    }
+
+    static void splitRowScalar(const uint8_t* source, uint8_t* luma, uint8_t* cb, uint8_t* cr, size_t width) {
+        for (size_t x = 0; x + 1 < width; x += 2) {
+            const uint8_t* yuyv = source + x * 2;
+            luma[x] = yuyv[0];
+            luma[x + 1] = yuyv[2];
+            cb[x / 2] = yuyv[1];
+            cr[x / 2] = yuyv[3];
+        }
+    }
+
+#pragma mark - SSE4
+
+#if ZED_X86
+    // Interleaves 8 pixels of three 8-bit channels (low 8 bytes of each register) into 24 bytes
+    ZED_TARGET_SSE4 static inline void storeInterleaved8(__m128i first, __m128i second, __m128i third, uint8_t* destination) {
+        const __m128i firstSecondMask0 = _mm_setr_epi8(0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1, 10);
+        const __m128i thirdMask0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+        const __m128i firstSecondMask1 = _mm_setr_epi8(11, -1, 12, 13, -1, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i thirdMask1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        __m128i firstSecond = _mm_unpacklo_epi8(first, second);
+
+        __m128i output0 = _mm_or_si128(_mm_shuffle_epi8(firstSecond, firstSecondMask0), _mm_shuffle_epi8(third, thirdMask0));
+        __m128i output1 = _mm_or_si128(_mm_shuffle_epi8(firstSecond, firstSecondMask1), _mm_shuffle_epi8(third, thirdMask1));
+
+        _mm_storeu_si128((__m128i*)destination, output0);
+        _mm_storel_epi64((__m128i*)(destination + 16), output1);
+    }
+
+    // Computes one channel for 8 pixels: (luma + chroma . coefficients) >> shift, saturated to 8 bits
+    ZED_TARGET_SSE4 static inline __m128i computeChannel8(__m128i lumaLow, __m128i lumaHigh, __m128i chromaLow, __m128i chromaHigh, __m128i coefficients) {
+        __m128i low = _mm_srai_epi32(_mm_add_epi32(lumaLow, _mm_madd_epi16(chromaLow, coefficients)), kYUVShift);
+        __m128i high = _mm_srai_epi32(_mm_add_epi32(lumaHigh, _mm_madd_epi16(chromaHigh, coefficients)), kYUVShift);
+        __m128i packed = _mm_packs_epi32(low, high);
+
+        return _mm_packus_epi16(packed, packed);
+    }
+
+    template <bool isBGR> ZED_TARGET_SSE4 static void convertRowToRGBSSE4(const uint8_t* source, uint8_t* destination, size_t width) {
+        const __m128i lowByteMask = _mm_set1_epi16(0x00ff);
+        const __m128i lumaOffset = _mm_set1_epi16(kYUVLumaOffset);
+        const __m128i chromaOffset = _mm_set1_epi16(kYUVChromaOffset);
+        const __m128i rounding = _mm_set1_epi16(kYUVRounding);
+
+        // Coefficients are applied to (luma, rounding) and (Cb, Cr) pairs with `madd`
+        const __m128i lumaCoefficients = _mm_set1_epi32((1 << 16) | kYUVLumaCoefficient);
+        const __m128i rCoefficients = _mm_set1_epi32(kYUVCrToRCoefficient << 16);
+        const __m128i gCoefficients = _mm_set1_epi32((kYUVCrToGCoefficient * (1 << 16)) | (kYUVCbToGCoefficient & 0xffff));
+        const __m128i bCoefficients = _mm_set1_epi32(kYUVCbToBCoefficient);
+
+        size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            __m128i yuyv = _mm_loadu_si128((const __m128i*)(source + x * 2));
+
+            __m128i luma = _mm_sub_epi16(_mm_and_si128(yuyv, lowByteMask), lumaOffset);
+            __m128i chroma = _mm_sub_epi16(_mm_srli_epi16(yuyv, 8), chromaOffset);
+
+            __m128i lumaLow = _mm_madd_epi16(_mm_unpacklo_epi16(luma, rounding), lumaCoefficients);
+            __m128i lumaHigh = _mm_madd_epi16(_mm_unpackhi_epi16(luma, rounding), lumaCoefficients);
+
+            // Each (Cb, Cr) pair is shared by two neighbouring pixels
+            __m128i chromaLow = _mm_unpacklo_epi32(chroma, chroma);
+            __m128i chromaHigh = _mm_unpackhi_epi32(chroma, chroma);
+
+            __m128i r = computeChannel8(lumaLow, lumaHigh, chromaLow, chromaHigh, rCoefficients);
+            __m128i g = computeChannel8(lumaLow, lumaHigh, chromaLow, chromaHigh, gCoefficients);
+            __m128i b = computeChannel8(lumaLow, lumaHigh, chromaLow, chromaHigh, bCoefficients);
+
+            storeInterleaved8(isBGR ? b : r, g, isBGR ? r : b, destination + x * 3);
+        }
+
+        convertRowToRGBScalar<isBGR>(source + x * 2, destination + x * 3, width - x);
+    }
+
+    ZED_TARGET_SSE4 static void convertRowToGreyscaleSSE4(const uint8_t* source, uint8_t* destination, size_t width) {
+        const __m128i lowByteMask = _mm_set1_epi16(0x00ff);
+
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m128i yuyv0 = _mm_loadu_si128((const __m128i*)(source + x * 2));
+            __m128i yuyv1 = _mm_loadu_si128((const __m128i*)(source + x * 2 + 16));
+
+            __m128i luma = _mm_packus_epi16(_mm_and_si128(yuyv0, lowByteMask), _mm_and_si128(yuyv1, lowByteMask));
+            _mm_storeu_si128((__m128i*)(destination + x), luma);
+        }
+
+        convertRowToGreyscaleScalar(source + x * 2, destination + x, width - x);
+    }
+
+    ZED_TARGET_SSE4 static void splitRowSSE4(const uint8_t* source, uint8_t* luma, uint8_t* cb, uint8_t* cr, size_t width) {
+        const __m128i lowByteMask = _mm_set1_epi16(0x00ff);
+
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m128i yuyv0 = _mm_loadu_si128((const __m128i*)(source + x * 2));
+            __m128i yuyv1 = _mm_loadu_si128((const __m128i*)(source + x * 2 + 16));
+
+            __m128i lumaPixels = _mm_packus_epi16(_mm_and_si128(yuyv0, lowByteMask), _mm_and_si128(yuyv1, lowByteMask));
+
+            // Cb0, Cr0, Cb1, Cr1, ... for 8 pixel pairs
+            __m128i chroma = _mm_packus_epi16(_mm_srli_epi16(yuyv0, 8), _mm_srli_epi16(yuyv1, 8));
+            __m128i cbPixels = _mm_packus_epi16(_mm_and_si128(chroma, lowByteMask), _mm_setzero_si128());
+            __m128i crPixels = _mm_packus_epi16(_mm_srli_epi16(chroma, 8), _mm_setzero_si128());
+
+            _mm_storeu_si128((__m128i*)(luma + x), lumaPixels);
+            _mm_storel_epi64((__m128i*)(cb + x / 2), cbPixels);
+            _mm_storel_epi64((__m128i*)(cr + x / 2), crPixels);
+        }
+
+        splitRowScalar(source + x * 2, luma + x, cb + x / 2, cr + x / 2, width - x);
+    }
+
+#pragma mark - AVX2
+
+    // AVX2 variant of `computeChannel8`, each 128-bit lane holds 8 pixels
+    ZED_TARGET_AVX2 static inline __m256i computeChannel16(__m256i lumaLow, __m256i lumaHigh, __m256i chromaLow, __m256i chromaHigh, __m256i coefficients) {
+        __m256i low = _mm256_srai_epi32(_mm256_add_epi32(lumaLow, _mm256_madd_epi16(chromaLow, coefficients)), kYUVShift);
+        __m256i high = _mm256_srai_epi32(_mm256_add_epi32(lumaHigh, _mm256_madd_epi16(chromaHigh, coefficients)), kYUVShift);
+        __m256i packed = _mm256_packs_epi32(low, high);
+
+        return _mm256_packus_epi16(packed, packed);
+    }
+
+    template <bool isBGR> ZED_TARGET_AVX2 static void convertRowToRGBAVX2(const uint8_t* source, uint8_t* destination, size_t width) {
+        const __m256i lowByteMask = _mm256_set1_epi16(0x00ff);
+        const __m256i lumaOffset = _mm256_set1_epi16(kYUVLumaOffset);
+        const __m256i chromaOffset = _mm256_set1_epi16(kYUVChromaOffset);
+        const __m256i rounding = _mm256_set1_epi16(kYUVRounding);
+
+        const __m256i lumaCoefficients = _mm256_set1_epi32((1 << 16) | kYUVLumaCoefficient);
+        const __m256i rCoefficients = _mm256_set1_epi32(kYUVCrToRCoefficient << 16);
+        const __m256i gCoefficients = _mm256_set1_epi32((kYUVCrToGCoefficient * (1 << 16)) | (kYUVCbToGCoefficient & 0xffff));
+        const __m256i bCoefficients = _mm256_set1_epi32(kYUVCbToBCoefficient);
+
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            __m256i yuyv = _mm256_loadu_si256((const __m256i*)(source + x * 2));
+
+            __m256i luma = _mm256_sub_epi16(_mm256_and_si256(yuyv, lowByteMask), lumaOffset);
+            __m256i chroma = _mm256_sub_epi16(_mm256_srli_epi16(yuyv, 8), chromaOffset);
+
+            __m256i lumaLow = _mm256_madd_epi16(_mm256_unpacklo_epi16(luma, rounding), lumaCoefficients);
+            __m256i lumaHigh = _mm256_madd_epi16(_mm256_unpackhi_epi16(luma, rounding), lumaCoefficients);
+
+            __m256i chromaLow = _mm256_unpacklo_epi32(chroma, chroma);
+            __m256i chromaHigh = _mm256_unpackhi_epi32(chroma, chroma);
+
+            __m256i r = computeChannel16(lumaLow, lumaHigh, chromaLow, chromaHigh, rCoefficients);
+            __m256i g = computeChannel16(lumaLow, lumaHigh, chromaLow, chromaHigh, gCoefficients);
+            __m256i b = computeChannel16(lumaLow, lumaHigh, chromaLow, chromaHigh, bCoefficients);
+
+            __m256i first = isBGR ? b : r;
+            __m256i third = isBGR ? r : b;
+
+            storeInterleaved8(_mm256_castsi256_si128(first), _mm256_castsi256_si128(g), _mm256_castsi256_si128(third), destination + x * 3);
+            storeInterleaved8(_mm256_extracti128_si256(first, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(third, 1), destination + x * 3 + 24);
+        }
+
+        convertRowToRGBScalar<isBGR>(source + x * 2, destination + x * 3, width - x);
+    }
+
+    ZED_TARGET_AVX2 static void convertRowToGreyscaleAVX2(const uint8_t* source, uint8_t* destination, size_t width) {
+        const __m256i lowByteMask = _mm256_set1_epi16(0x00ff);
+
+        size_t x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            __m256i yuyv0 = _mm256_loadu_si256((const __m256i*)(source + x * 2));
+            __m256i yuyv1 = _mm256_loadu_si256((const __m256i*)(source + x * 2 + 32));
+
+            // Packing works per 128-bit lane, so the 64-bit quarters need reordering afterwards
+            __m256i luma = _mm256_packus_epi16(_mm256_and_si256(yuyv0, lowByteMask), _mm256_and_si256(yuyv1, lowByteMask));
+            luma = _mm256_permute4x64_epi64(luma, 0xd8);
+
+            _mm256_storeu_si256((__m256i*)(destination + x), luma);
+        }
+
+        convertRowToGreyscaleSSE4(source + x * 2, destination + x, width - x);
+    }
+#endif
+
+#pragma mark - NEON
+
+#if defined(__ARM_NEON)
+    // Computes one channel for 8 pixels: (luma + Cb * cbCoefficient + Cr * crCoefficient) >> shift, saturated to 8 bits
+    static inline uint8x8_t computeChannel8(int16x8_t luma, int16x8_t cb, int16x8_t cr, int16_t cbCoefficient, int16_t crCoefficient) {
+        int32x4_t low = vmlal_n_s16(vdupq_n_s32(kYUVRounding), vget_low_s16(luma), kYUVLumaCoefficient);
+        int32x4_t high = vmlal_n_s16(vdupq_n_s32(kYUVRounding), vget_high_s16(luma), kYUVLumaCoefficient);
+
+        low = vmlal_n_s16(vmlal_n_s16(low, vget_low_s16(cb), cbCoefficient), vget_low_s16(cr), crCoefficient);
+        high = vmlal_n_s16(vmlal_n_s16(high, vget_high_s16(cb), cbCoefficient), vget_high_s16(cr), crCoefficient);
+
+        return vqmovun_s16(vcombine_s16(vshrn_n_s32(low, kYUVShift), vshrn_n_s32(high, kYUVShift)));
+    }
+
+    template <bool isBGR> static inline uint8x8x3_t convertPixels8(int16x8_t luma, int16x8_t cb, int16x8_t cr) {
+        uint8x8_t r = computeChannel8(luma, cb, cr, 0, kYUVCrToRCoefficient);
+        uint8x8_t g = computeChannel8(luma, cb, cr, kYUVCbToGCoefficient, kYUVCrToGCoefficient);
+        uint8x8_t b = computeChannel8(luma, cb, cr, kYUVCbToBCoefficient, 0);
+
+        uint8x8x3_t pixels;
+        pixels.val[0] = isBGR ? b : r;
+        pixels.val[1] = g;
+        pixels.val[2] = isBGR ? r : b;
+
+        return pixels;
+    }
+
+    template <bool isBGR> static void convertRowToRGBNEON(const uint8_t* source, uint8_t* destination, size_t width) {
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            // val[0] = Y0...Y15, val[1] = Cb0, Cr0, Cb1, Cr1, ...
+            uint8x16x2_t yuyv = vld2q_u8(source + x * 2);
+            uint8x8x2_t chroma = vuzp_u8(vget_low_u8(yuyv.val[1]), vget_high_u8(yuyv.val[1]));
+
+            int16x8_t cb = vreinterpretq_s16_u16(vsubl_u8(chroma.val[0], vdup_n_u8(kYUVChromaOffset)));
+            int16x8_t cr = vreinterpretq_s16_u16(vsubl_u8(chroma.val[1], vdup_n_u8(kYUVChromaOffset)));
+
+            // Each (Cb, Cr) pair is shared by two neighbouring pixels
+            int16x8x2_t cbPixels = vzipq_s16(cb, cb);
+            int16x8x2_t crPixels = vzipq_s16(cr, cr);
+
+            int16x8_t lumaLow = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(yuyv.val[0]), vdup_n_u8(kYUVLumaOffset)));
+            int16x8_t lumaHigh = vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(yuyv.val[0]), vdup_n_u8(kYUVLumaOffset)));
+
+            vst3_u8(destination + x * 3, convertPixels8<isBGR>(lumaLow, cbPixels.val[0], crPixels.val[0]));
+            vst3_u8(destination + x * 3 + 24, convertPixels8<isBGR>(lumaHigh, cbPixels.val[1], crPixels.val[1]));
+        }
+
+        convertRowToRGBScalar<isBGR>(source + x * 2, destination + x * 3, width - x);
+    }
+
+    static void convertRowToGreyscaleNEON(const uint8_t* source, uint8_t* destination, size_t width) {
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x2_t yuyv = vld2q_u8(source + x * 2);
+            vst1q_u8(destination + x, yuyv.val[0]);
+        }
+
+        convertRowToGreyscaleScalar(source + x * 2, destination + x, width - x);
+    }
+
+    static void splitRowNEON(const uint8_t* source, uint8_t* luma, uint8_t* cb, uint8_t* cr, size_t width) {
+        size_t x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            // val[0] = Y0, val[1] = Cb, val[2] = Y1, val[3] = Cr for 16 pixel pairs
+            uint8x16x4_t yuyv = vld4q_u8(source + x * 2);
+
+            uint8x16x2_t lumaPixels;
+            lumaPixels.val[0] = yuyv.val[0];
+            lumaPixels.val[1] = yuyv.val[2];
+
+            vst2q_u8(luma + x, lumaPixels);
+            vst1q_u8(cb + x / 2, yuyv.val[1]);
+            vst1q_u8(cr + x / 2, yuyv.val[3]);
+        }
+
+        splitRowScalar(source + x * 2, luma + x, cb + x / 2, cr + x / 2, width - x);
+    }
+#endif
+
+#pragma mark - Dispatch
+
+    RowConverter rowConverterFor(InstructionSet instructionSet, ColorSpace colorSpace) {
+        if (colorSpace == YUV) {
+            return copyRow;
+        }
+
+        switch (instructionSet) {
+#if ZED_X86
+            case AVX2:
+                return colorSpace == RGB ? convertRowToRGBAVX2<false> : (colorSpace == BGR ? convertRowToRGBAVX2<true> : convertRowToGreyscaleAVX2);
+            case SSE4:
+                return colorSpace == RGB ? convertRowToRGBSSE4<false> : (colorSpace == BGR ? convertRowToRGBSSE4<true> : convertRowToGreyscaleSSE4);
+#endif
+#if defined(__ARM_NEON)
+            case NEON:
+                return colorSpace == RGB ? convertRowToRGBNEON<false> : (colorSpace == BGR ? convertRowToRGBNEON<true> : convertRowToGreyscaleNEON);
+#endif
+            default:
+                return colorSpace == RGB ? convertRowToRGBScalar<false> : (colorSpace == BGR ? convertRowToRGBScalar<true> : convertRowToGreyscaleScalar);
+        }
+    }
+
+    static RowSplitter rowSplitterFor(InstructionSet instructionSet) {
+        switch (instructionSet) {
+#if ZED_X86
+            // Splitting is bound by memory bandwidth, so AVX2 gains nothing over SSE4
+            case AVX2:
+            case SSE4:
+                return splitRowSSE4;
+#endif
+#if defined(__ARM_NEON)
+            case NEON:
+                return splitRowNEON;
+#endif
+            default:
+                return splitRowScalar;
+        }
+    }
+
+#pragma mark - Public
+
+    ColorConverter::ColorConverter(size_t threadCount) : ColorConverter(threadCount, detectInstructionSet()) {}
+
+    ColorConverter::ColorConverter(size_t threadCount, InstructionSet instructionSet) {
+        if (!isSupported(instructionSet)) {
+            throw runtime_error(format("Instruction set {} is not supported on this CPU", instructionSetToString(instructionSet)));
+        }
+
+        this->instructionSet = instructionSet;
+        threadPool = make_unique<ThreadPool>(threadCount);
+    }
+
+    void ColorConverter::convert(const uint8_t* source,
+        size_t sourceRowBytes,
+        uint8_t* destination,
+        size_t destinationRowBytes,
+        size_t height,
+        size_t width,
+        ColorSpace colorSpace) {
+
+        RowConverter convertRow = rowConverterFor(instructionSet, colorSpace);
+
+        size_t bandCount = min(threadPool->getThreadCount(), height);
+        size_t bandHeight = bandCount > 0 ? (height + bandCount - 1) / bandCount : 0;
+
+        threadPool->parallelFor(bandCount, [=](size_t band) {
+            size_t startRow = band * bandHeight;
+            size_t endRow = min(startRow + bandHeight, height);
+
+            for (size_t row = startRow; row < endRow; row++) {
+                convertRow(source + row * sourceRowBytes, destination + row * destinationRowBytes, width);
+            }
+        });
+    }
+
+    void ColorConverter::convert(const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace) {
+        if (destination.getLayout() == SIDE_BY_SIDE && destination.getPyramidLevelCount() == 1) {
+            convert(source, sourceRowBytes, destination.getData(), destination.getRowBytes(), destination.getHeight(), destination.getWidth(), colorSpace);
+            return;
+        }
+
+        size_t eyeWidth = destination.getPlane(LEFT).width;
+        const uint8_t* eyeSources[2] = {source, source + eyeWidth * 2};
+
+        convertEyes(eyeSources, sourceRowBytes, destination, colorSpace);
+    }
+
+    void ColorConverter::convert(const uint8_t* source,
+        size_t sourceRowBytes,
+        size_t sourceEyeWidth,
+        const array<EyeRegion, 2>& regions,
+        Frame& destination,
+        ColorSpace colorSpace) {
+
+        FramePlane leftPlane = destination.getPlane(LEFT);
+        const uint8_t* eyeSources[2];
+
+        for (size_t eye = 0; eye < 2; eye++) {
+            const EyeRegion& region = regions[eye];
+
+            if (region.width != leftPlane.width || region.height != leftPlane.height) {
+                throw runtime_error(format("Region {} doesn't match the destination's eyes ({} x {})", region.toString(), leftPlane.width, leftPlane.height));
+            }
+
+            // 4:2:2 pixel pairs share their chroma, so regions cover whole pairs
+            if (region.x % 2 != 0 || region.width % 2 != 0 || region.x + region.width > sourceEyeWidth) {
+                throw runtime_error(format("Invalid region {} for {} pixel wide eyes", region.toString(), sourceEyeWidth));
+            }
+
+            eyeSources[eye] = source + region.y * sourceRowBytes + (eye * sourceEyeWidth + region.x) * 2;
+        }
+
+        convertEyes(eyeSources, sourceRowBytes, destination, colorSpace);
+    }
+
+    InstructionSet ColorConverter::getInstructionSet() {
+        return instructionSet;
+    }
+
+    size_t ColorConverter::getThreadCount() {
+        return threadPool->getThreadCount();
+    }
+
+    InstructionSet ColorConverter::detectInstructionSet() {
+        if (isSupported(AVX2)) {
+            return AVX2;
+        }
+        else if (isSupported(SSE4)) {
+            return SSE4;
+        }
+        else if (isSupported(NEON)) {
+            return NEON;
+        }
+        else {
+            return SCALAR;
+        }
+    }
+
+    bool ColorConverter::isSupported(InstructionSet instructionSet) {
+        switch (instructionSet) {
+            case SCALAR:
+                return true;
+#if ZED_X86
+            case SSE4:
+                return __builtin_cpu_supports("sse4.1");
+            case AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON)
+            case NEON:
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+#pragma mark - Private
+
+    void ColorConverter::convertEyes(const uint8_t* const eyeSources[2], size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace) {
+        bool isSideBySide = destination.getLayout() == SIDE_BY_SIDE;
+        bool isPlanar = destination.getLayout() == PLANAR;
+        size_t pyramidLevelCount = destination.getPyramidLevelCount();
+
+        if (isPlanar && colorSpace != YUV) {
+            throw runtime_error(format("Planar output is unavailable in the {} color space", colorSpaceToString(colorSpace)));
+        }
+
+        RowConverter convertRow = rowConverterFor(instructionSet, colorSpace);
+        RowSplitter splitRow = rowSplitterFor(instructionSet);
+
+        // Planes per eye (Y, U, V for planar frames), and each eye's pyramid levels
+        FramePlane planes[2][3];
+        FramePlane pyramids[2][kMaxPyramidLevelCount];
+        size_t componentCount = isPlanar ? 3 : 1;
+
+        for (size_t eye = 0; eye < 2; eye++) {
+            for (size_t i = 0; i < componentCount; i++) {
+                planes[eye][i] = destination.getPlane(Eye(eye), i);
+            }
+
+            for (size_t level = 0; level < pyramidLevelCount; level++) {
+                pyramids[eye][level] = destination.getPyramidLevel(level, Eye(eye));
+            }
+        }
+
+        size_t height = destination.getHeight();
+        size_t eyeWidth = planes[LEFT][0].width;
+
+        // Whole side-by-side rows are converted in one go
+        bool isContiguous = isSideBySide && eyeSources[RIGHT] == eyeSources[LEFT] + eyeWidth * 2;
+
+        // Rows are converted in chunks that complete whole rows of every pyramid level, which are downsampled while still in cache
+        size_t chunkHeight = size_t(1) << (pyramidLevelCount - 1);
+        size_t chunkCount = (height + chunkHeight - 1) / chunkHeight;
+        size_t bandCount = min(threadPool->getThreadCount(), chunkCount);
+        size_t chunksPerBand = bandCount > 0 ? (chunkCount + bandCount - 1) / bandCount : 0;
+
+        threadPool->parallelFor(bandCount, [&](size_t band) {
+            size_t endChunk = min((band + 1) * chunksPerBand, chunkCount);
+
+            for (size_t chunk = band * chunksPerBand; chunk < endChunk; chunk++) {
+                size_t startRow = chunk * chunkHeight;
+                size_t endRow = min(startRow + chunkHeight, height);
+
+                for (size_t row = startRow; row < endRow; row++) {
+                    if (isContiguous) {
+                        convertRow(eyeSources[LEFT] + row * sourceRowBytes, destination.getData() + row * destination.getRowBytes(), eyeWidth * 2);
+                        continue;
+                    }
+
+                    // Both eyes of a row are written while its source row is in cache
+                    for (size_t eye = 0; eye < 2; eye++) {
+                        const uint8_t* eyeSource = eyeSources[eye] + row * sourceRowBytes;
+                        const FramePlane* eyePlanes = planes[eye];
+
+                        if (isPlanar) {
+                            splitRow(eyeSource,
+                                eyePlanes[0].data + row * eyePlanes[0].rowBytes,
+                                eyePlanes[1].data + row * eyePlanes[1].rowBytes,
+                                eyePlanes[2].data + row * eyePlanes[2].rowBytes,
+                                eyeWidth);
+                        }
+                        else {
+                            convertRow(eyeSource, eyePlanes[0].data + row * eyePlanes[0].rowBytes, eyeWidth);
+                        }
+                    }
+                }
+
+                if (pyramidLevelCount > 1) {
+                    for (size_t eye = 0; eye < 2; eye++) {
+                        downsamplePyramidRegion(pyramids[eye], pyramidLevelCount, 0, startRow, eyeWidth, endRow);
+                    }
+                }
+            }
+        });
+    }
+}
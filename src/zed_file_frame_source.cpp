@@ -0,0 +1,90 @@
+//
+// zed_file_frame_source.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_file_frame_source.h"
+#include <format>
+#include <stdexcept>
+
+using namespace std;
+
+namespace zed {
+
+#pragma mark - Public
+
+    FileFrameSource::FileFrameSource(const path& filepath, PlaybackSpeed playbackSpeed, bool isLooping, const string& serialNumber)
+        : PacedFrameSource(playbackSpeed) {
+        this->filepath = filepath;
+        this->isLooping = isLooping;
+        this->serialNumber = serialNumber;
+        frameSize = 0;
+        frameCount = 0;
+    }
+
+    FileFrameSource::~FileFrameSource() {
+        stop();
+    }
+
+    string FileFrameSource::getDeviceID() {
+        return filepath.string();
+    }
+
+    string FileFrameSource::getDeviceName() {
+        return filepath.filename().string();
+    }
+
+    string FileFrameSource::getDeviceSerialNumber() {
+        return serialNumber;
+    }
+
+    size_t FileFrameSource::getFrameCount() {
+        return frameCount;
+    }
+
+#pragma mark - Protected
+
+    void FileFrameSource::prepare() {
+        size_t channels = rawColorSpace == YUV ? 2 : 1;
+        frameSize = size_t(stereoDimensions.width) * stereoDimensions.height * channels;
+
+        file.close();
+        file.clear();
+        file.open(filepath, ios::binary);
+
+        if (!file) {
+            throw runtime_error(format("Failed to open raw frame file: {}", filepath.string()));
+        }
+
+        frameCount = file_size(filepath) / frameSize;
+
+        if (frameCount == 0) {
+            throw runtime_error(format("Raw frame file {} holds no complete {} {} frames", filepath.string(), stereoDimensions.toString(), colorSpaceToString(rawColorSpace)));
+        }
+    }
+
+    bool FileFrameSource::produceFrame(uint8_t* data, size_t rowBytes, uint64_t frameIndex) {
+        if (frameIndex >= frameCount && !isLooping) {
+            return false;
+        }
+
+        // Frames skipped at native speed are skipped in the file too, so playback keeps real time
+        file.seekg(streamoff((frameIndex % frameCount) * frameSize));
+
+        size_t fileRowBytes = frameSize / stereoDimensions.height;
+
+        if (rowBytes == fileRowBytes) {
+            file.read(reinterpret_cast<char*>(data), streamsize(frameSize));
+        }
+        else {
+            for (size_t y = 0; y < size_t(stereoDimensions.height); y++) {
+                file.read(reinterpret_cast<char*>(data + y * rowBytes), streamsize(fileRowBytes));
+            }
+        }
+
+        // A failed read (e.g. the file was truncated during playback) ends the stream
+        return bool(file);
+    }
+}
@@ -0,0 +1,427 @@
+//
+// zed_frame.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_frame.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <format>
+#include <stdexcept>
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kFrameBufferAlignment 64
+
+namespace zed {
+
+    static size_t alignToBuffer(size_t size) {
+        return (size + kFrameBufferAlignment - 1) / kFrameBufferAlignment * kFrameBufferAlignment;
+    }
+
+    // Each eye of the frame covers the whole source eye
+    static void resetRegions(FrameSlot* slot) {
+        size_t eyeWidth = slot->layout == SIDE_BY_SIDE ? slot->width / 2 : slot->width;
+
+        slot->regions[LEFT] = EyeRegion {0, 0, eyeWidth, slot->height};
+        slot->regions[RIGHT] = EyeRegion {0, 0, eyeWidth, slot->height};
+    }
+
+#pragma mark - Frame
+
+    Frame::Frame() : slot(nullptr) {}
+
+    Frame::Frame(FrameSlot* slot) : slot(slot) {}
+
+    Frame::Frame(const Frame& other) : slot(other.slot) {
+        if (slot) {
+            slot->referenceCount.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    Frame::Frame(Frame&& other) noexcept : slot(other.slot) {
+        other.slot = nullptr;
+    }
+
+    Frame& Frame::operator=(const Frame& other) {
+        if (this != &other) {
+            release();
+            slot = other.slot;
+
+            if (slot) {
+                slot->referenceCount.fetch_add(1, memory_order_relaxed);
+            }
+        }
+
+        return *this;
+    }
+
+    Frame& Frame::operator=(Frame&& other) noexcept {
+        if (this != &other) {
+            release();
+            slot = other.slot;
+            other.slot = nullptr;
+        }
+
+        return *this;
+    }
+
+    Frame::~Frame() {
+        release();
+    }
+
+    Frame Frame::wrap(uint8_t* data, size_t height, size_t width, size_t channels, size_t rowBytes, function<void()> releaseHandler) {
+        FrameSlot* slot = new FrameSlot();
+        slot->data = data;
+        slot->height = height;
+        slot->width = width;
+        slot->channels = channels;
+        slot->rowBytes = rowBytes;
+        slot->timestamp = 0;
+        slot->sequenceNumber = 0;
+        slot->processedTimestamp = 0;
+        slot->deliveryTimestamp.store(0, memory_order_relaxed);
+        slot->rectification = RAW;
+        slot->layout = SIDE_BY_SIDE;
+        slot->planeCount = 1;
+        slot->planes[0] = FramePlane {data, height, width, channels, rowBytes};
+        resetRegions(slot);
+        slot->pyramidLevelCount = 1;
+        slot->referenceCount.store(1, memory_order_relaxed);
+        slot->poolIndex = 0;
+        slot->releaseHandler = std::move(releaseHandler);
+
+        return Frame(slot);
+    }
+
+    uint8_t* Frame::getData() const {
+        return slot ? slot->data : nullptr;
+    }
+
+    size_t Frame::getHeight() const {
+        return slot ? slot->height : 0;
+    }
+
+    size_t Frame::getWidth() const {
+        return slot ? slot->width : 0;
+    }
+
+    size_t Frame::getChannels() const {
+        return slot ? slot->channels : 0;
+    }
+
+    size_t Frame::getRowBytes() const {
+        return slot ? slot->rowBytes : 0;
+    }
+
+    FrameLayout Frame::getLayout() const {
+        return slot ? slot->layout : SIDE_BY_SIDE;
+    }
+
+    size_t Frame::getPlaneCount() const {
+        return slot ? slot->planeCount : 0;
+    }
+
+    FramePlane Frame::getPlane(size_t planeIndex) const {
+        if (planeIndex >= getPlaneCount()) {
+            throw out_of_range(format("Plane index {} is out of range for a frame with {} planes", planeIndex, getPlaneCount()));
+        }
+
+        return slot->planes[planeIndex];
+    }
+
+    FramePlane Frame::getPlane(Eye eye, size_t componentIndex) const {
+        if (!slot) {
+            throw out_of_range("Attempted to get a plane of an invalid frame");
+        }
+
+        size_t planesPerEye = slot->layout == SIDE_BY_SIDE ? 1 : slot->planeCount / 2;
+
+        if (componentIndex >= planesPerEye) {
+            throw out_of_range(format("Component index {} is out of range for a frame with {} planes per eye", componentIndex, planesPerEye));
+        }
+
+        if (slot->layout != SIDE_BY_SIDE) {
+            return slot->planes[eye * planesPerEye + componentIndex];
+        }
+
+        FramePlane plane = slot->planes[0];
+        plane.width /= 2;
+
+        if (eye == RIGHT) {
+            plane.data += plane.width * plane.channels;
+        }
+
+        return plane;
+    }
+
+    size_t Frame::getPyramidLevelCount() const {
+        return slot ? slot->pyramidLevelCount : 0;
+    }
+
+    FramePlane Frame::getPyramidLevel(size_t level, Eye eye) const {
+        if (level >= getPyramidLevelCount()) {
+            throw out_of_range(format("Pyramid level {} is out of range for a frame with {} levels", level, getPyramidLevelCount()));
+        }
+
+        return level == 0 ? getPlane(eye) : slot->pyramidPlanes[level - 1][eye];
+    }
+
+    uint64_t Frame::getTimestamp() const {
+        return slot ? slot->timestamp : 0;
+    }
+
+    void Frame::setTimestamp(uint64_t timestamp) {
+        if (slot) {
+            slot->timestamp = timestamp;
+        }
+    }
+
+    uint64_t Frame::getSequenceNumber() const {
+        return slot ? slot->sequenceNumber : 0;
+    }
+
+    void Frame::setSequenceNumber(uint64_t sequenceNumber) {
+        if (slot) {
+            slot->sequenceNumber = sequenceNumber;
+        }
+    }
+
+    uint64_t Frame::getProcessedTimestamp() const {
+        return slot ? slot->processedTimestamp : 0;
+    }
+
+    void Frame::setProcessedTimestamp(uint64_t processedTimestamp) {
+        if (slot) {
+            slot->processedTimestamp = processedTimestamp;
+        }
+    }
+
+    uint64_t Frame::getDeliveryTimestamp() const {
+        return slot ? slot->deliveryTimestamp.load(memory_order_relaxed) : 0;
+    }
+
+    void Frame::setDeliveryTimestamp(uint64_t deliveryTimestamp) {
+        if (slot) {
+            slot->deliveryTimestamp.store(deliveryTimestamp, memory_order_relaxed);
+        }
+    }
+
+    Rectification Frame::getRectification() const {
+        return slot ? slot->rectification : RAW;
+    }
+
+    void Frame::setRectification(Rectification rectification) {
+        if (slot) {
+            slot->rectification = rectification;
+        }
+    }
+
+    EyeRegion Frame::getRegion(Eye eye) const {
+        return slot ? slot->regions[eye] : EyeRegion();
+    }
+
+    void Frame::setRegion(Eye eye, EyeRegion region) {
+        if (slot) {
+            slot->regions[eye] = region;
+        }
+    }
+
+    bool Frame::isValid() const {
+        return slot != nullptr;
+    }
+
+    void Frame::release() {
+        if (!slot) {
+            return;
+        }
+
+        FrameSlot* releasedSlot = slot;
+        slot = nullptr;
+
+        if (releasedSlot->referenceCount.fetch_sub(1, memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        if (releasedSlot->pool) {
+            // Holding the pool here keeps it alive until the buffer has been returned
+            shared_ptr<FramePool> pool = std::move(releasedSlot->pool);
+            pool->recycle(releasedSlot);
+        }
+        else {
+            function<void()> releaseHandler = std::move(releasedSlot->releaseHandler);
+            delete releasedSlot;
+
+            if (releaseHandler) {
+                releaseHandler();
+            }
+        }
+    }
+
+#pragma mark - FramePool
+
+    shared_ptr<FramePool> FramePool::create(size_t capacity, size_t height, size_t width, size_t channels, FrameLayout frameLayout, size_t pyramidLevelCount) {
+        if (capacity == 0 || capacity > kMaxFramePoolCapacity) {
+            throw runtime_error(format("Invalid frame pool capacity: {} (expected 1 to {})", capacity, kMaxFramePoolCapacity));
+        }
+
+        if (pyramidLevelCount == 0 || pyramidLevelCount > kMaxPyramidLevelCount) {
+            throw runtime_error(format("Invalid pyramid level count: {} (expected 1 to {})", pyramidLevelCount, kMaxPyramidLevelCount));
+        }
+
+        return shared_ptr<FramePool>(new FramePool(capacity, height, width, channels, frameLayout, pyramidLevelCount));
+    }
+
+    FramePool::FramePool(size_t capacity, size_t height, size_t width, size_t channels, FrameLayout frameLayout, size_t pyramidLevelCount) {
+        // Only YUV frames have components to split, and only the other color spaces have pyramids
+        if (frameLayout == PLANAR && channels != 2) {
+            frameLayout = SEPARATE_EYES;
+        }
+
+        if (channels == 2) {
+            pyramidLevelCount = 1;
+        }
+
+        this->capacity = capacity;
+        this->height = height;
+        this->width = width;
+        this->channels = channels;
+        this->frameLayout = frameLayout;
+
+        // Plane shapes and offsets within a buffer, every plane starts on an aligned address with an aligned row stride
+        FramePlane planes[kMaxFramePlaneCount];
+        size_t planeOffsets[kMaxFramePlaneCount];
+        size_t planeCount = 0;
+        size_t bufferSize = 0;
+
+        auto allocatePlane = [&](size_t planeHeight, size_t planeWidth, size_t planeChannels, size_t rowBytes, size_t& planeOffset) {
+            planeOffset = bufferSize;
+            bufferSize += alignToBuffer(planeHeight * rowBytes);
+
+            return FramePlane {nullptr, planeHeight, planeWidth, planeChannels, rowBytes};
+        };
+
+        auto addPlane = [&](size_t planeWidth, size_t planeChannels, size_t rowBytes) {
+            planes[planeCount] = allocatePlane(height, planeWidth, planeChannels, rowBytes, planeOffsets[planeCount]);
+            planeCount++;
+        };
+
+        size_t eyeWidth = width / 2;
+
+        if (frameLayout == SIDE_BY_SIDE) {
+            addPlane(width, channels, width * channels);
+        }
+        else {
+            for (size_t eye = 0; eye < 2; eye++) {
+                if (frameLayout == PLANAR) {
+                    addPlane(eyeWidth, 1, alignToBuffer(eyeWidth));
+                    addPlane(eyeWidth / 2, 1, alignToBuffer(eyeWidth / 2));
+                    addPlane(eyeWidth / 2, 1, alignToBuffer(eyeWidth / 2));
+                }
+                else {
+                    addPlane(eyeWidth, channels, alignToBuffer(eyeWidth * channels));
+                }
+            }
+        }
+
+        FramePlane pyramidPlanes[kMaxPyramidLevelCount - 1][2];
+        size_t pyramidOffsets[kMaxPyramidLevelCount - 1][2];
+
+        for (size_t level = 1; level < pyramidLevelCount; level++) {
+            for (size_t eye = 0; eye < 2; eye++) {
+                size_t levelWidth = eyeWidth >> level;
+                pyramidPlanes[level - 1][eye] =
+                    allocatePlane(height >> level, levelWidth, channels, alignToBuffer(levelWidth * channels), pyramidOffsets[level - 1][eye]);
+            }
+        }
+
+        storage = static_cast<uint8_t*>(aligned_alloc(kFrameBufferAlignment, max(bufferSize * capacity, size_t(kFrameBufferAlignment))));
+
+        if (!storage) {
+            throw runtime_error(format("Failed to allocate {} frame buffers of {} bytes", capacity, bufferSize));
+        }
+
+        slots = make_unique<FrameSlot[]>(capacity);
+
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].layout = frameLayout;
+            slots[i].planeCount = planeCount;
+
+            for (size_t p = 0; p < planeCount; p++) {
+                slots[i].planes[p] = planes[p];
+                slots[i].planes[p].data = storage + i * bufferSize + planeOffsets[p];
+            }
+
+            slots[i].pyramidLevelCount = pyramidLevelCount;
+
+            for (size_t level = 1; level < pyramidLevelCount; level++) {
+                for (size_t eye = 0; eye < 2; eye++) {
+                    slots[i].pyramidPlanes[level - 1][eye] = pyramidPlanes[level - 1][eye];
+                    slots[i].pyramidPlanes[level - 1][eye].data = storage + i * bufferSize + pyramidOffsets[level - 1][eye];
+                }
+            }
+
+            slots[i].data = slots[i].planes[0].data;
+            slots[i].height = slots[i].planes[0].height;
+            slots[i].width = slots[i].planes[0].width;
+            slots[i].channels = slots[i].planes[0].channels;
+            slots[i].rowBytes = slots[i].planes[0].rowBytes;
+            slots[i].timestamp = 0;
+            slots[i].sequenceNumber = 0;
+            slots[i].processedTimestamp = 0;
+            slots[i].deliveryTimestamp.store(0, memory_order_relaxed);
+            slots[i].rectification = RAW;
+            resetRegions(&slots[i]);
+            slots[i].referenceCount.store(0, memory_order_relaxed);
+            slots[i].poolIndex = i;
+        }
+
+        freeMask.store(capacity == 64 ? ~uint64_t(0) : (uint64_t(1) << capacity) - 1, memory_order_release);
+    }
+
+    FramePool::~FramePool() {
+        free(storage);
+    }
+
+    Frame FramePool::acquire() {
+        uint64_t mask = freeMask.load(memory_order_acquire);
+
+        while (mask != 0) {
+            uint64_t lowestFreeBit = mask & (~mask + 1);
+
+            if (freeMask.compare_exchange_weak(mask, mask & ~lowestFreeBit, memory_order_acq_rel, memory_order_acquire)) {
+                FrameSlot* slot = &slots[countr_zero(lowestFreeBit)];
+                slot->timestamp = 0;
+                slot->sequenceNumber = 0;
+                slot->processedTimestamp = 0;
+                slot->deliveryTimestamp.store(0, memory_order_relaxed);
+                slot->rectification = RAW;
+                resetRegions(slot);
+                slot->referenceCount.store(1, memory_order_relaxed);
+                slot->pool = shared_from_this();
+
+                return Frame(slot);
+            }
+        }
+
+        return Frame();
+    }
+
+    size_t FramePool::getCapacity() {
+        return capacity;
+    }
+
+    size_t FramePool::getAvailableCount() {
+        return popcount(freeMask.load(memory_order_acquire));
+    }
+
+    void FramePool::recycle(FrameSlot* slot) {
+        freeMask.fetch_or(uint64_t(1) << slot->poolIndex, memory_order_release);
+    }
+}
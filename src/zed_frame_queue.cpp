@@ -0,0 +1,275 @@
+//
+// zed_frame_queue.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_frame_queue.h"
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kLatestFreshBit 0x4
+#define kLatestIndexMask 0x3
+
+namespace zed {
+
+#pragma mark - Public
+
+    FrameQueue::FrameQueue(size_t capacity, BackpressurePolicy backpressurePolicy) {
+        if (capacity == 0) {
+            throw runtime_error(format("Invalid frame queue capacity: {}", capacity));
+        }
+
+        this->capacity = capacity;
+        this->backpressurePolicy = backpressurePolicy;
+
+        cells = make_unique<Cell[]>(backpressurePolicy == LATEST_ONLY ? 0 : capacity);
+        for (size_t i = 0; i < (backpressurePolicy == LATEST_ONLY ? 0 : capacity); i++) {
+            cells[i].sequence.store(2 * i, memory_order_relaxed);
+        }
+
+        head.store(0, memory_order_relaxed);
+        tail.store(0, memory_order_relaxed);
+
+        latestMiddle.store(0, memory_order_relaxed);
+        latestBack = 1;
+        latestFront = 2;
+
+        droppedFrameCount.store(0, memory_order_relaxed);
+        blockedPushCount.store(0, memory_order_relaxed);
+        isConsumerWaiting.store(false, memory_order_relaxed);
+        isProducerWaiting.store(false, memory_order_relaxed);
+        isClosed.store(false, memory_order_relaxed);
+    }
+
+    bool FrameQueue::push(Frame frame) {
+        if (isClosed.load(memory_order_relaxed)) {
+            droppedFrameCount.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+
+        bool isDropFree = true;
+
+        if (backpressurePolicy == LATEST_ONLY) {
+            latestSlots[latestBack] = std::move(frame);
+
+            uint8_t previousMiddle = latestMiddle.exchange(latestBack | kLatestFreshBit, memory_order_acq_rel);
+            latestBack = previousMiddle & kLatestIndexMask;
+
+            if (previousMiddle & kLatestFreshBit) {
+                // The replaced frame was never popped, release its buffer now rather than on the next push
+                latestSlots[latestBack].release();
+                droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                isDropFree = false;
+            }
+        }
+        else {
+            size_t position = tail.load(memory_order_relaxed);
+            bool isBlocked = false;
+
+            while (!hasSpace(position)) {
+                if (backpressurePolicy == DROP_NEWEST) {
+                    droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                    return false;
+                }
+                else if (backpressurePolicy == DROP_OLDEST) {
+                    Frame oldestFrame;
+
+                    if (tryPop(oldestFrame)) {
+                        oldestFrame.release();
+                        droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                        isDropFree = false;
+                    }
+                    else {
+                        // The consumer claimed the oldest frame and is still moving it out of its cell
+                        this_thread::yield();
+                    }
+                }
+                else {
+                    if (!isBlocked) {
+                        blockedPushCount.fetch_add(1, memory_order_relaxed);
+                        isBlocked = true;
+                    }
+
+                    waitForSpace(position);
+
+                    if (isClosed.load(memory_order_relaxed)) {
+                        droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                        return false;
+                    }
+                }
+            }
+
+            Cell& cell = cells[position % capacity];
+            cell.frame = std::move(frame);
+            cell.sequence.store(2 * position + 1, memory_order_release);
+            tail.store(position + 1, memory_order_release);
+        }
+
+        wakeConsumer();
+
+        return isDropFree;
+    }
+
+    bool FrameQueue::pop(Frame& frame) {
+        if (!tryPop(frame)) {
+            return false;
+        }
+
+        wakeProducer();
+
+        return true;
+    }
+
+    bool FrameQueue::pop(Frame& frame, chrono::nanoseconds timeout) {
+        if (pop(frame)) {
+            return true;
+        }
+
+        if (timeout <= chrono::nanoseconds::zero()) {
+            return false;
+        }
+
+        bool isPopped = false;
+
+        {
+            unique_lock<mutex> lock(waitMutex);
+
+            // Pairs with the fence in `wakeConsumer()`: either the producer sees the waiting flag, or the predicate sees the frame
+            isConsumerWaiting.store(true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+
+            waitCondition.wait_for(lock, timeout, [this, &frame, &isPopped] {
+                isPopped = tryPop(frame);
+                return isPopped || isClosed.load(memory_order_relaxed);
+            });
+
+            isConsumerWaiting.store(false, memory_order_relaxed);
+        }
+
+        if (isPopped) {
+            wakeProducer();
+        }
+
+        return isPopped;
+    }
+
+    void FrameQueue::close() {
+        isClosed.store(true, memory_order_relaxed);
+
+        lock_guard<mutex> lock(waitMutex);
+        waitCondition.notify_all();
+        spaceCondition.notify_all();
+    }
+
+    size_t FrameQueue::getCapacity() {
+        return capacity;
+    }
+
+    BackpressurePolicy FrameQueue::getBackpressurePolicy() {
+        return backpressurePolicy;
+    }
+
+    size_t FrameQueue::getCount() {
+        if (backpressurePolicy == LATEST_ONLY) {
+            return (latestMiddle.load(memory_order_relaxed) & kLatestFreshBit) ? 1 : 0;
+        }
+
+        size_t currentHead = head.load(memory_order_relaxed);
+        size_t currentTail = tail.load(memory_order_relaxed);
+
+        return currentTail > currentHead ? currentTail - currentHead : 0;
+    }
+
+    uint64_t FrameQueue::getDroppedFrameCount() {
+        return droppedFrameCount.load(memory_order_relaxed);
+    }
+
+    uint64_t FrameQueue::getBlockedPushCount() {
+        return blockedPushCount.load(memory_order_relaxed);
+    }
+
+#pragma mark - Private
+
+    bool FrameQueue::tryPop(Frame& frame) {
+        if (backpressurePolicy == LATEST_ONLY) {
+            if (!(latestMiddle.load(memory_order_acquire) & kLatestFreshBit)) {
+                return false;
+            }
+
+            uint8_t previousMiddle = latestMiddle.exchange(latestFront, memory_order_acq_rel);
+            latestFront = previousMiddle & kLatestIndexMask;
+            frame = std::move(latestSlots[latestFront]);
+
+            return true;
+        }
+
+        size_t position = head.load(memory_order_relaxed);
+
+        while (true) {
+            Cell& cell = cells[position % capacity];
+            ptrdiff_t difference = ptrdiff_t(cell.sequence.load(memory_order_acquire)) - ptrdiff_t(2 * position + 1);
+
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                    frame = std::move(cell.frame);
+                    cell.sequence.store(2 * (position + capacity), memory_order_release);
+
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = head.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    bool FrameQueue::hasSpace(size_t position) {
+        return cells[position % capacity].sequence.load(memory_order_acquire) == 2 * position;
+    }
+
+    void FrameQueue::waitForSpace(size_t position) {
+        unique_lock<mutex> lock(waitMutex);
+
+        // Pairs with the fence in `wakeProducer()`
+        isProducerWaiting.store(true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        spaceCondition.wait(lock, [this, position] { return hasSpace(position) || isClosed.load(memory_order_relaxed); });
+
+        isProducerWaiting.store(false, memory_order_relaxed);
+    }
+
+    void FrameQueue::wakeConsumer() {
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (isConsumerWaiting.load(memory_order_relaxed)) {
+            lock_guard<mutex> lock(waitMutex);
+            waitCondition.notify_one();
+        }
+    }
+
+    void FrameQueue::wakeProducer() {
+        if (backpressurePolicy != BLOCK_PRODUCER) {
+            return;
+        }
+
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (isProducerWaiting.load(memory_order_relaxed)) {
+            lock_guard<mutex> lock(waitMutex);
+            spaceCondition.notify_one();
+        }
+    }
+}
@@ -0,0 +1,186 @@
+//
+// zed_frame_source.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_frame_source.h"
+#include <chrono>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kRawFramePoolCapacity 4
+#define kRawFrameWaitMicroseconds 100
+
+namespace zed {
+
+#pragma mark - FrameSource
+
+    size_t FrameSource::getRawFrameCapacity() {
+        return 0;
+    }
+
+    string FrameSource::getDeviceID() {
+        throw runtime_error("Device ID is unavailable for this frame source");
+    }
+
+    string FrameSource::getDeviceName() {
+        throw runtime_error("Device name is unavailable for this frame source");
+    }
+
+    string FrameSource::getDeviceSerialNumber() {
+        throw runtime_error("Device serial number is unavailable for this frame source");
+    }
+
+    string FrameSource::readCalibration() {
+        return "";
+    }
+
+    uint16_t FrameSource::getControlValue(CameraControl cameraControl) {
+        throw runtime_error(format("Camera control {} is unavailable for this frame source", cameraControlToString(cameraControl)));
+    }
+
+    void FrameSource::setControlValue(CameraControl cameraControl, uint16_t) {
+        throw runtime_error(format("Camera control {} is unavailable for this frame source", cameraControlToString(cameraControl)));
+    }
+
+    void FrameSource::applySettings(const CameraSettings& cameraSettings) {
+        if (cameraSettings.whiteBalanceTemperature.has_value() && cameraSettings.autoWhiteBalanceTemperature.value_or(false)) {
+            throw runtime_error("Conflicting camera settings: a white balance temperature with automatic white balance");
+        }
+
+        if (cameraSettings.autoWhiteBalanceTemperature.has_value()) {
+            setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, *cameraSettings.autoWhiteBalanceTemperature);
+        }
+        else if (cameraSettings.whiteBalanceTemperature.has_value()) {
+            setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, false);
+        }
+
+        const pair<CameraControl, const optional<uint16_t>&> controls[] = {
+            {WHITE_BALANCE_TEMPERATURE, cameraSettings.whiteBalanceTemperature},
+            {BRIGHTNESS, cameraSettings.brightness},
+            {CONTRAST, cameraSettings.contrast},
+            {HUE, cameraSettings.hue},
+            {SATURATION, cameraSettings.saturation},
+            {SHARPNESS, cameraSettings.sharpness},
+        };
+
+        for (const auto& [cameraControl, value] : controls) {
+            if (value.has_value()) {
+                setControlValue(cameraControl, *value);
+            }
+        }
+
+        if (cameraSettings.isLEDOn.has_value()) {
+            setControlValue(LED, *cameraSettings.isLEDOn);
+        }
+    }
+
+#pragma mark - PacedFrameSource
+
+    PacedFrameSource::PacedFrameSource(PlaybackSpeed playbackSpeed) {
+        this->playbackSpeed = playbackSpeed;
+        frameRate = FPS_15;
+        rawColorSpace = YUV;
+        isRunning = false;
+        isOpen = false;
+    }
+
+    PacedFrameSource::~PacedFrameSource() {
+        stop();
+    }
+
+    void PacedFrameSource::open(Resolution resolution, FrameRate frameRate, ColorSpace rawColorSpace) {
+        if (isOpen) {
+            throw runtime_error("Attempted to open an already open frame source");
+        }
+
+        if (rawColorSpace != YUV && rawColorSpace != GREYSCALE) {
+            throw runtime_error(format("Unsupported raw color space: {}", colorSpaceToString(rawColorSpace)));
+        }
+
+        this->stereoDimensions = StereoDimensions(resolution);
+        this->frameRate = frameRate;
+        this->rawColorSpace = rawColorSpace;
+
+        prepare();
+
+        size_t channels = rawColorSpace == YUV ? 2 : 1;
+        framePool = FramePool::create(kRawFramePoolCapacity, stereoDimensions.height, stereoDimensions.width, channels);
+
+        isOpen = true;
+    }
+
+    void PacedFrameSource::close() {
+        stop();
+
+        framePool.reset();
+        isOpen = false;
+    }
+
+    void PacedFrameSource::start(function<void(Frame)> rawFrameHandler) {
+        if (!isOpen) {
+            throw runtime_error("Attempted to start an unopened frame source");
+        }
+
+        if (isRunning) {
+            throw runtime_error("Attempted to start an already running frame source");
+        }
+
+        isRunning = true;
+        producerThread = thread(&PacedFrameSource::run, this, rawFrameHandler);
+    }
+
+    void PacedFrameSource::stop() {
+        isRunning = false;
+
+        if (producerThread.joinable()) {
+            producerThread.join();
+        }
+    }
+
+    size_t PacedFrameSource::getRawFrameCapacity() {
+        return kRawFramePoolCapacity;
+    }
+
+    void PacedFrameSource::run(function<void(Frame)> rawFrameHandler) {
+        chrono::nanoseconds frameDuration = chrono::nanoseconds(1'000'000'000 / frameRate);
+        chrono::steady_clock::time_point nextFrameTime = chrono::steady_clock::now();
+
+        for (uint64_t frameIndex = 0; isRunning; frameIndex++) {
+            if (playbackSpeed == NATIVE_SPEED) {
+                this_thread::sleep_until(nextFrameTime);
+                nextFrameTime += frameDuration;
+            }
+
+            Frame frame = framePool->acquire();
+
+            // At native speed a frame is skipped like a camera would, at max speed the consumer sets the pace
+            while (!frame.isValid() && playbackSpeed == MAX_SPEED && isRunning) {
+                this_thread::sleep_for(chrono::microseconds(kRawFrameWaitMicroseconds));
+                frame = framePool->acquire();
+            }
+
+            if (!frame.isValid()) {
+                continue;
+            }
+
+            // Stamped before producing, so the source latency includes the time to read or render the frame
+            frame.setTimestamp(steadyClockTimestamp());
+            frame.setSequenceNumber(frameIndex);
+
+            if (!produceFrame(frame.getData(), frame.getRowBytes(), frameIndex)) {
+                break;
+            }
+
+            rawFrameHandler(std::move(frame));
+        }
+    }
+}
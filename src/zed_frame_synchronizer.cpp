@@ -0,0 +1,222 @@
+//
+// zed_frame_synchronizer.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_frame_synchronizer.h"
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace zed {
+
+#pragma mark - SynchronizationStats
+
+    string SynchronizationStats::toString() const {
+        string unmatched;
+        string offsets;
+
+        for (size_t i = 0; i < unmatchedFrameCounts.size(); i++) {
+            unmatched += format("{}{}", i == 0 ? "" : ", ", unmatchedFrameCounts[i]);
+            offsets += format("{}{:.3f} ms", i == 0 ? "" : ", ", meanOffsets[i] / 1e6);
+        }
+
+        return format("Frame sets: {} ({} dropped), unmatched frames per source: [{}]\n"
+                      "Mean offset per source: [{}]\n"
+                      "Skew: {}",
+            frameSetCount,
+            droppedFrameSetCount,
+            unmatched,
+            offsets,
+            skew.toString());
+    }
+
+#pragma mark - FrameSynchronizer
+
+    FrameSynchronizer::FrameSynchronizer(size_t sourceCount, chrono::nanoseconds tolerance, function<void(FrameSet)> frameSetHandler, size_t bufferCapacity) {
+        if (sourceCount == 0) {
+            throw runtime_error("Attempted to create a FrameSynchronizer without sources");
+        }
+
+        if (bufferCapacity == 0) {
+            throw runtime_error("Invalid FrameSynchronizer buffer capacity: 0");
+        }
+
+        this->sourceCount = sourceCount;
+        this->tolerance = tolerance;
+        this->frameSetHandler = std::move(frameSetHandler);
+        this->bufferCapacity = bufferCapacity;
+        isDelivering = false;
+
+        pendingFrames.resize(sourceCount);
+        unmatchedFrameCounts.resize(sourceCount);
+        offsetSums.resize(sourceCount);
+        reset();
+    }
+
+    void FrameSynchronizer::push(size_t sourceIndex, Frame frame) {
+        if (sourceIndex >= sourceCount) {
+            throw runtime_error(format("Invalid FrameSynchronizer source index: {} (of {} sources)", sourceIndex, sourceCount));
+        }
+
+        if (!frame.isValid()) {
+            return;
+        }
+
+        unique_lock<mutex> lock(synchronizerMutex);
+
+        deque<Frame>& frames = pendingFrames[sourceIndex];
+
+        // The source is running ahead of the others, its oldest frame would be too old to match by the time they catch up
+        if (frames.size() == bufferCapacity) {
+            frames.pop_front();
+            unmatchedFrameCounts[sourceIndex]++;
+        }
+
+        frames.push_back(std::move(frame));
+
+        match();
+        deliver(lock);
+    }
+
+    function<void(Frame)> FrameSynchronizer::sourceHandler(size_t sourceIndex) {
+        if (sourceIndex >= sourceCount) {
+            throw runtime_error(format("Invalid FrameSynchronizer source index: {} (of {} sources)", sourceIndex, sourceCount));
+        }
+
+        return [this, sourceIndex](Frame frame) { push(sourceIndex, std::move(frame)); };
+    }
+
+    size_t FrameSynchronizer::getSourceCount() {
+        return sourceCount;
+    }
+
+    chrono::nanoseconds FrameSynchronizer::getTolerance() {
+        return tolerance;
+    }
+
+    SynchronizationStats FrameSynchronizer::getStats() {
+        lock_guard<mutex> lock(synchronizerMutex);
+
+        SynchronizationStats stats;
+        stats.frameSetCount = frameSetCount;
+        stats.droppedFrameSetCount = droppedFrameSetCount;
+        stats.unmatchedFrameCounts = unmatchedFrameCounts;
+        stats.meanOffsets.resize(sourceCount, 0);
+        stats.skew = skew.summarize();
+
+        if (frameSetCount > 0) {
+            for (size_t i = 0; i < sourceCount; i++) {
+                stats.meanOffsets[i] = offsetSums[i] / int64_t(frameSetCount);
+            }
+        }
+
+        return stats;
+    }
+
+    void FrameSynchronizer::reset() {
+        lock_guard<mutex> lock(synchronizerMutex);
+
+        for (deque<Frame>& frames : pendingFrames) {
+            frames.clear();
+        }
+
+        readyFrameSets.clear();
+        frameSetCount = 0;
+        droppedFrameSetCount = 0;
+        fill(unmatchedFrameCounts.begin(), unmatchedFrameCounts.end(), 0);
+        fill(offsetSums.begin(), offsetSums.end(), 0);
+        skew.reset();
+    }
+
+#pragma mark - Private
+
+    void FrameSynchronizer::match() {
+        uint64_t toleranceNanoseconds = uint64_t(max(tolerance.count(), int64_t(0)));
+
+        while (true) {
+            size_t earliestIndex = 0;
+            uint64_t earliestTimestamp = UINT64_MAX;
+            uint64_t latestTimestamp = 0;
+
+            for (size_t i = 0; i < sourceCount; i++) {
+                if (pendingFrames[i].empty()) {
+                    return;
+                }
+
+                uint64_t timestamp = pendingFrames[i].front().getTimestamp();
+
+                if (timestamp < earliestTimestamp) {
+                    earliestTimestamp = timestamp;
+                    earliestIndex = i;
+                }
+
+                latestTimestamp = max(latestTimestamp, timestamp);
+            }
+
+            // Every later frame of the latest source is later still, so the earliest frame has no match left
+            if (latestTimestamp - earliestTimestamp > toleranceNanoseconds) {
+                pendingFrames[earliestIndex].pop_front();
+                unmatchedFrameCounts[earliestIndex]++;
+                continue;
+            }
+
+            FrameSet frameSet;
+            frameSet.frames.reserve(sourceCount);
+            frameSet.timestamp = earliestTimestamp;
+            frameSet.skew = latestTimestamp - earliestTimestamp;
+
+            uint64_t referenceTimestamp = pendingFrames[0].front().getTimestamp();
+
+            for (size_t i = 0; i < sourceCount; i++) {
+                offsetSums[i] += int64_t(pendingFrames[i].front().getTimestamp() - referenceTimestamp);
+                frameSet.frames.push_back(std::move(pendingFrames[i].front()));
+                pendingFrames[i].pop_front();
+            }
+
+            frameSetCount++;
+            skew.record(frameSet.skew);
+
+            // The handler is behind, its oldest set would only hold the sources' buffers longer
+            if (readyFrameSets.size() == bufferCapacity) {
+                readyFrameSets.pop_front();
+                droppedFrameSetCount++;
+            }
+
+            readyFrameSets.push_back(std::move(frameSet));
+        }
+    }
+
+    void FrameSynchronizer::deliver(unique_lock<mutex>& lock) {
+        if (isDelivering) {
+            return;
+        }
+
+        isDelivering = true;
+
+        while (!readyFrameSets.empty()) {
+            FrameSet frameSet = std::move(readyFrameSets.front());
+            readyFrameSets.pop_front();
+
+            lock.unlock();
+
+            try {
+                frameSetHandler(std::move(frameSet));
+            }
+            catch (...) {
+                lock.lock();
+                isDelivering = false;
+                throw;
+            }
+
+            lock.lock();
+        }
+
+        isDelivering = false;
+    }
+}
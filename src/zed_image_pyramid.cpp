@@ -0,0 +1,127 @@
+//
+// zed_image_pyramid.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_image_pyramid.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZED_X86 1
+#include <immintrin.h>
+#define ZED_TARGET_SSE4 __attribute__((target("sse4.1")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace zed {
+
+    typedef void (*RowDownsampler)(const uint8_t* top, const uint8_t* bottom, uint8_t* destination, size_t width, size_t channels);
+
+    // Averages the 2x2 blocks of two rows into `width` pixels, rounding to nearest
+    static void downsampleRowScalar(const uint8_t* top, const uint8_t* bottom, uint8_t* destination, size_t width, size_t channels) {
+        for (size_t x = 0; x < width; x++) {
+            for (size_t c = 0; c < channels; c++) {
+                size_t left = x * 2 * channels + c;
+                size_t right = left + channels;
+
+                destination[x * channels + c] = uint8_t((top[left] + top[right] + bottom[left] + bottom[right] + 2) >> 2);
+            }
+        }
+    }
+
+#if ZED_X86
+    ZED_TARGET_SSE4 static void downsampleRowSSE4(const uint8_t* top, const uint8_t* bottom, uint8_t* destination, size_t width, size_t channels) {
+        if (channels != 1) {
+            downsampleRowScalar(top, bottom, destination, width, channels);
+            return;
+        }
+
+        const __m128i ones = _mm_set1_epi8(1);
+        const __m128i rounding = _mm_set1_epi16(2);
+
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            // Sums of horizontal pairs, 8 per register
+            __m128i top0 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(top + x * 2)), ones);
+            __m128i top1 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(top + x * 2 + 16)), ones);
+            __m128i bottom0 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(bottom + x * 2)), ones);
+            __m128i bottom1 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(bottom + x * 2 + 16)), ones);
+
+            __m128i sum0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top0, bottom0), rounding), 2);
+            __m128i sum1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top1, bottom1), rounding), 2);
+
+            _mm_storeu_si128((__m128i*)(destination + x), _mm_packus_epi16(sum0, sum1));
+        }
+
+        downsampleRowScalar(top + x * 2, bottom + x * 2, destination + x, width - x, 1);
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    static void downsampleRowNEON(const uint8_t* top, const uint8_t* bottom, uint8_t* destination, size_t width, size_t channels) {
+        if (channels != 1) {
+            downsampleRowScalar(top, bottom, destination, width, channels);
+            return;
+        }
+
+        size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            uint16x8_t sum0 = vpadalq_u8(vpaddlq_u8(vld1q_u8(top + x * 2)), vld1q_u8(bottom + x * 2));
+            uint16x8_t sum1 = vpadalq_u8(vpaddlq_u8(vld1q_u8(top + x * 2 + 16)), vld1q_u8(bottom + x * 2 + 16));
+
+            vst1q_u8(destination + x, vcombine_u8(vrshrn_n_u16(sum0, 2), vrshrn_n_u16(sum1, 2)));
+        }
+
+        downsampleRowScalar(top + x * 2, bottom + x * 2, destination + x, width - x, 1);
+    }
+#endif
+
+    static RowDownsampler detectRowDownsampler() {
+#if ZED_X86
+        if (__builtin_cpu_supports("sse4.1")) {
+            return downsampleRowSSE4;
+        }
+#endif
+#if defined(__ARM_NEON)
+        return downsampleRowNEON;
+#endif
+        return downsampleRowScalar;
+    }
+
+    void downsamplePyramidRegion(const FramePlane* levels, size_t levelCount, size_t x0, size_t y0, size_t x1, size_t y1) {
+        static const RowDownsampler downsampleRow = detectRowDownsampler();
+
+        for (size_t level = 1; level < levelCount; level++) {
+            const FramePlane& source = levels[level - 1];
+            const FramePlane& destination = levels[level];
+
+            // Odd trailing rows and columns fall off the next level
+            x0 /= 2;
+            y0 /= 2;
+            x1 = min(x1 / 2, destination.width);
+            y1 = min(y1 / 2, destination.height);
+
+            if (x0 >= x1 || y0 >= y1) {
+                return;
+            }
+
+            size_t channels = destination.channels;
+
+            for (size_t y = y0; y < y1; y++) {
+                const uint8_t* top = source.data + y * 2 * source.rowBytes + x0 * 2 * channels;
+                const uint8_t* bottom = top + source.rowBytes;
+
+                downsampleRow(top, bottom, destination.data + y * destination.rowBytes + x0 * channels, x1 - x0, channels);
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+//
+// zed_image_pyramid.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_IMAGE_PYRAMID_H
+#define ZED_IMAGE_PYRAMID_H
+
+#include "../include/zed_frame.h"
+
+using namespace std;
+
+namespace zed {
+
+    //
+    // Fills the pyramid levels of one eye from a region of its full resolution image (level 0)
+    //
+    // Each level halves the one before it by averaging 2x2 blocks. `x0` and `y0` must be multiples of
+    // 2^(levelCount - 1), so that regions split this way (row bands, remap tiles) never share an output pixel,
+    // and can be downsampled by the thread that just wrote them while they're still in cache
+    //
+    void downsamplePyramidRegion(const FramePlane* levels, size_t levelCount, size_t x0, size_t y0, size_t x1, size_t y1);
+}
+
+#endif
@@ -0,0 +1,155 @@
+//
+// zed_memory_mapped_file.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_memory_mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace zed {
+
+#pragma mark - Public
+
+    shared_ptr<MemoryMappedFile> MemoryMappedFile::create(const path& filepath, size_t size) {
+        int fileDescriptor = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fileDescriptor < 0) {
+            throw runtime_error(format("Failed to create file: {} ({})", filepath.string(), strerror(errno)));
+        }
+
+#ifdef __APPLE__
+        // Try for contiguous blocks first, then any blocks
+        fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, off_t(size), 0};
+
+        if (fcntl(fileDescriptor, F_PREALLOCATE, &store) == -1) {
+            store.fst_flags = F_ALLOCATEALL;
+            fcntl(fileDescriptor, F_PREALLOCATE, &store);
+        }
+
+        int result = ftruncate(fileDescriptor, off_t(size));
+#else
+        int result = posix_fallocate(fileDescriptor, 0, off_t(size));
+
+        // Not every filesystem supports allocation, fall back to a sparse file
+        if (result != 0) {
+            result = ftruncate(fileDescriptor, off_t(size));
+        }
+#endif
+
+        if (result != 0) {
+            ::close(fileDescriptor);
+            throw runtime_error(format("Failed to allocate {} bytes for file: {}", size, filepath.string()));
+        }
+
+        shared_ptr<MemoryMappedFile> mappedFile(new MemoryMappedFile(filepath, fileDescriptor, true, size));
+        mappedFile->map();
+
+        return mappedFile;
+    }
+
+    shared_ptr<MemoryMappedFile> MemoryMappedFile::open(const path& filepath) {
+        int fileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+
+        if (fileDescriptor < 0) {
+            throw runtime_error(format("Failed to open file: {} ({})", filepath.string(), strerror(errno)));
+        }
+
+        struct stat fileStatus;
+
+        if (fstat(fileDescriptor, &fileStatus) != 0) {
+            ::close(fileDescriptor);
+            throw runtime_error(format("Failed to read size of file: {}", filepath.string()));
+        }
+
+        shared_ptr<MemoryMappedFile> mappedFile(new MemoryMappedFile(filepath, fileDescriptor, false, size_t(fileStatus.st_size)));
+        mappedFile->map();
+
+        return mappedFile;
+    }
+
+    MemoryMappedFile::~MemoryMappedFile() {
+        unmap();
+        ::close(fileDescriptor);
+    }
+
+    uint8_t* MemoryMappedFile::getData() {
+        return data;
+    }
+
+    size_t MemoryMappedFile::getSize() {
+        return size;
+    }
+
+    void MemoryMappedFile::flush(size_t offset, size_t length, bool isAsync) {
+        // msync needs a page-aligned start
+        size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+        size_t alignedOffset = offset / pageSize * pageSize;
+
+        msync(data + alignedOffset, length + offset - alignedOffset, isAsync ? MS_ASYNC : MS_SYNC);
+    }
+
+    void MemoryMappedFile::release(size_t offset, size_t length) {
+        size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+        size_t alignedOffset = offset / pageSize * pageSize;
+
+        // Dirty shared pages are written back before they're dropped, so no data is lost
+        posix_madvise(data + alignedOffset, length + offset - alignedOffset, POSIX_MADV_DONTNEED);
+    }
+
+    void MemoryMappedFile::resize(size_t size) {
+        unmap();
+
+        if (ftruncate(fileDescriptor, off_t(size)) != 0) {
+            map();
+            throw runtime_error(format("Failed to resize file: {} to {} bytes", filepath.string(), size));
+        }
+
+        this->size = size;
+        map();
+    }
+
+#pragma mark - Private
+
+    MemoryMappedFile::MemoryMappedFile(const path& filepath, int fileDescriptor, bool isWritable, size_t size) {
+        this->filepath = filepath;
+        this->fileDescriptor = fileDescriptor;
+        this->isWritable = isWritable;
+        this->size = size;
+        data = nullptr;
+    }
+
+    void MemoryMappedFile::map() {
+        if (size == 0) {
+            data = nullptr;
+            return;
+        }
+
+        int protection = isWritable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* mapping = mmap(nullptr, size, protection, MAP_SHARED, fileDescriptor, 0);
+
+        if (mapping == MAP_FAILED) {
+            data = nullptr;
+            throw runtime_error(format("Failed to map file: {} ({})", filepath.string(), strerror(errno)));
+        }
+
+        data = static_cast<uint8_t*>(mapping);
+    }
+
+    void MemoryMappedFile::unmap() {
+        if (data) {
+            munmap(data, size);
+            data = nullptr;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+//
+// zed_memory_mapped_file.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_MEMORY_MAPPED_FILE_H
+#define ZED_MEMORY_MAPPED_FILE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+using namespace std;
+using namespace filesystem;
+
+namespace zed {
+
+    //
+    // Shared memory mapping of a whole file (POSIX mmap)
+    //
+    class MemoryMappedFile {
+
+    public:
+        // Creates (or replaces) a file of `size` bytes with its blocks allocated up front, mapped read-write
+        static shared_ptr<MemoryMappedFile> create(const path& filepath, size_t size);
+
+        // Maps an existing file read-only
+        static shared_ptr<MemoryMappedFile> open(const path& filepath);
+
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        uint8_t* getData();
+        size_t getSize();
+
+        // Schedules (or, if not `isAsync`, waits for) write-back of a byte range
+        void flush(size_t offset, size_t length, bool isAsync);
+
+        // Hints that a byte range won't be accessed again soon, letting the kernel drop its pages once written back
+        void release(size_t offset, size_t length);
+
+        // Shrinks or grows the file and remaps it, invalidating pointers into the previous mapping
+        void resize(size_t size);
+
+    private:
+        path filepath;
+        int fileDescriptor;
+        bool isWritable;
+
+        uint8_t* data;
+        size_t size;
+
+        MemoryMappedFile(const path& filepath, int fileDescriptor, bool isWritable, size_t size);
+
+        void map();
+        void unmap();
+    };
+}
+
+#endif
@@ -0,0 +1,361 @@
+//
+// zed_point_cloud.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_point_cloud.h"
+#include "../include/zed_stereo_matcher.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZED_X86 1
+#include <immintrin.h>
+#define ZED_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define ZED_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace zed {
+
+    struct RowReprojection {
+        float rowOffset;     // (row - centerY) / focalLength
+        float centerX;
+        float inverseFocalLength;
+        float depthScale;
+        float maxDepth;      // Infinity keeps every point
+    };
+
+    // Reprojects a row of disparities into depth, and points if `x` and `y` aren't null (NaN where there's no valid point)
+    typedef void (*RowReprojector)(const int16_t* disparity, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z);
+
+#pragma mark - Scalar
+
+    // Reprojects the columns from `firstColumn`, vector paths finish their rows here so every column is computed the same way
+    static void reprojectColumnsScalar(
+        const int16_t* disparity, size_t firstColumn, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z) {
+        const float invalid = numeric_limits<float>::quiet_NaN();
+
+        for (size_t column = firstColumn; column < width; column++) {
+            float depth = disparity[column] > 0 ? reprojection.depthScale / float(disparity[column]) : invalid;
+
+            // NaN fails the comparison too
+            if (!(depth <= reprojection.maxDepth)) {
+                depth = invalid;
+            }
+
+            z[column] = depth;
+
+            if (x) {
+                x[column] = (float(column) - reprojection.centerX) * reprojection.inverseFocalLength * depth;
+                y[column] = reprojection.rowOffset * depth;
+            }
+        }
+    }
+
+    static void reprojectRowScalar(const int16_t* disparity, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z) {
+        reprojectColumnsScalar(disparity, 0, width, reprojection, x, y, z);
+    }
+
+#pragma mark - SSE4
+
+#if ZED_X86
+    ZED_TARGET_SSE4 static void reprojectRowSSE4(const int16_t* disparity, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z) {
+        const __m128 invalid = _mm_set1_ps(numeric_limits<float>::quiet_NaN());
+        const __m128 depthScale = _mm_set1_ps(reprojection.depthScale);
+        const __m128 maxDepth = _mm_set1_ps(reprojection.maxDepth);
+        const __m128 inverseFocalLength = _mm_set1_ps(reprojection.inverseFocalLength);
+        const __m128 rowOffset = _mm_set1_ps(reprojection.rowOffset);
+        const __m128 centerX = _mm_set1_ps(reprojection.centerX);
+        const __m128 lanes = _mm_setr_ps(0, 1, 2, 3);
+
+        size_t column = 0;
+
+        for (; column + 4 <= width; column += 4) {
+            __m128i values = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(disparity + column)));
+            __m128 values32 = _mm_cvtepi32_ps(values);
+
+            __m128 depth = _mm_div_ps(depthScale, values32);
+            __m128 isValid = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(values, _mm_setzero_si128())), _mm_cmple_ps(depth, maxDepth));
+            depth = _mm_blendv_ps(invalid, depth, isValid);
+
+            _mm_storeu_ps(z + column, depth);
+
+            if (x) {
+                // (column - centerX) / focalLength * depth in the scalar path's order, columns are exact in single precision
+                __m128 columnOffset = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(float(column)), lanes), centerX), inverseFocalLength);
+
+                _mm_storeu_ps(x + column, _mm_mul_ps(columnOffset, depth));
+                _mm_storeu_ps(y + column, _mm_mul_ps(rowOffset, depth));
+            }
+        }
+
+        reprojectColumnsScalar(disparity, column, width, reprojection, x, y, z);
+    }
+#endif
+
+#pragma mark - AVX2
+
+#if ZED_X86
+    ZED_TARGET_AVX2 static void reprojectRowAVX2(const int16_t* disparity, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z) {
+        const __m256 invalid = _mm256_set1_ps(numeric_limits<float>::quiet_NaN());
+        const __m256 depthScale = _mm256_set1_ps(reprojection.depthScale);
+        const __m256 maxDepth = _mm256_set1_ps(reprojection.maxDepth);
+        const __m256 inverseFocalLength = _mm256_set1_ps(reprojection.inverseFocalLength);
+        const __m256 rowOffset = _mm256_set1_ps(reprojection.rowOffset);
+        const __m256 centerX = _mm256_set1_ps(reprojection.centerX);
+        const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+
+        size_t column = 0;
+
+        for (; column + 8 <= width; column += 8) {
+            __m256i values = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(disparity + column)));
+            __m256 values32 = _mm256_cvtepi32_ps(values);
+
+            __m256 depth = _mm256_div_ps(depthScale, values32);
+            __m256 isValid = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(values, _mm256_setzero_si256())), _mm256_cmp_ps(depth, maxDepth, _CMP_LE_OQ));
+            depth = _mm256_blendv_ps(invalid, depth, isValid);
+
+            _mm256_storeu_ps(z + column, depth);
+
+            if (x) {
+                __m256 columnOffset = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(float(column)), lanes), centerX), inverseFocalLength);
+
+                _mm256_storeu_ps(x + column, _mm256_mul_ps(columnOffset, depth));
+                _mm256_storeu_ps(y + column, _mm256_mul_ps(rowOffset, depth));
+            }
+        }
+
+        reprojectColumnsScalar(disparity, column, width, reprojection, x, y, z);
+    }
+#endif
+
+#pragma mark - NEON
+
+#if defined(__ARM_NEON)
+    static void reprojectRowNEON(const int16_t* disparity, size_t width, const RowReprojection& reprojection, float* x, float* y, float* z) {
+        const float32x4_t invalid = vdupq_n_f32(numeric_limits<float>::quiet_NaN());
+        const float32x4_t depthScale = vdupq_n_f32(reprojection.depthScale);
+        const float32x4_t maxDepth = vdupq_n_f32(reprojection.maxDepth);
+        const float32x4_t inverseFocalLength = vdupq_n_f32(reprojection.inverseFocalLength);
+        const float32x4_t rowOffset = vdupq_n_f32(reprojection.rowOffset);
+        const float32x4_t centerX = vdupq_n_f32(reprojection.centerX);
+        const float laneColumns[4] = {0, 1, 2, 3};
+        const float32x4_t lanes = vld1q_f32(laneColumns);
+
+        size_t column = 0;
+
+        for (; column + 4 <= width; column += 4) {
+            int32x4_t values = vmovl_s16(vld1_s16(disparity + column));
+
+            float32x4_t depth = vdivq_f32(depthScale, vcvtq_f32_s32(values));
+            uint32x4_t isValid = vandq_u32(vcgtq_s32(values, vdupq_n_s32(0)), vcleq_f32(depth, maxDepth));
+            depth = vbslq_f32(isValid, depth, invalid);
+
+            vst1q_f32(z + column, depth);
+
+            if (x) {
+                float32x4_t columnOffset = vmulq_f32(vsubq_f32(vaddq_f32(vdupq_n_f32(float(column)), lanes), centerX), inverseFocalLength);
+
+                vst1q_f32(x + column, vmulq_f32(columnOffset, depth));
+                vst1q_f32(y + column, vmulq_f32(rowOffset, depth));
+            }
+        }
+
+        reprojectColumnsScalar(disparity, column, width, reprojection, x, y, z);
+    }
+#endif
+
+#pragma mark - Dispatch
+
+    static RowReprojector rowReprojectorFor(InstructionSet instructionSet) {
+        switch (instructionSet) {
+#if ZED_X86
+            case AVX2:
+                return reprojectRowAVX2;
+            case SSE4:
+                return reprojectRowSSE4;
+#endif
+#if defined(__ARM_NEON)
+            case NEON:
+                return reprojectRowNEON;
+#endif
+            default:
+                return reprojectRowScalar;
+        }
+    }
+
+    static void reserve(PointCloud& pointCloud, size_t size, bool hasPixelIndices) {
+        if (pointCloud.x.size() < size) {
+            pointCloud.x.resize(size);
+            pointCloud.y.resize(size);
+            pointCloud.z.resize(size);
+        }
+
+        if (hasPixelIndices && pointCloud.pixelIndices.size() < size) {
+            pointCloud.pixelIndices.resize(size);
+        }
+    }
+
+#pragma mark - Public
+
+    DepthReprojector::DepthReprojector(const CalibrationData& calibrationData, StereoRectifier& stereoRectifier, size_t threadCount)
+        : DepthReprojector(stereoRectifier.getLeftProjectionMatrix()[0],
+              stereoRectifier.getLeftProjectionMatrix()[2],
+              stereoRectifier.getLeftProjectionMatrix()[6],
+              calibrationData.getStereoCalibration(stereoRectifier.getStereoDimensions()).baseline,
+              threadCount) {}
+
+    DepthReprojector::DepthReprojector(double focalLength, double centerX, double centerY, double baseline, size_t threadCount)
+        : DepthReprojector(focalLength, centerX, centerY, baseline, threadCount, ColorConverter::detectInstructionSet()) {}
+
+    DepthReprojector::DepthReprojector(double focalLength, double centerX, double centerY, double baseline, size_t threadCount, InstructionSet instructionSet) {
+        if (!ColorConverter::isSupported(instructionSet)) {
+            throw runtime_error(format("Instruction set {} is not supported on this CPU", instructionSetToString(instructionSet)));
+        }
+
+        if (focalLength <= 0 || baseline == 0) {
+            throw runtime_error(format("Invalid focal length: {} or baseline: {} for reprojection", focalLength, baseline));
+        }
+
+        this->focalLength = float(focalLength);
+        this->centerX = float(centerX);
+        this->centerY = float(centerY);
+
+        // Baselines are in millimeters, disparities in 1/16 pixels
+        depthScale = float(focalLength * fabs(baseline) / 1000 * (1 << kDisparityFractionBits));
+
+        this->instructionSet = instructionSet;
+        threadPool = make_unique<ThreadPool>(threadCount);
+        bandClouds.resize(threadPool->getThreadCount());
+    }
+
+    void DepthReprojector::computeDepth(const int16_t* disparity, size_t disparityRowBytes, size_t height, size_t width, float* depth, size_t depthRowBytes, float maxDepth) {
+        RowReprojector rowReprojector = rowReprojectorFor(instructionSet);
+        size_t bandCount = threadPool->getThreadCount();
+        size_t bandHeight = (height + bandCount - 1) / bandCount;
+
+        threadPool->parallelFor(bandCount, [&](size_t band) {
+            size_t y0 = band * bandHeight;
+            size_t y1 = min(y0 + bandHeight, height);
+
+            for (size_t row = y0; row < y1; row++) {
+                RowReprojection reprojection = {0, centerX, 1 / focalLength, depthScale, maxDepth > 0 ? maxDepth : INFINITY};
+
+                rowReprojector(reinterpret_cast<const int16_t*>(reinterpret_cast<const uint8_t*>(disparity) + row * disparityRowBytes),
+                    width,
+                    reprojection,
+                    nullptr,
+                    nullptr,
+                    reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(depth) + row * depthRowBytes));
+            }
+        });
+    }
+
+    void DepthReprojector::computePointCloud(const int16_t* disparity,
+        size_t disparityRowBytes,
+        size_t height,
+        size_t width,
+        PointCloud& pointCloud,
+        ReprojectionSettings settings) {
+
+        RowReprojector rowReprojector = rowReprojectorFor(instructionSet);
+        size_t bandCount = threadPool->getThreadCount();
+        size_t bandHeight = (height + bandCount - 1) / bandCount;
+        float maxDepth = settings.maxDepth > 0 ? settings.maxDepth : INFINITY;
+
+        pointCloud.width = width;
+        pointCloud.height = height;
+        reserve(pointCloud, width * height, settings.isCompact && settings.hasPixelIndices);
+
+        auto reprojectRow = [&](size_t row, float* x, float* y, float* z) {
+            RowReprojection reprojection = {(float(row) - centerY) / focalLength, centerX, 1 / focalLength, depthScale, maxDepth};
+            rowReprojector(reinterpret_cast<const int16_t*>(reinterpret_cast<const uint8_t*>(disparity) + row * disparityRowBytes), width, reprojection, x, y, z);
+        };
+
+        if (!settings.isCompact) {
+            threadPool->parallelFor(bandCount, [&](size_t band) {
+                for (size_t row = band * bandHeight; row < min((band + 1) * bandHeight, height); row++) {
+                    reprojectRow(row, pointCloud.x.data() + row * width, pointCloud.y.data() + row * width, pointCloud.z.data() + row * width);
+                }
+            });
+
+            pointCloud.count = width * height;
+            return;
+        }
+
+        // Each band reprojects a row at a time into the end of its own cloud, then keeps only the valid points
+        threadPool->parallelFor(bandCount, [&](size_t band) {
+            PointCloud& bandCloud = bandClouds[band];
+            size_t y0 = band * bandHeight;
+            size_t y1 = min(y0 + bandHeight, height);
+
+            reserve(bandCloud, (y1 > y0 ? (y1 - y0) * width : 0) + width, settings.hasPixelIndices);
+            bandCloud.count = 0;
+
+            for (size_t row = y0; row < y1; row++) {
+                float* x = bandCloud.x.data() + bandCloud.count;
+                float* y = bandCloud.y.data() + bandCloud.count;
+                float* z = bandCloud.z.data() + bandCloud.count;
+                uint32_t* pixelIndices = settings.hasPixelIndices ? bandCloud.pixelIndices.data() + bandCloud.count : nullptr;
+
+                reprojectRow(row, x, y, z);
+
+                // Branchless compaction in place, valid points never move forward
+                size_t count = 0;
+
+                for (size_t column = 0; column < width; column++) {
+                    x[count] = x[column];
+                    y[count] = y[column];
+                    z[count] = z[column];
+
+                    if (pixelIndices) {
+                        pixelIndices[count] = uint32_t(row * width + column);
+                    }
+
+                    count += z[column] == z[column];
+                }
+
+                bandCloud.count += count;
+            }
+        });
+
+        vector<size_t> offsets(bandCount + 1, 0);
+
+        for (size_t band = 0; band < bandCount; band++) {
+            offsets[band + 1] = offsets[band] + bandClouds[band].count;
+        }
+
+        threadPool->parallelFor(bandCount, [&](size_t band) {
+            const PointCloud& bandCloud = bandClouds[band];
+            size_t count = bandCloud.count;
+
+            memcpy(pointCloud.x.data() + offsets[band], bandCloud.x.data(), count * sizeof(float));
+            memcpy(pointCloud.y.data() + offsets[band], bandCloud.y.data(), count * sizeof(float));
+            memcpy(pointCloud.z.data() + offsets[band], bandCloud.z.data(), count * sizeof(float));
+
+            if (settings.hasPixelIndices) {
+                memcpy(pointCloud.pixelIndices.data() + offsets[band], bandCloud.pixelIndices.data(), count * sizeof(uint32_t));
+            }
+        });
+
+        pointCloud.count = offsets[bandCount];
+    }
+
+    InstructionSet DepthReprojector::getInstructionSet() {
+        return instructionSet;
+    }
+
+    size_t DepthReprojector::getThreadCount() {
+        return threadPool->getThreadCount();
+    }
+}
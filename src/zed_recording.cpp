@@ -0,0 +1,319 @@
+//
+// zed_recording.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_recording.h"
+#include "zed_memory_mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kRecordingPageSize 4096
+#define kRecordingQueueCapacity 16
+#define kRecordingWaitMilliseconds 50
+#define kRecordingFlushInterval 8 // Frames between asynchronous write-backs
+
+namespace zed {
+
+    static size_t alignToPage(size_t size) {
+        return (size + kRecordingPageSize - 1) / kRecordingPageSize * kRecordingPageSize;
+    }
+
+#pragma mark - RecordingWriter
+
+    RecordingWriter::RecordingWriter(const path& filepath,
+        StereoDimensions stereoDimensions,
+        ColorSpace colorSpace,
+        FrameRate frameRate,
+        size_t maxFrameCount,
+        const string& serialNumber,
+        const string& calibration)
+        : frameQueue(kRecordingQueueCapacity, DROP_NEWEST) {
+        if (maxFrameCount == 0) {
+            throw runtime_error("Attempted to create a recording without room for any frames");
+        }
+
+        if (serialNumber.size() >= sizeof(RecordingHeader::serialNumber)) {
+            throw runtime_error(format("Serial number is too long to record: {}", serialNumber));
+        }
+
+        size_t channels = colorSpace == YUV ? 2 : colorSpace == GREYSCALE ? 1 : 3;
+        size_t frameSize = size_t(stereoDimensions.width) * stereoDimensions.height * channels;
+        size_t frameStride = alignToPage(frameSize);
+
+        size_t calibrationOffset = sizeof(RecordingHeader);
+        size_t indexOffset = alignToPage(calibrationOffset + calibration.size());
+        size_t dataOffset = alignToPage(indexOffset + maxFrameCount * sizeof(RecordingIndexEntry));
+
+        this->filepath = filepath;
+        mappedFile = MemoryMappedFile::create(filepath, dataOffset + maxFrameCount * frameStride);
+
+        header = reinterpret_cast<RecordingHeader*>(mappedFile->getData());
+        memset(header, 0, sizeof(RecordingHeader));
+        memcpy(header->magic, kRecordingMagic, sizeof(kRecordingMagic));
+        header->version = kRecordingVersion;
+        header->colorSpace = colorSpace;
+        header->width = stereoDimensions.width;
+        header->height = stereoDimensions.height;
+        header->frameRate = frameRate;
+        header->channels = uint32_t(channels);
+        header->frameSize = frameSize;
+        header->frameStride = frameStride;
+        header->maxFrameCount = maxFrameCount;
+        header->frameCount = 0;
+        header->calibrationOffset = calibrationOffset;
+        header->calibrationSize = calibration.size();
+        header->indexOffset = indexOffset;
+        header->dataOffset = dataOffset;
+        memcpy(header->serialNumber, serialNumber.data(), serialNumber.size());
+
+        memcpy(mappedFile->getData() + calibrationOffset, calibration.data(), calibration.size());
+        index = reinterpret_cast<RecordingIndexEntry*>(mappedFile->getData() + indexOffset);
+
+        // One more buffer than the queue holds, for the frame being written
+        framePool = FramePool::create(kRecordingQueueCapacity + 1, stereoDimensions.height, stereoDimensions.width, channels);
+
+        isFinishing = false;
+        isFinished = false;
+        recordedFrameCount = 0;
+        backlogDroppedFrameCount = 0;
+        fullDroppedFrameCount = 0;
+
+        writerThread = thread(&RecordingWriter::run, this);
+    }
+
+    RecordingWriter::~RecordingWriter() {
+        finish();
+    }
+
+    bool RecordingWriter::record(const Frame& frame) {
+        if (isFinishing.load(memory_order_relaxed)) {
+            return false;
+        }
+
+        if (frame.getHeight() != size_t(header->height) || frame.getWidth() != size_t(header->width) || frame.getChannels() != header->channels) {
+            return false;
+        }
+
+        // Copied, so a writer that falls behind never holds the source's own buffers
+        Frame copy = framePool->acquire();
+
+        if (!copy.isValid()) {
+            backlogDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+
+        size_t rowBytes = frame.getWidth() * frame.getChannels();
+
+        for (size_t y = 0; y < frame.getHeight(); y++) {
+            memcpy(copy.getData() + y * copy.getRowBytes(), frame.getData() + y * frame.getRowBytes(), rowBytes);
+        }
+
+        copy.setTimestamp(frame.getTimestamp());
+        copy.setSequenceNumber(frame.getSequenceNumber());
+
+        return frameQueue.push(std::move(copy));
+    }
+
+    void RecordingWriter::finish() {
+        if (isFinished) {
+            return;
+        }
+
+        isFinishing = true;
+        writerThread.join();
+
+        size_t frameCount = recordedFrameCount.load(memory_order_relaxed);
+        size_t usedSize = header->dataOffset + frameCount * header->frameStride;
+
+        mappedFile->flush(0, usedSize, false);
+        mappedFile->resize(usedSize);
+
+        header = reinterpret_cast<RecordingHeader*>(mappedFile->getData());
+        index = reinterpret_cast<RecordingIndexEntry*>(mappedFile->getData() + header->indexOffset);
+
+        isFinished = true;
+    }
+
+    size_t RecordingWriter::getRecordedFrameCount() {
+        return recordedFrameCount.load(memory_order_relaxed);
+    }
+
+    uint64_t RecordingWriter::getDroppedFrameCount() {
+        return frameQueue.getDroppedFrameCount() + backlogDroppedFrameCount.load(memory_order_relaxed) + fullDroppedFrameCount.load(memory_order_relaxed);
+    }
+
+    void RecordingWriter::run() {
+        Frame frame;
+
+        while (!isFinishing.load(memory_order_acquire)) {
+            if (frameQueue.pop(frame, chrono::milliseconds(kRecordingWaitMilliseconds))) {
+                write(frame);
+                frame.release();
+            }
+        }
+
+        // `record()` no longer queues frames, so drain whatever is left
+        while (frameQueue.pop(frame)) {
+            write(frame);
+            frame.release();
+        }
+    }
+
+    void RecordingWriter::write(const Frame& frame) {
+        size_t frameIndex = recordedFrameCount.load(memory_order_relaxed);
+
+        if (frameIndex == header->maxFrameCount) {
+            fullDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        size_t frameOffset = header->dataOffset + frameIndex * header->frameStride;
+        uint8_t* destination = mappedFile->getData() + frameOffset;
+        size_t rowBytes = size_t(header->width) * header->channels;
+
+        if (frame.getRowBytes() == rowBytes) {
+            memcpy(destination, frame.getData(), header->frameSize);
+        }
+        else {
+            for (size_t y = 0; y < size_t(header->height); y++) {
+                memcpy(destination + y * rowBytes, frame.getData() + y * frame.getRowBytes(), rowBytes);
+            }
+        }
+
+        index[frameIndex].timestamp = frame.getTimestamp();
+        index[frameIndex].offset = frameOffset;
+
+        // Readers of a recording in progress only see frames whose data and index entry are complete
+        atomic_ref<uint64_t>(header->frameCount).store(frameIndex + 1, memory_order_release);
+        recordedFrameCount.store(frameIndex + 1, memory_order_relaxed);
+
+        // Write back in batches, and let written frames leave the page cache so long recordings don't build up memory pressure
+        if ((frameIndex + 1) % kRecordingFlushInterval == 0) {
+            size_t batchOffset = header->dataOffset + (frameIndex + 1 - kRecordingFlushInterval) * header->frameStride;
+            size_t batchSize = kRecordingFlushInterval * header->frameStride;
+
+            mappedFile->flush(batchOffset, batchSize, true);
+            mappedFile->release(batchOffset, batchSize);
+        }
+    }
+
+#pragma mark - RecordingReader
+
+    RecordingReader::RecordingReader(const path& filepath) {
+        mappedFile = MemoryMappedFile::open(filepath);
+
+        if (mappedFile->getSize() < sizeof(RecordingHeader)) {
+            throw runtime_error(format("File is too small to be a recording: {}", filepath.string()));
+        }
+
+        header = reinterpret_cast<const RecordingHeader*>(mappedFile->getData());
+
+        if (memcmp(header->magic, kRecordingMagic, sizeof(kRecordingMagic)) != 0) {
+            throw runtime_error(format("File is not a recording: {}", filepath.string()));
+        }
+
+        if (header->version != kRecordingVersion) {
+            throw runtime_error(format("Unsupported recording version {} in {}", header->version, filepath.string()));
+        }
+
+        frameCount = atomic_ref<const uint64_t>(header->frameCount).load(memory_order_acquire);
+
+        // Only trust frames that are fully inside the file
+        size_t storedFrameCount = mappedFile->getSize() > header->dataOffset ? (mappedFile->getSize() - header->dataOffset) / header->frameStride : 0;
+        frameCount = min(frameCount, storedFrameCount);
+
+        index = reinterpret_cast<const RecordingIndexEntry*>(mappedFile->getData() + header->indexOffset);
+    }
+
+    StereoDimensions RecordingReader::getStereoDimensions() {
+        StereoDimensions stereoDimensions;
+        stereoDimensions.width = header->width;
+        stereoDimensions.height = header->height;
+
+        return stereoDimensions;
+    }
+
+    ColorSpace RecordingReader::getColorSpace() {
+        return ColorSpace(header->colorSpace);
+    }
+
+    FrameRate RecordingReader::getFrameRate() {
+        return FrameRate(header->frameRate);
+    }
+
+    string RecordingReader::getSerialNumber() {
+        return string(header->serialNumber, strnlen(header->serialNumber, sizeof(header->serialNumber)));
+    }
+
+    CalibrationData RecordingReader::getCalibrationData() {
+        if (header->calibrationSize == 0) {
+            throw runtime_error("Recording has no calibration data");
+        }
+
+        CalibrationData calibrationData;
+        calibrationData.parse(string(reinterpret_cast<const char*>(mappedFile->getData() + header->calibrationOffset), header->calibrationSize));
+
+        return calibrationData;
+    }
+
+    size_t RecordingReader::getFrameCount() {
+        return frameCount;
+    }
+
+    uint64_t RecordingReader::getTimestamp(size_t frameIndex) {
+        if (frameIndex >= frameCount) {
+            throw out_of_range(format("Frame index {} is out of range for a recording of {} frames", frameIndex, frameCount));
+        }
+
+        return index[frameIndex].timestamp;
+    }
+
+    Frame RecordingReader::getFrame(size_t frameIndex) {
+        if (frameIndex >= frameCount) {
+            throw out_of_range(format("Frame index {} is out of range for a recording of {} frames", frameIndex, frameCount));
+        }
+
+        uint8_t* data = mappedFile->getData() + index[frameIndex].offset;
+        size_t rowBytes = size_t(header->width) * header->channels;
+
+        // The frame keeps the mapping alive
+        shared_ptr<MemoryMappedFile> mapping = mappedFile;
+        Frame frame = Frame::wrap(data, header->height, header->width, header->channels, rowBytes, [mapping]() {});
+        frame.setTimestamp(index[frameIndex].timestamp);
+
+        return frame;
+    }
+
+    size_t RecordingReader::findFrameIndex(uint64_t timestamp) {
+        if (frameCount == 0) {
+            throw out_of_range("Recording has no frames");
+        }
+
+        const RecordingIndexEntry* end = index + frameCount;
+        const RecordingIndexEntry* next =
+            lower_bound(index, end, timestamp, [](const RecordingIndexEntry& entry, uint64_t timestamp) { return entry.timestamp < timestamp; });
+
+        if (next == end) {
+            return frameCount - 1;
+        }
+
+        if (next == index) {
+            return 0;
+        }
+
+        const RecordingIndexEntry* previous = next - 1;
+
+        return size_t(timestamp - previous->timestamp <= next->timestamp - timestamp ? previous - index : next - index);
+    }
+}
@@ -0,0 +1,306 @@
+//
+// zed_sensor_data.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_sensor_data.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kLegacyPressureScale 0.01
+#define kLegacyHumidityScale (1.0 / 1024)
+#define kSlowSensorCapacityDivisor 8
+
+namespace zed {
+
+#pragma mark - Helpers
+
+    static float temperatureFromReport(int16_t temperature) {
+        return temperature == kInvalidTemperature ? numeric_limits<float>::quiet_NaN() : float(temperature * kTemperatureScale);
+    }
+
+    IMUSample interpolateIMUSample(const IMUSample& before, const IMUSample& after, uint64_t timestamp) {
+        if (timestamp == before.timestamp) {
+            return before;
+        }
+
+        if (timestamp == after.timestamp) {
+            return after;
+        }
+
+        float weight = float(double(timestamp - before.timestamp) / double(after.timestamp - before.timestamp));
+        IMUSample sample;
+        sample.timestamp = timestamp;
+
+        for (size_t axis = 0; axis < 3; axis++) {
+            sample.acceleration[axis] = before.acceleration[axis] + weight * (after.acceleration[axis] - before.acceleration[axis]);
+            sample.angularVelocity[axis] = before.angularVelocity[axis] + weight * (after.angularVelocity[axis] - before.angularVelocity[axis]);
+        }
+
+        sample.temperature = before.temperature + weight * (after.temperature - before.temperature);
+        sample.isFrameSync = false;
+        sample.isInterpolated = true;
+
+        return sample;
+    }
+
+#pragma mark - SensorReportDecoder
+
+    SensorReportDecoder::SensorReportDecoder(bool isLegacyFirmware) {
+        legacyFirmware = isLegacyFirmware;
+        reset();
+    }
+
+    bool SensorReportDecoder::decode(const uint8_t* report, size_t size, uint64_t arrivalTimestamp, DecodedSensorReport& decodedReport) {
+        if (size < sizeof(SensorReport) || report[0] != kSensorReportID) {
+            return false;
+        }
+
+        SensorReport sensorReport;
+        memcpy(&sensorReport, report, sizeof(SensorReport));
+
+        uint64_t deviceTimestamp = uint64_t(llround(sensorReport.timestamp * kSensorTickNanoseconds));
+        uint64_t timestamp = mapTimestamp(deviceTimestamp, arrivalTimestamp);
+
+        decodedReport.deviceTimestamp = deviceTimestamp;
+        decodedReport.hasIMUSample = sensorReport.isIMUInvalid == 0;
+        decodedReport.hasMagnetometerSample = sensorReport.magnetometerStatus == SENSOR_NEW_VALUE;
+        decodedReport.hasEnvironmentSample = sensorReport.environmentStatus == SENSOR_NEW_VALUE;
+
+        if (decodedReport.hasIMUSample) {
+            IMUSample& imuSample = decodedReport.imuSample;
+            imuSample.timestamp = timestamp;
+
+            for (size_t axis = 0; axis < 3; axis++) {
+                imuSample.acceleration[axis] = float(sensorReport.accelerometer[axis] * kAccelerationScale);
+                imuSample.angularVelocity[axis] = float(sensorReport.gyroscope[axis] * kAngularVelocityScale);
+            }
+
+            imuSample.temperature = temperatureFromReport(sensorReport.imuTemperature);
+            imuSample.isFrameSync = sensorReport.isFrameSync != 0;
+            imuSample.isInterpolated = false;
+        }
+
+        if (decodedReport.hasMagnetometerSample) {
+            MagnetometerSample& magnetometerSample = decodedReport.magnetometerSample;
+            magnetometerSample.timestamp = timestamp;
+
+            for (size_t axis = 0; axis < 3; axis++) {
+                magnetometerSample.magneticField[axis] = float(sensorReport.magnetometer[axis] * kMagneticFieldScale);
+            }
+        }
+
+        if (decodedReport.hasEnvironmentSample) {
+            EnvironmentSample& environmentSample = decodedReport.environmentSample;
+            environmentSample.timestamp = timestamp;
+            environmentSample.temperature = temperatureFromReport(sensorReport.temperature);
+            environmentSample.pressure = float(sensorReport.pressure * (legacyFirmware ? kLegacyPressureScale : kPressureScale));
+            environmentSample.humidity = float(sensorReport.humidity * (legacyFirmware ? kLegacyHumidityScale : kHumidityScale));
+            environmentSample.leftCameraTemperature = temperatureFromReport(sensorReport.leftCameraTemperature);
+            environmentSample.rightCameraTemperature = temperatureFromReport(sensorReport.rightCameraTemperature);
+        }
+
+        return true;
+    }
+
+    void SensorReportDecoder::reset() {
+        hasClockOffset = false;
+        clockOffset = 0;
+        previousDeviceTimestamp = 0;
+    }
+
+    bool SensorReportDecoder::isLegacyFirmware() {
+        return legacyFirmware;
+    }
+
+    uint64_t SensorReportDecoder::mapTimestamp(uint64_t deviceTimestamp, uint64_t arrivalTimestamp) {
+        int64_t offset = int64_t(arrivalTimestamp) - int64_t(deviceTimestamp);
+
+        // The MCU clock restarted (the camera was reset), the previous mapping no longer holds
+        if (hasClockOffset && deviceTimestamp < previousDeviceTimestamp) {
+            hasClockOffset = false;
+        }
+
+        if (!hasClockOffset || offset < clockOffset) {
+            clockOffset = offset;
+            hasClockOffset = true;
+        }
+        else {
+            clockOffset += min(offset - clockOffset, kSensorClockDriftPerReport);
+        }
+
+        previousDeviceTimestamp = deviceTimestamp;
+
+        return uint64_t(int64_t(deviceTimestamp) + clockOffset);
+    }
+
+#pragma mark - SensorStream
+
+    SensorStream::SensorStream(size_t imuCapacity, bool isLegacyFirmware)
+        : decoder(isLegacyFirmware),
+          imuRing(imuCapacity),
+          magnetometerRing(max(imuCapacity / kSlowSensorCapacityDivisor, size_t(1))),
+          environmentRing(max(imuCapacity / kSlowSensorCapacityDivisor, size_t(1))) {
+
+        exposureOffset.store(0, memory_order_relaxed);
+        reportCount.store(0, memory_order_relaxed);
+        invalidReportCount.store(0, memory_order_relaxed);
+    }
+
+    bool SensorStream::pushReport(const uint8_t* report, size_t size, uint64_t arrivalTimestamp) {
+        DecodedSensorReport decodedReport;
+
+        if (!decoder.decode(report, size, arrivalTimestamp, decodedReport)) {
+            invalidReportCount.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+
+        if (decodedReport.hasIMUSample) {
+            pushIMUSample(decodedReport.imuSample);
+        }
+
+        if (decodedReport.hasMagnetometerSample) {
+            pushMagnetometerSample(decodedReport.magnetometerSample);
+        }
+
+        if (decodedReport.hasEnvironmentSample) {
+            pushEnvironmentSample(decodedReport.environmentSample);
+        }
+
+        reportCount.fetch_add(1, memory_order_relaxed);
+
+        return true;
+    }
+
+    void SensorStream::pushIMUSample(const IMUSample& imuSample) {
+        IMUSample latestSample;
+
+        // Readers search the ring by timestamp, so it must stay ordered
+        if (imuRing.readLatest(latestSample) && imuSample.timestamp <= latestSample.timestamp) {
+            return;
+        }
+
+        imuRing.push(imuSample);
+    }
+
+    void SensorStream::pushMagnetometerSample(const MagnetometerSample& magnetometerSample) {
+        magnetometerRing.push(magnetometerSample);
+    }
+
+    void SensorStream::pushEnvironmentSample(const EnvironmentSample& environmentSample) {
+        environmentRing.push(environmentSample);
+    }
+
+    bool SensorStream::getIMUSample(uint64_t timestamp, IMUSample& imuSample) {
+        IMUSample before;
+        IMUSample after;
+
+        if (!findIMUSamples(timestamp, before, after)) {
+            return false;
+        }
+
+        imuSample = interpolateIMUSample(before, after, timestamp);
+
+        return true;
+    }
+
+    bool SensorStream::getIMUSamples(uint64_t startTimestamp, uint64_t endTimestamp, vector<IMUSample>& imuSamples) {
+        imuSamples.clear();
+
+        if (endTimestamp < startTimestamp) {
+            return false;
+        }
+
+        IMUSample sample;
+        bool isComplete = getIMUSample(startTimestamp, sample);
+
+        if (isComplete) {
+            imuSamples.push_back(sample);
+        }
+
+        uint64_t position = imuRing.lowerBound(startTimestamp + 1);
+
+        for (; position < imuRing.getWriteCount(); position++) {
+            if (!imuRing.read(position, sample)) {
+                // Overwritten while reading, the start of the interval is gone
+                imuSamples.clear();
+                isComplete = false;
+                continue;
+            }
+
+            if (sample.timestamp >= endTimestamp) {
+                break;
+            }
+
+            imuSamples.push_back(sample);
+        }
+
+        if (getIMUSample(endTimestamp, sample)) {
+            imuSamples.push_back(sample);
+        }
+        else {
+            isComplete = false;
+        }
+
+        return isComplete;
+    }
+
+    bool SensorStream::getIMUSamples(const Frame& previousFrame, const Frame& frame, vector<IMUSample>& imuSamples) {
+        int64_t offset = exposureOffset.load(memory_order_relaxed);
+
+        return getIMUSamples(uint64_t(int64_t(previousFrame.getTimestamp()) - offset), uint64_t(int64_t(frame.getTimestamp()) - offset), imuSamples);
+    }
+
+    bool SensorStream::getLatestIMUSample(IMUSample& imuSample) {
+        return imuRing.readLatest(imuSample);
+    }
+
+    bool SensorStream::getLatestMagnetometerSample(MagnetometerSample& magnetometerSample) {
+        return magnetometerRing.readLatest(magnetometerSample);
+    }
+
+    bool SensorStream::getLatestEnvironmentSample(EnvironmentSample& environmentSample) {
+        return environmentRing.readLatest(environmentSample);
+    }
+
+    int64_t SensorStream::getExposureOffset() {
+        return exposureOffset.load(memory_order_relaxed);
+    }
+
+    void SensorStream::setExposureOffset(int64_t exposureOffset) {
+        this->exposureOffset.store(exposureOffset, memory_order_relaxed);
+    }
+
+    uint64_t SensorStream::getReportCount() {
+        return reportCount.load(memory_order_relaxed);
+    }
+
+    uint64_t SensorStream::getInvalidReportCount() {
+        return invalidReportCount.load(memory_order_relaxed);
+    }
+
+#pragma mark - Private
+
+    bool SensorStream::findIMUSamples(uint64_t timestamp, IMUSample& before, IMUSample& after) {
+        uint64_t position = imuRing.lowerBound(timestamp);
+
+        if (!imuRing.read(position, after)) {
+            return false;
+        }
+
+        if (after.timestamp == timestamp) {
+            before = after;
+            return true;
+        }
+
+        return position > 0 && imuRing.read(position - 1, before) && before.timestamp <= timestamp;
+    }
+}
@@ -0,0 +1,812 @@
+//
+// zed_stereo_matcher.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_stereo_matcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZED_X86 1
+#include <immintrin.h>
+#define ZED_TARGET_SSE4 __attribute__((target("sse4.1,popcnt")))
+#define ZED_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kCensusRadius 2           // 5x5 census window, 24 bits per pixel
+#define kMaxAbsoluteDifference 63 // Truncation of ABSOLUTE_DIFFERENCE costs, so occlusions don't dominate the aggregation
+#define kMaxBlockSize 11          // Keeps window sums of 24-bit census costs within 16 bits
+#define kMaxDisparityCount 256
+#define kMaxLargePenalty 8192     // Keeps the sum of 5 paths within 16 bits
+#define kCensusSmallPenalty 4
+#define kCensusLargePenalty 32
+#define kAbsoluteDifferenceSmallPenalty 8
+#define kAbsoluteDifferenceLargePenalty 64
+#define kSemiGlobalBandOverlap 16 // Rows above each band aggregated (and discarded) so its paths from above don't start cold
+#define kPathPadding 8            // Saturated costs on either side of each pixel's path costs, for the unaligned loads of d - 1 and d + 1
+#define kSaturatedCost 0xFFFF
+#define kMaxPathCount 4           // Paths aggregated together, sharing the loads and stores of a pixel's costs and sums
+
+namespace zed {
+
+    struct StereoMatcherBand {
+        vector<uint8_t> costs;       // Matching cost per pixel and disparity of the current row (BLOCK_MATCHING: the rows of the window)
+        vector<uint16_t> sums;       // Aggregated cost per pixel and disparity of the current row
+        vector<uint16_t> columnSums; // BLOCK_MATCHING: costs summed down the window
+
+        // SEMI_GLOBAL: path costs of the previous and current row from above left, above, and above right,
+        // plus single pixels for the horizontal paths and the start of a path
+        vector<uint16_t> rowPaths;
+        vector<uint16_t> rowPathMinimums;
+        vector<uint16_t> pixelPaths;
+
+        // Right image row reversed and padded, so the right pixels of a left pixel's disparities are contiguous
+        vector<uint32_t> reversedCensus;
+        vector<uint8_t> reversedPixels;
+
+        // Disparity selection
+        vector<int> bestDisparities;
+        vector<uint32_t> rightMatches;
+    };
+
+    // Computes the matching costs of a row, where the right pixel at disparity index `i` of left pixel `x` is `reversed[width - 1 - x + i]`
+    typedef void (*CostRowComputer)(const uint32_t* leftCensus,
+        const uint32_t* reversedCensus,
+        const uint8_t* left,
+        const uint8_t* reversedPixels,
+        size_t width,
+        size_t disparityCount,
+        uint8_t* costs);
+
+    // One pixel's step along a path: L(d) = C(d) + min(L'(d), L'(d - 1) + P1, L'(d + 1) + P1, min L' + P2) - min L',
+    // where L' are the costs of the previous pixel on the path
+    struct PathStep {
+        const uint16_t* previous; // L', with saturated costs before and after
+        uint16_t previousMinimum;
+        uint16_t* current;        // L
+        uint16_t* minimum;        // min L
+    };
+
+    // Aggregates one pixel's costs along up to kMaxPathCount paths at once, adding them to `sums`
+    typedef void (*PathAggregator)(const uint8_t* costs, const PathStep* steps, size_t pathCount, uint16_t* sums, size_t disparityCount, uint16_t smallPenalty, uint16_t largePenalty);
+
+#pragma mark - Census Transform
+
+    static void censusTransformRows(const uint8_t* image, size_t rowBytes, size_t height, size_t width, uint32_t* census, size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; y++) {
+            const uint8_t* center = image + y * rowBytes;
+            uint32_t* output = census + y * width;
+
+            fill(output, output + width, 0);
+
+            // One neighbor at a time across the row, so the comparisons vectorize
+            for (int dy = -kCensusRadius; dy <= kCensusRadius; dy++) {
+                const uint8_t* row = image + clamp(int(y) + dy, 0, int(height) - 1) * rowBytes;
+
+                for (int dx = -kCensusRadius; dx <= kCensusRadius; dx++) {
+                    if (dy == 0 && dx == 0) {
+                        continue;
+                    }
+
+                    size_t start = min(size_t(max(-dx, 0)), width);
+                    size_t end = max(width - min(size_t(max(dx, 0)), width), start);
+
+                    for (size_t x = start; x < end; x++) {
+                        output[x] = (output[x] << 1) | uint32_t(row[x + dx] < center[x]);
+                    }
+
+                    // Neighbors beyond the left and right edges repeat the edge pixels
+                    auto compareEdge = [&](size_t x) {
+                        size_t neighbor = size_t(clamp(int(x) + dx, 0, int(width) - 1));
+                        output[x] = (output[x] << 1) | uint32_t(row[neighbor] < center[x]);
+                    };
+
+                    for (size_t x = 0; x < start; x++) {
+                        compareEdge(x);
+                    }
+
+                    for (size_t x = end; x < width; x++) {
+                        compareEdge(x);
+                    }
+                }
+            }
+        }
+    }
+
+#pragma mark - Matching Costs
+
+    template <MatchingCost matchingCost>
+    static void computeCostRowScalar(const uint32_t* leftCensus,
+        const uint32_t* reversedCensus,
+        const uint8_t* left,
+        const uint8_t* reversedPixels,
+        size_t width,
+        size_t disparityCount,
+        uint8_t* costs) {
+
+        for (size_t x = 0; x < width; x++) {
+            uint8_t* output = costs + x * disparityCount;
+
+            if constexpr (matchingCost == CENSUS) {
+                const uint32_t* right = reversedCensus + (width - 1 - x);
+
+                for (size_t i = 0; i < disparityCount; i++) {
+                    output[i] = uint8_t(__builtin_popcount(leftCensus[x] ^ right[i]));
+                }
+            }
+            else {
+                const uint8_t* right = reversedPixels + (width - 1 - x);
+
+                for (size_t i = 0; i < disparityCount; i++) {
+                    output[i] = uint8_t(min(abs(int(left[x]) - int(right[i])), kMaxAbsoluteDifference));
+                }
+            }
+        }
+    }
+
+#if ZED_X86
+    // Compiled with the popcnt instruction, which every SSE4 / AVX2 CPU has
+    ZED_TARGET_SSE4 static void computeCensusCostRowPOPCNT(const uint32_t* leftCensus,
+        const uint32_t* reversedCensus,
+        const uint8_t*,
+        const uint8_t*,
+        size_t width,
+        size_t disparityCount,
+        uint8_t* costs) {
+
+        for (size_t x = 0; x < width; x++) {
+            uint8_t* output = costs + x * disparityCount;
+            const uint32_t* right = reversedCensus + (width - 1 - x);
+
+            for (size_t i = 0; i < disparityCount; i++) {
+                output[i] = uint8_t(_mm_popcnt_u32(leftCensus[x] ^ right[i]));
+            }
+        }
+    }
+#endif
+
+#pragma mark - Path Aggregation
+
+    static void aggregatePathsScalar(const uint8_t* costs, const PathStep* steps, size_t pathCount, uint16_t* sums, size_t disparityCount, uint16_t smallPenalty, uint16_t largePenalty) {
+        for (size_t path = 0; path < pathCount; path++) {
+            const PathStep& step = steps[path];
+            uint32_t jump = step.previousMinimum + largePenalty;
+            uint16_t minimum = kSaturatedCost;
+
+            for (size_t d = 0; d < disparityCount; d++) {
+                uint32_t best = min({uint32_t(step.previous[d]), step.previous[d - 1] + uint32_t(smallPenalty), step.previous[d + 1] + uint32_t(smallPenalty), jump});
+                uint16_t value = uint16_t(costs[d] + best - step.previousMinimum);
+
+                step.current[d] = value;
+                sums[d] = uint16_t(min(uint32_t(sums[d]) + value, uint32_t(kSaturatedCost)));
+                minimum = min(minimum, value);
+            }
+
+            *step.minimum = minimum;
+        }
+    }
+
+#if ZED_X86
+    ZED_TARGET_SSE4 static void aggregatePathsSSE4(const uint8_t* costs, const PathStep* steps, size_t pathCount, uint16_t* sums, size_t disparityCount, uint16_t smallPenalty, uint16_t largePenalty) {
+        const __m128i small = _mm_set1_epi16(short(smallPenalty));
+        __m128i jumps[kMaxPathCount];
+        __m128i offsets[kMaxPathCount];
+        __m128i minimums[kMaxPathCount];
+
+        for (size_t path = 0; path < pathCount; path++) {
+            jumps[path] = _mm_set1_epi16(short(min(steps[path].previousMinimum + largePenalty, kSaturatedCost)));
+            offsets[path] = _mm_set1_epi16(short(steps[path].previousMinimum));
+            minimums[path] = _mm_set1_epi16(short(kSaturatedCost));
+        }
+
+        for (size_t d = 0; d < disparityCount; d += 8) {
+            __m128i cost = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(costs + d)));
+            __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + d));
+
+            for (size_t path = 0; path < pathCount; path++) {
+                const uint16_t* previous = steps[path].previous + d;
+
+                __m128i same = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous));
+                __m128i lower = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(previous - 1)), small);
+                __m128i higher = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + 1)), small);
+                __m128i best = _mm_min_epu16(_mm_min_epu16(same, lower), _mm_min_epu16(higher, jumps[path]));
+                __m128i value = _mm_add_epi16(_mm_sub_epi16(best, offsets[path]), cost);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(steps[path].current + d), value);
+                sum = _mm_adds_epu16(sum, value);
+                minimums[path] = _mm_min_epu16(minimums[path], value);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + d), sum);
+        }
+
+        for (size_t path = 0; path < pathCount; path++) {
+            *steps[path].minimum = uint16_t(_mm_extract_epi16(_mm_minpos_epu16(minimums[path]), 0));
+        }
+    }
+
+    ZED_TARGET_AVX2 static void aggregatePathsAVX2(const uint8_t* costs, const PathStep* steps, size_t pathCount, uint16_t* sums, size_t disparityCount, uint16_t smallPenalty, uint16_t largePenalty) {
+        const __m256i small = _mm256_set1_epi16(short(smallPenalty));
+        __m256i jumps[kMaxPathCount];
+        __m256i offsets[kMaxPathCount];
+        __m256i minimums[kMaxPathCount];
+
+        for (size_t path = 0; path < pathCount; path++) {
+            jumps[path] = _mm256_set1_epi16(short(min(steps[path].previousMinimum + largePenalty, kSaturatedCost)));
+            offsets[path] = _mm256_set1_epi16(short(steps[path].previousMinimum));
+            minimums[path] = _mm256_set1_epi16(short(kSaturatedCost));
+        }
+
+        for (size_t d = 0; d < disparityCount; d += 16) {
+            __m256i cost = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(costs + d)));
+            __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + d));
+
+            for (size_t path = 0; path < pathCount; path++) {
+                const uint16_t* previous = steps[path].previous + d;
+
+                __m256i same = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous));
+                __m256i lower = _mm256_adds_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous - 1)), small);
+                __m256i higher = _mm256_adds_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous + 1)), small);
+                __m256i best = _mm256_min_epu16(_mm256_min_epu16(same, lower), _mm256_min_epu16(higher, jumps[path]));
+                __m256i value = _mm256_add_epi16(_mm256_sub_epi16(best, offsets[path]), cost);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(steps[path].current + d), value);
+                sum = _mm256_adds_epu16(sum, value);
+                minimums[path] = _mm256_min_epu16(minimums[path], value);
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + d), sum);
+        }
+
+        for (size_t path = 0; path < pathCount; path++) {
+            __m128i halves = _mm_min_epu16(_mm256_castsi256_si128(minimums[path]), _mm256_extracti128_si256(minimums[path], 1));
+            *steps[path].minimum = uint16_t(_mm_extract_epi16(_mm_minpos_epu16(halves), 0));
+        }
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    static void aggregatePathsNEON(const uint8_t* costs, const PathStep* steps, size_t pathCount, uint16_t* sums, size_t disparityCount, uint16_t smallPenalty, uint16_t largePenalty) {
+        const uint16x8_t small = vdupq_n_u16(smallPenalty);
+        uint16x8_t jumps[kMaxPathCount];
+        uint16x8_t offsets[kMaxPathCount];
+        uint16x8_t minimums[kMaxPathCount];
+
+        for (size_t path = 0; path < pathCount; path++) {
+            jumps[path] = vdupq_n_u16(uint16_t(min(steps[path].previousMinimum + largePenalty, kSaturatedCost)));
+            offsets[path] = vdupq_n_u16(steps[path].previousMinimum);
+            minimums[path] = vdupq_n_u16(kSaturatedCost);
+        }
+
+        for (size_t d = 0; d < disparityCount; d += 8) {
+            uint8x8_t cost = vld1_u8(costs + d);
+            uint16x8_t sum = vld1q_u16(sums + d);
+
+            for (size_t path = 0; path < pathCount; path++) {
+                const uint16_t* previous = steps[path].previous + d;
+
+                uint16x8_t same = vld1q_u16(previous);
+                uint16x8_t lower = vqaddq_u16(vld1q_u16(previous - 1), small);
+                uint16x8_t higher = vqaddq_u16(vld1q_u16(previous + 1), small);
+                uint16x8_t best = vminq_u16(vminq_u16(same, lower), vminq_u16(higher, jumps[path]));
+                uint16x8_t value = vaddw_u8(vsubq_u16(best, offsets[path]), cost);
+
+                vst1q_u16(steps[path].current + d, value);
+                sum = vqaddq_u16(sum, value);
+                minimums[path] = vminq_u16(minimums[path], value);
+            }
+
+            vst1q_u16(sums + d, sum);
+        }
+
+        for (size_t path = 0; path < pathCount; path++) {
+            *steps[path].minimum = vminvq_u16(minimums[path]);
+        }
+    }
+#endif
+
+#pragma mark - Dispatch
+
+    static CostRowComputer costRowComputerFor(InstructionSet instructionSet, MatchingCost matchingCost) {
+        if (matchingCost == ABSOLUTE_DIFFERENCE) {
+            return computeCostRowScalar<ABSOLUTE_DIFFERENCE>;
+        }
+
+        switch (instructionSet) {
+#if ZED_X86
+            case AVX2:
+            case SSE4:
+                return computeCensusCostRowPOPCNT;
+#endif
+            default:
+                return computeCostRowScalar<CENSUS>;
+        }
+    }
+
+    static PathAggregator pathAggregatorFor(InstructionSet instructionSet) {
+        switch (instructionSet) {
+#if ZED_X86
+            case AVX2:
+                return aggregatePathsAVX2;
+            case SSE4:
+                return aggregatePathsSSE4;
+#endif
+#if defined(__ARM_NEON)
+            case NEON:
+                return aggregatePathsNEON;
+#endif
+            default:
+                return aggregatePathsScalar;
+        }
+    }
+
+#pragma mark - Disparity Selection
+
+    // Packs a cost above its disparity index, so a single minimum finds the lowest cost and (on ties) the lowest disparity,
+    // and the loops below vectorize
+    static inline uint32_t packCost(uint16_t cost, int index) {
+        return (uint32_t(cost) << 16) | uint32_t(index);
+    }
+
+    // Picks the lowest cost disparity of each pixel in a row of aggregated costs, then rejects ambiguous matches,
+    // matches outside the right image, and (with the left-right check) matches that disagree with the best match of the right pixel
+    static void selectDisparities(const uint16_t* sums, size_t width, const StereoMatcherSettings& settings, StereoMatcherBand& band, int16_t* disparity) {
+        int disparityCount = settings.disparityCount;
+        int padding = disparityCount + abs(settings.minDisparity);
+        bool isCheckingLeftRight = settings.leftRightTolerance >= 0;
+
+        int* bestDisparities = band.bestDisparities.data();
+        uint32_t* rightMatches = band.rightMatches.data(); // Best packed cost of right pixel `width - 1 - (k - padding)`
+
+        if (isCheckingLeftRight) {
+            fill(band.rightMatches.begin(), band.rightMatches.end(), UINT32_MAX);
+        }
+
+        for (size_t x = 0; x < width; x++) {
+            const uint16_t* costs = sums + x * disparityCount;
+            uint32_t bestMatch = UINT32_MAX;
+
+            for (int i = 0; i < disparityCount; i++) {
+                bestMatch = min(bestMatch, packCost(costs[i], i));
+            }
+
+            if (isCheckingLeftRight) {
+                uint32_t* matches = rightMatches + padding + (int(width) - 1 - int(x) + settings.minDisparity);
+
+                for (int i = 0; i < disparityCount; i++) {
+                    matches[i] = min(matches[i], packCost(costs[i], i));
+                }
+            }
+
+            int best = int(bestMatch & 0xFFFF);
+            uint16_t bestCost = uint16_t(bestMatch >> 16);
+            int rightX = int(x) - settings.minDisparity - best;
+            bool isValid = rightX >= 0 && rightX < int(width);
+
+            if (isValid && settings.uniquenessRatio > 0) {
+                uint16_t nextCost = kSaturatedCost;
+
+                for (int i = 0; i < best - 1; i++) {
+                    nextCost = min(nextCost, costs[i]);
+                }
+
+                for (int i = best + 2; i < disparityCount; i++) {
+                    nextCost = min(nextCost, costs[i]);
+                }
+
+                isValid = uint32_t(nextCost) * 100 > uint32_t(bestCost) * (100 + settings.uniquenessRatio);
+            }
+
+            if (!isValid) {
+                bestDisparities[x] = -1;
+                disparity[x] = kInvalidDisparity;
+                continue;
+            }
+
+            bestDisparities[x] = best;
+            int value = (settings.minDisparity + best) << kDisparityFractionBits;
+
+            if (settings.isSubpixel && best > 0 && best < disparityCount - 1) {
+                int previous = costs[best - 1];
+                int next = costs[best + 1];
+                int denominator = previous + next - 2 * bestCost;
+
+                if (denominator > 0) {
+                    float offset = float(previous - next) / (2 * denominator);
+                    value += int(lroundf(offset * (1 << kDisparityFractionBits)));
+                }
+            }
+
+            disparity[x] = int16_t(value);
+        }
+
+        if (!isCheckingLeftRight) {
+            return;
+        }
+
+        for (size_t x = 0; x < width; x++) {
+            if (bestDisparities[x] < 0) {
+                continue;
+            }
+
+            int rightX = int(x) - settings.minDisparity - bestDisparities[x];
+            uint32_t rightMatch = rightMatches[padding + int(width) - 1 - rightX];
+
+            if (rightMatch == UINT32_MAX || abs(int(rightMatch & 0xFFFF) - bestDisparities[x]) > settings.leftRightTolerance) {
+                disparity[x] = kInvalidDisparity;
+            }
+        }
+    }
+
+#pragma mark - Matching
+
+    struct MatchingInputs {
+        const uint8_t* left;
+        size_t leftRowBytes;
+        const uint8_t* right;
+        size_t rightRowBytes;
+        const uint32_t* leftCensus;
+        const uint32_t* rightCensus;
+        size_t height;
+        size_t width;
+        int16_t* disparity;
+        size_t disparityRowBytes;
+    };
+
+    static void prepareBand(StereoMatcherBand& band, const StereoMatcherSettings& settings, size_t width) {
+        size_t rowSize = width * settings.disparityCount;
+        size_t pathStride = settings.disparityCount + 2 * kPathPadding;
+
+        if (settings.mode == BLOCK_MATCHING) {
+            band.costs.resize(rowSize * settings.blockSize);
+            band.columnSums.resize(rowSize);
+        }
+        else {
+            band.costs.resize(rowSize);
+            band.rowPaths.resize(6 * width * pathStride);
+            band.rowPathMinimums.resize(6 * width);
+            band.pixelPaths.resize(5 * pathStride);
+        }
+
+        size_t reversedSize = width + 2 * (settings.disparityCount + abs(settings.minDisparity));
+
+        if (settings.matchingCost == CENSUS) {
+            band.reversedCensus.resize(reversedSize);
+        }
+        else {
+            band.reversedPixels.resize(reversedSize);
+        }
+
+        band.sums.resize(rowSize);
+        band.bestDisparities.resize(width);
+        band.rightMatches.resize(reversedSize);
+    }
+
+    // Right image pixels beyond the image edges repeat the edge pixels, their matches are rejected when disparities are selected
+    static void computeCostRow(CostRowComputer costRowComputer, const MatchingInputs& inputs, const StereoMatcherSettings& settings, StereoMatcherBand& band, size_t y, uint8_t* costs) {
+        int width = int(inputs.width);
+        int padding = settings.disparityCount + abs(settings.minDisparity);
+        const uint32_t* rightCensus = inputs.rightCensus + y * inputs.width;
+        const uint8_t* right = inputs.right + y * inputs.rightRowBytes;
+        bool isCensus = settings.matchingCost == CENSUS;
+
+        // Element `k` holds right pixel `width - 1 - (k - padding)`
+        for (int k = 0; k < width + 2 * padding; k++) {
+            int rightX = clamp(width - 1 - (k - padding), 0, width - 1);
+
+            if (isCensus) {
+                band.reversedCensus[k] = rightCensus[rightX];
+            }
+            else {
+                band.reversedPixels[k] = right[rightX];
+            }
+        }
+
+        // Disparity index 0 of left pixel `x` is right pixel `x - minDisparity`
+        size_t offset = size_t(padding + settings.minDisparity);
+
+        costRowComputer(inputs.leftCensus + y * inputs.width,
+            band.reversedCensus.data() + offset,
+            inputs.left + y * inputs.leftRowBytes,
+            band.reversedPixels.data() + offset,
+            inputs.width,
+            settings.disparityCount,
+            costs);
+    }
+
+    static int16_t* disparityRow(const MatchingInputs& inputs, size_t y) {
+        return reinterpret_cast<int16_t*>(reinterpret_cast<uint8_t*>(inputs.disparity) + y * inputs.disparityRowBytes);
+    }
+
+    // Sums costs over a blockSize x blockSize window sliding down the band (replicating the image borders)
+    static void matchBlocks(const MatchingInputs& inputs, const StereoMatcherSettings& settings, CostRowComputer costRowComputer, StereoMatcherBand& band, size_t y0, size_t y1) {
+        size_t width = inputs.width;
+        size_t disparityCount = settings.disparityCount;
+        size_t rowSize = width * disparityCount;
+        int radius = settings.blockSize / 2;
+
+        uint16_t* columnSums = band.columnSums.data();
+        uint16_t* sums = band.sums.data();
+
+        // Window row `sequence` is image row `sequence - radius`, each stored in slot `sequence % blockSize`
+        auto addWindowRow = [&](size_t sequence) {
+            uint8_t* costs = band.costs.data() + (sequence % settings.blockSize) * rowSize;
+            computeCostRow(costRowComputer, inputs, settings, band, size_t(clamp(int(sequence) - radius, 0, int(inputs.height) - 1)), costs);
+
+            for (size_t i = 0; i < rowSize; i++) {
+                columnSums[i] += costs[i];
+            }
+        };
+
+        fill(columnSums, columnSums + rowSize, 0);
+
+        for (size_t sequence = y0; sequence < y0 + settings.blockSize; sequence++) {
+            addWindowRow(sequence);
+        }
+
+        for (size_t y = y0; y < y1; y++) {
+            if (y > y0) {
+                const uint8_t* leaving = band.costs.data() + ((y + 2 * radius) % settings.blockSize) * rowSize;
+
+                for (size_t i = 0; i < rowSize; i++) {
+                    columnSums[i] -= leaving[i];
+                }
+
+                addWindowRow(y + 2 * radius);
+            }
+
+            // Slide the window across the row (intermediate values may wrap, window sums fit in 16 bits)
+            fill(sums, sums + disparityCount, 0);
+
+            for (int dx = -radius; dx <= radius; dx++) {
+                const uint16_t* column = columnSums + clamp(dx, 0, int(width) - 1) * disparityCount;
+
+                for (size_t i = 0; i < disparityCount; i++) {
+                    sums[i] += column[i];
+                }
+            }
+
+            for (size_t x = 1; x < width; x++) {
+                const uint16_t* entering = columnSums + min(x + radius, width - 1) * disparityCount;
+                const uint16_t* leavingColumn = columnSums + size_t(max(int(x) - radius - 1, 0)) * disparityCount;
+                const uint16_t* previous = sums + (x - 1) * disparityCount;
+                uint16_t* current = sums + x * disparityCount;
+
+                for (size_t i = 0; i < disparityCount; i++) {
+                    current[i] = uint16_t(previous[i] + entering[i] - leavingColumn[i]);
+                }
+            }
+
+            selectDisparities(sums, width, settings, band, disparityRow(inputs, y));
+        }
+    }
+
+    // Single pass semi-global matching: paths from the right, left, above left, above, and above right,
+    // so each row's aggregated costs are complete once the row is reached and only two rows of path costs are kept
+    static void matchSemiGlobal(const MatchingInputs& inputs,
+        const StereoMatcherSettings& settings,
+        CostRowComputer costRowComputer,
+        PathAggregator pathAggregator,
+        StereoMatcherBand& band,
+        size_t y0,
+        size_t y1) {
+
+        size_t width = inputs.width;
+        size_t disparityCount = settings.disparityCount;
+        size_t rowSize = width * disparityCount;
+        size_t pathStride = disparityCount + 2 * kPathPadding;
+        uint16_t smallPenalty = uint16_t(settings.smallPenalty);
+        uint16_t largePenalty = uint16_t(settings.largePenalty);
+
+        uint8_t* costs = band.costs.data();
+        uint16_t* sums = band.sums.data();
+
+        // Padding stays saturated, the first rows start every path from zero costs
+        fill(band.rowPaths.begin(), band.rowPaths.end(), uint16_t(kSaturatedCost));
+        fill(band.pixelPaths.begin(), band.pixelPaths.end(), uint16_t(kSaturatedCost));
+        fill(band.rowPathMinimums.begin(), band.rowPathMinimums.end(), 0);
+
+        auto rowPath = [&](size_t row, size_t direction, size_t x) {
+            return band.rowPaths.data() + ((row * 3 + direction) * width + x) * pathStride + kPathPadding;
+        };
+
+        auto pixelPath = [&](size_t index) {
+            return band.pixelPaths.data() + index * pathStride + kPathPadding;
+        };
+
+        uint16_t* zero = pixelPath(4);
+        fill(zero, zero + disparityCount, 0);
+
+        for (size_t direction = 0; direction < 3; direction++) {
+            for (size_t x = 0; x < width; x++) {
+                fill(rowPath(0, direction, x), rowPath(0, direction, x) + disparityCount, 0);
+            }
+        }
+
+        size_t previousRow = 0;
+        size_t startRow = size_t(max(int(y0) - kSemiGlobalBandOverlap, 0));
+
+        for (size_t y = startRow; y < y1; y++) {
+            size_t currentRow = 1 - previousRow;
+            uint16_t* previousMinimums = band.rowPathMinimums.data() + previousRow * 3 * width;
+            uint16_t* currentMinimums = band.rowPathMinimums.data() + currentRow * 3 * width;
+
+            computeCostRow(costRowComputer, inputs, settings, band, y, costs);
+            fill(sums, sums + rowSize, 0);
+
+            // From the right
+            uint16_t minimums[kMaxPathCount] = {};
+            PathStep steps[kMaxPathCount];
+            steps[0] = {zero, 0, nullptr, &minimums[0]};
+
+            for (size_t x = width; x-- > 0;) {
+                steps[0].current = pixelPath(x & 1);
+                pathAggregator(costs + x * disparityCount, steps, 1, sums + x * disparityCount, disparityCount, smallPenalty, largePenalty);
+
+                steps[0].previous = steps[0].current;
+                steps[0].previousMinimum = minimums[0];
+            }
+
+            // From the left and the row above (above left, above, above right)
+            steps[0] = {zero, 0, nullptr, &minimums[0]};
+
+            for (size_t x = 0; x < width; x++) {
+                steps[0].current = pixelPath(2 + (x & 1));
+
+                for (size_t direction = 0; direction < 3; direction++) {
+                    int aboveX = int(x) + int(direction) - 1;
+                    bool isInside = aboveX >= 0 && aboveX < int(width);
+
+                    steps[direction + 1] = {isInside ? rowPath(previousRow, direction, aboveX) : zero,
+                        isInside ? previousMinimums[direction * width + aboveX] : uint16_t(0),
+                        rowPath(currentRow, direction, x),
+                        &currentMinimums[direction * width + x]};
+                }
+
+                pathAggregator(costs + x * disparityCount, steps, 4, sums + x * disparityCount, disparityCount, smallPenalty, largePenalty);
+
+                steps[0].previous = steps[0].current;
+                steps[0].previousMinimum = minimums[0];
+            }
+
+            previousRow = currentRow;
+
+            if (y >= y0) {
+                selectDisparities(sums, width, settings, band, disparityRow(inputs, y));
+            }
+        }
+    }
+
+#pragma mark - Public
+
+    StereoMatcher::StereoMatcher(StereoMatcherSettings settings, size_t threadCount) : StereoMatcher(settings, threadCount, ColorConverter::detectInstructionSet()) {}
+
+    StereoMatcher::StereoMatcher(StereoMatcherSettings settings, size_t threadCount, InstructionSet instructionSet) {
+        if (!ColorConverter::isSupported(instructionSet)) {
+            throw runtime_error(format("Instruction set {} is not supported on this CPU", instructionSetToString(instructionSet)));
+        }
+
+        if (settings.disparityCount <= 0 || settings.disparityCount % 16 != 0 || settings.disparityCount > kMaxDisparityCount) {
+            throw runtime_error(format("Invalid disparity count: {} (a multiple of 16 up to {})", settings.disparityCount, kMaxDisparityCount));
+        }
+
+        if (settings.blockSize < 1 || settings.blockSize % 2 == 0 || settings.blockSize > kMaxBlockSize) {
+            throw runtime_error(format("Invalid block size: {} (odd, up to {})", settings.blockSize, kMaxBlockSize));
+        }
+
+        if (settings.smallPenalty == 0) {
+            settings.smallPenalty = settings.matchingCost == CENSUS ? kCensusSmallPenalty : kAbsoluteDifferenceSmallPenalty;
+        }
+
+        if (settings.largePenalty == 0) {
+            settings.largePenalty = settings.matchingCost == CENSUS ? kCensusLargePenalty : kAbsoluteDifferenceLargePenalty;
+        }
+
+        if (settings.smallPenalty < 0 || settings.largePenalty < settings.smallPenalty || settings.largePenalty > kMaxLargePenalty) {
+            throw runtime_error(format("Invalid penalties: {}, {} (0 <= small <= large <= {})", settings.smallPenalty, settings.largePenalty, kMaxLargePenalty));
+        }
+
+        this->settings = settings;
+        this->instructionSet = instructionSet;
+        threadPool = make_unique<ThreadPool>(threadCount);
+
+        for (size_t i = 0; i < threadPool->getThreadCount(); i++) {
+            bands.push_back(make_unique<StereoMatcherBand>());
+        }
+    }
+
+    StereoMatcher::~StereoMatcher() = default;
+
+    void StereoMatcher::compute(const uint8_t* left,
+        size_t leftRowBytes,
+        const uint8_t* right,
+        size_t rightRowBytes,
+        size_t height,
+        size_t width,
+        int16_t* disparity,
+        size_t disparityRowBytes) {
+
+        if (width == 0 || height == 0) {
+            return;
+        }
+
+        size_t bandCount = min(bands.size(), height);
+        size_t bandHeight = (height + bandCount - 1) / bandCount;
+
+        leftCensus.resize(width * height);
+        rightCensus.resize(width * height);
+
+        if (settings.matchingCost == CENSUS) {
+            threadPool->parallelFor(bandCount * 2, [&](size_t task) {
+                size_t y0 = (task / 2) * bandHeight;
+                size_t y1 = min(y0 + bandHeight, height);
+
+                if (task % 2 == 0) {
+                    censusTransformRows(left, leftRowBytes, height, width, leftCensus.data(), y0, y1);
+                }
+                else {
+                    censusTransformRows(right, rightRowBytes, height, width, rightCensus.data(), y0, y1);
+                }
+            });
+        }
+
+        MatchingInputs inputs = {left, leftRowBytes, right, rightRowBytes, leftCensus.data(), rightCensus.data(), height, width, disparity, disparityRowBytes};
+        CostRowComputer costRowComputer = costRowComputerFor(instructionSet, settings.matchingCost);
+        PathAggregator pathAggregator = pathAggregatorFor(instructionSet);
+
+        threadPool->parallelFor(bandCount, [&](size_t band) {
+            size_t y0 = band * bandHeight;
+            size_t y1 = min(y0 + bandHeight, height);
+
+            if (y0 >= y1) {
+                return;
+            }
+
+            prepareBand(*bands[band], settings, width);
+
+            if (settings.mode == BLOCK_MATCHING) {
+                matchBlocks(inputs, settings, costRowComputer, *bands[band], y0, y1);
+            }
+            else {
+                matchSemiGlobal(inputs, settings, costRowComputer, pathAggregator, *bands[band], y0, y1);
+            }
+        });
+    }
+
+    void StereoMatcher::compute(Frame& frame, int16_t* disparity, size_t disparityRowBytes) {
+        FramePlane left = frame.getPlane(LEFT);
+        FramePlane right = frame.getPlane(RIGHT);
+
+        if (left.channels != 1) {
+            throw runtime_error(format("Stereo matching needs GREYSCALE frames, got {} channels", left.channels));
+        }
+
+        compute(left.data, left.rowBytes, right.data, right.rowBytes, left.height, left.width, disparity, disparityRowBytes);
+    }
+
+    StereoMatcherSettings StereoMatcher::getSettings() {
+        return settings;
+    }
+
+    InstructionSet StereoMatcher::getInstructionSet() {
+        return instructionSet;
+    }
+
+    size_t StereoMatcher::getThreadCount() {
+        return threadPool->getThreadCount();
+    }
+}
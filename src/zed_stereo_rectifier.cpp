@@ -0,0 +1,1220 @@
+//
+// zed_stereo_rectifier.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_stereo_rectifier.h"
+#include "zed_image_pyramid.h"
+#include "zed_memory_mapped_file.h"
+#include "zed_yuv_conversion.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZED_X86 1
+#include <immintrin.h>
+#define ZED_TARGET_SSE4 __attribute__((target("sse4.1")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+//
+// Parameters
+//
+#define kRemapTileWidth 256 // Tile sizes are multiples of 2^(kMaxPyramidLevelCount - 1), so tiles align with every pyramid level
+#define kRemapTileHeight 16
+#define kUndistortIterations 5
+#define kRectangleGridSize 9
+#define kRectificationCacheAlignment 64
+
+namespace zed {
+
+    typedef array<double, 3> Vector3;
+    typedef array<double, 9> Matrix3;
+
+    struct CameraParameters {
+        double fx, fy, cx, cy;
+        double k1, k2, p1, p2, k3;
+    };
+
+    struct Rectangle {
+        double x, y, width, height;
+    };
+
+#pragma mark - Linear Algebra
+
+    static Matrix3 multiply(const Matrix3& a, const Matrix3& b) {
+        Matrix3 result = {};
+
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 3; column++) {
+                for (int k = 0; k < 3; k++) {
+                    result[row * 3 + column] += a[row * 3 + k] * b[k * 3 + column];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static Vector3 multiply(const Matrix3& a, const Vector3& v) {
+        return {a[0] * v[0] + a[1] * v[1] + a[2] * v[2], a[3] * v[0] + a[4] * v[1] + a[5] * v[2], a[6] * v[0] + a[7] * v[1] + a[8] * v[2]};
+    }
+
+    static Matrix3 transpose(const Matrix3& a) {
+        return {a[0], a[3], a[6], a[1], a[4], a[7], a[2], a[5], a[8]};
+    }
+
+    static Matrix3 inverse(const Matrix3& a) {
+        double determinant = a[0] * (a[4] * a[8] - a[5] * a[7]) - a[1] * (a[3] * a[8] - a[5] * a[6]) + a[2] * (a[3] * a[7] - a[4] * a[6]);
+
+        if (fabs(determinant) < DBL_EPSILON) {
+            throw runtime_error("Unable to invert singular rectification matrix");
+        }
+
+        double scale = 1.0 / determinant;
+
+        return {(a[4] * a[8] - a[5] * a[7]) * scale,
+            (a[2] * a[7] - a[1] * a[8]) * scale,
+            (a[1] * a[5] - a[2] * a[4]) * scale,
+            (a[5] * a[6] - a[3] * a[8]) * scale,
+            (a[0] * a[8] - a[2] * a[6]) * scale,
+            (a[2] * a[3] - a[0] * a[5]) * scale,
+            (a[3] * a[7] - a[4] * a[6]) * scale,
+            (a[1] * a[6] - a[0] * a[7]) * scale,
+            (a[0] * a[4] - a[1] * a[3]) * scale};
+    }
+
+    static Vector3 cross(const Vector3& a, const Vector3& b) {
+        return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    }
+
+    static double norm(const Vector3& v) {
+        return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+
+    // Converts a rotation vector (axis * angle) to a rotation matrix
+    static Matrix3 rodrigues(const Vector3& rotation) {
+        double theta = norm(rotation);
+
+        if (theta < DBL_EPSILON) {
+            return {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        }
+
+        double x = rotation[0] / theta;
+        double y = rotation[1] / theta;
+        double z = rotation[2] / theta;
+        double c = cos(theta);
+        double s = sin(theta);
+        double t = 1 - c;
+
+        return {c + t * x * x, t * x * y - s * z, t * x * z + s * y, t * x * y + s * z, c + t * y * y, t * y * z - s * x, t * x * z - s * y, t * y * z + s * x, c + t * z * z};
+    }
+
+#pragma mark - Camera Model
+
+    static CameraParameters loadCameraParameters(const CameraIntrinsics& intrinsics) {
+        return {intrinsics.fx, intrinsics.fy, intrinsics.cx, intrinsics.cy, intrinsics.k1, intrinsics.k2, intrinsics.p1, intrinsics.p2, intrinsics.k3};
+    }
+
+    // Applies lens distortion to a normalized image point
+    static void distort(const CameraParameters& camera, double x, double y, double& distortedX, double& distortedY) {
+        double x2 = x * x;
+        double y2 = y * y;
+        double r2 = x2 + y2;
+        double xy2 = 2 * x * y;
+        double radial = 1 + ((camera.k3 * r2 + camera.k2) * r2 + camera.k1) * r2;
+
+        distortedX = x * radial + camera.p1 * xy2 + camera.p2 * (r2 + 2 * x2);
+        distortedY = y * radial + camera.p1 * (r2 + 2 * y2) + camera.p2 * xy2;
+    }
+
+    // Removes lens distortion from a pixel, returning a normalized image point (iterative inverse of `distort`)
+    static void undistort(const CameraParameters& camera, double u, double v, double& x, double& y) {
+        double x0 = (u - camera.cx) / camera.fx;
+        double y0 = (v - camera.cy) / camera.fy;
+
+        x = x0;
+        y = y0;
+
+        for (int i = 0; i < kUndistortIterations; i++) {
+            double r2 = x * x + y * y;
+            double inverseRadial = 1 / (1 + ((camera.k3 * r2 + camera.k2) * r2 + camera.k1) * r2);
+            double deltaX = 2 * camera.p1 * x * y + camera.p2 * (r2 + 2 * x * x);
+            double deltaY = camera.p1 * (r2 + 2 * y * y) + 2 * camera.p2 * x * y;
+
+            x = (x0 - deltaX) * inverseRadial;
+            y = (y0 - deltaY) * inverseRadial;
+        }
+    }
+
+    // Finds the largest rectangle inside and the bounding rectangle of the rectified image area
+    static void findRectangles(const CameraParameters& camera,
+        const Matrix3& rotation,
+        double focalLength,
+        double centerX,
+        double centerY,
+        size_t width,
+        size_t height,
+        Rectangle& inner,
+        Rectangle& outer) {
+
+        double innerX0 = -DBL_MAX, innerX1 = DBL_MAX, innerY0 = -DBL_MAX, innerY1 = DBL_MAX;
+        double outerX0 = DBL_MAX, outerX1 = -DBL_MAX, outerY0 = DBL_MAX, outerY1 = -DBL_MAX;
+
+        for (int gridY = 0; gridY < kRectangleGridSize; gridY++) {
+            for (int gridX = 0; gridX < kRectangleGridSize; gridX++) {
+                double x, y;
+                undistort(camera, double(gridX) * width / (kRectangleGridSize - 1), double(gridY) * height / (kRectangleGridSize - 1), x, y);
+
+                Vector3 point = multiply(rotation, Vector3{x, y, 1});
+                double px = focalLength * point[0] / point[2] + centerX;
+                double py = focalLength * point[1] / point[2] + centerY;
+
+                outerX0 = min(outerX0, px);
+                outerX1 = max(outerX1, px);
+                outerY0 = min(outerY0, py);
+                outerY1 = max(outerY1, py);
+
+                if (gridX == 0) {
+                    innerX0 = max(innerX0, px);
+                }
+                if (gridX == kRectangleGridSize - 1) {
+                    innerX1 = min(innerX1, px);
+                }
+                if (gridY == 0) {
+                    innerY0 = max(innerY0, py);
+                }
+                if (gridY == kRectangleGridSize - 1) {
+                    innerY1 = min(innerY1, py);
+                }
+            }
+        }
+
+        inner = {innerX0, innerY0, innerX1 - innerX0, innerY1 - innerY0};
+        outer = {outerX0, outerY0, outerX1 - outerX0, outerY1 - outerY0};
+    }
+
+    // Computes remap tables from rectified pixels to raw pixels for one eye
+    static void computeRemapMap(const CameraParameters& camera,
+        const Matrix3& rotation,
+        const array<double, 12>& projection,
+        size_t width,
+        size_t height,
+        ThreadPool& threadPool,
+        int16_t* mapCoordinates,
+        uint16_t* mapFractions) {
+
+        Matrix3 newCameraMatrix = {projection[0], projection[1], projection[2], projection[4], projection[5], projection[6], projection[8], projection[9], projection[10]};
+        Matrix3 inverseRectification = inverse(multiply(newCameraMatrix, rotation));
+
+        size_t bandCount = threadPool.getThreadCount();
+        size_t bandHeight = (height + bandCount - 1) / bandCount;
+
+        threadPool.parallelFor(bandCount, [&](size_t band) {
+            size_t startRow = band * bandHeight;
+            size_t endRow = min(startRow + bandHeight, height);
+
+            for (size_t row = startRow; row < endRow; row++) {
+                int16_t* coordinates = mapCoordinates + row * width * 2;
+                uint16_t* fractions = mapFractions + row * width;
+
+                for (size_t column = 0; column < width; column++) {
+                    Vector3 ray = multiply(inverseRectification, Vector3{double(column), double(row), 1});
+
+                    double x, y;
+                    distort(camera, ray[0] / ray[2], ray[1] / ray[2], x, y);
+
+                    double u = camera.fx * x + camera.cx;
+                    double v = camera.fy * y + camera.cy;
+
+                    // Clamping keeps far-away coordinates outside the image while fitting in 16 bits
+                    long fixedU = lround(clamp(u, -2.0, double(width) + 1) * kRemapFractionCount);
+                    long fixedV = lround(clamp(v, -2.0, double(height) + 1) * kRemapFractionCount);
+
+                    coordinates[column * 2] = int16_t(fixedU >> kRemapFractionBits);
+                    coordinates[column * 2 + 1] = int16_t(fixedV >> kRemapFractionBits);
+                    fractions[column] = uint16_t(((fixedV & (kRemapFractionCount - 1)) << kRemapFractionBits) | (fixedU & (kRemapFractionCount - 1)));
+                }
+            }
+        });
+    }
+
+#pragma mark - Remap
+
+    // Bilinear weights of every packed fraction, 4 per fraction (see `StereoRectifier::remapWeights()`)
+    static const array<int16_t, kRemapFractionCount * kRemapFractionCount * 4> remapWeightTable = [] {
+        array<int16_t, kRemapFractionCount * kRemapFractionCount * 4> table;
+        const double unit = 1 << kRemapWeightBits;
+
+        for (int fy = 0; fy < kRemapFractionCount; fy++) {
+            for (int fx = 0; fx < kRemapFractionCount; fx++) {
+                double x = double(fx) / kRemapFractionCount;
+                double y = double(fy) / kRemapFractionCount;
+                int16_t* weights = table.data() + ((fy << kRemapFractionBits) | fx) * 4;
+
+                weights[1] = int16_t(lround(x * (1 - y) * unit));
+                weights[2] = int16_t(lround((1 - x) * y * unit));
+                weights[3] = int16_t(lround(x * y * unit));
+
+                // The remaining weight absorbs rounding so the 4 weights always sum to exactly 1.0
+                weights[0] = int16_t((1 << kRemapWeightBits) - weights[1] - weights[2] - weights[3]);
+            }
+        }
+
+        return table;
+    }();
+
+    // Image being remapped, with `data` starting at its pixel (`x`, `y`)
+    struct RemapSource {
+        const uint8_t* data;
+        size_t rowBytes;
+        int x;
+        int y;
+        uint8_t borderValue; // Value of the samples outside the image
+    };
+
+    typedef void (*RemapRow)(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool isInterior);
+
+    // Samples one pixel at (`x`, `y`) plus its fraction, handling samples outside the `width` x `height` image
+    template <int channels>
+    static inline void remapPixel(int x, int y, const int16_t* weights, const RemapSource& source, size_t width, size_t height, uint8_t* destination) {
+        const int rounding = 1 << (kRemapWeightBits - 1);
+        bool isInside = unsigned(x) < width - 1 && unsigned(y) < height - 1;
+        int values[channels] = {};
+
+        for (int corner = 0; corner < 4; corner++) {
+            int sampleX = x + (corner & 1);
+            int sampleY = y + (corner >> 1);
+
+            if (isInside || (sampleX >= 0 && sampleY >= 0 && size_t(sampleX) < width && size_t(sampleY) < height)) {
+                const uint8_t* sample = source.data + (sampleY - source.y) * source.rowBytes + (sampleX - source.x) * channels;
+
+                for (int c = 0; c < channels; c++) {
+                    values[c] += sample[c] * weights[corner];
+                }
+            }
+            else {
+                for (int c = 0; c < channels; c++) {
+                    values[c] += source.borderValue * weights[corner];
+                }
+            }
+        }
+
+        for (int c = 0; c < channels; c++) {
+            destination[c] = uint8_t((values[c] + rounding) >> kRemapWeightBits);
+        }
+    }
+
+    template <int channels>
+    static void remapRowScalar(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool) {
+
+        for (size_t i = 0; i < count; i++) {
+            remapPixel<channels>(coordinates[i * 2], coordinates[i * 2 + 1], remapWeightTable.data() + fractions[i] * 4, source, width, height, destination + i * channels);
+        }
+    }
+
+    // Top (low 16 bits) and bottom (high 16 bits) taps of a 1 channel pixel, loaded into a register
+    static inline uint32_t loadGreyscaleTaps(const uint8_t* top, size_t rowBytes) {
+        uint16_t topPair, bottomPair;
+
+        memcpy(&topPair, top, 2);
+        memcpy(&bottomPair, top + rowBytes, 2);
+
+        return uint32_t(bottomPair) << 16 | topPair;
+    }
+
+    // Left and right taps of a 3 channel pixel, loaded into a register without reading past them
+    static inline uint64_t loadRGBTaps(const uint8_t* taps) {
+        uint32_t first;
+        uint16_t last;
+
+        memcpy(&first, taps, 4);
+        memcpy(&last, taps + 4, 2);
+
+        return uint64_t(last) << 32 | first;
+    }
+
+#if ZED_X86
+    // Whether the top left samples of 4 pixels are at least one pixel away from the right and bottom edges
+    ZED_TARGET_SSE4 static inline bool isInterior4(const int16_t* coordinates, __m128i maxCoordinates) {
+        __m128i xy = _mm_loadu_si128((const __m128i*)coordinates);
+
+        // Negative coordinates are above the maximum as unsigned
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_min_epu16(xy, maxCoordinates), xy)) == 0xffff;
+    }
+
+    // Blends the 4 taps of 4 pixels at once: each pixel's (top left, top right, bottom left, bottom right) taps
+    // multiply its 4 weights with `madd`, and horizontal adds sum the pairs
+    ZED_TARGET_SSE4 static void remapRowSSE4Greyscale(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool isInterior) {
+
+        const int16_t* weightTable = remapWeightTable.data();
+        const __m128i maxCoordinates = _mm_set1_epi32(int((height - 2) << 16 | (width - 2)));
+        const __m128i rounding = _mm_set1_epi32(1 << (kRemapWeightBits - 1));
+
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            const int16_t* pixelCoordinates = coordinates + i * 2;
+
+            if (!isInterior && !isInterior4(pixelCoordinates, maxCoordinates)) {
+                remapRowScalar<1>(pixelCoordinates, fractions + i, source, width, height, destination + i, 4, false);
+                continue;
+            }
+
+            const uint8_t* tops[4];
+
+            for (int j = 0; j < 4; j++) {
+                tops[j] = source.data + (pixelCoordinates[j * 2 + 1] - source.y) * source.rowBytes + (pixelCoordinates[j * 2] - source.x);
+            }
+
+            // Inserted from registers, a 16 byte load of taps just stored in pieces would stall on store forwarding
+            __m128i tapBytes = _mm_cvtsi32_si128(int(loadGreyscaleTaps(tops[0], source.rowBytes)));
+            tapBytes = _mm_insert_epi32(tapBytes, int(loadGreyscaleTaps(tops[1], source.rowBytes)), 1);
+            tapBytes = _mm_insert_epi32(tapBytes, int(loadGreyscaleTaps(tops[2], source.rowBytes)), 2);
+            tapBytes = _mm_insert_epi32(tapBytes, int(loadGreyscaleTaps(tops[3], source.rowBytes)), 3);
+            __m128i weights01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(weightTable + fractions[i] * 4)),
+                _mm_loadl_epi64((const __m128i*)(weightTable + fractions[i + 1] * 4)));
+            __m128i weights23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(weightTable + fractions[i + 2] * 4)),
+                _mm_loadl_epi64((const __m128i*)(weightTable + fractions[i + 3] * 4)));
+
+            __m128i sums01 = _mm_madd_epi16(_mm_cvtepu8_epi16(tapBytes), weights01);
+            __m128i sums23 = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(tapBytes, 8)), weights23);
+            __m128i values = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(sums01, sums23), rounding), kRemapWeightBits);
+            __m128i packed = _mm_packs_epi32(values, values);
+
+            uint32_t output = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed)));
+            memcpy(destination + i, &output, 4);
+        }
+
+        remapRowScalar<1>(coordinates + i * 2, fractions + i, source, width, height, destination + i, count - i, isInterior);
+    }
+
+    // Blends one pixel's 3 channels at a time: the channels of its left and right taps are paired up for `madd`
+    ZED_TARGET_SSE4 static void remapRowSSE4RGB(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool isInterior) {
+
+        const int16_t* weightTable = remapWeightTable.data();
+        const size_t maxX = width - 2;
+        const size_t maxY = height - 2;
+        const __m128i pairMask = _mm_setr_epi8(0, 3, 1, 4, 2, 5, -1, -1, 8, 11, 9, 12, 10, 13, -1, -1);
+        const __m128i rounding = _mm_set1_epi32(1 << (kRemapWeightBits - 1));
+
+        for (size_t i = 0; i < count; i++) {
+            int x = coordinates[i * 2];
+            int y = coordinates[i * 2 + 1];
+            const int16_t* weights = weightTable + fractions[i] * 4;
+
+            if (!isInterior && (unsigned(x) > maxX || unsigned(y) > maxY)) {
+                remapPixel<3>(x, y, weights, source, width, height, destination + i * 3);
+                continue;
+            }
+
+            const uint8_t* top = source.data + (y - source.y) * source.rowBytes + (x - source.x) * 3;
+            uint64_t topTaps = loadRGBTaps(top);
+            uint64_t bottomTaps = loadRGBTaps(top + source.rowBytes);
+
+            // (left, right) pairs of each channel, top taps in the low half and bottom taps in the high half
+            __m128i taps = _mm_shuffle_epi8(_mm_set_epi64x(int64_t(bottomTaps), int64_t(topTaps)), pairMask);
+            __m128i pairWeights = _mm_loadl_epi64((const __m128i*)weights);
+
+            __m128i topSums = _mm_madd_epi16(_mm_cvtepu8_epi16(taps), _mm_shuffle_epi32(pairWeights, 0x00));
+            __m128i bottomSums = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(taps, 8)), _mm_shuffle_epi32(pairWeights, 0x55));
+            __m128i values = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(topSums, bottomSums), rounding), kRemapWeightBits);
+            __m128i packed = _mm_packs_epi32(values, values);
+
+            uint32_t output = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed)));
+            memcpy(destination + i * 3, &output, 3);
+        }
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    // Whether the top left samples of 4 pixels are at least one pixel away from the right and bottom edges
+    static inline bool isInterior4(const int16_t* coordinates, uint16x8_t maxCoordinates) {
+        uint16x8_t xy = vld1q_u16((const uint16_t*)coordinates);
+
+        // Negative coordinates are above the maximum as unsigned
+        return vminvq_u16(vcleq_u16(xy, maxCoordinates)) != 0;
+    }
+
+    // Blends the 4 taps of 4 pixels at once: each pixel's (top left, top right, bottom left, bottom right) taps
+    // multiply its 4 weights, and pairwise adds sum them
+    static void remapRowNEONGreyscale(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool isInterior) {
+
+        const int16_t* weightTable = remapWeightTable.data();
+        const uint16x8_t maxCoordinates = vreinterpretq_u16_u32(vdupq_n_u32(uint32_t((height - 2) << 16 | (width - 2))));
+
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            const int16_t* pixelCoordinates = coordinates + i * 2;
+
+            if (!isInterior && !isInterior4(pixelCoordinates, maxCoordinates)) {
+                remapRowScalar<1>(pixelCoordinates, fractions + i, source, width, height, destination + i, 4, false);
+                continue;
+            }
+
+            const uint8_t* tops[4];
+
+            for (int j = 0; j < 4; j++) {
+                tops[j] = source.data + (pixelCoordinates[j * 2 + 1] - source.y) * source.rowBytes + (pixelCoordinates[j * 2] - source.x);
+            }
+
+            // Inserted from registers, a 16 byte load of taps just stored in pieces would stall on store forwarding
+            uint32x4_t tapWords = vdupq_n_u32(loadGreyscaleTaps(tops[0], source.rowBytes));
+            tapWords = vsetq_lane_u32(loadGreyscaleTaps(tops[1], source.rowBytes), tapWords, 1);
+            tapWords = vsetq_lane_u32(loadGreyscaleTaps(tops[2], source.rowBytes), tapWords, 2);
+            tapWords = vsetq_lane_u32(loadGreyscaleTaps(tops[3], source.rowBytes), tapWords, 3);
+            uint8x16_t tapBytes = vreinterpretq_u8_u32(tapWords);
+            int16x8_t taps01 = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(tapBytes)));
+            int16x8_t taps23 = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(tapBytes)));
+            int16x8_t weights01 = vcombine_s16(vld1_s16(weightTable + fractions[i] * 4), vld1_s16(weightTable + fractions[i + 1] * 4));
+            int16x8_t weights23 = vcombine_s16(vld1_s16(weightTable + fractions[i + 2] * 4), vld1_s16(weightTable + fractions[i + 3] * 4));
+
+            int32x4_t sums01 = vpaddq_s32(vmull_s16(vget_low_s16(taps01), vget_low_s16(weights01)), vmull_high_s16(taps01, weights01));
+            int32x4_t sums23 = vpaddq_s32(vmull_s16(vget_low_s16(taps23), vget_low_s16(weights23)), vmull_high_s16(taps23, weights23));
+            uint16x4_t values = vqmovun_s32(vrshrq_n_s32(vpaddq_s32(sums01, sums23), kRemapWeightBits));
+
+            vst1_lane_u32((uint32_t*)(destination + i), vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(values, values))), 0);
+        }
+
+        remapRowScalar<1>(coordinates + i * 2, fractions + i, source, width, height, destination + i, count - i, isInterior);
+    }
+
+    // Blends one pixel's 3 channels at a time: the channels of its left and right taps are paired up
+    static void remapRowNEONRGB(const int16_t* coordinates,
+        const uint16_t* fractions,
+        const RemapSource& source,
+        size_t width,
+        size_t height,
+        uint8_t* destination,
+        size_t count,
+        bool isInterior) {
+
+        const int16_t* weightTable = remapWeightTable.data();
+        const size_t maxX = width - 2;
+        const size_t maxY = height - 2;
+        const uint8x8_t pairIndices = {0, 3, 1, 4, 2, 5, 6, 7};
+
+        for (size_t i = 0; i < count; i++) {
+            int x = coordinates[i * 2];
+            int y = coordinates[i * 2 + 1];
+            const int16_t* weights = weightTable + fractions[i] * 4;
+
+            if (!isInterior && (unsigned(x) > maxX || unsigned(y) > maxY)) {
+                remapPixel<3>(x, y, weights, source, width, height, destination + i * 3);
+                continue;
+            }
+
+            const uint8_t* top = source.data + (y - source.y) * source.rowBytes + (x - source.x) * 3;
+            uint64_t topTaps = loadRGBTaps(top);
+            uint64_t bottomTaps = loadRGBTaps(top + source.rowBytes);
+
+            // (left, right) pairs of each channel, the last pair is zero
+            int16x8_t topPairs = vreinterpretq_s16_u16(vmovl_u8(vtbl1_u8(vcreate_u8(topTaps), pairIndices)));
+            int16x8_t bottomPairs = vreinterpretq_s16_u16(vmovl_u8(vtbl1_u8(vcreate_u8(bottomTaps), pairIndices)));
+
+            uint32_t topWeightPair, bottomWeightPair;
+            memcpy(&topWeightPair, weights, 4);
+            memcpy(&bottomWeightPair, weights + 2, 4);
+            int16x8_t topWeights = vreinterpretq_s16_u32(vdupq_n_u32(topWeightPair));
+            int16x8_t bottomWeights = vreinterpretq_s16_u32(vdupq_n_u32(bottomWeightPair));
+
+            int32x4_t topSums = vpaddq_s32(vmull_s16(vget_low_s16(topPairs), vget_low_s16(topWeights)), vmull_high_s16(topPairs, topWeights));
+            int32x4_t bottomSums = vpaddq_s32(vmull_s16(vget_low_s16(bottomPairs), vget_low_s16(bottomWeights)), vmull_high_s16(bottomPairs, bottomWeights));
+            uint16x4_t values = vqmovun_s32(vrshrq_n_s32(vaddq_s32(topSums, bottomSums), kRemapWeightBits));
+
+            uint32_t output = vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(values, values))), 0);
+            memcpy(destination + i * 3, &output, 3);
+        }
+    }
+#endif
+
+    template <int channels> static RemapRow detectRemapRow() {
+#if ZED_X86
+        if (__builtin_cpu_supports("sse4.1")) {
+            return channels == 1 ? remapRowSSE4Greyscale : remapRowSSE4RGB;
+        }
+#endif
+#if defined(__ARM_NEON)
+        return channels == 1 ? remapRowNEONGreyscale : remapRowNEONRGB;
+#endif
+        return remapRowScalar<channels>;
+    }
+
+    static RemapBounds remapBounds(const RemapMap& map, size_t width, size_t x0, size_t y0, size_t x1, size_t y1) {
+        RemapBounds bounds = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+
+        for (size_t row = y0; row < y1; row++) {
+            const int16_t* coordinates = map.coordinates + (row * width + x0) * 2;
+
+            for (size_t i = 0; i < (x1 - x0) * 2; i += 2) {
+                bounds.minX = min(bounds.minX, int(coordinates[i]));
+                bounds.maxX = max(bounds.maxX, int(coordinates[i]));
+                bounds.minY = min(bounds.minY, int(coordinates[i + 1]));
+                bounds.maxY = max(bounds.maxY, int(coordinates[i + 1]));
+            }
+        }
+
+        return bounds;
+    }
+
+    // Whether every pixel samples its 4 taps inside the `width` x `height` image
+    static bool isInterior(const RemapBounds& bounds, size_t width, size_t height) {
+        return bounds.minX >= 0 && bounds.minY >= 0 && bounds.maxX < int(width) - 1 && bounds.maxY < int(height) - 1;
+    }
+
+    // Remaps a tile of the rectified `width` x `height` eye, the destination starting at (`originX`, `originY`) of it.
+    // Interior tiles sample only inside the image
+    template <int channels>
+    static void remapTile(const RemapMap& map,
+        size_t width,
+        size_t height,
+        const RemapSource& source,
+        uint8_t* destination,
+        size_t destinationRowBytes,
+        size_t x0,
+        size_t y0,
+        size_t x1,
+        size_t y1,
+        bool isInterior,
+        size_t originX = 0,
+        size_t originY = 0) {
+
+        static const RemapRow remapRow = detectRemapRow<channels>();
+
+        for (size_t row = y0; row < y1; row++) {
+            remapRow(map.coordinates + (row * width + x0) * 2,
+                map.fractions + row * width + x0,
+                source,
+                width,
+                height,
+                destination + (row - originY) * destinationRowBytes + (x0 - originX) * channels,
+                x1 - x0,
+                isInterior);
+        }
+    }
+
+    // Converts the YUV 4:2:2 pixels a tile samples into a window of the destination color space, then remaps the tile
+    // from the window while it's still in cache, the destination starting at (`originX`, `originY`) of the rectified eye
+    static void remapYUVTile(RowConverter convertRow,
+        ColorSpace colorSpace,
+        const RemapMap& map,
+        size_t width,
+        size_t height,
+        const uint8_t* source,
+        size_t sourceRowBytes,
+        uint8_t* destination,
+        size_t destinationRowBytes,
+        size_t x0,
+        size_t y0,
+        size_t x1,
+        size_t y1,
+        const RemapBounds& bounds,
+        size_t originX = 0,
+        size_t originY = 0) {
+
+        thread_local vector<uint8_t> window;
+
+        size_t channels = colorSpace == GREYSCALE ? 1 : 3;
+
+        // Whole 4:2:2 pixel pairs holding every tap inside the image
+        int windowX0 = max(bounds.minX, 0) & ~1;
+        int windowX1 = min(bounds.maxX + 2, int(width));
+        int windowY0 = max(bounds.minY, 0);
+        int windowY1 = min(bounds.maxY + 2, int(height));
+        windowX1 += windowX1 & 1;
+
+        size_t windowRowBytes = 0;
+
+        if (windowX0 < windowX1 && windowY0 < windowY1) {
+            windowRowBytes = (windowX1 - windowX0) * channels;
+            window.resize(max(window.size(), windowRowBytes * (windowY1 - windowY0)));
+
+            for (int row = windowY0; row < windowY1; row++) {
+                convertRow(source + row * sourceRowBytes + windowX0 * 2, window.data() + (row - windowY0) * windowRowBytes, windowX1 - windowX0);
+            }
+        }
+
+        // Samples outside the image are black, which is 16 in the greyscale (luma) range
+        RemapSource windowSource = {window.data(), windowRowBytes, windowX0, windowY0, uint8_t(colorSpace == GREYSCALE ? kYUVLumaOffset : 0)};
+        bool isInteriorTile = isInterior(bounds, width, height);
+
+        if (channels == 1) {
+            remapTile<1>(map, width, height, windowSource, destination, destinationRowBytes, x0, y0, x1, y1, isInteriorTile, originX, originY);
+        }
+        else {
+            remapTile<3>(map, width, height, windowSource, destination, destinationRowBytes, x0, y0, x1, y1, isInteriorTile, originX, originY);
+        }
+    }
+
+#pragma mark - Public
+
+    StereoRectifier::StereoRectifier(CalibrationData& calibrationData, StereoDimensions stereoDimensions, size_t threadCount) {
+        this->stereoDimensions = stereoDimensions;
+        eyeWidth = stereoDimensions.width / 2;
+        eyeHeight = stereoDimensions.height;
+        threadPool = make_unique<ThreadPool>(threadCount);
+        instructionSet = ColorConverter::detectInstructionSet();
+        isCached = false;
+
+        path filepath = cacheFilepath(calibrationData, stereoDimensions);
+
+        if (!filepath.empty() && loadCache(filepath, calibrationData)) {
+            computeTileBounds();
+            return;
+        }
+
+        //
+        // Parse parameters
+        //
+        const StereoCalibration& calibration = calibrationData.getStereoCalibration(stereoDimensions);
+
+        Vector3 translation = {calibration.baseline, calibration.ty, calibration.tz};
+        Vector3 rotation = {calibration.rx, calibration.ry, calibration.rz};
+        CameraParameters cameras[2] = {loadCameraParameters(calibration.left), loadCameraParameters(calibration.right)};
+
+        //
+        // Rectifying rotations (Bouguet's method, as in OpenCV's stereoRectify)
+        //
+
+        // Rotate both cameras half way to the same orientation
+        Matrix3 halfRotation = rodrigues({rotation[0] * -0.5, rotation[1] * -0.5, rotation[2] * -0.5});
+        Vector3 t = multiply(halfRotation, translation);
+
+        // Then rotate around the optical axes so the baseline is horizontal
+        int baselineAxis = fabs(t[0]) > fabs(t[1]) ? 0 : 1;
+        Vector3 axis = {0, 0, 0};
+        axis[baselineAxis] = t[baselineAxis] > 0 ? 1 : -1;
+
+        Vector3 baselineRotation = cross(t, axis);
+        double baselineRotationNorm = norm(baselineRotation);
+
+        if (baselineRotationNorm > 0) {
+            double angle = acos(fabs(t[baselineAxis]) / norm(t)) / baselineRotationNorm;
+            baselineRotation = {baselineRotation[0] * angle, baselineRotation[1] * angle, baselineRotation[2] * angle};
+        }
+
+        Matrix3 baselineRotationMatrix = rodrigues(baselineRotation);
+
+        Matrix3 rectifyingRotations[2] = {multiply(baselineRotationMatrix, transpose(halfRotation)), multiply(baselineRotationMatrix, halfRotation)};
+        t = multiply(rectifyingRotations[1], translation);
+
+        //
+        // Rectified camera matrices
+        //
+        // The mean focal length across the baseline, as OpenCV's stereoRectify in 4.11 and 5.0 (some older releases took the
+        // smaller of the two, shortened for barrel distortion, which gives a smaller focal length before the alpha = 0 scaling)
+        double focalLength = baselineAxis == 0 ? (cameras[0].fy + cameras[1].fy) * 0.5 : (cameras[0].fx + cameras[1].fx) * 0.5;
+        double centers[2][2];
+
+        for (int k = 0; k < 2; k++) {
+            double sumX = 0;
+            double sumY = 0;
+
+            for (int corner = 0; corner < 4; corner++) {
+                double x, y;
+                undistort(cameras[k], (corner % 2) * double(eyeWidth - 1), (corner / 2) * double(eyeHeight - 1), x, y);
+
+                Vector3 point = multiply(rectifyingRotations[k], Vector3{x, y, 1});
+                sumX += focalLength * point[0] / point[2];
+                sumY += focalLength * point[1] / point[2];
+            }
+
+            centers[k][0] = (double(eyeWidth) - 1) / 2 - sumX / 4;
+            centers[k][1] = (double(eyeHeight) - 1) / 2 - sumY / 4;
+        }
+
+        // Zero disparity at infinity: both cameras share the same principal point
+        double centerX = (centers[0][0] + centers[1][0]) * 0.5;
+        double centerY = (centers[0][1] + centers[1][1]) * 0.5;
+
+        //
+        // Scale so only valid pixels are visible (alpha = 0)
+        //
+        double scale = 0;
+
+        for (int k = 0; k < 2; k++) {
+            Rectangle inner, outer;
+            findRectangles(cameras[k], rectifyingRotations[k], focalLength, centerX, centerY, eyeWidth, eyeHeight, inner, outer);
+
+            scale = max({scale,
+                centerX / (centerX - inner.x),
+                centerY / (centerY - inner.y),
+                (eyeWidth - 1 - centerX) / (inner.x + inner.width - centerX),
+                (eyeHeight - 1 - centerY) / (inner.y + inner.height - centerY)});
+        }
+
+        focalLength *= scale;
+
+        leftProjectionMatrix = {focalLength, 0, centerX, 0, 0, focalLength, centerY, 0, 0, 0, 1, 0};
+        rightProjectionMatrix = leftProjectionMatrix;
+        rightProjectionMatrix[baselineAxis * 4 + 3] = t[baselineAxis] * focalLength;
+
+        disparityToDepthMatrix = {1, 0, 0, -centerX, 0, 1, 0, -centerY, 0, 0, 0, focalLength, 0, 0, -1 / t[baselineAxis], 0};
+
+        //
+        // Remap tables
+        //
+        int16_t* coordinates[2];
+        uint16_t* fractions[2];
+        allocateMaps(filepath, coordinates, fractions);
+
+        computeRemapMap(cameras[0], rectifyingRotations[0], leftProjectionMatrix, eyeWidth, eyeHeight, *threadPool, coordinates[0], fractions[0]);
+        computeRemapMap(cameras[1], rectifyingRotations[1], rightProjectionMatrix, eyeWidth, eyeHeight, *threadPool, coordinates[1], fractions[1]);
+
+        if (cacheFile) {
+            storeCache(filepath, calibrationData);
+        }
+
+        computeTileBounds();
+    }
+
+    StereoRectifier::~StereoRectifier() = default;
+
+    void StereoRectifier::rectify(const uint8_t* source, uint8_t* destination, size_t channels) {
+        size_t rowBytes = stereoDimensions.width * channels;
+        size_t eyeOffset = eyeWidth * channels;
+
+        if (channels != 1 && channels != 3) {
+            throw runtime_error(format("Unsupported channel count for rectification: {}", channels));
+        }
+
+        forEachTile(2, LEFT, [&](Eye eye, size_t x0, size_t y0, size_t x1, size_t y1, const RemapBounds& bounds) {
+            const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+            size_t offset = eye == LEFT ? 0 : eyeOffset;
+
+            if (channels == 1) {
+                remapTile<1>(map, eyeWidth, eyeHeight, {source + offset, rowBytes, 0, 0, 0}, destination + offset, rowBytes, x0, y0, x1, y1, isInterior(bounds, eyeWidth, eyeHeight));
+            }
+            else {
+                remapTile<3>(map, eyeWidth, eyeHeight, {source + offset, rowBytes, 0, 0, 0}, destination + offset, rowBytes, x0, y0, x1, y1, isInterior(bounds, eyeWidth, eyeHeight));
+            }
+        });
+    }
+
+    void StereoRectifier::rectify(Eye eye, const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, size_t channels) {
+        if (channels != 1 && channels != 3) {
+            throw runtime_error(format("Unsupported channel count for rectification: {}", channels));
+        }
+
+        const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+
+        forEachTile(1, eye, [&](Eye, size_t x0, size_t y0, size_t x1, size_t y1, const RemapBounds& bounds) {
+            if (channels == 1) {
+                remapTile<1>(map, eyeWidth, eyeHeight, {source, sourceRowBytes, 0, 0, 0}, destination, destinationRowBytes, x0, y0, x1, y1, isInterior(bounds, eyeWidth, eyeHeight));
+            }
+            else {
+                remapTile<3>(map, eyeWidth, eyeHeight, {source, sourceRowBytes, 0, 0, 0}, destination, destinationRowBytes, x0, y0, x1, y1, isInterior(bounds, eyeWidth, eyeHeight));
+            }
+        });
+    }
+
+    void StereoRectifier::rectifyYUV(const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, ColorSpace colorSpace) {
+        if (colorSpace == YUV) {
+            throw runtime_error("Rectified output is unavailable in the YUV color space");
+        }
+
+        size_t channels = colorSpace == GREYSCALE ? 1 : 3;
+        RowConverter convertRow = rowConverterFor(instructionSet, colorSpace);
+
+        forEachTile(2, LEFT, [&](Eye eye, size_t x0, size_t y0, size_t x1, size_t y1, const RemapBounds& bounds) {
+            const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+            const uint8_t* eyeSource = eye == LEFT ? source : source + eyeWidth * 2;
+            uint8_t* eyeDestination = eye == LEFT ? destination : destination + eyeWidth * channels;
+
+            remapYUVTile(convertRow, colorSpace, map, eyeWidth, eyeHeight, eyeSource, sourceRowBytes, eyeDestination, destinationRowBytes, x0, y0, x1, y1, bounds);
+        });
+    }
+
+    void StereoRectifier::rectifyYUV(const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace) {
+        if (destination.getLayout() == SIDE_BY_SIDE && destination.getPyramidLevelCount() == 1) {
+            rectifyYUV(source, sourceRowBytes, destination.getData(), destination.getRowBytes(), colorSpace);
+            return;
+        }
+
+        EyeRegion eyeRegion = {0, 0, eyeWidth, eyeHeight};
+        rectifyYUVRegions(source, sourceRowBytes, {eyeRegion, eyeRegion}, destination, colorSpace, 2, LEFT, true);
+    }
+
+    void StereoRectifier::rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, uint8_t* destination, size_t destinationRowBytes, ColorSpace colorSpace) {
+        if (colorSpace == YUV) {
+            throw runtime_error("Rectified output is unavailable in the YUV color space");
+        }
+
+        const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+        const uint8_t* eyeSource = eye == LEFT ? source : source + eyeWidth * 2;
+        RowConverter convertRow = rowConverterFor(instructionSet, colorSpace);
+
+        forEachTile(1, eye, [&](Eye, size_t x0, size_t y0, size_t x1, size_t y1, const RemapBounds& bounds) {
+            remapYUVTile(convertRow, colorSpace, map, eyeWidth, eyeHeight, eyeSource, sourceRowBytes, destination, destinationRowBytes, x0, y0, x1, y1, bounds);
+        });
+    }
+
+    void StereoRectifier::rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, Frame& destination, ColorSpace colorSpace) {
+        EyeRegion eyeRegion = {0, 0, eyeWidth, eyeHeight};
+        rectifyYUVRegions(source, sourceRowBytes, {eyeRegion, eyeRegion}, destination, colorSpace, 1, eye, false);
+    }
+
+    void StereoRectifier::rectifyYUV(const uint8_t* source, size_t sourceRowBytes, const array<EyeRegion, 2>& regions, Frame& destination, ColorSpace colorSpace) {
+        rectifyYUVRegions(source, sourceRowBytes, regions, destination, colorSpace, 2, LEFT, true);
+    }
+
+    void StereoRectifier::rectifyYUV(Eye eye, const uint8_t* source, size_t sourceRowBytes, const array<EyeRegion, 2>& regions, Frame& destination, ColorSpace colorSpace) {
+        rectifyYUVRegions(source, sourceRowBytes, regions, destination, colorSpace, 1, eye, false);
+    }
+
+    array<double, 12> StereoRectifier::getLeftProjectionMatrix() {
+        return leftProjectionMatrix;
+    }
+
+    array<double, 12> StereoRectifier::getRightProjectionMatrix() {
+        return rightProjectionMatrix;
+    }
+
+    array<double, 16> StereoRectifier::getDisparityToDepthMatrix() {
+        return disparityToDepthMatrix;
+    }
+
+    StereoDimensions StereoRectifier::getStereoDimensions() {
+        return stereoDimensions;
+    }
+
+    const RemapMap& StereoRectifier::getRemapMap(Eye eye) {
+        return eye == LEFT ? leftMap : rightMap;
+    }
+
+    bool StereoRectifier::isLoadedFromCache() {
+        return isCached;
+    }
+
+    path StereoRectifier::cacheFilepath(const CalibrationData& calibrationData, StereoDimensions stereoDimensions) {
+        path calibrationFilepath = calibrationData.getFilepath();
+
+        if (calibrationFilepath.empty()) {
+            return path();
+        }
+
+        string resolutionString = resolutionToString(calibrationData.getStereoCalibration(stereoDimensions).resolution);
+        return calibrationFilepath.parent_path() / format("SN{}_{}.rectification", calibrationData.getSerialNumber(), resolutionString);
+    }
+
+    const int16_t* StereoRectifier::remapWeights(uint16_t fraction) {
+        return remapWeightTable.data() + fraction * 4;
+    }
+
+#pragma mark - Private
+
+    void StereoRectifier::computeTileBounds() {
+        size_t tileColumns = (eyeWidth + kRemapTileWidth - 1) / kRemapTileWidth;
+        size_t tileRows = (eyeHeight + kRemapTileHeight - 1) / kRemapTileHeight;
+
+        for (size_t eye = 0; eye < 2; eye++) {
+            const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+            tileBounds[eye].resize(tileColumns * tileRows);
+
+            for (size_t tile = 0; tile < tileColumns * tileRows; tile++) {
+                size_t x0 = (tile % tileColumns) * kRemapTileWidth;
+                size_t y0 = (tile / tileColumns) * kRemapTileHeight;
+
+                tileBounds[eye][tile] = remapBounds(map, eyeWidth, x0, y0, min(x0 + kRemapTileWidth, eyeWidth), min(y0 + kRemapTileHeight, eyeHeight));
+            }
+        }
+    }
+
+    void StereoRectifier::forEachTile(size_t eyeCount, Eye firstEye, const function<void(Eye, size_t, size_t, size_t, size_t, const RemapBounds&)>& tileTask) {
+        size_t tileColumns = (eyeWidth + kRemapTileWidth - 1) / kRemapTileWidth;
+        size_t tileRows = (eyeHeight + kRemapTileHeight - 1) / kRemapTileHeight;
+        size_t tilesPerEye = tileColumns * tileRows;
+
+        threadPool->parallelFor(tilesPerEye * eyeCount, [&](size_t index) {
+            Eye eye = Eye((firstEye + index / tilesPerEye) % 2);
+            size_t tile = index % tilesPerEye;
+            size_t x0 = (tile % tileColumns) * kRemapTileWidth;
+            size_t y0 = (tile / tileColumns) * kRemapTileHeight;
+
+            tileTask(eye, x0, y0, min(x0 + kRemapTileWidth, eyeWidth), min(y0 + kRemapTileHeight, eyeHeight), tileBounds[eye][tile]);
+        });
+    }
+
+    void StereoRectifier::rectifyYUVRegions(const uint8_t* source,
+        size_t sourceRowBytes,
+        const array<EyeRegion, 2>& regions,
+        Frame& destination,
+        ColorSpace colorSpace,
+        size_t eyeCount,
+        Eye firstEye,
+        bool isParallel) {
+
+        if (colorSpace == YUV) {
+            throw runtime_error("Rectified output is unavailable in the YUV color space");
+        }
+
+        FramePlane firstPlane = destination.getPlane(firstEye);
+
+        for (size_t index = 0; index < eyeCount; index++) {
+            const EyeRegion& region = regions[(firstEye + index) % 2];
+
+            if (region.width != firstPlane.width || region.height != firstPlane.height) {
+                throw runtime_error(format("Region {} doesn't match the destination's eyes ({} x {})", region.toString(), firstPlane.width, firstPlane.height));
+            }
+
+            if (region.x + region.width > eyeWidth || region.y + region.height > eyeHeight) {
+                throw runtime_error(format("Invalid region {} for {} x {} eyes", region.toString(), eyeWidth, eyeHeight));
+            }
+        }
+
+        size_t pyramidLevelCount = destination.getPyramidLevelCount();
+        FramePlane pyramids[2][kMaxPyramidLevelCount];
+
+        for (size_t eye = 0; eye < 2; eye++) {
+            for (size_t level = 0; level < pyramidLevelCount; level++) {
+                pyramids[eye][level] = destination.getPyramidLevel(level, Eye(eye));
+            }
+        }
+
+        // Tiles start at the region's origin, so they stay aligned to every pyramid level of a cropped frame
+        size_t tileColumns = (firstPlane.width + kRemapTileWidth - 1) / kRemapTileWidth;
+        size_t tileRows = (firstPlane.height + kRemapTileHeight - 1) / kRemapTileHeight;
+        size_t tilesPerEye = tileColumns * tileRows;
+        RowConverter convertRow = rowConverterFor(instructionSet, colorSpace);
+
+        // Each tile is downsampled by the thread that just remapped it
+        auto rectifyTile = [&](size_t index) {
+            Eye eye = Eye((firstEye + index / tilesPerEye) % 2);
+            size_t tile = index % tilesPerEye;
+            size_t x0 = (tile % tileColumns) * kRemapTileWidth;
+            size_t y0 = (tile / tileColumns) * kRemapTileHeight;
+            size_t x1 = min(x0 + kRemapTileWidth, firstPlane.width);
+            size_t y1 = min(y0 + kRemapTileHeight, firstPlane.height);
+
+            const EyeRegion& region = regions[eye];
+            const RemapMap& map = eye == LEFT ? leftMap : rightMap;
+            const uint8_t* eyeSource = eye == LEFT ? source : source + eyeWidth * 2;
+            const FramePlane& plane = pyramids[eye][0];
+
+            // Tiles of a whole eye line up with the map's, those of a cropped one have their bounds found as they're remapped
+            bool isWholeEye = region.width == eyeWidth && region.height == eyeHeight;
+            RemapBounds bounds = isWholeEye ? tileBounds[eye][tile] : remapBounds(map, eyeWidth, region.x + x0, region.y + y0, region.x + x1, region.y + y1);
+
+            remapYUVTile(convertRow,
+                colorSpace,
+                map,
+                eyeWidth,
+                eyeHeight,
+                eyeSource,
+                sourceRowBytes,
+                plane.data,
+                plane.rowBytes,
+                region.x + x0,
+                region.y + y0,
+                region.x + x1,
+                region.y + y1,
+                bounds,
+                region.x,
+                region.y);
+
+            if (pyramidLevelCount > 1) {
+                downsamplePyramidRegion(pyramids[eye], pyramidLevelCount, x0, y0, x1, y1);
+            }
+        };
+
+        if (isParallel) {
+            threadPool->parallelFor(tilesPerEye * eyeCount, rectifyTile);
+        }
+        else {
+            for (size_t index = 0; index < tilesPerEye * eyeCount; index++) {
+                rectifyTile(index);
+            }
+        }
+    }
+
+    static size_t alignCacheOffset(size_t offset) {
+        return (offset + kRectificationCacheAlignment - 1) / kRectificationCacheAlignment * kRectificationCacheAlignment;
+    }
+
+    // New caches are written under a per-process name and renamed into place, so readers never see a partial cache
+    static path temporaryCacheFilepath(const path& filepath) {
+        return path(filepath.string() + format(".{}.tmp", getpid()));
+    }
+
+    bool StereoRectifier::loadCache(const path& filepath, const CalibrationData& calibrationData) {
+        if (!exists(filepath)) {
+            return false;
+        }
+
+        shared_ptr<MemoryMappedFile> mappedFile;
+
+        try {
+            mappedFile = MemoryMappedFile::open(filepath);
+        }
+        catch (const runtime_error& error) {
+            cerr << "Ignoring rectification cache: " << error.what() << endl;
+            return false;
+        }
+
+        if (mappedFile->getSize() < sizeof(RectificationCacheHeader)) {
+            return false;
+        }
+
+        const RectificationCacheHeader* header = reinterpret_cast<const RectificationCacheHeader*>(mappedFile->getData());
+        string serialNumber = calibrationData.getSerialNumber();
+        size_t pixelCount = eyeWidth * eyeHeight;
+
+        bool isValid = memcmp(header->magic, kRectificationCacheMagic, sizeof(kRectificationCacheMagic)) == 0
+            && header->version == kRectificationCacheVersion
+            && header->remapFractionBits == kRemapFractionBits
+            && strncmp(header->serialNumber, serialNumber.c_str(), sizeof(header->serialNumber)) == 0
+            && header->calibrationHash == calibrationData.getHash()
+            && header->width == stereoDimensions.width
+            && header->height == stereoDimensions.height
+            && header->fileSize == mappedFile->getSize();
+
+        for (int eye = 0; isValid && eye < 2; eye++) {
+            isValid = header->coordinatesOffsets[eye] % kRectificationCacheAlignment == 0
+                && header->fractionsOffsets[eye] % kRectificationCacheAlignment == 0
+                && header->coordinatesOffsets[eye] + pixelCount * 2 * sizeof(int16_t) <= header->fileSize
+                && header->fractionsOffsets[eye] + pixelCount * sizeof(uint16_t) <= header->fileSize;
+        }
+
+        if (!isValid) {
+            return false;
+        }
+
+        copy(begin(header->leftProjectionMatrix), end(header->leftProjectionMatrix), leftProjectionMatrix.begin());
+        copy(begin(header->rightProjectionMatrix), end(header->rightProjectionMatrix), rightProjectionMatrix.begin());
+        copy(begin(header->disparityToDepthMatrix), end(header->disparityToDepthMatrix), disparityToDepthMatrix.begin());
+
+        const uint8_t* data = mappedFile->getData();
+        leftMap = {reinterpret_cast<const int16_t*>(data + header->coordinatesOffsets[LEFT]), reinterpret_cast<const uint16_t*>(data + header->fractionsOffsets[LEFT])};
+        rightMap = {reinterpret_cast<const int16_t*>(data + header->coordinatesOffsets[RIGHT]), reinterpret_cast<const uint16_t*>(data + header->fractionsOffsets[RIGHT])};
+
+        cacheFile = std::move(mappedFile);
+        isCached = true;
+
+        return true;
+    }
+
+    void StereoRectifier::allocateMaps(const path& filepath, int16_t* coordinates[2], uint16_t* fractions[2]) {
+        size_t pixelCount = eyeWidth * eyeHeight;
+
+        if (!filepath.empty()) {
+            size_t offset = alignCacheOffset(sizeof(RectificationCacheHeader));
+            size_t coordinatesOffsets[2];
+            size_t fractionsOffsets[2];
+
+            for (int eye = 0; eye < 2; eye++) {
+                coordinatesOffsets[eye] = offset;
+                offset = alignCacheOffset(offset + pixelCount * 2 * sizeof(int16_t));
+                fractionsOffsets[eye] = offset;
+                offset = alignCacheOffset(offset + pixelCount * sizeof(uint16_t));
+            }
+
+            try {
+                cacheFile = MemoryMappedFile::create(temporaryCacheFilepath(filepath), offset);
+
+                uint8_t* data = cacheFile->getData();
+                RectificationCacheHeader* header = reinterpret_cast<RectificationCacheHeader*>(data);
+                memset(header, 0, sizeof(RectificationCacheHeader));
+                header->fileSize = offset;
+
+                for (int eye = 0; eye < 2; eye++) {
+                    header->coordinatesOffsets[eye] = coordinatesOffsets[eye];
+                    header->fractionsOffsets[eye] = fractionsOffsets[eye];
+                    coordinates[eye] = reinterpret_cast<int16_t*>(data + coordinatesOffsets[eye]);
+                    fractions[eye] = reinterpret_cast<uint16_t*>(data + fractionsOffsets[eye]);
+                }
+            }
+            catch (const runtime_error& error) {
+                cerr << "Unable to create rectification cache: " << error.what() << endl;
+                cacheFile.reset();
+            }
+        }
+
+        if (!cacheFile) {
+            coordinateStorage.resize(pixelCount * 2 * 2);
+            fractionStorage.resize(pixelCount * 2);
+
+            for (int eye = 0; eye < 2; eye++) {
+                coordinates[eye] = coordinateStorage.data() + eye * pixelCount * 2;
+                fractions[eye] = fractionStorage.data() + eye * pixelCount;
+            }
+        }
+
+        leftMap = {coordinates[LEFT], fractions[LEFT]};
+        rightMap = {coordinates[RIGHT], fractions[RIGHT]};
+    }
+
+    void StereoRectifier::storeCache(const path& filepath, const CalibrationData& calibrationData) {
+        RectificationCacheHeader* header = reinterpret_cast<RectificationCacheHeader*>(cacheFile->getData());
+        header->version = kRectificationCacheVersion;
+        header->remapFractionBits = kRemapFractionBits;
+        strncpy(header->serialNumber, calibrationData.getSerialNumber().c_str(), sizeof(header->serialNumber) - 1);
+        header->calibrationHash = calibrationData.getHash();
+        header->width = stereoDimensions.width;
+        header->height = stereoDimensions.height;
+
+        copy(leftProjectionMatrix.begin(), leftProjectionMatrix.end(), header->leftProjectionMatrix);
+        copy(rightProjectionMatrix.begin(), rightProjectionMatrix.end(), header->rightProjectionMatrix);
+        copy(disparityToDepthMatrix.begin(), disparityToDepthMatrix.end(), header->disparityToDepthMatrix);
+
+        // The magic marks the header complete
+        memcpy(header->magic, kRectificationCacheMagic, sizeof(kRectificationCacheMagic));
+        cacheFile->flush(0, cacheFile->getSize(), false);
+
+        error_code error;
+        rename(temporaryCacheFilepath(filepath), filepath, error);
+
+        if (error) {
+            cerr << "Unable to store rectification cache: " << filepath.string() << " (" << error.message() << ")" << endl;
+            remove(temporaryCacheFilepath(filepath), error);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+//
+// zed_synthetic_frame_source.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_synthetic_frame_source.h"
+#include <cstring>
+
+using namespace std;
+
+//
+// Pattern Parameters
+//
+#define kRampPeriod 256         // Pixels per ramp cycle
+#define kRampSpeed 4            // Pixels the ramp scrolls per frame
+#define kSquareSpeed 6          // Pixels the square moves per frame
+#define kSquareSizeDivisor 8    // Square side as a fraction of the eye height
+#define kDisparityDivisor 32    // Right-eye shift as a fraction of the eye width
+#define kSquareLuma 235
+
+namespace zed {
+
+#pragma mark - Public
+
+    SyntheticFrameSource::SyntheticFrameSource(PlaybackSpeed playbackSpeed, const string& serialNumber) : PacedFrameSource(playbackSpeed) {
+        this->serialNumber = serialNumber;
+        eyeWidth = 0;
+        disparity = 0;
+    }
+
+    SyntheticFrameSource::~SyntheticFrameSource() {
+        stop();
+    }
+
+    string SyntheticFrameSource::getDeviceID() {
+        return "synthetic";
+    }
+
+    string SyntheticFrameSource::getDeviceName() {
+        return "Synthetic Frame Source";
+    }
+
+    string SyntheticFrameSource::getDeviceSerialNumber() {
+        return serialNumber;
+    }
+
+#pragma mark - Protected
+
+    void SyntheticFrameSource::prepare() {
+        eyeWidth = stereoDimensions.width / 2;
+        disparity = (eyeWidth / kDisparityDivisor) & ~size_t(1);
+
+        // Luma ramps across x, chroma ramps in opposite directions so color conversion has something to do
+        size_t rampPixels = eyeWidth + kRampPeriod;
+        size_t channels = rawColorSpace == YUV ? 2 : 1;
+        rampRow.resize(rampPixels * channels);
+
+        for (size_t x = 0; x < rampPixels; x++) {
+            uint8_t luma = uint8_t(16 + (x % kRampPeriod) * 219 / kRampPeriod);
+
+            if (channels == 1) {
+                rampRow[x] = luma;
+            }
+            else {
+                rampRow[x * 2] = luma;
+                rampRow[x * 2 + 1] = uint8_t(x % 2 == 0 ? 16 + (x % kRampPeriod) * 224 / kRampPeriod : 240 - (x % kRampPeriod) * 224 / kRampPeriod);
+            }
+        }
+    }
+
+    bool SyntheticFrameSource::produceFrame(uint8_t* data, size_t rowBytes, uint64_t frameIndex) {
+        size_t height = stereoDimensions.height;
+        size_t channels = rawColorSpace == YUV ? 2 : 1;
+        size_t eyeRowBytes = eyeWidth * channels;
+
+        size_t squareSize = height / kSquareSizeDivisor;
+        size_t squareTravelX = eyeWidth - squareSize - disparity;
+        size_t squareTravelY = height - squareSize;
+        size_t squareX = disparity + (frameIndex * kSquareSpeed) % squareTravelX;
+        size_t squareY = (frameIndex * kSquareSpeed / 2) % squareTravelY;
+
+        for (size_t y = 0; y < height; y++) {
+            uint8_t* row = data + y * rowBytes;
+
+            for (size_t eye = 0; eye < 2; eye++) {
+                // The right eye sees the scene shifted left, i.e. positive disparity everywhere
+                size_t shift = eye == 0 ? 0 : disparity;
+                size_t phase = ((y + frameIndex * kRampSpeed + shift) % kRampPeriod) & ~size_t(1);
+                uint8_t* eyeRow = row + eye * eyeRowBytes;
+
+                memcpy(eyeRow, rampRow.data() + phase * channels, eyeRowBytes);
+
+                if (y >= squareY && y < squareY + squareSize) {
+                    size_t x0 = squareX - shift;
+
+                    for (size_t x = x0; x < x0 + squareSize; x++) {
+                        eyeRow[x * channels] = kSquareLuma;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,178 @@
+//
+// zed_thread_pool.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "../include/zed_thread_pool.h"
+#include <pthread.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#else
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace zed {
+
+#pragma mark - Public
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = max(thread::hardware_concurrency(), 1u);
+        }
+
+        currentTask = nullptr;
+        taskCount = 0;
+        nextTaskIndex = 0;
+        completedTaskCount = 0;
+        generation = 0;
+        isStopping = false;
+        taskException = nullptr;
+
+        // The calling thread takes part in every job, so it counts as one of the threads
+        for (size_t i = 1; i < threadCount; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            isStopping = true;
+        }
+
+        workCondition.notify_all();
+
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::getThreadCount() {
+        return workers.size() + 1;
+    }
+
+    void ThreadPool::parallelFor(size_t count, const function<void(size_t)>& task) {
+        if (workers.empty() || count < 2) {
+            for (size_t i = 0; i < count; i++) {
+                task(i);
+            }
+
+            return;
+        }
+
+        lock_guard<mutex> jobLock(jobMutex);
+        unique_lock<mutex> lock(stateMutex);
+
+        currentTask = &task;
+        taskCount = count;
+        nextTaskIndex = 0;
+        completedTaskCount = 0;
+        generation++;
+
+        workCondition.notify_all();
+
+        runTasks(lock);
+        doneCondition.wait(lock, [this] { return completedTaskCount == taskCount; });
+
+        currentTask = nullptr;
+
+        // Every thread is done with the task, so the first failure can be reported
+        if (taskException) {
+            exception_ptr exception = taskException;
+            taskException = nullptr;
+            rethrow_exception(exception);
+        }
+    }
+
+#pragma mark - Private
+
+    void ThreadPool::runTasks(unique_lock<mutex>& lock) {
+        while (nextTaskIndex < taskCount) {
+            size_t index = nextTaskIndex++;
+            const function<void(size_t)>* task = currentTask;
+
+            exception_ptr exception;
+
+            lock.unlock();
+
+            try {
+                (*task)(index);
+            }
+            catch (...) {
+                exception = current_exception();
+            }
+
+            lock.lock();
+
+            // The job has failed, tasks not started yet are skipped
+            if (exception) {
+                if (!taskException) {
+                    taskException = exception;
+                }
+
+                completedTaskCount += taskCount - nextTaskIndex;
+                nextTaskIndex = taskCount;
+            }
+
+            if (++completedTaskCount == taskCount) {
+                doneCondition.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::workerLoop() {
+        unique_lock<mutex> lock(stateMutex);
+        uint64_t seenGeneration = 0;
+
+        while (true) {
+            workCondition.wait(lock, [this, &seenGeneration] { return isStopping || generation != seenGeneration; });
+
+            if (isStopping) {
+                return;
+            }
+
+            seenGeneration = generation;
+            runTasks(lock);
+        }
+    }
+
+#pragma mark - Threads
+
+    bool setCurrentThreadAffinity(size_t cpuIndex) {
+#ifdef __APPLE__
+        // Threads sharing a tag are kept on cores sharing a cache, distinct tags are spread apart (0 means no tag)
+        thread_affinity_policy_data_t policy = {integer_t(cpuIndex + 1)};
+        kern_return_t result = thread_policy_set(
+            pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY, (thread_policy_t)&policy, THREAD_AFFINITY_POLICY_COUNT);
+
+        return result == KERN_SUCCESS;
+#else
+        if (cpuIndex >= CPU_SETSIZE) {
+            return false;
+        }
+
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpuIndex, &cpuSet);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#endif
+    }
+
+    bool setCurrentThreadHighPriority() {
+#ifdef __APPLE__
+        return pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0) == 0;
+#else
+        sched_param parameters = {};
+        parameters.sched_priority = sched_get_priority_min(SCHED_FIFO);
+
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+#endif
+    }
+}
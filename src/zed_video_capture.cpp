@@ -0,0 +1,1461 @@
+//
+// zed_video_capture.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 01/11/2025
+//
+
+#include "../include/zed_video_capture.h"
+#include "../include/zed_capture_stats.h"
+#include "../include/zed_color_conversion.h"
+#include "../include/zed_recording.h"
+#include "../include/zed_stereo_rectifier.h"
+#include "../include/zed_thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __APPLE__
+#include "../include/zed_camera_frame_source.h"
+#include <dispatch/dispatch.h>
+#endif
+
+using namespace std;
+using namespace zed;
+
+//
+// Parameters
+//
+#define kFramePoolCapacity 8
+#define kColorSpaceCount 4
+#define kSubscriberWaitMilliseconds 100
+#define kMaxPoolFramesInFlight (kFramePoolCapacity / 2)
+
+namespace zed {
+
+    // Live counters and histograms behind `getStats()`, shared with deliveries still pending on the main queue
+    struct CaptureCounters {
+        atomic<uint64_t> capturedFrameCount;
+        atomic<uint64_t> deliveredFrameCount;
+        atomic<uint64_t> poolDroppedFrameCount;
+        atomic<uint64_t> queueDroppedFrameCount;
+        atomic<uint64_t> blockedFrameCount;
+
+        LatencyHistogram sourceLatency;
+        LatencyHistogram conversionTime;
+        LatencyHistogram queueWait;
+        LatencyHistogram callbackDuration;
+        LatencyHistogram totalLatency;
+
+        CaptureCounters() {
+            reset();
+        }
+
+        void reset() {
+            capturedFrameCount.store(0, memory_order_relaxed);
+            deliveredFrameCount.store(0, memory_order_relaxed);
+            poolDroppedFrameCount.store(0, memory_order_relaxed);
+            queueDroppedFrameCount.store(0, memory_order_relaxed);
+            blockedFrameCount.store(0, memory_order_relaxed);
+
+            sourceLatency.reset();
+            conversionTime.reset();
+            queueWait.reset();
+            callbackDuration.reset();
+            totalLatency.reset();
+        }
+
+        // Stamps a frame as delivered (unless another subscriber got it first) and records its latencies
+        uint64_t recordDelivery(Frame& frame) {
+            uint64_t deliveryTimestamp = steadyClockTimestamp();
+
+            if (frame.getProcessedTimestamp() != 0 && frame.getProcessedTimestamp() <= deliveryTimestamp) {
+                queueWait.record(deliveryTimestamp - frame.getProcessedTimestamp());
+            }
+
+            if (frame.getTimestamp() != 0 && frame.getTimestamp() <= deliveryTimestamp) {
+                totalLatency.record(deliveryTimestamp - frame.getTimestamp());
+            }
+
+            if (frame.getDeliveryTimestamp() == 0) {
+                frame.setDeliveryTimestamp(deliveryTimestamp);
+            }
+
+            deliveredFrameCount.fetch_add(1, memory_order_relaxed);
+
+            return deliveryTimestamp;
+        }
+    };
+
+    // Region of interest of the capture's own frames, with buffers sized for it (replaced as a whole when it changes)
+    struct RegionOutput {
+        array<EyeRegion, 2> regions;
+        shared_ptr<FramePool> framePool;
+    };
+
+    // Frame waiting for a pool thread, converted by the thread that takes it unless a subscriber already needed it
+    struct PendingFrame {
+        Frame frame;
+        bool isConverted;
+        shared_ptr<const RegionOutput> regionOutput;
+    };
+
+    // Callback state for one `start()`, pending deliveries from an earlier `start()` see it deactivated and skip
+    struct FrameDelivery {
+        function<void(Frame)> frameProcessor;
+        DeliveryOptions deliveryOptions;
+        atomic<bool> isActive;
+        atomic<bool> isStopping;
+
+        // Frames waiting for the main queue (with at most one drain scheduled at a time) or the dedicated thread
+        shared_ptr<FrameQueue> frameQueue;
+        atomic<bool> isDrainScheduled;
+
+        // The dedicated thread, or the pool's threads
+        vector<thread> workerThreads;
+
+        //
+        // THREAD_POOL: frames wait in `pendingFrames` under the backpressure policy. The thread that takes one numbers it
+        // in capture order and converts it, then leaves it in `completedFrames` until every earlier frame is delivered,
+        // whichever thread completes the next frame in line delivers it and the later ones that are ready. At most
+        // `maxFramesInFlight` frames are taken and not yet delivered, so converted frames can't pile up behind a slow callback
+        //
+        mutex poolMutex;
+        condition_variable workCondition;
+        condition_variable spaceCondition;
+        deque<PendingFrame> pendingFrames;
+        size_t queueCapacity;
+        BackpressurePolicy backpressurePolicy;
+        size_t maxFramesInFlight;
+        uint64_t nextSequenceNumber;
+        uint64_t nextDeliverySequenceNumber;
+        map<uint64_t, Frame> completedFrames;
+        bool isDelivering;
+    };
+
+    // Consumer added with `subscribe()`, fed through its own queue and called on its own thread
+    struct Subscriber {
+        size_t subscriptionID;
+        ColorSpace colorSpace;
+        function<void(Frame)> frameProcessor;
+        shared_ptr<FrameQueue> frameQueue;
+        atomic<uint64_t> droppedFrameCount;
+        atomic<bool> isActive;
+        thread workerThread;
+    };
+
+    // One raw frame in every color space asked for so far, each converted on first use
+    struct FrameOutputs {
+        Frame rawFrame;
+        uint64_t receivedTimestamp;
+        Frame frames[kColorSpaceCount];
+        bool isAttempted[kColorSpaceCount];
+    };
+
+    struct VideoCaptureImpl {
+        shared_ptr<FrameSource> frameSource;
+
+        StereoDimensions stereoDimensions;
+        FrameRate frameRate;
+        ColorSpace rawColorSpace;
+        ColorSpace colorSpace;
+        atomic<Rectification> rectification; // RECTIFIED once a rectifier is published (possibly by the calibration thread)
+        FrameLayout frameLayout;
+        size_t pyramidLevelCount;
+        size_t conversionThreadCount;
+
+        // Created at `open()` and kept until `close()`, even for rectified output (for YUV subscribers and cropped frames
+        // before a calibration loads), so it's never replaced while the source thread may be using it
+        unique_ptr<ColorConverter> colorConverter;
+        shared_ptr<StereoRectifier> stereoRectifier;
+
+        // The rectifier the source thread uses, published once `stereoRectifier` is set (possibly by the calibration thread)
+        atomic<StereoRectifier*> activeStereoRectifier;
+
+        // Loads the calibration in the background (see `loadCalibrationAsync()`)
+        string calibrationDownloadURL;
+        thread calibrationThread;
+        atomic<bool> isLoadingCalibration;
+
+        // Output buffers indexed by ColorSpace, for the capture's color space and each subscriber's
+        shared_ptr<FramePool> framePools[kColorSpaceCount];
+
+        // The source thread takes a reference to the region for each frame, so it can change between frames
+        mutex regionMutex;
+        shared_ptr<const RegionOutput> regionOutput;
+
+        shared_ptr<FrameDelivery> frameDelivery;
+        shared_ptr<FrameQueue> frameQueue;
+        Frame grabbedFrame;
+
+        shared_ptr<CaptureCounters> counters;
+
+        // The source thread takes a reference to the list for each frame, so it's replaced rather than modified
+        mutex subscriberMutex;
+        shared_ptr<const vector<shared_ptr<Subscriber>>> subscribers;
+        size_t nextSubscriptionID;
+
+        // The source thread only uses the writer between incrementing and decrementing `recordingUseCount`
+        unique_ptr<RecordingWriter> recordingWriter;
+        atomic<RecordingWriter*> activeRecordingWriter;
+        atomic<int> recordingUseCount;
+
+        bool isOpen;
+        bool isRunning;
+
+        VideoCaptureImpl(shared_ptr<FrameSource> frameSource) {
+            this->frameSource = frameSource;
+            counters = make_shared<CaptureCounters>();
+            subscribers = make_shared<const vector<shared_ptr<Subscriber>>>();
+            nextSubscriptionID = 1;
+            frameRate = FPS_15;
+            rawColorSpace = YUV;
+            colorSpace = YUV;
+            rectification = RAW;
+            frameLayout = SIDE_BY_SIDE;
+            pyramidLevelCount = 1;
+            conversionThreadCount = 0;
+            activeStereoRectifier = nullptr;
+            calibrationDownloadURL = kCalibrationDownloadURL;
+            isLoadingCalibration = false;
+            activeRecordingWriter = nullptr;
+            recordingUseCount = 0;
+            isOpen = false;
+            isRunning = false;
+        };
+
+        // Converts or rectifies a raw frame from the source (on the source's thread), then queues or delivers it to everyone
+        void processRawFrame(Frame rawFrame) {
+            recordingUseCount.fetch_add(1, memory_order_seq_cst);
+
+            if (RecordingWriter* writer = activeRecordingWriter.load(memory_order_seq_cst)) {
+                writer->record(rawFrame);
+            }
+
+            recordingUseCount.fetch_sub(1, memory_order_release);
+
+            uint64_t receivedTimestamp = steadyClockTimestamp();
+            counters->capturedFrameCount.fetch_add(1, memory_order_relaxed);
+
+            if (rawFrame.getTimestamp() != 0 && rawFrame.getTimestamp() <= receivedTimestamp) {
+                counters->sourceLatency.record(receivedTimestamp - rawFrame.getTimestamp());
+            }
+
+            shared_ptr<const vector<shared_ptr<Subscriber>>> currentSubscribers;
+            {
+                lock_guard<mutex> lock(subscriberMutex);
+                currentSubscribers = subscribers;
+            }
+
+            // Each color space is converted at most once, only if someone takes the frame, and shared read-only by everyone who asked for it
+            FrameOutputs frameOutputs;
+            frameOutputs.rawFrame = std::move(rawFrame);
+            frameOutputs.receivedTimestamp = receivedTimestamp;
+            fill(begin(frameOutputs.isAttempted), end(frameOutputs.isAttempted), false);
+
+            // Subscribers first, so their threads get going while the capture's own callback may run inline
+            for (const shared_ptr<Subscriber>& subscriber : *currentSubscribers) {
+                if (!isAccepting(subscriber->frameQueue.get())) {
+                    subscriber->droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                    counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                    continue;
+                }
+
+                Frame frame = getOutputFrame(frameOutputs, subscriber->colorSpace);
+
+                if (frame.isValid() && !subscriber->frameQueue->push(std::move(frame))) {
+                    subscriber->droppedFrameCount.fetch_add(1, memory_order_relaxed);
+                    counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                }
+            }
+
+            if (!frameQueue && !frameDelivery) {
+                return;
+            }
+
+            shared_ptr<const RegionOutput> currentRegionOutput;
+            {
+                lock_guard<mutex> lock(regionMutex);
+                currentRegionOutput = regionOutput;
+            }
+
+            // Pool threads convert frames themselves, so the source thread is free for the next one
+            if (frameDelivery && frameDelivery->deliveryOptions.deliveryMode == THREAD_POOL) {
+                bool isConverted = !currentRegionOutput && (frameOutputs.isAttempted[colorSpace] || isNativeOutput(colorSpace));
+                Frame frame = isConverted ? getOutputFrame(frameOutputs, colorSpace) : frameOutputs.rawFrame;
+
+                if (frame.isValid()) {
+                    submitToPool(*frameDelivery, PendingFrame {std::move(frame), isConverted, std::move(currentRegionOutput)});
+                }
+
+                return;
+            }
+
+            if (!isAccepting(frameQueue ? frameQueue.get() : frameDelivery->frameQueue.get())) {
+                counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+
+            // Cropped frames are the capture's own, they aren't shared with subscribers
+            Frame frame = currentRegionOutput ? convertFrame(frameOutputs.rawFrame, colorSpace, currentRegionOutput.get()) : getOutputFrame(frameOutputs, colorSpace);
+
+            if (!frame.isValid()) {
+                return;
+            }
+
+            if (frameQueue) {
+                if (!frameQueue->push(std::move(frame))) {
+                    counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                }
+            }
+            else {
+                deliver(frameDelivery, counters, std::move(frame));
+            }
+        }
+
+        // Whether frames in `outputColorSpace` are the source's frames as they are, without conversion
+        bool isNativeOutput(ColorSpace outputColorSpace) {
+            return outputColorSpace == rawColorSpace && frameLayout == SIDE_BY_SIDE;
+        }
+
+        // Creates the buffers for output in `outputColorSpace`, before the source thread can ask for it
+        void prepareOutput(ColorSpace outputColorSpace) {
+            if (isNativeOutput(outputColorSpace)) {
+                return;
+            }
+
+            if (!framePools[outputColorSpace]) {
+                framePools[outputColorSpace] = FramePool::create(
+                    kFramePoolCapacity, stereoDimensions.height, stereoDimensions.width, channelCount(outputColorSpace), frameLayout, pyramidLevelCount);
+            }
+        }
+
+        static size_t channelCount(ColorSpace colorSpace) {
+            return colorSpace == YUV ? 2 : (colorSpace == GREYSCALE ? 1 : 3);
+        }
+
+        // Whether a queue has room for another frame, a frame it would reject is dropped before spending time on converting it
+        bool isAccepting(FrameQueue* pendingQueue) {
+            if (!pendingQueue || pendingQueue->getCount() < pendingQueue->getCapacity()) {
+                return true;
+            }
+
+            BackpressurePolicy backpressurePolicy = pendingQueue->getBackpressurePolicy();
+
+            if (backpressurePolicy == DROP_NEWEST) {
+                return false;
+            }
+            else if (backpressurePolicy == BLOCK_PRODUCER) {
+                counters->blockedFrameCount.fetch_add(1, memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        // Returns the frame in `outputColorSpace`, converting or rectifying it the first time it's asked for
+        Frame getOutputFrame(FrameOutputs& frameOutputs, ColorSpace outputColorSpace) {
+            if (frameOutputs.isAttempted[outputColorSpace]) {
+                return frameOutputs.frames[outputColorSpace];
+            }
+
+            frameOutputs.isAttempted[outputColorSpace] = true;
+
+            // Native frames are shared as they are (unrectified, for YUV subscribers)
+            if (isNativeOutput(outputColorSpace)) {
+                frameOutputs.rawFrame.setProcessedTimestamp(frameOutputs.receivedTimestamp);
+                frameOutputs.frames[outputColorSpace] = frameOutputs.rawFrame;
+
+                return frameOutputs.rawFrame;
+            }
+
+            Frame frame = convertFrame(frameOutputs.rawFrame, outputColorSpace);
+            frameOutputs.frames[outputColorSpace] = frame;
+
+            return frame;
+        }
+
+        // Converts or rectifies a raw frame (only the region of interest, if given) into a buffer from the output pool
+        // (invalid if they're all in use), from any thread
+        //
+        // Pool threads pass their own single-threaded converter and rectify eye by eye on their own thread, so they don't
+        // take turns on the shared converter's and rectifier's thread pools
+        Frame convertFrame(const Frame& rawFrame, ColorSpace outputColorSpace, const RegionOutput* regionOutput = nullptr, ColorConverter* threadColorConverter = nullptr) {
+            Frame frame = regionOutput ? regionOutput->framePool->acquire() : framePools[outputColorSpace]->acquire();
+
+            if (!frame.isValid()) {
+                counters->poolDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                cerr << "Warning: dropped frame (all " << kFramePoolCapacity << " " << colorSpaceToString(outputColorSpace) << " frame buffers in use)" << endl;
+                return frame;
+            }
+
+            uint64_t conversionTimestamp = steadyClockTimestamp();
+            StereoRectifier* rectifier = activeStereoRectifier.load(memory_order_acquire);
+            ColorConverter* converter = threadColorConverter ? threadColorConverter : colorConverter.get();
+
+            // Separate eye planes are written directly by the conversion pass
+            if (regionOutput) {
+                if (rectifier && outputColorSpace != YUV) {
+                    if (threadColorConverter) {
+                        rectifier->rectifyYUV(LEFT, rawFrame.getData(), rawFrame.getRowBytes(), regionOutput->regions, frame, outputColorSpace);
+                        rectifier->rectifyYUV(RIGHT, rawFrame.getData(), rawFrame.getRowBytes(), regionOutput->regions, frame, outputColorSpace);
+                    }
+                    else {
+                        rectifier->rectifyYUV(rawFrame.getData(), rawFrame.getRowBytes(), regionOutput->regions, frame, outputColorSpace);
+                    }
+
+                    frame.setRectification(RECTIFIED);
+                }
+                else {
+                    converter->convert(rawFrame.getData(), rawFrame.getRowBytes(), stereoDimensions.width / 2, regionOutput->regions, frame, outputColorSpace);
+                }
+
+                frame.setRegion(LEFT, regionOutput->regions[LEFT]);
+                frame.setRegion(RIGHT, regionOutput->regions[RIGHT]);
+            }
+            else if (rectifier && outputColorSpace != YUV) {
+                if (threadColorConverter) {
+                    rectifier->rectifyYUV(LEFT, rawFrame.getData(), rawFrame.getRowBytes(), frame, outputColorSpace);
+                    rectifier->rectifyYUV(RIGHT, rawFrame.getData(), rawFrame.getRowBytes(), frame, outputColorSpace);
+                }
+                else {
+                    rectifier->rectifyYUV(rawFrame.getData(), rawFrame.getRowBytes(), frame, outputColorSpace);
+                }
+
+                frame.setRectification(RECTIFIED);
+            }
+            else {
+                converter->convert(rawFrame.getData(), rawFrame.getRowBytes(), frame, outputColorSpace);
+            }
+
+            // Holds the time processing finished until the frame is delivered (see `CaptureCounters::recordDelivery()`)
+            uint64_t processedTimestamp = steadyClockTimestamp();
+            counters->conversionTime.record(processedTimestamp - conversionTimestamp);
+
+            frame.setTimestamp(rawFrame.getTimestamp());
+            frame.setSequenceNumber(rawFrame.getSequenceNumber());
+            frame.setProcessedTimestamp(processedTimestamp);
+
+            return frame;
+        }
+
+        static void deliver(shared_ptr<FrameDelivery> frameDelivery, shared_ptr<CaptureCounters> counters, Frame frame) {
+            DeliveryMode deliveryMode = frameDelivery->deliveryOptions.deliveryMode;
+
+            if (deliveryMode == INLINE) {
+                if (frameDelivery->isActive.load(memory_order_acquire)) {
+                    invokeFrameProcessor(*frameDelivery, *counters, frame);
+                }
+
+                return;
+            }
+
+            // Frames wait in the delivery queue under its backpressure policy, for the dedicated thread or the main queue (e.g. for UI work)
+            if (!frameDelivery->frameQueue->push(std::move(frame))) {
+                counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+            }
+
+#ifdef __APPLE__
+            if (deliveryMode == MAIN_QUEUE) {
+                scheduleDrain(frameDelivery, counters);
+            }
+#endif
+        }
+
+        // Hands a frame to the pool's threads under the backpressure policy (on the source thread)
+        void submitToPool(FrameDelivery& frameDelivery, PendingFrame pendingFrame) {
+            unique_lock<mutex> lock(frameDelivery.poolMutex);
+
+            if (frameDelivery.isStopping.load(memory_order_relaxed)) {
+                return;
+            }
+
+            deque<PendingFrame>& pendingFrames = frameDelivery.pendingFrames;
+            bool isFull = frameDelivery.backpressurePolicy == LATEST_ONLY ? !pendingFrames.empty() : pendingFrames.size() >= frameDelivery.queueCapacity;
+
+            if (isFull) {
+                switch (frameDelivery.backpressurePolicy) {
+                    case DROP_NEWEST:
+                        counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                        return;
+                    case DROP_OLDEST:
+                        pendingFrames.pop_front();
+                        counters->queueDroppedFrameCount.fetch_add(1, memory_order_relaxed);
+                        break;
+                    case LATEST_ONLY:
+                        counters->queueDroppedFrameCount.fetch_add(pendingFrames.size(), memory_order_relaxed);
+                        pendingFrames.clear();
+                        break;
+                    case BLOCK_PRODUCER:
+                        counters->blockedFrameCount.fetch_add(1, memory_order_relaxed);
+                        frameDelivery.spaceCondition.wait(lock, [&frameDelivery] {
+                            return frameDelivery.isStopping.load(memory_order_relaxed) || frameDelivery.pendingFrames.size() < frameDelivery.queueCapacity;
+                        });
+
+                        if (frameDelivery.isStopping.load(memory_order_relaxed)) {
+                            return;
+                        }
+
+                        break;
+                }
+            }
+
+            pendingFrames.push_back(std::move(pendingFrame));
+            lock.unlock();
+
+            frameDelivery.workCondition.notify_one();
+        }
+
+        // Pool thread: takes frames in capture order, converts them, and delivers them in that order
+        void runPoolThread(shared_ptr<FrameDelivery> frameDelivery, shared_ptr<CaptureCounters> counters, size_t threadIndex) {
+            configureDeliveryThread(frameDelivery->deliveryOptions, threadIndex);
+
+            // The pool's threads already convert frames side by side, each converts its own on its own thread
+            ColorConverter threadColorConverter(1);
+
+            while (true) {
+                PendingFrame pendingFrame;
+                uint64_t sequenceNumber;
+                {
+                    unique_lock<mutex> lock(frameDelivery->poolMutex);
+
+                    frameDelivery->workCondition.wait(lock, [&frameDelivery] {
+                        uint64_t framesInFlight = frameDelivery->nextSequenceNumber - frameDelivery->nextDeliverySequenceNumber;
+
+                        return frameDelivery->isStopping.load(memory_order_relaxed) ||
+                               (!frameDelivery->pendingFrames.empty() && framesInFlight < frameDelivery->maxFramesInFlight);
+                    });
+
+                    // Returns without touching the capture, which may be gone if this thread stopped it from its own callback
+                    if (frameDelivery->isStopping.load(memory_order_relaxed)) {
+                        return;
+                    }
+
+                    pendingFrame = std::move(frameDelivery->pendingFrames.front());
+                    frameDelivery->pendingFrames.pop_front();
+                    sequenceNumber = frameDelivery->nextSequenceNumber++;
+                }
+
+                frameDelivery->spaceCondition.notify_one();
+
+                Frame frame = pendingFrame.isConverted ? pendingFrame.frame : convertFrame(pendingFrame.frame, colorSpace, pendingFrame.regionOutput.get(), &threadColorConverter);
+
+                // Returns the raw buffer to the source before the frame waits for earlier ones
+                pendingFrame.frame.release();
+
+                deliverInOrder(*frameDelivery, *counters, sequenceNumber, std::move(frame));
+            }
+        }
+
+        // Delivers a pool thread's frame once every earlier one has been, the callback never runs on two threads at once
+        static void deliverInOrder(FrameDelivery& frameDelivery, CaptureCounters& counters, uint64_t sequenceNumber, Frame frame) {
+            unique_lock<mutex> lock(frameDelivery.poolMutex);
+
+            frameDelivery.completedFrames.emplace(sequenceNumber, std::move(frame));
+
+            // The delivering thread picks the frame up when its turn comes
+            if (frameDelivery.isDelivering) {
+                return;
+            }
+
+            frameDelivery.isDelivering = true;
+
+            while (!frameDelivery.isStopping.load(memory_order_relaxed)) {
+                auto next = frameDelivery.completedFrames.find(frameDelivery.nextDeliverySequenceNumber);
+
+                if (next == frameDelivery.completedFrames.end()) {
+                    break;
+                }
+
+                Frame nextFrame = std::move(next->second);
+                frameDelivery.completedFrames.erase(next);
+                frameDelivery.nextDeliverySequenceNumber++;
+
+                lock.unlock();
+
+                // A frame that couldn't be converted (all buffers in use) only held its place in line
+                if (nextFrame.isValid() && frameDelivery.isActive.load(memory_order_acquire)) {
+                    invokeFrameProcessor(frameDelivery, counters, nextFrame);
+                }
+
+                nextFrame.release();
+                lock.lock();
+
+                // Room for another frame in flight
+                frameDelivery.workCondition.notify_one();
+            }
+
+            frameDelivery.isDelivering = false;
+        }
+
+        // Dedicated thread: delivers frames from the delivery queue until the capture stops
+        static void runDedicatedThread(shared_ptr<FrameDelivery> frameDelivery, shared_ptr<CaptureCounters> counters) {
+            configureDeliveryThread(frameDelivery->deliveryOptions, 0);
+            setCurrentThreadHighPriority();
+
+            Frame frame;
+
+            while (!frameDelivery->isStopping.load(memory_order_acquire)) {
+                if (!frameDelivery->frameQueue->pop(frame, chrono::milliseconds(kSubscriberWaitMilliseconds))) {
+                    continue;
+                }
+
+                if (frameDelivery->isActive.load(memory_order_acquire)) {
+                    invokeFrameProcessor(*frameDelivery, *counters, frame);
+                }
+
+                frame.release();
+            }
+        }
+
+        // Pins a delivery thread to its core, if the delivery options list any
+        static void configureDeliveryThread(const DeliveryOptions& deliveryOptions, size_t threadIndex) {
+            if (deliveryOptions.cpuAffinity.empty()) {
+                return;
+            }
+
+            size_t cpuIndex = deliveryOptions.cpuAffinity[threadIndex % deliveryOptions.cpuAffinity.size()];
+
+            if (!setCurrentThreadAffinity(cpuIndex)) {
+                cerr << "Warning: couldn't pin delivery thread " << threadIndex << " to core " << cpuIndex << endl;
+            }
+        }
+
+        // Stops the dedicated or pool threads and waits for them (a thread that stopped the capture from its own callback finishes on its own)
+        static void stopDeliveryThreads(FrameDelivery& frameDelivery) {
+            for (thread& workerThread : frameDelivery.workerThreads) {
+                if (workerThread.get_id() == this_thread::get_id()) {
+                    workerThread.detach();
+                }
+                else {
+                    workerThread.join();
+                }
+            }
+
+            frameDelivery.workerThreads.clear();
+
+            lock_guard<mutex> lock(frameDelivery.poolMutex);
+            frameDelivery.pendingFrames.clear();
+            frameDelivery.completedFrames.clear();
+        }
+
+#ifdef __APPLE__
+        // Delivers one queued frame per main queue block so the run loop stays responsive, with at most one block scheduled
+        static void scheduleDrain(shared_ptr<FrameDelivery> frameDelivery, shared_ptr<CaptureCounters> counters) {
+            struct DeliveryContext {
+                shared_ptr<FrameDelivery> frameDelivery;
+                shared_ptr<CaptureCounters> counters;
+            };
+
+            if (frameDelivery->isDrainScheduled.exchange(true, memory_order_acq_rel)) {
+                return;
+            }
+
+            dispatch_async_f(dispatch_get_main_queue(), new DeliveryContext {frameDelivery, counters}, [](void* context) {
+                DeliveryContext* deliveryContext = static_cast<DeliveryContext*>(context);
+                FrameDelivery& frameDelivery = *deliveryContext->frameDelivery;
+
+                // Frames pushed after this see the flag cleared and schedule another drain
+                frameDelivery.isDrainScheduled.store(false, memory_order_seq_cst);
+                atomic_thread_fence(memory_order_seq_cst);
+
+                Frame frame;
+
+                if (frameDelivery.frameQueue->pop(frame) && frameDelivery.isActive.load(memory_order_acquire)) {
+                    invokeFrameProcessor(frameDelivery, *deliveryContext->counters, frame);
+                }
+
+                frame.release();
+
+                if (frameDelivery.frameQueue->getCount() > 0 && frameDelivery.isActive.load(memory_order_acquire)) {
+                    scheduleDrain(deliveryContext->frameDelivery, deliveryContext->counters);
+                }
+
+                delete deliveryContext;
+            });
+        }
+#endif
+
+        static void invokeFrameProcessor(FrameDelivery& frameDelivery, CaptureCounters& counters, Frame& frame) {
+            uint64_t deliveryTimestamp = counters.recordDelivery(frame);
+            frameDelivery.frameProcessor(frame);
+            counters.callbackDuration.record(steadyClockTimestamp() - deliveryTimestamp);
+        }
+
+        // Subscriber thread: delivers frames from the subscriber's queue until it unsubscribes
+        static void runSubscriber(shared_ptr<Subscriber> subscriber, shared_ptr<CaptureCounters> counters) {
+            Frame frame;
+
+            while (subscriber->isActive.load(memory_order_acquire)) {
+                if (!subscriber->frameQueue->pop(frame, chrono::milliseconds(kSubscriberWaitMilliseconds))) {
+                    continue;
+                }
+
+                uint64_t deliveryTimestamp = counters->recordDelivery(frame);
+                subscriber->frameProcessor(frame);
+                counters->callbackDuration.record(steadyClockTimestamp() - deliveryTimestamp);
+
+                frame.release();
+            }
+        }
+
+        static void stopSubscriber(Subscriber& subscriber) {
+            subscriber.isActive.store(false, memory_order_release);
+
+            // Releases the source thread if it's blocked on a full BLOCK_PRODUCER queue
+            subscriber.frameQueue->close();
+
+            // A subscriber may unsubscribe from its own callback, its thread then finishes on its own
+            if (subscriber.workerThread.get_id() == this_thread::get_id()) {
+                subscriber.workerThread.detach();
+            }
+            else {
+                subscriber.workerThread.join();
+            }
+        }
+    };
+
+#ifdef __APPLE__
+    VideoCapture::VideoCapture() : VideoCapture(make_shared<CameraFrameSource>()) {}
+
+    VideoCapture::VideoCapture(const string& device) : VideoCapture(make_shared<CameraFrameSource>(device)) {}
+
+    vector<DeviceInfo> VideoCapture::listDevices() {
+        return CameraFrameSource::listDevices();
+    }
+#endif
+
+    VideoCapture::VideoCapture(shared_ptr<FrameSource> frameSource) {
+        if (!frameSource) {
+            throw runtime_error("Attempted to create a VideoCapture without a frame source");
+        }
+
+        impl = new VideoCaptureImpl(frameSource);
+    }
+
+    VideoCapture::~VideoCapture() {
+        close();
+        delete impl;
+    }
+
+    string VideoCapture::getDeviceID() {
+        return impl->frameSource->getDeviceID();
+    }
+
+    string VideoCapture::getDeviceName() {
+        return impl->frameSource->getDeviceName();
+    }
+
+    string VideoCapture::getDeviceSerialNumber() {
+        return impl->frameSource->getDeviceSerialNumber();
+    }
+
+    uint16_t VideoCapture::getBrightness() {
+        return impl->frameSource->getControlValue(BRIGHTNESS);
+    }
+
+    void VideoCapture::setBrightness(uint16_t brightness) {
+        assert(brightness >= 0 && brightness <= 8);
+        impl->frameSource->setControlValue(BRIGHTNESS, brightness);
+    }
+
+    uint16_t VideoCapture::getDefaultBrightness() {
+        return cameraControlDefaultValue(BRIGHTNESS);
+    }
+
+    void VideoCapture::resetBrightness() {
+        impl->frameSource->setControlValue(BRIGHTNESS, cameraControlDefaultValue(BRIGHTNESS));
+    }
+
+    uint16_t VideoCapture::getContrast() {
+        return impl->frameSource->getControlValue(CONTRAST);
+    }
+
+    void VideoCapture::setContrast(uint16_t contrast) {
+        assert(contrast >= 0 && contrast <= 8);
+        impl->frameSource->setControlValue(CONTRAST, contrast);
+    }
+
+    uint16_t VideoCapture::getDefaultContrast() {
+        return cameraControlDefaultValue(CONTRAST);
+    }
+
+    void VideoCapture::resetContrast() {
+        impl->frameSource->setControlValue(CONTRAST, cameraControlDefaultValue(CONTRAST));
+    }
+
+    uint16_t VideoCapture::getHue() {
+        return impl->frameSource->getControlValue(HUE);
+    }
+
+    void VideoCapture::setHue(uint16_t hue) {
+        assert(hue >= 0 && hue <= 11);
+        impl->frameSource->setControlValue(HUE, hue);
+    }
+
+    uint16_t VideoCapture::getDefaultHue() {
+        return cameraControlDefaultValue(HUE);
+    }
+
+    void VideoCapture::resetHue() {
+        impl->frameSource->setControlValue(HUE, cameraControlDefaultValue(HUE));
+    }
+
+    uint16_t VideoCapture::getSaturation() {
+        return impl->frameSource->getControlValue(SATURATION);
+    }
+
+    void VideoCapture::setSaturation(uint16_t saturation) {
+        assert(saturation >= 0 && saturation <= 8);
+        impl->frameSource->setControlValue(SATURATION, saturation);
+    }
+
+    uint16_t VideoCapture::getDefaultSaturation() {
+        return cameraControlDefaultValue(SATURATION);
+    }
+
+    void VideoCapture::resetSaturation() {
+        impl->frameSource->setControlValue(SATURATION, cameraControlDefaultValue(SATURATION));
+    }
+
+    uint16_t VideoCapture::getSharpness() {
+        return impl->frameSource->getControlValue(SHARPNESS);
+    }
+
+    void VideoCapture::setSharpness(uint16_t sharpness) {
+        assert(sharpness >= 0 && sharpness <= 8);
+        impl->frameSource->setControlValue(SHARPNESS, sharpness);
+    }
+
+    uint16_t VideoCapture::getDefaultSharpness() {
+        return cameraControlDefaultValue(SHARPNESS);
+    }
+
+    void VideoCapture::resetSharpness() {
+        impl->frameSource->setControlValue(SHARPNESS, cameraControlDefaultValue(SHARPNESS));
+    }
+
+    uint16_t VideoCapture::getWhiteBalanceTemperature() {
+        return impl->frameSource->getControlValue(WHITE_BALANCE_TEMPERATURE);
+    }
+
+    void VideoCapture::setWhiteBalanceTemperature(uint16_t whiteBalanceTemperature) {
+        assert(whiteBalanceTemperature >= 2800 && whiteBalanceTemperature <= 6500 && (whiteBalanceTemperature % 100 == 0));
+        impl->frameSource->applySettings({.whiteBalanceTemperature = whiteBalanceTemperature});
+    }
+
+    uint16_t VideoCapture::getDefaultWhiteBalanceTemperature() {
+        return cameraControlDefaultValue(WHITE_BALANCE_TEMPERATURE);
+    }
+
+    void VideoCapture::resetWhiteBalanceTemperature() {
+        impl->frameSource->applySettings({.whiteBalanceTemperature = cameraControlDefaultValue(WHITE_BALANCE_TEMPERATURE)});
+    }
+
+    bool VideoCapture::getAutoWhiteBalanceTemperature() {
+        return impl->frameSource->getControlValue(AUTO_WHITE_BALANCE_TEMPERATURE);
+    }
+
+    void VideoCapture::setAutoWhiteBalanceTemperature(bool autoWhiteBalanceTemperature) {
+        impl->frameSource->setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, autoWhiteBalanceTemperature);
+    }
+
+    bool VideoCapture::getDefaultAutoWhiteBalanceTemperature() {
+        return cameraControlDefaultValue(AUTO_WHITE_BALANCE_TEMPERATURE);
+    }
+
+    void VideoCapture::resetAutoWhiteBalanceTemperature() {
+        impl->frameSource->setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, cameraControlDefaultValue(AUTO_WHITE_BALANCE_TEMPERATURE));
+    }
+
+    bool VideoCapture::isLEDOn() {
+        return impl->frameSource->getControlValue(LED);
+    }
+
+    void VideoCapture::turnOnLED() {
+        impl->frameSource->setControlValue(LED, true);
+    }
+
+    void VideoCapture::turnOffLED() {
+        impl->frameSource->setControlValue(LED, false);
+    }
+
+    void VideoCapture::toggleLED() {
+        impl->frameSource->setControlValue(LED, !isLEDOn());
+    }
+
+    void VideoCapture::applySettings(const CameraSettings& cameraSettings) {
+        assert(!cameraSettings.brightness || *cameraSettings.brightness <= 8);
+        assert(!cameraSettings.contrast || *cameraSettings.contrast <= 8);
+        assert(!cameraSettings.hue || *cameraSettings.hue <= 11);
+        assert(!cameraSettings.saturation || *cameraSettings.saturation <= 8);
+        assert(!cameraSettings.sharpness || *cameraSettings.sharpness <= 8);
+        assert(!cameraSettings.whiteBalanceTemperature ||
+               (*cameraSettings.whiteBalanceTemperature >= 2800 && *cameraSettings.whiteBalanceTemperature <= 6500 &&
+                   (*cameraSettings.whiteBalanceTemperature % 100 == 0)));
+        impl->frameSource->applySettings(cameraSettings);
+    }
+
+    void VideoCapture::setConversionThreadCount(size_t threadCount) {
+        impl->conversionThreadCount = threadCount;
+    }
+
+    void VideoCapture::setPyramidLevelCount(size_t levelCount) {
+        if (impl->isOpen) {
+            throw runtime_error("Attempted to change the pyramid level count of an open VideoCapture");
+        }
+
+        if (levelCount == 0 || levelCount > kMaxPyramidLevelCount) {
+            throw runtime_error(format("Invalid pyramid level count: {} (expected 1 to {})", levelCount, kMaxPyramidLevelCount));
+        }
+
+        impl->pyramidLevelCount = levelCount;
+    }
+
+    void VideoCapture::setFrameLayout(FrameLayout frameLayout) {
+        if (impl->isOpen) {
+            throw runtime_error("Attempted to change the frame layout of an open VideoCapture");
+        }
+
+        impl->frameLayout = frameLayout;
+    }
+
+    void VideoCapture::setRegionOfInterest(EyeRegion leftRegion, EyeRegion rightRegion) {
+        if (!impl->isOpen) {
+            throw runtime_error("Attempted to set a region of interest before opening the VideoCapture");
+        }
+
+        size_t eyeWidth = impl->stereoDimensions.width / 2;
+        size_t eyeHeight = impl->stereoDimensions.height;
+
+        if (leftRegion.width != rightRegion.width || leftRegion.height != rightRegion.height) {
+            throw runtime_error(format("Mismatched region of interest sizes: {} and {}", leftRegion.toString(), rightRegion.toString()));
+        }
+
+        for (const EyeRegion& region : {leftRegion, rightRegion}) {
+            bool isValid = region.width > 0 && region.height > 0 && region.x % 2 == 0 && region.width % 2 == 0 && region.x + region.width <= eyeWidth &&
+                           region.y + region.height <= eyeHeight;
+
+            if (!isValid) {
+                throw runtime_error(format("Invalid region of interest: {} (expected an even x and width within {} x {} eyes)", region.toString(), eyeWidth, eyeHeight));
+            }
+        }
+
+        shared_ptr<RegionOutput> regionOutput = make_shared<RegionOutput>();
+        regionOutput->regions = {leftRegion, rightRegion};
+
+        lock_guard<mutex> lock(impl->regionMutex);
+
+        // Moving a region of the same size keeps its buffers
+        if (impl->regionOutput && impl->regionOutput->regions[LEFT].width == leftRegion.width && impl->regionOutput->regions[LEFT].height == leftRegion.height) {
+            regionOutput->framePool = impl->regionOutput->framePool;
+        }
+        else {
+            regionOutput->framePool = FramePool::create(kFramePoolCapacity,
+                leftRegion.height,
+                leftRegion.width * 2,
+                VideoCaptureImpl::channelCount(impl->colorSpace),
+                impl->frameLayout,
+                impl->pyramidLevelCount);
+        }
+
+        impl->regionOutput = regionOutput;
+    }
+
+    void VideoCapture::setRegionOfInterest(EyeRegion region) {
+        setRegionOfInterest(region, region);
+    }
+
+    void VideoCapture::clearRegionOfInterest() {
+        lock_guard<mutex> lock(impl->regionMutex);
+        impl->regionOutput.reset();
+    }
+
+    StereoDimensions VideoCapture::open(ColorSpace colorSpace, Rectification rectification) {
+        return open(HD2K, FPS_15, colorSpace, rectification);
+    }
+
+    StereoDimensions VideoCapture::open(Resolution resolution, FrameRate frameRate, ColorSpace colorSpace, Rectification rectification) {
+        if (impl->isOpen) {
+            throw runtime_error("Attempted to open an already open VideoCapture");
+        }
+
+        if (rectification == RECTIFIED && colorSpace == YUV) {
+            throw runtime_error("Rectified output is unavailable in the YUV color space");
+        }
+
+        StereoDimensions stereoDimensions = StereoDimensions(resolution);
+
+        // Everything is converted from the native YUV 4:2:2 frames, greyscale included (extracting luma costs less than
+        // having the capture transcode to another format)
+        ColorSpace rawColorSpace = YUV;
+
+        impl->frameSource->open(resolution, frameRate, rawColorSpace);
+
+        impl->stereoDimensions = stereoDimensions;
+        impl->frameRate = frameRate;
+        impl->rawColorSpace = rawColorSpace;
+        impl->colorSpace = colorSpace;
+        impl->rectification.store(RAW, memory_order_release);
+
+        try {
+            if (rectification == RECTIFIED) {
+                CalibrationData calibrationData = getCalibrationData();
+                impl->stereoRectifier = make_shared<StereoRectifier>(calibrationData, stereoDimensions, impl->conversionThreadCount);
+                impl->activeStereoRectifier.store(impl->stereoRectifier.get(), memory_order_release);
+                impl->rectification.store(RECTIFIED, memory_order_release);
+            }
+
+            impl->colorConverter = make_unique<ColorConverter>(impl->conversionThreadCount);
+            impl->prepareOutput(colorSpace);
+        }
+        catch (...) {
+            impl->framePools[colorSpace].reset();
+            impl->colorConverter.reset();
+            impl->activeStereoRectifier.store(nullptr, memory_order_release);
+            impl->rectification.store(RAW, memory_order_release);
+            impl->stereoRectifier.reset();
+            impl->frameSource->close();
+            throw;
+        }
+
+        impl->isOpen = true;
+
+        return stereoDimensions;
+    }
+
+    void VideoCapture::close() {
+        stop();
+        stopRecording();
+
+        if (impl->isOpen) {
+            // The calibration is read from the source, which stays open until the load finishes
+            if (impl->calibrationThread.joinable()) {
+                impl->calibrationThread.join();
+            }
+
+            impl->frameSource->close();
+
+            shared_ptr<const vector<shared_ptr<Subscriber>>> subscribers;
+            {
+                lock_guard<mutex> lock(impl->subscriberMutex);
+                subscribers = impl->subscribers;
+                impl->subscribers = make_shared<const vector<shared_ptr<Subscriber>>>();
+            }
+
+            for (const shared_ptr<Subscriber>& subscriber : *subscribers) {
+                VideoCaptureImpl::stopSubscriber(*subscriber);
+            }
+
+            impl->frameQueue.reset();
+            impl->grabbedFrame.release();
+
+            for (shared_ptr<FramePool>& framePool : impl->framePools) {
+                framePool.reset();
+            }
+
+            {
+                lock_guard<mutex> lock(impl->regionMutex);
+                impl->regionOutput.reset();
+            }
+
+            impl->colorConverter.reset();
+            impl->activeStereoRectifier.store(nullptr, memory_order_release);
+            impl->rectification.store(RAW, memory_order_release);
+            impl->stereoRectifier.reset();
+
+            impl->isOpen = false;
+        }
+    }
+
+    void VideoCapture::start(function<void(Frame)> frameProcessor, BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        start(frameProcessor, DeliveryOptions(), backpressurePolicy, queueCapacity);
+    }
+
+    void VideoCapture::start(function<void(Frame)> frameProcessor, const DeliveryOptions& deliveryOptions, BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        if (impl->isRunning) {
+            throw runtime_error("Attempted to start an already running VideoCapture");
+        }
+
+        DeliveryMode deliveryMode = deliveryOptions.deliveryMode;
+        size_t poolThreadCount = deliveryOptions.threadCount > 0 ? deliveryOptions.threadCount : max(thread::hardware_concurrency(), 1u);
+
+#ifndef __APPLE__
+        if (deliveryMode == MAIN_QUEUE) {
+            throw runtime_error("Attempted to start a VideoCapture with MAIN_QUEUE delivery, which is only available on macOS");
+        }
+#endif
+
+        if (deliveryMode == THREAD_POOL && queueCapacity == 0) {
+            throw runtime_error(format("Invalid frame queue capacity: {}", queueCapacity));
+        }
+
+        shared_ptr<FrameDelivery> frameDelivery = make_shared<FrameDelivery>();
+        frameDelivery->frameProcessor = frameProcessor;
+        frameDelivery->deliveryOptions = deliveryOptions;
+        frameDelivery->isActive = true;
+        frameDelivery->isStopping = false;
+        frameDelivery->isDrainScheduled = false;
+        frameDelivery->queueCapacity = queueCapacity;
+        frameDelivery->backpressurePolicy = backpressurePolicy;
+        frameDelivery->maxFramesInFlight = min(poolThreadCount, size_t(kMaxPoolFramesInFlight));
+
+        // Pending THREAD_POOL frames hold the source's raw buffers, so no more wait than it can lend next to the frames
+        // being converted and the one it's filling (otherwise the source drops frames before the backpressure policy sees them)
+        size_t rawFrameCapacity = impl->frameSource ? impl->frameSource->getRawFrameCapacity() : 0;
+
+        if (deliveryMode == THREAD_POOL && rawFrameCapacity > 0) {
+            size_t lendableFrameCount = rawFrameCapacity - min(rawFrameCapacity, frameDelivery->maxFramesInFlight + 1);
+            frameDelivery->queueCapacity = min(queueCapacity, max(lendableFrameCount, size_t(1)));
+        }
+        frameDelivery->nextSequenceNumber = 0;
+        frameDelivery->nextDeliverySequenceNumber = 0;
+        frameDelivery->isDelivering = false;
+
+        // INLINE frames are delivered on the source's thread as soon as they're processed, and THREAD_POOL frames wait unconverted
+        if (deliveryMode == MAIN_QUEUE || deliveryMode == DEDICATED_THREAD) {
+            frameDelivery->frameQueue = make_shared<FrameQueue>(queueCapacity, backpressurePolicy);
+        }
+
+        impl->frameDelivery = frameDelivery;
+        impl->frameQueue.reset();
+
+        // Delivery threads are up before the first frame, whose callback may already stop the capture
+        if (deliveryMode == DEDICATED_THREAD) {
+            frameDelivery->workerThreads.emplace_back(VideoCaptureImpl::runDedicatedThread, frameDelivery, impl->counters);
+        }
+        else if (deliveryMode == THREAD_POOL) {
+            for (size_t i = 0; i < poolThreadCount; i++) {
+                frameDelivery->workerThreads.emplace_back(&VideoCaptureImpl::runPoolThread, impl, frameDelivery, impl->counters, i);
+            }
+        }
+
+        impl->isRunning = true;
+
+        try {
+            VideoCaptureImpl* captureImpl = impl;
+            impl->frameSource->start([captureImpl](Frame rawFrame) { captureImpl->processRawFrame(rawFrame); });
+        }
+        catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    void VideoCapture::start(function<void(uint8_t*, size_t, size_t, size_t)> frameProcessor, BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        start(frameProcessor, DeliveryOptions(), backpressurePolicy, queueCapacity);
+    }
+
+    void VideoCapture::start(
+        function<void(uint8_t*, size_t, size_t, size_t)> frameProcessor, const DeliveryOptions& deliveryOptions, BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        // A single buffer only holds side-by-side frames, the planes of other layouts need the Frame callback
+        if (impl->frameLayout != SIDE_BY_SIDE) {
+            throw runtime_error(format("Raw buffer callbacks require SIDE_BY_SIDE frames (the frame layout is {})", frameLayoutToString(impl->frameLayout)));
+        }
+
+        start(
+            [frameProcessor](Frame frame) { frameProcessor(frame.getData(), frame.getHeight(), frame.getWidth(), frame.getChannels()); },
+            deliveryOptions,
+            backpressurePolicy,
+            queueCapacity);
+    }
+
+    void VideoCapture::start(BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        if (impl->isRunning) {
+            throw runtime_error("Attempted to start an already running VideoCapture");
+        }
+
+        impl->frameDelivery.reset();
+        impl->frameQueue = make_shared<FrameQueue>(queueCapacity, backpressurePolicy);
+        impl->grabbedFrame.release();
+
+        VideoCaptureImpl* captureImpl = impl;
+        impl->frameSource->start([captureImpl](Frame rawFrame) { captureImpl->processRawFrame(rawFrame); });
+
+        impl->isRunning = true;
+    }
+
+    void VideoCapture::stop() {
+        if (impl->isRunning) {
+            // Releases a source thread blocked on a full BLOCK_PRODUCER queue, so the source can stop
+            if (impl->frameQueue) {
+                impl->frameQueue->close();
+            }
+
+            if (impl->frameDelivery && impl->frameDelivery->frameQueue) {
+                impl->frameDelivery->frameQueue->close();
+            }
+
+            // Also releases a source thread waiting for room in the pool
+            if (impl->frameDelivery) {
+                FrameDelivery& frameDelivery = *impl->frameDelivery;
+                {
+                    lock_guard<mutex> lock(frameDelivery.poolMutex);
+                    frameDelivery.isStopping.store(true, memory_order_release);
+                }
+
+                frameDelivery.workCondition.notify_all();
+                frameDelivery.spaceCondition.notify_all();
+            }
+
+            impl->frameSource->stop();
+
+            if (impl->frameDelivery) {
+                impl->frameDelivery->isActive.store(false, memory_order_release);
+                VideoCaptureImpl::stopDeliveryThreads(*impl->frameDelivery);
+            }
+
+            impl->isRunning = false;
+        }
+    }
+
+    bool VideoCapture::grab(chrono::milliseconds timeout) {
+        if (!impl->frameQueue) {
+            throw runtime_error("Attempted to grab a frame without starting the capture in grab mode");
+        }
+
+        // Return the previous frame's buffer before waiting on the next one
+        impl->grabbedFrame.release();
+
+        if (!impl->frameQueue->pop(impl->grabbedFrame, timeout)) {
+            return false;
+        }
+
+        impl->counters->recordDelivery(impl->grabbedFrame);
+
+        return true;
+    }
+
+    Frame VideoCapture::retrieve() {
+        return impl->grabbedFrame;
+    }
+
+    size_t VideoCapture::subscribe(ColorSpace colorSpace, function<void(Frame)> frameProcessor, BackpressurePolicy backpressurePolicy, size_t queueCapacity) {
+        if (!impl->isOpen) {
+            throw runtime_error("Attempted to subscribe before opening the VideoCapture");
+        }
+
+        if (impl->rectification.load(memory_order_acquire) == RECTIFIED && colorSpace == YUV) {
+            cerr << "Warning: YUV subscribers receive unrectified frames" << endl;
+        }
+
+        impl->prepareOutput(colorSpace);
+
+        shared_ptr<Subscriber> subscriber = make_shared<Subscriber>();
+        subscriber->colorSpace = colorSpace;
+        subscriber->frameProcessor = frameProcessor;
+        subscriber->frameQueue = make_shared<FrameQueue>(queueCapacity, backpressurePolicy);
+        subscriber->droppedFrameCount = 0;
+        subscriber->isActive = true;
+        subscriber->workerThread = thread(VideoCaptureImpl::runSubscriber, subscriber, impl->counters);
+
+        lock_guard<mutex> lock(impl->subscriberMutex);
+
+        subscriber->subscriptionID = impl->nextSubscriptionID++;
+
+        auto subscribers = make_shared<vector<shared_ptr<Subscriber>>>(*impl->subscribers);
+        subscribers->push_back(subscriber);
+        impl->subscribers = subscribers;
+
+        return subscriber->subscriptionID;
+    }
+
+    void VideoCapture::unsubscribe(size_t subscriptionID) {
+        shared_ptr<Subscriber> subscriber;
+        {
+            lock_guard<mutex> lock(impl->subscriberMutex);
+
+            auto subscribers = make_shared<vector<shared_ptr<Subscriber>>>(*impl->subscribers);
+            auto match = find_if(subscribers->begin(), subscribers->end(), [subscriptionID](const shared_ptr<Subscriber>& subscriber) {
+                return subscriber->subscriptionID == subscriptionID;
+            });
+
+            if (match == subscribers->end()) {
+                throw runtime_error(format("Attempted to unsubscribe with an unknown subscription ID: {}", subscriptionID));
+            }
+
+            subscriber = *match;
+            subscribers->erase(match);
+            impl->subscribers = subscribers;
+        }
+
+        VideoCaptureImpl::stopSubscriber(*subscriber);
+    }
+
+    uint64_t VideoCapture::getSubscriberDroppedFrameCount(size_t subscriptionID) {
+        lock_guard<mutex> lock(impl->subscriberMutex);
+
+        for (const shared_ptr<Subscriber>& subscriber : *impl->subscribers) {
+            if (subscriber->subscriptionID == subscriptionID) {
+                return subscriber->droppedFrameCount.load(memory_order_relaxed);
+            }
+        }
+
+        throw runtime_error(format("Unknown subscription ID: {}", subscriptionID));
+    }
+
+    uint64_t VideoCapture::getDroppedFrameCount() {
+        return impl->counters->queueDroppedFrameCount.load(memory_order_relaxed);
+    }
+
+    CaptureStats VideoCapture::getStats() {
+        CaptureCounters& counters = *impl->counters;
+        CaptureStats stats;
+
+        stats.capturedFrameCount = counters.capturedFrameCount.load(memory_order_relaxed);
+        stats.deliveredFrameCount = counters.deliveredFrameCount.load(memory_order_relaxed);
+        stats.poolDroppedFrameCount = counters.poolDroppedFrameCount.load(memory_order_relaxed);
+        stats.queueDroppedFrameCount = counters.queueDroppedFrameCount.load(memory_order_relaxed);
+        stats.droppedFrameCount = stats.poolDroppedFrameCount + stats.queueDroppedFrameCount;
+        stats.blockedFrameCount = counters.blockedFrameCount.load(memory_order_relaxed);
+
+        if (impl->frameQueue) {
+            stats.backlogCount = impl->frameQueue->getCount();
+        }
+        else if (impl->frameDelivery && impl->frameDelivery->frameQueue) {
+            stats.backlogCount = impl->frameDelivery->frameQueue->getCount();
+        }
+
+        stats.sourceLatency = counters.sourceLatency.summarize();
+        stats.conversionTime = counters.conversionTime.summarize();
+        stats.queueWait = counters.queueWait.summarize();
+        stats.callbackDuration = counters.callbackDuration.summarize();
+        stats.totalLatency = counters.totalLatency.summarize();
+
+        return stats;
+    }
+
+    void VideoCapture::resetStats() {
+        impl->counters->reset();
+    }
+
+    void VideoCapture::startRecording(const path& filepath, size_t maxFrameCount) {
+        if (!impl->isOpen) {
+            throw runtime_error("Attempted to start recording before opening the VideoCapture");
+        }
+
+        if (impl->recordingWriter) {
+            throw runtime_error("Attempted to start recording while already recording");
+        }
+
+        // Device info and calibration are stored when available, so recordings from any source can be made
+        string serialNumber;
+        string calibration;
+
+        try {
+            serialNumber = getDeviceSerialNumber();
+            calibration = getCalibrationData().toString();
+        }
+        catch (const exception& error) {
+            cerr << "Warning: recording without calibration data (" << error.what() << ")" << endl;
+        }
+
+        impl->recordingWriter =
+            make_unique<RecordingWriter>(filepath, impl->stereoDimensions, impl->rawColorSpace, impl->frameRate, maxFrameCount, serialNumber, calibration);
+        impl->activeRecordingWriter.store(impl->recordingWriter.get(), memory_order_seq_cst);
+    }
+
+    void VideoCapture::stopRecording() {
+        if (!impl->recordingWriter) {
+            return;
+        }
+
+        impl->activeRecordingWriter.store(nullptr, memory_order_seq_cst);
+
+        // Wait out a frame that may still be handing itself to the writer
+        while (impl->recordingUseCount.load(memory_order_acquire) != 0) {
+            this_thread::yield();
+        }
+
+        impl->recordingWriter->finish();
+        impl->recordingWriter.reset();
+    }
+
+    bool VideoCapture::isRecording() {
+        return impl->recordingWriter != nullptr;
+    }
+
+    uint64_t VideoCapture::getRecordingDroppedFrameCount() {
+        return impl->recordingWriter ? impl->recordingWriter->getDroppedFrameCount() : 0;
+    }
+
+    CalibrationData VideoCapture::getCalibrationData() {
+        string serialNumber = getDeviceSerialNumber();
+        string deviceCalibration;
+
+        // Calibration stored on the device needs neither the file cache nor the network (cameras without any go straight to the cache)
+        try {
+            deviceCalibration = impl->frameSource->readCalibration();
+        }
+        catch (const exception& error) {
+            cerr << "Warning: falling back to the calibration file cache (" << error.what() << ")" << endl;
+        }
+
+        CalibrationData calibrationData;
+
+        if (!deviceCalibration.empty()) {
+            calibrationData.loadFromDevice(serialNumber, deviceCalibration);
+        }
+        else {
+            calibrationData.load(serialNumber, impl->calibrationDownloadURL);
+        }
+
+        return calibrationData;
+    }
+
+    future<CalibrationData> VideoCapture::loadCalibrationAsync() {
+        if (!impl->isOpen) {
+            throw runtime_error("Attempted to load calibration for a non-open VideoCapture");
+        }
+
+        if (impl->colorSpace == YUV) {
+            throw runtime_error("Rectified output is unavailable in the YUV color space");
+        }
+
+        if (impl->activeStereoRectifier.load(memory_order_acquire) || impl->isLoadingCalibration.load(memory_order_acquire)) {
+            throw runtime_error("Attempted to load calibration for an already rectified VideoCapture");
+        }
+
+        // A previous load failed
+        if (impl->calibrationThread.joinable()) {
+            impl->calibrationThread.join();
+        }
+
+        impl->isLoadingCalibration.store(true, memory_order_release);
+
+        promise<CalibrationData> calibrationPromise;
+        future<CalibrationData> calibrationFuture = calibrationPromise.get_future();
+
+        impl->calibrationThread = thread([this, calibrationPromise = std::move(calibrationPromise)]() mutable {
+            try {
+                CalibrationData calibrationData = getCalibrationData();
+                impl->stereoRectifier = make_shared<StereoRectifier>(calibrationData, impl->stereoDimensions, impl->conversionThreadCount);
+
+                // The source thread switches to rectified output with the next frame it processes
+                impl->activeStereoRectifier.store(impl->stereoRectifier.get(), memory_order_release);
+                impl->rectification.store(RECTIFIED, memory_order_release);
+                impl->isLoadingCalibration.store(false, memory_order_release);
+                calibrationPromise.set_value(std::move(calibrationData));
+            }
+            catch (...) {
+                impl->isLoadingCalibration.store(false, memory_order_release);
+                calibrationPromise.set_exception(current_exception());
+            }
+        });
+
+        return calibrationFuture;
+    }
+
+    void VideoCapture::setCalibrationDownloadURL(const string& downloadURL) {
+        impl->calibrationDownloadURL = downloadURL;
+    }
+}
@@ -0,0 +1,58 @@
+//
+// zed_yuv_conversion.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_YUV_CONVERSION_H
+#define ZED_YUV_CONVERSION_H
+
+#include "../include/zed_color_conversion.h"
+#include <cstdint>
+
+//
+// BT.601 video range YUV -> RGB in 8-bit fixed point
+//
+// Every conversion path (scalar, SIMD, fused rectification) evaluates exactly this arithmetic,
+// so their outputs are bit-identical
+//
+#define kYUVLumaOffset 16
+#define kYUVChromaOffset 128
+#define kYUVLumaCoefficient 298
+#define kYUVCrToRCoefficient 409
+#define kYUVCbToGCoefficient -100
+#define kYUVCrToGCoefficient -208
+#define kYUVCbToBCoefficient 516
+#define kYUVRounding 128
+#define kYUVShift 8
+
+namespace zed {
+
+    inline uint8_t clampToByte(int value) {
+        return value < 0 ? 0 : (value > 255 ? 255 : uint8_t(value));
+    }
+
+    // Converts a single pixel, writing channels in RGB order (or BGR order if `isBGR`)
+    template <bool isBGR> inline void convertYUVPixel(int y, int cb, int cr, uint8_t* destination) {
+        int luma = kYUVLumaCoefficient * (y - kYUVLumaOffset) + kYUVRounding;
+        int u = cb - kYUVChromaOffset;
+        int v = cr - kYUVChromaOffset;
+
+        uint8_t r = clampToByte((luma + kYUVCrToRCoefficient * v) >> kYUVShift);
+        uint8_t g = clampToByte((luma + kYUVCbToGCoefficient * u + kYUVCrToGCoefficient * v) >> kYUVShift);
+        uint8_t b = clampToByte((luma + kYUVCbToBCoefficient * u) >> kYUVShift);
+
+        destination[0] = isBGR ? b : r;
+        destination[1] = g;
+        destination[2] = isBGR ? r : b;
+    }
+
+    // Converts a row of `width` YUV 4:2:2 pixels into a color space (copies it for YUV)
+    typedef void (*RowConverter)(const uint8_t* source, uint8_t* destination, size_t width);
+
+    // Row converter of the color conversion for an instruction set and color space, for passes that convert rows themselves
+    RowConverter rowConverterFor(InstructionSet instructionSet, ColorSpace colorSpace);
+}
+
+#endif
@@ -0,0 +1,239 @@
+//
+// zed_calibration_data_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_calibration_data.h"
+#include "zed_camera_controls.h"
+#include "zed_synthetic_frame_source.h"
+#include "zed_test.h"
+#include "zed_video_capture.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+
+using namespace zed;
+
+//
+// Where a capture's calibration comes from: the copy in the camera's flash, then the file cache, then the download,
+// and switching a running capture to rectified frames once it's loaded
+//
+
+#define kSerialNumber "424242"
+#define kFrameTimeout chrono::seconds(10)
+
+// Calibration file contents for the VGA resolution, told apart by their baseline
+static string calibrationContents(float baseline) {
+    return format("[LEFT_CAM_VGA]\nfx=348.5\nfy=348.4\ncx=337.5\ncy=186.8\nk1=-0.171\nk2=0.0262\np1=0.0003\np2=-0.0002\nk3=0.0001\n\n"
+                  "[RIGHT_CAM_VGA]\nfx=348.7\nfy=348.6\ncx=338.1\ncy=187.2\nk1=-0.172\nk2=0.0264\np1=0.0002\np2=-0.0001\nk3=0.0001\n\n"
+                  "[STEREO]\nBaseline={}\nTY=0.3\nTZ=-0.5\nCV_VGA=0.004\nRX_VGA=0.002\nRZ_VGA=-0.0015\n",
+        baseline);
+}
+
+// Synthetic frames with the calibration read from a simulated camera's flash, as CameraFrameSource reads it over USB
+class FlashFrameSource : public SyntheticFrameSource {
+
+public:
+    FlashFrameSource(shared_ptr<SimulatedControlTransport> controlTransport)
+        : SyntheticFrameSource(MAX_SPEED, kSerialNumber),
+          controlSession(controlTransport) {}
+
+    string readCalibration() override {
+        return controlSession.readCalibration();
+    }
+
+private:
+    ControlSession controlSession;
+};
+
+// A home directory with the calibration file cache, and a download mirror, for each test
+struct CalibrationFixture {
+    TemporaryDirectory directory;
+    path cacheFilepath;
+    shared_ptr<SimulatedControlTransport> controlTransport;
+    VideoCapture videoCapture;
+
+    CalibrationFixture()
+        : controlTransport(make_shared<SimulatedControlTransport>()),
+          videoCapture(make_shared<FlashFrameSource>(controlTransport)) {
+
+        setenv("HOME", directory.getPath().c_str(), 1);
+        cacheFilepath = directory.getPath() / ".stereolabs" / "calibration" / ("SN" kSerialNumber ".conf");
+
+        path mirrorDirectory = directory.getPath() / "mirror";
+        writeFile(mirrorDirectory / kSerialNumber, calibrationContents(121));
+        videoCapture.setCalibrationDownloadURL(format("file://{}/", mirrorDirectory.string()));
+    }
+};
+
+static bool isBaseline(const CalibrationData& calibrationData, float baseline) {
+    return calibrationData.getStereoCalibration(VGA).baseline == baseline;
+}
+
+static void testDeviceCalibrationIsPreferredAndCached() {
+    CalibrationFixture fixture;
+    writeFile(fixture.cacheFilepath, calibrationContents(119));
+    fixture.controlTransport->setFlashImage(kFlashCalibrationAddress, encodeFlashCalibration(calibrationContents(120)));
+
+    CalibrationData calibrationData = fixture.videoCapture.getCalibrationData();
+
+    CHECK(isBaseline(calibrationData, 120));
+    CHECK(calibrationData.getFilepath() == fixture.cacheFilepath);
+    CHECK(readFile(fixture.cacheFilepath) == calibrationContents(120));
+
+    // Only the cache itself is left, no temporary files
+    size_t fileCount = distance(directory_iterator(fixture.cacheFilepath.parent_path()), directory_iterator());
+    CHECK(fileCount == 1);
+}
+
+static void testCorruptFlashFallsBackToFileCache() {
+    CalibrationFixture fixture;
+    writeFile(fixture.cacheFilepath, calibrationContents(119));
+
+    vector<uint8_t> record = encodeFlashCalibration(calibrationContents(120));
+    record[record.size() / 2] ^= 0x01;
+    fixture.controlTransport->setFlashImage(kFlashCalibrationAddress, record);
+
+    CalibrationData calibrationData = fixture.videoCapture.getCalibrationData();
+
+    CHECK(isBaseline(calibrationData, 119));
+    CHECK(readFile(fixture.cacheFilepath) == calibrationContents(119));
+}
+
+static void testEmptyFlashFallsBackToDownload() {
+    CalibrationFixture fixture;
+
+    // Erased flash, and nothing cached yet
+    CalibrationData calibrationData = fixture.videoCapture.getCalibrationData();
+
+    CHECK(isBaseline(calibrationData, 121));
+    CHECK(readFile(fixture.cacheFilepath) == calibrationContents(121));
+}
+
+static void testCacheFailureKeepsDeviceCalibration() {
+    CalibrationFixture fixture;
+    fixture.controlTransport->setFlashImage(kFlashCalibrationAddress, encodeFlashCalibration(calibrationContents(120)));
+
+    // A file where the cache directory should be
+    writeFile(fixture.directory.getPath() / ".stereolabs", "");
+
+    CalibrationData calibrationData = fixture.videoCapture.getCalibrationData();
+
+    CHECK(isBaseline(calibrationData, 120));
+    CHECK(calibrationData.getFilepath().empty());
+}
+
+#pragma mark - Asynchronous Loading
+
+// Counts a running capture's frames by rectification
+class RectificationCounter {
+
+public:
+    function<void(Frame)> frameHandler() {
+        return [this](Frame frame) {
+            lock_guard<mutex> lock(counterMutex);
+
+            if (frame.getRectification() == RECTIFIED) {
+                rectifiedFrameCount++;
+            }
+            else {
+                rawFrameCount++;
+                rawFramesAfterRectifiedCount += rectifiedFrameCount > 0;
+            }
+
+            frameCondition.notify_all();
+        };
+    }
+
+    // Waits for `count` more frames of the given rectification
+    bool waitForFrames(Rectification rectification, uint64_t count) {
+        unique_lock<mutex> lock(counterMutex);
+        uint64_t& frameCount = rectification == RECTIFIED ? rectifiedFrameCount : rawFrameCount;
+        uint64_t targetFrameCount = frameCount + count;
+
+        return frameCondition.wait_for(lock, kFrameTimeout, [&] { return frameCount >= targetFrameCount; });
+    }
+
+    uint64_t getRectifiedFrameCount() {
+        lock_guard<mutex> lock(counterMutex);
+        return rectifiedFrameCount;
+    }
+
+    uint64_t getRawFramesAfterRectifiedCount() {
+        lock_guard<mutex> lock(counterMutex);
+        return rawFramesAfterRectifiedCount;
+    }
+
+private:
+    mutex counterMutex;
+    condition_variable frameCondition;
+    uint64_t rawFrameCount = 0;
+    uint64_t rectifiedFrameCount = 0;
+    uint64_t rawFramesAfterRectifiedCount = 0;
+};
+
+static void testAsyncLoadRectifiesLaterFrames() {
+    CalibrationFixture fixture;
+    RectificationCounter counter;
+
+    fixture.videoCapture.open<VGA, FPS_100>(RGB);
+    fixture.videoCapture.start(counter.frameHandler());
+    CHECK(counter.waitForFrames(RAW, 1));
+
+    future<CalibrationData> calibrationFuture = fixture.videoCapture.loadCalibrationAsync();
+    CHECK(calibrationFuture.wait_for(kFrameTimeout) == future_status::ready);
+    CHECK(isBaseline(calibrationFuture.get(), 121));
+
+    // Frames processed from now on are rectified, and stay rectified
+    CHECK(counter.waitForFrames(RECTIFIED, 3));
+    CHECK(counter.getRawFramesAfterRectifiedCount() == 0);
+
+    CHECK_THROWS(fixture.videoCapture.loadCalibrationAsync());
+
+    fixture.videoCapture.stop();
+    fixture.videoCapture.close();
+}
+
+static void testFailedAsyncLoadCanBeRetried() {
+    CalibrationFixture fixture;
+    RectificationCounter counter;
+
+    // Nothing in flash, the cache, or the mirror
+    path mirrorFilepath = fixture.directory.getPath() / "mirror" / kSerialNumber;
+    remove(mirrorFilepath);
+
+    fixture.videoCapture.open<VGA, FPS_100>(GREYSCALE);
+    fixture.videoCapture.start(counter.frameHandler());
+
+    future<CalibrationData> calibrationFuture = fixture.videoCapture.loadCalibrationAsync();
+    CHECK(calibrationFuture.wait_for(kFrameTimeout) == future_status::ready);
+    CHECK_THROWS(calibrationFuture.get());
+
+    // The capture keeps delivering raw frames
+    CHECK(counter.waitForFrames(RAW, 3));
+    CHECK(counter.getRectifiedFrameCount() == 0);
+
+    // Once the mirror has the file, loading again succeeds
+    writeFile(mirrorFilepath, calibrationContents(121));
+
+    calibrationFuture = fixture.videoCapture.loadCalibrationAsync();
+    CHECK(calibrationFuture.wait_for(kFrameTimeout) == future_status::ready);
+    CHECK(isBaseline(calibrationFuture.get(), 121));
+    CHECK(counter.waitForFrames(RECTIFIED, 3));
+
+    fixture.videoCapture.stop();
+    fixture.videoCapture.close();
+}
+
+int main() {
+    runTest("device calibration is preferred and cached", testDeviceCalibrationIsPreferredAndCached);
+    runTest("corrupt flash falls back to the file cache", testCorruptFlashFallsBackToFileCache);
+    runTest("empty flash falls back to the download", testEmptyFlashFallsBackToDownload);
+    runTest("cache failure keeps the device calibration", testCacheFailureKeepsDeviceCalibration);
+    runTest("async load rectifies later frames", testAsyncLoadRectifiesLaterFrames);
+    runTest("failed async load can be retried", testFailedAsyncLoadCanBeRetried);
+
+    return EXIT_SUCCESS;
+}
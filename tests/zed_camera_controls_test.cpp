@@ -0,0 +1,171 @@
+//
+// zed_camera_controls_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_camera_controls.h"
+#include "zed_test.h"
+#include <cstdlib>
+
+using namespace zed;
+
+//
+// Control session caching and batching, and calibration reads from flash, counted on a simulated camera
+//
+
+// Forwards to a simulated camera and records which controls each transfer changed, in order
+class CountingControlTransport : public ControlTransport {
+
+public:
+    SimulatedControlTransport camera;
+    uint64_t transferCount = 0;
+    vector<CameraControl> changedControls;
+
+    void transfer(ControlTransfer& controlTransfer) override {
+        uint16_t previousValues[kCameraControlCount];
+
+        for (size_t i = 0; i < kCameraControlCount; i++) {
+            previousValues[i] = camera.getDeviceValue(CameraControl(i));
+        }
+
+        camera.transfer(controlTransfer);
+        transferCount++;
+
+        for (size_t i = 0; i < kCameraControlCount; i++) {
+            if (camera.getDeviceValue(CameraControl(i)) != previousValues[i]) {
+                changedControls.push_back(CameraControl(i));
+            }
+        }
+    }
+
+    void reset() {
+        transferCount = 0;
+        changedControls.clear();
+    }
+};
+
+static void testCachedReadsSkipTransfers() {
+    shared_ptr<CountingControlTransport> transport = make_shared<CountingControlTransport>();
+    ControlSession controlSession(transport);
+
+    uint16_t brightness = controlSession.getControlValue(BRIGHTNESS);
+    CHECK(transport->transferCount == 1);
+
+    CHECK(controlSession.getControlValue(BRIGHTNESS) == brightness);
+    CHECK(transport->transferCount == 1);
+    CHECK(controlSession.getCachedReadCount() == 1);
+
+    // A written value is known without reading it back, and writing it again is skipped
+    controlSession.setControlValue(CONTRAST, 6);
+    controlSession.setControlValue(CONTRAST, 6);
+    CHECK(controlSession.getControlValue(CONTRAST) == 6);
+    CHECK(transport->transferCount == 2);
+
+    // Forgotten values are read again
+    controlSession.invalidate();
+    CHECK(controlSession.getControlValue(CONTRAST) == 6);
+    CHECK(transport->transferCount == 3);
+}
+
+static void testTemperatureIsReadWhileAutomatic() {
+    shared_ptr<CountingControlTransport> transport = make_shared<CountingControlTransport>();
+    ControlSession controlSession(transport);
+
+    controlSession.setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, 1);
+    transport->reset();
+
+    // Automatic white balance may change the temperature at any time
+    controlSession.getControlValue(WHITE_BALANCE_TEMPERATURE);
+    controlSession.getControlValue(WHITE_BALANCE_TEMPERATURE);
+    CHECK(transport->transferCount == 2);
+}
+
+static void testApplySettingsWritesChangedControls() {
+    shared_ptr<CountingControlTransport> transport = make_shared<CountingControlTransport>();
+    ControlSession controlSession(transport);
+
+    CameraSettings cameraSettings;
+    cameraSettings.brightness = 5;
+    cameraSettings.contrast = 6;
+    cameraSettings.saturation = 7;
+
+    controlSession.applySettings(cameraSettings);
+    CHECK(transport->transferCount == 3);
+    CHECK(transport->camera.getDeviceValue(BRIGHTNESS) == 5);
+    CHECK(transport->camera.getDeviceValue(CONTRAST) == 6);
+    CHECK(transport->camera.getDeviceValue(SATURATION) == 7);
+
+    // Unchanged controls are skipped
+    transport->reset();
+    controlSession.applySettings(cameraSettings);
+    CHECK(transport->transferCount == 0);
+
+    cameraSettings.contrast = 2;
+    cameraSettings.hue = 3;
+    controlSession.applySettings(cameraSettings);
+    CHECK(transport->transferCount == 2);
+    CHECK((transport->changedControls == vector<CameraControl> {CONTRAST, HUE}));
+}
+
+static void testTemperatureTurnsAutomaticWhiteBalanceOff() {
+    shared_ptr<CountingControlTransport> transport = make_shared<CountingControlTransport>();
+    ControlSession controlSession(transport);
+
+    controlSession.setControlValue(AUTO_WHITE_BALANCE_TEMPERATURE, 1);
+    transport->reset();
+
+    CameraSettings cameraSettings;
+    cameraSettings.whiteBalanceTemperature = 5200;
+
+    // Automatic white balance is turned off first, so the temperature takes effect
+    controlSession.applySettings(cameraSettings);
+    CHECK(transport->transferCount == 2);
+    CHECK((transport->changedControls == vector<CameraControl> {AUTO_WHITE_BALANCE_TEMPERATURE, WHITE_BALANCE_TEMPERATURE}));
+    CHECK(transport->camera.getDeviceValue(AUTO_WHITE_BALANCE_TEMPERATURE) == 0);
+    CHECK(transport->camera.getDeviceValue(WHITE_BALANCE_TEMPERATURE) == 5200);
+
+    // Once it's off, the temperature is cached like any other control
+    transport->reset();
+    controlSession.applySettings(cameraSettings);
+    CHECK(controlSession.getControlValue(WHITE_BALANCE_TEMPERATURE) == 5200);
+    CHECK(transport->transferCount == 0);
+
+    // A temperature can't be set along with automatic white balance
+    cameraSettings.autoWhiteBalanceTemperature = true;
+    CHECK_THROWS(controlSession.applySettings(cameraSettings));
+}
+
+static void testMissingCalibrationRecordIsRemembered() {
+    shared_ptr<CountingControlTransport> transport = make_shared<CountingControlTransport>();
+    ControlSession controlSession(transport);
+
+    // Erased flash has no record, which costs a single read
+    CHECK(controlSession.readCalibration().empty());
+    CHECK(transport->transferCount > 0);
+
+    uint64_t transferCount = transport->transferCount;
+    CHECK(controlSession.readCalibration().empty());
+    CHECK(transport->transferCount == transferCount);
+
+    // A record written since is found once the session is invalidated, a corrupt one throws
+    vector<uint8_t> record = encodeFlashCalibration("[STEREO]\nBaseline=120\n");
+    transport->camera.setFlashImage(kFlashCalibrationAddress, record);
+    controlSession.invalidate();
+    CHECK(controlSession.readCalibration() == "[STEREO]\nBaseline=120\n");
+
+    record[kFlashCalibrationHeaderSize] ^= 0x01;
+    transport->camera.setFlashImage(kFlashCalibrationAddress, record);
+    CHECK_THROWS(controlSession.readCalibration());
+}
+
+int main() {
+    runTest("cached reads skip transfers", testCachedReadsSkipTransfers);
+    runTest("temperature is read while automatic", testTemperatureIsReadWhileAutomatic);
+    runTest("apply settings writes changed controls", testApplySettingsWritesChangedControls);
+    runTest("temperature turns automatic white balance off", testTemperatureTurnsAutomaticWhiteBalanceOff);
+    runTest("missing calibration record is remembered", testMissingCalibrationRecordIsRemembered);
+
+    return EXIT_SUCCESS;
+}
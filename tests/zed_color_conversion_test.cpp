@@ -0,0 +1,162 @@
+//
+// zed_color_conversion_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_color_conversion.h"
+#include "zed_test.h"
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace zed;
+
+//
+// Vector conversion paths against the scalar one, which they must match bit for bit
+//
+
+#define kThreadCount 3
+
+static vector<uint8_t> randomBytes(size_t count, uint32_t seed) {
+    mt19937 generator(seed);
+    vector<uint8_t> bytes(count);
+
+    for (uint8_t& byte : bytes) {
+        byte = uint8_t(generator());
+    }
+
+    return bytes;
+}
+
+static size_t channelsOf(ColorSpace colorSpace) {
+    switch (colorSpace) {
+        case YUV:
+            return 2;
+        case GREYSCALE:
+            return 1;
+        default:
+            return 3;
+    }
+}
+
+// Instruction sets other than scalar that the running CPU supports
+static vector<InstructionSet> vectorInstructionSets() {
+    vector<InstructionSet> instructionSets;
+
+    for (InstructionSet instructionSet : {SSE4, AVX2, NEON}) {
+        if (ColorConverter::isSupported(instructionSet)) {
+            instructionSets.push_back(instructionSet);
+        }
+    }
+
+    return instructionSets;
+}
+
+static bool hasSamePixels(const FramePlane& plane, const FramePlane& otherPlane) {
+    for (size_t row = 0; row < plane.height; row++) {
+        if (memcmp(plane.data + row * plane.rowBytes, otherPlane.data + row * otherPlane.rowBytes, plane.width * plane.channels) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Whether every plane and pyramid level of two frames of the same shape holds the same pixels
+static bool hasSamePixels(const Frame& frame, const Frame& otherFrame) {
+    for (size_t i = 0; i < frame.getPlaneCount(); i++) {
+        if (!hasSamePixels(frame.getPlane(i), otherFrame.getPlane(i))) {
+            return false;
+        }
+    }
+
+    for (size_t level = 1; level < frame.getPyramidLevelCount(); level++) {
+        for (Eye eye : {LEFT, RIGHT}) {
+            if (!hasSamePixels(frame.getPyramidLevel(level, eye), otherFrame.getPyramidLevel(level, eye))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+#pragma mark - Buffers
+
+static void testVectorConversionMatchesScalar() {
+    CHECK(ColorConverter::isSupported(SCALAR));
+
+    // Widths around the vector lengths, so every path runs its tail
+    for (size_t width : {2, 4, 14, 16, 18, 30, 32, 34, 62, 64, 66, 100, 1344}) {
+        for (size_t height : {1, 3, 16}) {
+            vector<uint8_t> source = randomBytes(width * 2 * height, uint32_t(width * height));
+
+            for (ColorSpace colorSpace : {YUV, GREYSCALE, RGB, BGR}) {
+                size_t rowBytes = width * channelsOf(colorSpace);
+                vector<uint8_t> expected(rowBytes * height);
+                ColorConverter(1, SCALAR).convert(source.data(), width * 2, expected.data(), rowBytes, height, width, colorSpace);
+
+                for (InstructionSet instructionSet : vectorInstructionSets()) {
+                    for (size_t threadCount : {1, kThreadCount}) {
+                        vector<uint8_t> converted(rowBytes * height);
+                        ColorConverter(threadCount, instructionSet).convert(source.data(), width * 2, converted.data(), rowBytes, height, width, colorSpace);
+
+                        CHECK(converted == expected);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#pragma mark - Frames
+
+static void testVectorFrameConversionMatchesScalar() {
+    StereoDimensions stereoDimensions(VGA);
+    size_t sourceRowBytes = stereoDimensions.width * 2;
+    vector<uint8_t> source = randomBytes(sourceRowBytes * stereoDimensions.height, 1);
+
+    // An odd region of each eye, at an even x
+    array<EyeRegion, 2> regions = {EyeRegion {10, 33, 226, 101}, EyeRegion {96, 7, 226, 101}};
+
+    for (ColorSpace colorSpace : {YUV, GREYSCALE, RGB, BGR}) {
+        size_t channels = channelsOf(colorSpace);
+
+        for (FrameLayout frameLayout : {SIDE_BY_SIDE, SEPARATE_EYES, PLANAR}) {
+            size_t pyramidLevelCount = colorSpace == YUV ? 1 : 3;
+
+            shared_ptr<FramePool> framePool = FramePool::create(2, stereoDimensions.height, stereoDimensions.width, channels, frameLayout, pyramidLevelCount);
+            shared_ptr<FramePool> regionFramePool = FramePool::create(2, regions[0].height, regions[0].width * 2, channels, frameLayout, pyramidLevelCount);
+
+            Frame expected = framePool->acquire();
+            Frame expectedRegions = regionFramePool->acquire();
+
+            ColorConverter scalarConverter(1, SCALAR);
+            scalarConverter.convert(source.data(), sourceRowBytes, expected, colorSpace);
+            scalarConverter.convert(source.data(), sourceRowBytes, stereoDimensions.width / 2, regions, expectedRegions, colorSpace);
+
+            for (InstructionSet instructionSet : vectorInstructionSets()) {
+                Frame converted = framePool->acquire();
+                Frame convertedRegions = regionFramePool->acquire();
+
+                ColorConverter colorConverter(kThreadCount, instructionSet);
+                colorConverter.convert(source.data(), sourceRowBytes, converted, colorSpace);
+                colorConverter.convert(source.data(), sourceRowBytes, stereoDimensions.width / 2, regions, convertedRegions, colorSpace);
+
+                CHECK(hasSamePixels(converted, expected));
+                CHECK(hasSamePixels(convertedRegions, expectedRegions));
+            }
+        }
+    }
+}
+
+int main() {
+    runTest("vector conversion matches scalar", testVectorConversionMatchesScalar);
+    runTest("vector frame conversion matches scalar", testVectorFrameConversionMatchesScalar);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+//
+// zed_frame_queue_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_frame_queue.h"
+#include "zed_frame_source.h"
+#include "zed_test.h"
+#include "zed_video_capture.h"
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace zed;
+
+//
+// Backpressure policies, on a FrameQueue fed directly and on a capture polled with grab() / retrieve() from a fake source
+//
+
+#define kQueueCapacity 4
+#define kFrameCount 6
+#define kGrabTimeout chrono::milliseconds(50)
+
+// Frames over a 1 x 1 buffer, numbered by sequence number
+static Frame makeFrame(uint64_t sequenceNumber) {
+    static uint8_t pixel = 0;
+
+    Frame frame = Frame::wrap(&pixel, 1, 1, 1, 1, [] {});
+    frame.setSequenceNumber(sequenceNumber);
+
+    return frame;
+}
+
+// Sequence numbers of the frames left in a queue, in the order they're popped
+static vector<uint64_t> popAll(FrameQueue& frameQueue) {
+    vector<uint64_t> sequenceNumbers;
+    Frame frame;
+
+    while (frameQueue.pop(frame)) {
+        sequenceNumbers.push_back(frame.getSequenceNumber());
+    }
+
+    return sequenceNumbers;
+}
+
+static vector<uint64_t> sequence(uint64_t first, uint64_t last) {
+    vector<uint64_t> sequenceNumbers;
+
+    for (uint64_t i = first; i <= last; i++) {
+        sequenceNumbers.push_back(i);
+    }
+
+    return sequenceNumbers;
+}
+
+// Delivers raw side-by-side YUV frames over a shared buffer when asked, on the calling thread, like a camera's capture thread
+class FakeFrameSource : public FrameSource {
+
+public:
+    void open(Resolution resolution, FrameRate, ColorSpace rawColorSpace) override {
+        CHECK(rawColorSpace == YUV);
+
+        stereoDimensions = StereoDimensions(resolution);
+        buffer.assign(stereoDimensions.width * stereoDimensions.height * 2, 0);
+    }
+
+    void close() override {}
+
+    void start(function<void(Frame)> rawFrameHandler) override {
+        this->rawFrameHandler = std::move(rawFrameHandler);
+    }
+
+    void stop() override {}
+
+    void produce(uint64_t sequenceNumber) {
+        Frame frame = Frame::wrap(buffer.data(), stereoDimensions.height, stereoDimensions.width, 2, stereoDimensions.width * 2, [] {});
+        frame.setTimestamp(steadyClockTimestamp());
+        frame.setSequenceNumber(sequenceNumber);
+
+        rawFrameHandler(std::move(frame));
+    }
+
+private:
+    StereoDimensions stereoDimensions;
+    vector<uint8_t> buffer;
+    function<void(Frame)> rawFrameHandler;
+};
+
+// Sequence numbers of the frames grabbed until none arrives within the timeout
+static vector<uint64_t> grabAll(VideoCapture& videoCapture) {
+    vector<uint64_t> sequenceNumbers;
+
+    while (videoCapture.grab(kGrabTimeout)) {
+        sequenceNumbers.push_back(videoCapture.retrieve().getSequenceNumber());
+    }
+
+    return sequenceNumbers;
+}
+
+#pragma mark - FrameQueue
+
+static void testDropNewestKeepsQueuedFrames() {
+    FrameQueue frameQueue(kQueueCapacity, DROP_NEWEST);
+
+    for (uint64_t i = 0; i < kFrameCount; i++) {
+        CHECK(frameQueue.push(makeFrame(i)) == (i < kQueueCapacity));
+    }
+
+    CHECK(frameQueue.getCount() == kQueueCapacity);
+    CHECK(frameQueue.getDroppedFrameCount() == kFrameCount - kQueueCapacity);
+    CHECK(popAll(frameQueue) == sequence(0, kQueueCapacity - 1));
+}
+
+static void testDropOldestKeepsRecentFrames() {
+    FrameQueue frameQueue(kQueueCapacity, DROP_OLDEST);
+
+    for (uint64_t i = 0; i < kFrameCount; i++) {
+        CHECK(frameQueue.push(makeFrame(i)) == (i < kQueueCapacity));
+    }
+
+    CHECK(frameQueue.getDroppedFrameCount() == kFrameCount - kQueueCapacity);
+    CHECK(popAll(frameQueue) == sequence(kFrameCount - kQueueCapacity, kFrameCount - 1));
+}
+
+static void testLatestOnlyKeepsLatestFrame() {
+    FrameQueue frameQueue(kQueueCapacity, LATEST_ONLY);
+
+    for (uint64_t i = 0; i < kFrameCount; i++) {
+        CHECK(frameQueue.push(makeFrame(i)) == (i == 0));
+    }
+
+    CHECK(frameQueue.getDroppedFrameCount() == kFrameCount - 1);
+    CHECK(popAll(frameQueue) == vector<uint64_t> {kFrameCount - 1});
+
+    // Popped frames aren't counted as dropped
+    CHECK(frameQueue.push(makeFrame(kFrameCount)));
+    CHECK(popAll(frameQueue) == vector<uint64_t> {kFrameCount});
+}
+
+static void testBlockProducerDropsNothing() {
+    FrameQueue frameQueue(2, BLOCK_PRODUCER);
+
+    thread producerThread([&frameQueue] {
+        for (uint64_t i = 0; i < kFrameCount; i++) {
+            CHECK(frameQueue.push(makeFrame(i)));
+        }
+    });
+
+    // The producer fills the queue and waits for the consumer
+    this_thread::sleep_for(kGrabTimeout);
+
+    vector<uint64_t> sequenceNumbers;
+    Frame frame;
+
+    while (frameQueue.pop(frame, kGrabTimeout)) {
+        sequenceNumbers.push_back(frame.getSequenceNumber());
+    }
+
+    producerThread.join();
+
+    CHECK(sequenceNumbers == sequence(0, kFrameCount - 1));
+    CHECK(frameQueue.getDroppedFrameCount() == 0);
+    CHECK(frameQueue.getBlockedPushCount() > 0);
+
+    // Closing releases the producer and refuses further frames
+    frameQueue.close();
+    CHECK(!frameQueue.push(makeFrame(kFrameCount)));
+}
+
+static void testPopWaitsForTimeout() {
+    FrameQueue frameQueue(kQueueCapacity, DROP_NEWEST);
+    Frame frame;
+
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    CHECK(!frameQueue.pop(frame, kGrabTimeout));
+    CHECK(chrono::steady_clock::now() - startTime >= kGrabTimeout);
+
+    // A frame pushed while waiting ends the wait
+    thread producerThread([&frameQueue] {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        frameQueue.push(makeFrame(0));
+    });
+
+    CHECK(frameQueue.pop(frame, chrono::seconds(10)));
+    CHECK(frame.getSequenceNumber() == 0);
+
+    producerThread.join();
+}
+
+#pragma mark - Grab
+
+static void testGrabUnderEachPolicy() {
+    struct Expectation {
+        BackpressurePolicy backpressurePolicy;
+        vector<uint64_t> sequenceNumbers;
+        uint64_t droppedFrameCount;
+    };
+
+    Expectation expectations[] = {
+        {DROP_NEWEST, sequence(0, kQueueCapacity - 1), kFrameCount - kQueueCapacity},
+        {DROP_OLDEST, sequence(kFrameCount - kQueueCapacity, kFrameCount - 1), kFrameCount - kQueueCapacity},
+        {LATEST_ONLY, {kFrameCount - 1}, kFrameCount - 1},
+    };
+
+    for (const Expectation& expectation : expectations) {
+        shared_ptr<FakeFrameSource> frameSource = make_shared<FakeFrameSource>();
+        VideoCapture videoCapture(frameSource);
+        videoCapture.open<VGA, FPS_100>(YUV);
+        videoCapture.start(expectation.backpressurePolicy, kQueueCapacity);
+
+        // Faster than the consumer polls
+        for (uint64_t i = 0; i < kFrameCount; i++) {
+            frameSource->produce(i);
+        }
+
+        CHECK(grabAll(videoCapture) == expectation.sequenceNumbers);
+        CHECK(videoCapture.getDroppedFrameCount() == expectation.droppedFrameCount);
+
+        videoCapture.stop();
+        videoCapture.close();
+    }
+}
+
+static void testGrabBlocksProducer() {
+    shared_ptr<FakeFrameSource> frameSource = make_shared<FakeFrameSource>();
+    VideoCapture videoCapture(frameSource);
+    videoCapture.open<VGA, FPS_100>(YUV);
+    videoCapture.start(BLOCK_PRODUCER, 2);
+
+    thread producerThread([frameSource] {
+        for (uint64_t i = 0; i < kFrameCount; i++) {
+            frameSource->produce(i);
+        }
+    });
+
+    this_thread::sleep_for(kGrabTimeout);
+
+    CHECK(grabAll(videoCapture) == sequence(0, kFrameCount - 1));
+    CHECK(videoCapture.getDroppedFrameCount() == 0);
+    CHECK(videoCapture.getStats().blockedFrameCount > 0);
+
+    producerThread.join();
+    videoCapture.stop();
+    videoCapture.close();
+}
+
+static void testGrabTimesOut() {
+    shared_ptr<FakeFrameSource> frameSource = make_shared<FakeFrameSource>();
+    VideoCapture videoCapture(frameSource);
+    videoCapture.open<VGA, FPS_100>(YUV);
+
+    CHECK_THROWS(videoCapture.grab(kGrabTimeout));
+
+    videoCapture.start(DROP_NEWEST, kQueueCapacity);
+    frameSource->produce(0);
+
+    CHECK(videoCapture.grab(kGrabTimeout));
+    CHECK(videoCapture.retrieve().getSequenceNumber() == 0);
+
+    // Nothing arrives, and the previously grabbed frame is released
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    CHECK(!videoCapture.grab(kGrabTimeout));
+    CHECK(chrono::steady_clock::now() - startTime >= kGrabTimeout);
+    CHECK(!videoCapture.retrieve().isValid());
+
+    videoCapture.stop();
+    videoCapture.close();
+}
+
+int main() {
+    runTest("drop newest keeps queued frames", testDropNewestKeepsQueuedFrames);
+    runTest("drop oldest keeps recent frames", testDropOldestKeepsRecentFrames);
+    runTest("latest only keeps the latest frame", testLatestOnlyKeepsLatestFrame);
+    runTest("block producer drops nothing", testBlockProducerDropsNothing);
+    runTest("pop waits for the timeout", testPopWaitsForTimeout);
+    runTest("grab under each policy", testGrabUnderEachPolicy);
+    runTest("grab blocks the producer", testGrabBlocksProducer);
+    runTest("grab times out", testGrabTimesOut);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+//
+// zed_frame_synchronizer_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_frame_synchronizer.h"
+#include "zed_synthetic_frame_source.h"
+#include "zed_test.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace zed;
+
+//
+// Matching frames from two synthetic sources, restamped on a schedule with a fixed skew, a dropped frame, and a late frame
+//
+
+#define kFrameCount 10
+#define kFrameInterval 33000000 // Nanoseconds
+#define kSourceSkew 2000000     // Second source behind the first, nanoseconds
+#define kTolerance chrono::milliseconds(5)
+#define kDroppedFrameIndex 3 // Never delivered by the second source
+#define kLateFrameIndex 6    // Delivered by the second source 20 ms late
+#define kLateFrameDelay 20000000
+
+static uint64_t scheduledTimestamp(size_t sourceIndex, uint64_t frameIndex) {
+    uint64_t timestamp = 1000000000 + frameIndex * kFrameInterval;
+
+    if (sourceIndex == 1) {
+        timestamp += frameIndex == kLateFrameIndex ? kLateFrameDelay : kSourceSkew;
+    }
+
+    return timestamp;
+}
+
+// Feeds each source's first kFrameCount frames to the synchronizer, frame index by frame index across sources, so the
+// pairing doesn't depend on how the source threads are scheduled
+class LockstepFeeder {
+
+public:
+    LockstepFeeder(FrameSynchronizer& synchronizer) : synchronizer(synchronizer) {}
+
+    function<void(Frame)> sourceHandler(size_t sourceIndex) {
+        return [this, sourceIndex](Frame frame) { feed(sourceIndex, std::move(frame)); };
+    }
+
+    void waitUntilFed() {
+        unique_lock<mutex> lock(feederMutex);
+        fedCondition.wait(lock, [this] { return fedCounts[0] == kFrameCount && fedCounts[1] == kFrameCount; });
+    }
+
+private:
+    FrameSynchronizer& synchronizer;
+
+    mutex feederMutex;
+    condition_variable fedCondition;
+    uint64_t fedCounts[2] = {0, 0};
+
+    void feed(size_t sourceIndex, Frame frame) {
+        uint64_t frameIndex = frame.getSequenceNumber();
+
+        if (frameIndex >= kFrameCount) {
+            return;
+        }
+
+        {
+            unique_lock<mutex> lock(feederMutex);
+            fedCondition.wait(lock, [this, sourceIndex, frameIndex] { return fedCounts[1 - sourceIndex] >= frameIndex; });
+        }
+
+        if (sourceIndex == 0 || frameIndex != kDroppedFrameIndex) {
+            frame.setTimestamp(scheduledTimestamp(sourceIndex, frameIndex));
+            synchronizer.push(sourceIndex, std::move(frame));
+        }
+
+        {
+            lock_guard<mutex> lock(feederMutex);
+            fedCounts[sourceIndex] = frameIndex + 1;
+        }
+
+        fedCondition.notify_all();
+    }
+};
+
+static void testSyntheticSourcesArePaired() {
+    // Frame indices and skew of each set, the handler is called one set at a time
+    vector<pair<uint64_t, uint64_t>> frameIndices;
+    vector<uint64_t> skews;
+
+    FrameSynchronizer synchronizer(2, kTolerance, [&](FrameSet frameSet) {
+        CHECK(frameSet.frames.size() == 2);
+        CHECK(frameSet.timestamp == frameSet.frames[0].getTimestamp());
+
+        frameIndices.push_back({frameSet.frames[0].getSequenceNumber(), frameSet.frames[1].getSequenceNumber()});
+        skews.push_back(frameSet.skew);
+    });
+
+    LockstepFeeder feeder(synchronizer);
+    SyntheticFrameSource sources[2] = {SyntheticFrameSource(MAX_SPEED), SyntheticFrameSource(MAX_SPEED)};
+
+    for (size_t i = 0; i < 2; i++) {
+        sources[i].open(VGA, FPS_100, YUV);
+        sources[i].start(feeder.sourceHandler(i));
+    }
+
+    feeder.waitUntilFed();
+
+    for (SyntheticFrameSource& source : sources) {
+        source.stop();
+        source.close();
+    }
+
+    // Every frame but the dropped and late ones is paired with the one of the same index
+    vector<pair<uint64_t, uint64_t>> expectedFrameIndices;
+
+    for (uint64_t i = 0; i < kFrameCount; i++) {
+        if (i != kDroppedFrameIndex && i != kLateFrameIndex) {
+            expectedFrameIndices.push_back({i, i});
+        }
+    }
+
+    CHECK(frameIndices == expectedFrameIndices);
+    CHECK(all_of(skews.begin(), skews.end(), [](uint64_t skew) { return skew == kSourceSkew; }));
+
+    // The first source's frames left without a partner, and the late frame, are dropped
+    SynchronizationStats stats = synchronizer.getStats();
+    CHECK(stats.frameSetCount == expectedFrameIndices.size());
+    CHECK((stats.unmatchedFrameCounts == vector<uint64_t> {2, 1}));
+    CHECK((stats.meanOffsets == vector<int64_t> {0, kSourceSkew}));
+}
+
+static void testSourceRunningAheadIsBounded() {
+    uint64_t frameSetCount = 0;
+    FrameSynchronizer synchronizer(2, kTolerance, [&](FrameSet) { frameSetCount++; }, 2);
+
+    uint8_t pixels[4];
+
+    // The first source delivers three frames before the second delivers any, the oldest can't wait any longer
+    for (uint64_t i = 0; i < 3; i++) {
+        Frame frame = Frame::wrap(&pixels[i], 1, 1, 1, 1, [] {});
+        frame.setTimestamp(scheduledTimestamp(0, i));
+        synchronizer.push(0, std::move(frame));
+    }
+
+    CHECK((synchronizer.getStats().unmatchedFrameCounts == vector<uint64_t> {1, 0}));
+
+    Frame frame = Frame::wrap(&pixels[3], 1, 1, 1, 1, [] {});
+    frame.setTimestamp(scheduledTimestamp(1, 2));
+    synchronizer.push(1, std::move(frame));
+
+    CHECK(frameSetCount == 1);
+    CHECK((synchronizer.getStats().unmatchedFrameCounts == vector<uint64_t> {2, 0}));
+
+    synchronizer.reset();
+    CHECK(synchronizer.getStats().frameSetCount == 0);
+    CHECK_THROWS(synchronizer.push(2, Frame()));
+}
+
+// A frame over a 1 x 1 buffer, at a source's scheduled timestamp
+static Frame makeFrame(uint8_t* pixel, size_t sourceIndex, uint64_t frameIndex) {
+    Frame frame = Frame::wrap(pixel, 1, 1, 1, 1, [] {});
+    frame.setTimestamp(scheduledTimestamp(sourceIndex, frameIndex));
+    frame.setSequenceNumber(frameIndex);
+
+    return frame;
+}
+
+static void testHandlerCanUseSynchronizer() {
+    FrameSynchronizer* synchronizerPointer = nullptr;
+    uint64_t handledFrameSetCount = 0;
+
+    FrameSynchronizer synchronizer(2, kTolerance, [&](FrameSet) {
+        // Would deadlock if the handler ran under the synchronizer's lock
+        handledFrameSetCount = synchronizerPointer->getStats().frameSetCount;
+        synchronizerPointer->reset();
+    });
+
+    synchronizerPointer = &synchronizer;
+
+    uint8_t pixels[2];
+    synchronizer.push(0, makeFrame(&pixels[0], 0, 0));
+    synchronizer.push(1, makeFrame(&pixels[1], 1, 0));
+
+    CHECK(handledFrameSetCount == 1);
+    CHECK(synchronizer.getStats().frameSetCount == 0);
+}
+
+static void testSlowHandlerDoesNotBlockSources() {
+    promise<void> handlerEntered;
+    promise<void> handlerReleased;
+    shared_future<void> isReleased = handlerReleased.get_future().share();
+    vector<uint64_t> frameIndices;
+
+    FrameSynchronizer synchronizer(2, kTolerance, [&](FrameSet frameSet) {
+        frameIndices.push_back(frameSet.frames[0].getSequenceNumber());
+
+        if (frameIndices.size() == 1) {
+            handlerEntered.set_value();
+            isReleased.wait();
+        }
+    });
+
+    uint8_t pixels[8];
+    synchronizer.push(0, makeFrame(&pixels[0], 0, 0));
+
+    // Completes the first set, and stays in the handler
+    thread deliveringThread([&] { synchronizer.push(1, makeFrame(&pixels[1], 1, 0)); });
+    handlerEntered.get_future().wait();
+
+    // Later sets are matched without waiting for the handler, the oldest is dropped once more than the buffer capacity wait
+    for (uint64_t i = 1; i <= 3; i++) {
+        synchronizer.push(0, makeFrame(&pixels[2 * i], 0, i));
+        synchronizer.push(1, makeFrame(&pixels[2 * i + 1], 1, i));
+    }
+
+    CHECK(synchronizer.getStats().frameSetCount == 4);
+    CHECK(frameIndices.size() == 1);
+
+    // The delivering thread hands over the sets that completed meanwhile, in capture order
+    handlerReleased.set_value();
+    deliveringThread.join();
+
+    CHECK((frameIndices == vector<uint64_t> {0, 2, 3}));
+    CHECK(synchronizer.getStats().droppedFrameSetCount == 1);
+}
+
+int main() {
+    runTest("synthetic sources are paired", testSyntheticSourcesArePaired);
+    runTest("source running ahead is bounded", testSourceRunningAheadIsBounded);
+    runTest("handler can use the synchronizer", testHandlerCanUseSynchronizer);
+    runTest("slow handler does not block sources", testSlowHandlerDoesNotBlockSources);
+
+    return EXIT_SUCCESS;
+}
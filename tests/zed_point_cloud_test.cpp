@@ -0,0 +1,181 @@
+//
+// zed_point_cloud_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_point_cloud.h"
+#include "zed_stereo_matcher.h"
+#include "zed_test.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace zed;
+
+//
+// Depth and point clouds from a disparity map with invalid, zero, and far disparities, against the pinhole model,
+// and the vector paths against the scalar one
+//
+
+#define kWidth 203 // Not a multiple of any vector length
+#define kHeight 61
+#define kFocalLength 350.0
+#define kCenterX 101.5
+#define kCenterY 30.25
+#define kBaseline 120.0 // Millimeters
+#define kMaxDepth 3.0f
+#define kThreadCount 3
+
+static vector<int16_t> syntheticDisparity() {
+    vector<int16_t> disparity(kWidth * kHeight);
+
+    for (size_t i = 0; i < disparity.size(); i++) {
+        uint32_t value = (uint32_t(i) * 2654435761u) >> 20 & 1023;
+        disparity[i] = value < 100 ? kInvalidDisparity : value < 150 ? 0 : int16_t(value * 8);
+    }
+
+    return disparity;
+}
+
+static bool isNear(float value, double expectedValue) {
+    return fabs(value - expectedValue) <= 1e-5 * max(1.0, fabs(expectedValue));
+}
+
+// Whether two float arrays hold the same bits, NaN included
+static bool hasSameBits(const float* values, const float* otherValues, size_t count) {
+    return memcmp(values, otherValues, count * sizeof(float)) == 0;
+}
+
+#pragma mark - Depth
+
+static void testDepthMatchesPinholeModel() {
+    vector<int16_t> disparity = syntheticDisparity();
+    DepthReprojector depthReprojector(kFocalLength, kCenterX, kCenterY, kBaseline, kThreadCount);
+
+    vector<float> depth(kWidth * kHeight);
+    depthReprojector.computeDepth(disparity.data(), kWidth * sizeof(int16_t), kHeight, kWidth, depth.data(), kWidth * sizeof(float), kMaxDepth);
+
+    for (size_t i = 0; i < depth.size(); i++) {
+        double pixelDisparity = double(disparity[i]) / (1 << kDisparityFractionBits);
+        double expectedDepth = kFocalLength * kBaseline / 1000 / pixelDisparity;
+
+        if (disparity[i] <= 0 || expectedDepth > kMaxDepth) {
+            CHECK(isnan(depth[i]));
+        }
+        else {
+            CHECK(isNear(depth[i], expectedDepth));
+        }
+    }
+}
+
+static void testPointCloudMatchesPinholeModel() {
+    vector<int16_t> disparity = syntheticDisparity();
+    DepthReprojector depthReprojector(kFocalLength, kCenterX, kCenterY, kBaseline, kThreadCount);
+
+    PointCloud denseCloud;
+    depthReprojector.computePointCloud(disparity.data(), kWidth * sizeof(int16_t), kHeight, kWidth, denseCloud);
+
+    CHECK(denseCloud.count == kWidth * kHeight);
+
+    for (size_t row = 0; row < kHeight; row++) {
+        for (size_t column = 0; column < kWidth; column++) {
+            size_t i = row * kWidth + column;
+
+            if (disparity[i] <= 0) {
+                CHECK(isnan(denseCloud.x[i]) && isnan(denseCloud.y[i]) && isnan(denseCloud.z[i]));
+                continue;
+            }
+
+            double z = kFocalLength * kBaseline / 1000 / (double(disparity[i]) / (1 << kDisparityFractionBits));
+
+            CHECK(isNear(denseCloud.z[i], z));
+            CHECK(isNear(denseCloud.x[i], (column - kCenterX) * z / kFocalLength));
+            CHECK(isNear(denseCloud.y[i], (row - kCenterY) * z / kFocalLength));
+        }
+    }
+
+    // Compact clouds hold the dense cloud's valid points within the maximum depth, in order
+    ReprojectionSettings settings;
+    settings.maxDepth = kMaxDepth;
+    settings.isCompact = true;
+    settings.hasPixelIndices = true;
+
+    PointCloud compactCloud;
+    depthReprojector.computePointCloud(disparity.data(), kWidth * sizeof(int16_t), kHeight, kWidth, compactCloud, settings);
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < kWidth * kHeight; i++) {
+        if (denseCloud.z[i] <= kMaxDepth) {
+            CHECK(compactCloud.pixelIndices[count] == i);
+            CHECK(compactCloud.x[count] == denseCloud.x[i]);
+            CHECK(compactCloud.y[count] == denseCloud.y[i]);
+            CHECK(compactCloud.z[count] == denseCloud.z[i]);
+            count++;
+        }
+    }
+
+    CHECK(compactCloud.count == count);
+}
+
+#pragma mark - Instruction Sets
+
+static void testVectorReprojectionMatchesScalar() {
+    vector<int16_t> disparity = syntheticDisparity();
+    size_t disparityRowBytes = kWidth * sizeof(int16_t);
+
+    ReprojectionSettings compactSettings;
+    compactSettings.maxDepth = kMaxDepth;
+    compactSettings.isCompact = true;
+    compactSettings.hasPixelIndices = true;
+
+    DepthReprojector scalarReprojector(kFocalLength, kCenterX, kCenterY, kBaseline, 1, SCALAR);
+
+    vector<float> expectedDepth(kWidth * kHeight);
+    PointCloud expectedDenseCloud;
+    PointCloud expectedCompactCloud;
+    scalarReprojector.computeDepth(disparity.data(), disparityRowBytes, kHeight, kWidth, expectedDepth.data(), kWidth * sizeof(float), kMaxDepth);
+    scalarReprojector.computePointCloud(disparity.data(), disparityRowBytes, kHeight, kWidth, expectedDenseCloud);
+    scalarReprojector.computePointCloud(disparity.data(), disparityRowBytes, kHeight, kWidth, expectedCompactCloud, compactSettings);
+
+    for (InstructionSet instructionSet : {SCALAR, SSE4, AVX2, NEON}) {
+        if (!ColorConverter::isSupported(instructionSet)) {
+            continue;
+        }
+
+        for (size_t threadCount : {1, kThreadCount}) {
+            DepthReprojector depthReprojector(kFocalLength, kCenterX, kCenterY, kBaseline, threadCount, instructionSet);
+
+            vector<float> depth(kWidth * kHeight);
+            depthReprojector.computeDepth(disparity.data(), disparityRowBytes, kHeight, kWidth, depth.data(), kWidth * sizeof(float), kMaxDepth);
+            CHECK(hasSameBits(depth.data(), expectedDepth.data(), depth.size()));
+
+            PointCloud denseCloud;
+            depthReprojector.computePointCloud(disparity.data(), disparityRowBytes, kHeight, kWidth, denseCloud);
+            CHECK(denseCloud.count == expectedDenseCloud.count);
+            CHECK(hasSameBits(denseCloud.x.data(), expectedDenseCloud.x.data(), denseCloud.count));
+            CHECK(hasSameBits(denseCloud.y.data(), expectedDenseCloud.y.data(), denseCloud.count));
+            CHECK(hasSameBits(denseCloud.z.data(), expectedDenseCloud.z.data(), denseCloud.count));
+
+            PointCloud compactCloud;
+            depthReprojector.computePointCloud(disparity.data(), disparityRowBytes, kHeight, kWidth, compactCloud, compactSettings);
+            CHECK(compactCloud.count == expectedCompactCloud.count);
+            CHECK(hasSameBits(compactCloud.x.data(), expectedCompactCloud.x.data(), compactCloud.count));
+            CHECK(hasSameBits(compactCloud.y.data(), expectedCompactCloud.y.data(), compactCloud.count));
+            CHECK(hasSameBits(compactCloud.z.data(), expectedCompactCloud.z.data(), compactCloud.count));
+            CHECK(equal(compactCloud.pixelIndices.begin(), compactCloud.pixelIndices.begin() + compactCloud.count, expectedCompactCloud.pixelIndices.begin()));
+        }
+    }
+}
+
+int main() {
+    runTest("depth matches the pinhole model", testDepthMatchesPinholeModel);
+    runTest("point cloud matches the pinhole model", testPointCloudMatchesPinholeModel);
+    runTest("vector reprojection matches scalar", testVectorReprojectionMatchesScalar);
+
+    return EXIT_SUCCESS;
+}
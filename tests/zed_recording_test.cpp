@@ -0,0 +1,68 @@
+//
+// zed_recording_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_recording.h"
+#include "zed_test.h"
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+using namespace zed;
+
+//
+// Recording frames that the source lends from a small pool of its own
+//
+
+#define kFrameCount 24
+
+static void testRecordingReleasesSourceBuffers() {
+    TemporaryDirectory directory;
+    path filepath = directory.getPath() / "test.zedrec";
+
+    StereoDimensions stereoDimensions(VGA);
+    size_t rowBytes = stereoDimensions.width * 2;
+    vector<uint8_t> buffer(rowBytes * stereoDimensions.height);
+    atomic<size_t> releasedFrameCount = 0;
+
+    {
+        RecordingWriter recordingWriter(filepath, stereoDimensions, YUV, FPS_100, kFrameCount);
+
+        for (uint64_t i = 0; i < kFrameCount; i++) {
+            buffer.assign(buffer.size(), uint8_t(i));
+
+            Frame frame = Frame::wrap(buffer.data(), stereoDimensions.height, stereoDimensions.width, 2, rowBytes, [&] { releasedFrameCount++; });
+            frame.setTimestamp(1000 * (i + 1));
+
+            recordingWriter.record(frame);
+            frame.release();
+
+            // The source gets its buffer back as soon as the frame is recorded, whether or not it's been written yet
+            CHECK(releasedFrameCount == i + 1);
+        }
+
+        recordingWriter.finish();
+
+        CHECK(recordingWriter.getRecordedFrameCount() + recordingWriter.getDroppedFrameCount() == kFrameCount);
+    }
+
+    // Recorded frames hold the contents they had when recorded, not the reused buffer's
+    RecordingReader recordingReader(filepath);
+
+    for (size_t i = 0; i < recordingReader.getFrameCount(); i++) {
+        Frame frame = recordingReader.getFrame(i);
+        uint64_t frameIndex = frame.getTimestamp() / 1000 - 1;
+
+        CHECK(frame.getData()[0] == uint8_t(frameIndex));
+        CHECK(frame.getData()[frame.getRowBytes() * (frame.getHeight() - 1) + rowBytes - 1] == uint8_t(frameIndex));
+    }
+}
+
+int main() {
+    runTest("recording releases source buffers", testRecordingReleasesSourceBuffers);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+//
+// zed_sensor_data_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_sensor_data.h"
+#include "zed_sensor_ring.h"
+#include "zed_test.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace zed;
+
+//
+// Sensor report decoding, the sample ring, and matching the IMU to frame timestamps, fed with synthetic reports
+//
+
+#define kReportTicks 64                 // 2.5 ms between reports (400 Hz)
+#define kReportInterval 2500000         // Nanoseconds
+#define kArrivalTimestamp 1000000000000 // Steady clock when the MCU clock reads 0, nanoseconds
+
+static bool isNear(float value, float expectedValue) {
+    return fabs(value - expectedValue) < 1e-3f;
+}
+
+// A report with a valid IMU reading, no new magnetometer or environment reading, and every temperature unavailable
+static SensorReport makeSensorReport(uint64_t ticks) {
+    SensorReport sensorReport;
+    memset(&sensorReport, 0, sizeof(SensorReport));
+
+    sensorReport.reportID = kSensorReportID;
+    sensorReport.timestamp = ticks;
+    sensorReport.imuTemperature = kInvalidTemperature;
+    sensorReport.magnetometerStatus = SENSOR_OLD_VALUE;
+    sensorReport.environmentStatus = SENSOR_OLD_VALUE;
+    sensorReport.temperature = kInvalidTemperature;
+    sensorReport.leftCameraTemperature = kInvalidTemperature;
+    sensorReport.rightCameraTemperature = kInvalidTemperature;
+
+    return sensorReport;
+}
+
+static bool decode(SensorReportDecoder& decoder, const SensorReport& sensorReport, uint64_t arrivalTimestamp, DecodedSensorReport& decodedReport) {
+    uint8_t bytes[sizeof(SensorReport)];
+    memcpy(bytes, &sensorReport, sizeof(SensorReport));
+
+    return decoder.decode(bytes, sizeof(bytes), arrivalTimestamp, decodedReport);
+}
+
+static IMUSample makeIMUSample(uint64_t timestamp, float acceleration) {
+    IMUSample imuSample = {};
+    imuSample.timestamp = timestamp;
+    imuSample.acceleration[0] = acceleration;
+
+    return imuSample;
+}
+
+static Frame makeFrame(uint8_t* pixel, uint64_t timestamp) {
+    Frame frame = Frame::wrap(pixel, 1, 1, 1, 1, [] {});
+    frame.setTimestamp(timestamp);
+
+    return frame;
+}
+
+#pragma mark - Decoding
+
+static void testWireReportDecodes() {
+    // A 64-byte HID report as the camera sends it, field by field at its wire offset
+    const uint8_t report[64] = {
+        0x01,                                           // 0: report ID
+        0x00,                                           // 1: IMU valid
+        0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 2: 64 ticks
+        0x00, 0x00, 0x33, 0xf3, 0x00, 0x00,             // 10: gyroscope (0, -3277, 0)
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x10,             // 16: accelerometer (0, 0, 4096)
+        0x01,                                           // 22: frame sync
+        0x01,                                           // 23: sync capabilities
+        0x05, 0x00, 0x00, 0x00,                         // 24: frame sync count
+        0xd0, 0x09,                                     // 28: IMU temperature (2512)
+        0x02,                                           // 30: magnetometer status (new)
+        0x20, 0x03, 0x00, 0x00, 0x00, 0x00,             // 31: magnetometer (800, 0, 0)
+        0x00, 0x00, 0x00, 0x00, 0x00,                   // 37: moving, moving count
+        0x00, 0x00, 0x00, 0x00, 0x00,                   // 42: falling, falling count
+        0x02,                                           // 47: environment status (new)
+        0x34, 0x08,                                     // 48: temperature (2100)
+        0x14, 0x9c, 0x9a, 0x00,                         // 50: pressure (10132500)
+        0xc6, 0x11, 0x00, 0x00,                         // 54: humidity (4550)
+        0xb8, 0x0b,                                     // 58: left camera temperature (3000)
+        0x4d, 0x95,                                     // 60: right camera temperature (unavailable)
+        0x00, 0x00                                      // 62: padding
+    };
+
+    SensorReportDecoder decoder;
+    DecodedSensorReport decodedReport;
+
+    CHECK(decoder.decode(report, sizeof(report), kArrivalTimestamp, decodedReport));
+    CHECK(decodedReport.deviceTimestamp == kReportInterval);
+
+    CHECK(decodedReport.hasIMUSample);
+    CHECK(isNear(decodedReport.imuSample.acceleration[2], 9.8189f));
+    CHECK(fabs(decodedReport.imuSample.angularVelocity[1] + 100) < 0.01f);
+    CHECK(isNear(decodedReport.imuSample.temperature, 25.12f));
+    CHECK(decodedReport.imuSample.isFrameSync);
+
+    CHECK(decodedReport.hasMagnetometerSample);
+    CHECK(isNear(decodedReport.magnetometerSample.magneticField[0], 50));
+
+    CHECK(decodedReport.hasEnvironmentSample);
+    CHECK(isNear(decodedReport.environmentSample.temperature, 21));
+    CHECK(isNear(decodedReport.environmentSample.pressure, 1013.25f));
+    CHECK(isNear(decodedReport.environmentSample.humidity, 45.5f));
+    CHECK(isNear(decodedReport.environmentSample.leftCameraTemperature, 30));
+    CHECK(isnan(decodedReport.environmentSample.rightCameraTemperature));
+
+    // The same report without its padding
+    CHECK(decoder.decode(report, 62, kArrivalTimestamp, decodedReport));
+}
+
+static void testReportDecodesToCalibratedUnits() {
+    SensorReportDecoder decoder;
+    DecodedSensorReport decodedReport;
+
+    SensorReport sensorReport = makeSensorReport(kReportTicks);
+    sensorReport.accelerometer[2] = 4096;
+    sensorReport.gyroscope[1] = -3277;
+    sensorReport.imuTemperature = 2512;
+    sensorReport.isFrameSync = 1;
+    sensorReport.magnetometerStatus = SENSOR_NEW_VALUE;
+    sensorReport.magnetometer[0] = 800;
+    sensorReport.environmentStatus = SENSOR_NEW_VALUE;
+    sensorReport.temperature = 2100;
+    sensorReport.pressure = 10132500;
+    sensorReport.humidity = 4550;
+
+    CHECK(decode(decoder, sensorReport, kArrivalTimestamp, decodedReport));
+    CHECK(decodedReport.deviceTimestamp == kReportInterval);
+
+    const IMUSample& imuSample = decodedReport.imuSample;
+    CHECK(decodedReport.hasIMUSample);
+    CHECK(imuSample.timestamp == kArrivalTimestamp);
+    CHECK(isNear(imuSample.acceleration[2], 9.8189f));
+    CHECK(isNear(imuSample.acceleration[0], 0));
+    CHECK(fabs(imuSample.angularVelocity[1] + 100) < 0.01f);
+    CHECK(isNear(imuSample.temperature, 25.12f));
+    CHECK(imuSample.isFrameSync);
+    CHECK(!imuSample.isInterpolated);
+
+    CHECK(decodedReport.hasMagnetometerSample);
+    CHECK(isNear(decodedReport.magnetometerSample.magneticField[0], 50));
+
+    const EnvironmentSample& environmentSample = decodedReport.environmentSample;
+    CHECK(decodedReport.hasEnvironmentSample);
+    CHECK(isNear(environmentSample.temperature, 21));
+    CHECK(isNear(environmentSample.pressure, 1013.25f));
+    CHECK(isNear(environmentSample.humidity, 45.5f));
+    CHECK(isnan(environmentSample.leftCameraTemperature));
+    CHECK(isnan(environmentSample.rightCameraTemperature));
+}
+
+static void testStaleAndInvalidReadingsAreSkipped() {
+    SensorReportDecoder decoder;
+    DecodedSensorReport decodedReport;
+
+    SensorReport sensorReport = makeSensorReport(kReportTicks);
+    sensorReport.isIMUInvalid = 1;
+
+    CHECK(decode(decoder, sensorReport, kArrivalTimestamp, decodedReport));
+    CHECK(!decodedReport.hasIMUSample);
+    CHECK(!decodedReport.hasMagnetometerSample);
+    CHECK(!decodedReport.hasEnvironmentSample);
+
+    // Other reports, and truncated ones, aren't sensor reports
+    uint8_t bytes[sizeof(SensorReport)];
+    memcpy(bytes, &sensorReport, sizeof(SensorReport));
+    CHECK(!decoder.decode(bytes, sizeof(bytes) - 1, kArrivalTimestamp, decodedReport));
+
+    bytes[0] = kSensorReportID + 1;
+    CHECK(!decoder.decode(bytes, sizeof(bytes), kArrivalTimestamp, decodedReport));
+}
+
+static void testLegacyFirmwareScales() {
+    SensorReportDecoder decoder(true);
+    DecodedSensorReport decodedReport;
+
+    SensorReport sensorReport = makeSensorReport(kReportTicks);
+    sensorReport.environmentStatus = SENSOR_NEW_VALUE;
+    sensorReport.pressure = 101325;
+    sensorReport.humidity = 46592;
+
+    CHECK(decode(decoder, sensorReport, kArrivalTimestamp, decodedReport));
+    CHECK(isNear(decodedReport.environmentSample.pressure, 1013.25f));
+    CHECK(isNear(decodedReport.environmentSample.humidity, 45.5f));
+}
+
+static void testTimestampsFollowLeastDelayedReport() {
+    SensorReportDecoder decoder;
+    DecodedSensorReport decodedReport;
+
+    // Arrival delays of 3 ms, then 1 ms, then 5 ms
+    int64_t delays[3] = {3000000, 1000000, 5000000};
+    uint64_t timestamps[3];
+
+    for (size_t i = 0; i < 3; i++) {
+        uint64_t deviceTimestamp = (i + 1) * kReportInterval;
+        CHECK(decode(decoder, makeSensorReport((i + 1) * kReportTicks), kArrivalTimestamp + deviceTimestamp + delays[i], decodedReport));
+        timestamps[i] = decodedReport.imuSample.timestamp;
+    }
+
+    CHECK(timestamps[0] == kArrivalTimestamp + 1 * kReportInterval + 3000000);
+    CHECK(timestamps[1] == kArrivalTimestamp + 2 * kReportInterval + 1000000);
+
+    // A late report only moves the mapping by the allowed drift
+    CHECK(timestamps[2] == kArrivalTimestamp + 3 * kReportInterval + 1000000 + kSensorClockDriftPerReport);
+
+    // A restarted MCU clock starts a new mapping
+    CHECK(decode(decoder, makeSensorReport(kReportTicks), kArrivalTimestamp + 7000000, decodedReport));
+    CHECK(decodedReport.imuSample.timestamp == kArrivalTimestamp + 7000000);
+}
+
+#pragma mark - Ring
+
+struct TestSample {
+    uint64_t timestamp;
+    uint64_t value;
+};
+
+static void testRingWrapsAroundAndOverwrites() {
+    SensorRing<TestSample> ring(5);
+    CHECK(ring.getCapacity() == 8);
+    CHECK_THROWS(SensorRing<TestSample>(0));
+
+    TestSample sample;
+    CHECK(!ring.readLatest(sample));
+    CHECK(ring.lowerBound(0) == 0);
+
+    for (uint64_t i = 0; i < 20; i++) {
+        ring.push({.timestamp = 100 + 10 * i, .value = i});
+    }
+
+    CHECK(ring.getWriteCount() == 20);
+    CHECK(ring.readLatest(sample) && sample.value == 19);
+
+    // Only the latest 8 are held, in the slots of the ones they overwrote
+    CHECK(!ring.read(11, sample));
+    CHECK(ring.read(12, sample) && sample.value == 12 && sample.timestamp == 220);
+    CHECK(ring.read(19, sample) && sample.value == 19);
+    CHECK(!ring.read(20, sample));
+
+    // Searches never land before the oldest held sample
+    CHECK(ring.lowerBound(0) == 12);
+    CHECK(ring.lowerBound(250) == 15);
+    CHECK(ring.lowerBound(251) == 16);
+    CHECK(ring.lowerBound(291) == 20);
+}
+
+#pragma mark - Frame Sync
+
+static void testIMUIsMatchedToTimestamps() {
+    SensorStream sensorStream(16);
+
+    for (uint64_t i = 0; i < 8; i++) {
+        sensorStream.pushIMUSample(makeIMUSample(1000 * (i + 1), float(i)));
+    }
+
+    // Out of order samples are dropped
+    sensorStream.pushIMUSample(makeIMUSample(2500, 100));
+
+    IMUSample imuSample;
+    CHECK(sensorStream.getIMUSample(3000, imuSample));
+    CHECK(imuSample.timestamp == 3000 && imuSample.acceleration[0] == 2 && !imuSample.isInterpolated);
+
+    CHECK(sensorStream.getIMUSample(3250, imuSample));
+    CHECK(imuSample.timestamp == 3250 && isNear(imuSample.acceleration[0], 2.25f) && imuSample.isInterpolated);
+
+    // Nothing to interpolate from before the first sample or after the latest
+    CHECK(!sensorStream.getIMUSample(999, imuSample));
+    CHECK(!sensorStream.getIMUSample(8001, imuSample));
+}
+
+static void testIMUBetweenFrames() {
+    SensorStream sensorStream(16);
+    sensorStream.setExposureOffset(500);
+
+    for (uint64_t i = 0; i < 8; i++) {
+        sensorStream.pushIMUSample(makeIMUSample(1000 * (i + 1), float(i)));
+    }
+
+    // Exposures at 2250 and 4750
+    uint8_t pixels[2];
+    Frame previousFrame = makeFrame(&pixels[0], 2750);
+    Frame frame = makeFrame(&pixels[1], 5250);
+
+    vector<IMUSample> imuSamples;
+    CHECK(sensorStream.getIMUSamples(previousFrame, frame, imuSamples));
+    CHECK(imuSamples.size() == 4);
+    CHECK(imuSamples[0].timestamp == 2250 && isNear(imuSamples[0].acceleration[0], 1.25f) && imuSamples[0].isInterpolated);
+    CHECK(imuSamples[1].timestamp == 3000 && !imuSamples[1].isInterpolated);
+    CHECK(imuSamples[2].timestamp == 4000 && !imuSamples[2].isInterpolated);
+    CHECK(imuSamples[3].timestamp == 4750 && isNear(imuSamples[3].acceleration[0], 3.75f) && imuSamples[3].isInterpolated);
+
+    // The IMU hasn't reached the second exposure yet
+    Frame laterFrame = makeFrame(&pixels[1], 9000);
+    CHECK(!sensorStream.getIMUSamples(previousFrame, laterFrame, imuSamples));
+    CHECK(imuSamples.size() == 7 && imuSamples.back().timestamp == 8000);
+
+    // Its start has been overwritten
+    for (uint64_t i = 8; i < 24; i++) {
+        sensorStream.pushIMUSample(makeIMUSample(1000 * (i + 1), float(i)));
+    }
+
+    CHECK(!sensorStream.getIMUSamples(previousFrame, frame, imuSamples));
+}
+
+static void testReportsArePublished() {
+    SensorStream sensorStream(16);
+
+    for (uint64_t i = 1; i <= 3; i++) {
+        SensorReport sensorReport = makeSensorReport(i * kReportTicks);
+        sensorReport.accelerometer[0] = int16_t(i * 4096);
+        sensorReport.magnetometerStatus = i == 2 ? SENSOR_NEW_VALUE : SENSOR_OLD_VALUE;
+
+        uint8_t bytes[sizeof(SensorReport)];
+        memcpy(bytes, &sensorReport, sizeof(SensorReport));
+        CHECK(sensorStream.pushReport(bytes, sizeof(bytes), kArrivalTimestamp + i * kReportInterval));
+    }
+
+    uint8_t invalidReport[4] = {0};
+    CHECK(!sensorStream.pushReport(invalidReport, sizeof(invalidReport), kArrivalTimestamp));
+
+    CHECK(sensorStream.getReportCount() == 3);
+    CHECK(sensorStream.getInvalidReportCount() == 1);
+
+    IMUSample imuSample;
+    CHECK(sensorStream.getLatestIMUSample(imuSample));
+    CHECK(imuSample.timestamp == kArrivalTimestamp + 3 * kReportInterval && isNear(imuSample.acceleration[0], 3 * 9.8189f));
+
+    MagnetometerSample magnetometerSample;
+    CHECK(sensorStream.getLatestMagnetometerSample(magnetometerSample));
+    CHECK(magnetometerSample.timestamp == kArrivalTimestamp + 2 * kReportInterval);
+
+    EnvironmentSample environmentSample;
+    CHECK(!sensorStream.getLatestEnvironmentSample(environmentSample));
+}
+
+int main() {
+    runTest("wire report decodes", testWireReportDecodes);
+    runTest("report decodes to calibrated units", testReportDecodesToCalibratedUnits);
+    runTest("stale and invalid readings are skipped", testStaleAndInvalidReadingsAreSkipped);
+    runTest("legacy firmware scales", testLegacyFirmwareScales);
+    runTest("timestamps follow the least delayed report", testTimestampsFollowLeastDelayedReport);
+    runTest("ring wraps around and overwrites", testRingWrapsAroundAndOverwrites);
+    runTest("IMU is matched to timestamps", testIMUIsMatchedToTimestamps);
+    runTest("IMU between frames", testIMUBetweenFrames);
+    runTest("reports are published", testReportsArePublished);
+
+    return EXIT_SUCCESS;
+}
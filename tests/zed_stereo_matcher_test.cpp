@@ -0,0 +1,146 @@
+//
+// zed_stereo_matcher_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_stereo_matcher.h"
+#include "zed_test.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace zed;
+
+//
+// Disparity of a random texture shifted by a known amount, and the vector paths against the scalar one
+//
+
+#define kWidth 320
+#define kHeight 96
+#define kShift 25 // Pixels the right image is shifted by
+#define kThreadCount 3
+
+struct StereoPair {
+    vector<uint8_t> left;
+    vector<uint8_t> right;
+};
+
+// A random texture, and the same texture seen from kShift pixels to the right
+static StereoPair shiftedPair() {
+    mt19937 generator(1);
+    StereoPair stereoPair = {vector<uint8_t>(kWidth * kHeight), vector<uint8_t>(kWidth * kHeight)};
+
+    for (uint8_t& pixel : stereoPair.left) {
+        pixel = uint8_t(generator());
+    }
+
+    for (size_t row = 0; row < kHeight; row++) {
+        for (size_t column = 0; column < kWidth; column++) {
+            stereoPair.right[row * kWidth + column] = stereoPair.left[row * kWidth + min<size_t>(column + kShift, kWidth - 1)];
+        }
+    }
+
+    return stereoPair;
+}
+
+static vector<int16_t> computeDisparity(const StereoPair& stereoPair, StereoMatcherSettings settings, size_t threadCount, InstructionSet instructionSet) {
+    StereoMatcher stereoMatcher(settings, threadCount, instructionSet);
+    vector<int16_t> disparity(kWidth * kHeight);
+
+    stereoMatcher.compute(
+        stereoPair.left.data(), kWidth, stereoPair.right.data(), kWidth, kHeight, kWidth, disparity.data(), kWidth * sizeof(int16_t));
+
+    return disparity;
+}
+
+// Every combination of mode and matching cost, with and without subpixel refinement and a negative minimum disparity
+static vector<StereoMatcherSettings> settingsVariants() {
+    vector<StereoMatcherSettings> variants;
+
+    for (StereoMatchingMode mode : {BLOCK_MATCHING, SEMI_GLOBAL}) {
+        for (MatchingCost matchingCost : {CENSUS, ABSOLUTE_DIFFERENCE}) {
+            StereoMatcherSettings settings;
+            settings.mode = mode;
+            settings.matchingCost = matchingCost;
+            variants.push_back(settings);
+
+            settings.minDisparity = -8;
+            settings.disparityCount = 48;
+            settings.isSubpixel = false;
+            variants.push_back(settings);
+        }
+    }
+
+    return variants;
+}
+
+#pragma mark - Disparity
+
+static void testShiftIsRecovered() {
+    StereoPair stereoPair = shiftedPair();
+
+    for (const StereoMatcherSettings& settings : settingsVariants()) {
+        vector<int16_t> disparity = computeDisparity(stereoPair, settings, kThreadCount, ColorConverter::detectInstructionSet());
+
+        // Away from the borders, where the shifted texture is unique
+        size_t pixelCount = 0;
+        size_t matchedPixelCount = 0;
+
+        for (size_t row = 8; row < kHeight - 8; row++) {
+            for (size_t column = 80; column < kWidth - 40; column++) {
+                pixelCount++;
+                matchedPixelCount += abs(disparity[row * kWidth + column] - (kShift << kDisparityFractionBits)) <= 8;
+            }
+        }
+
+        CHECK(matchedPixelCount >= pixelCount * 95 / 100);
+    }
+}
+
+static void testVectorMatchingMatchesScalar() {
+    StereoPair stereoPair = shiftedPair();
+
+    for (const StereoMatcherSettings& settings : settingsVariants()) {
+        for (size_t threadCount : {1, kThreadCount}) {
+            vector<int16_t> expected = computeDisparity(stereoPair, settings, threadCount, SCALAR);
+
+            for (InstructionSet instructionSet : {SSE4, AVX2, NEON}) {
+                if (ColorConverter::isSupported(instructionSet)) {
+                    CHECK(computeDisparity(stereoPair, settings, threadCount, instructionSet) == expected);
+                }
+            }
+        }
+    }
+}
+
+static void testBlockMatchingIgnoresBands() {
+    StereoPair stereoPair = shiftedPair();
+
+    // Semi-global paths from above restart before each band, block matching windows don't depend on the bands
+    for (const StereoMatcherSettings& settings : settingsVariants()) {
+        if (settings.mode == BLOCK_MATCHING) {
+            CHECK(computeDisparity(stereoPair, settings, kThreadCount, SCALAR) == computeDisparity(stereoPair, settings, 1, SCALAR));
+        }
+    }
+}
+
+static void testInvalidSettingsThrow() {
+    StereoMatcherSettings settings;
+    settings.disparityCount = 40;
+    CHECK_THROWS(StereoMatcher matcher(settings));
+
+    settings = StereoMatcherSettings();
+    settings.blockSize = 8;
+    CHECK_THROWS(StereoMatcher matcher(settings));
+}
+
+int main() {
+    runTest("shift is recovered", testShiftIsRecovered);
+    runTest("vector matching matches scalar", testVectorMatchingMatchesScalar);
+    runTest("block matching ignores bands", testBlockMatchingIgnoresBands);
+    runTest("invalid settings throw", testInvalidSettingsThrow);
+
+    return EXIT_SUCCESS;
+}
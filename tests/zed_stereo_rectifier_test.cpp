@@ -0,0 +1,181 @@
+//
+// zed_stereo_rectifier_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_calibration_data.h"
+#include "zed_color_conversion.h"
+#include "zed_stereo_rectifier.h"
+#include "zed_test.h"
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace zed;
+
+//
+// Rectification of a fixed calibration, checked against OpenCV, and the fused YUV path checked against conversion followed by rectification
+//
+
+// Calibration file contents with every resolution, the same as the benchmarks'
+static string syntheticCalibration() {
+    string contents;
+
+    for (int resolution = HD2K; resolution <= VGA; resolution++) {
+        StereoDimensions stereoDimensions = StereoDimensions(Resolution(resolution));
+        double scale = stereoDimensions.height / 376.0;
+        string suffix = array<string, 4> {"2K", "FHD", "HD", "VGA"}[resolution];
+
+        for (const char* camera : {"LEFT", "RIGHT"}) {
+            contents += format("[{}_CAM_{}]\n", camera, suffix);
+            contents += format("fx={}\nfy={}\n", 348.5 * scale, 348.4 * scale);
+            contents += format("cx={}\ncy={}\n", stereoDimensions.width / 4.0 + 1.5, stereoDimensions.height / 2.0 - 1.25);
+            contents += "k1=-0.171\nk2=0.0262\np1=0.0003\np2=-0.0002\nk3=0.0001\n\n";
+        }
+    }
+
+    contents += "[STEREO]\nBaseline=119.9\nTY=0.3\nTZ=-0.5\n";
+
+    for (const char* suffix : {"2K", "FHD", "HD", "VGA"}) {
+        contents += format("CV_{}=0.004\nRX_{}=0.002\nRZ_{}=-0.0015\n", suffix, suffix, suffix);
+    }
+
+    contents += "\n[MISC]\nSensor_ID=0\n";
+
+    return contents;
+}
+
+// Within OpenCV's single precision intermediates
+static bool isNear(double value, double expectedValue) {
+    return fabs(value - expectedValue) <= 1e-5 * max(1.0, fabs(expectedValue));
+}
+
+#pragma mark - Matrices
+
+// OpenCV 4.11's stereoRectify (CALIB_ZERO_DISPARITY, alpha = 0) of the same calibration, as examples/calibration.cpp computed it
+struct ExpectedMatrices {
+    Resolution resolution;
+    double focalLength;
+    double centerX;
+    double centerY;
+    double baselineTerm;    // P2[0][3]
+    double inverseBaseline; // Q[3][2]
+};
+
+static void testMatricesMatchOpenCV() {
+    CalibrationData calibrationData;
+    calibrationData.parse(syntheticCalibration());
+
+    ExpectedMatrices expectations[] = {
+        {VGA, 331.1437846325726, 340.4175148010254, 186.90781211853027, 39704.609791579904, -0.008340184839262611},
+        {HD720, 634.4513604917388, 645.5798950195312, 359.38451385498047, 76071.61864146804, -0.008340184839262611},
+    };
+
+    for (const ExpectedMatrices& expected : expectations) {
+        StereoRectifier stereoRectifier(calibrationData, StereoDimensions(expected.resolution));
+
+        array<double, 12> leftProjectionMatrix = stereoRectifier.getLeftProjectionMatrix();
+        array<double, 12> rightProjectionMatrix = stereoRectifier.getRightProjectionMatrix();
+        array<double, 16> disparityToDepthMatrix = stereoRectifier.getDisparityToDepthMatrix();
+
+        array<double, 12> expectedLeftProjectionMatrix = {
+            expected.focalLength, 0, expected.centerX, 0, 0, expected.focalLength, expected.centerY, 0, 0, 0, 1, 0};
+        array<double, 12> expectedRightProjectionMatrix = expectedLeftProjectionMatrix;
+        expectedRightProjectionMatrix[3] = expected.baselineTerm;
+
+        array<double, 16> expectedDisparityToDepthMatrix = {
+            1, 0, 0, -expected.centerX, 0, 1, 0, -expected.centerY, 0, 0, 0, expected.focalLength, 0, 0, expected.inverseBaseline, 0};
+
+        for (size_t i = 0; i < 12; i++) {
+            CHECK(isNear(leftProjectionMatrix[i], expectedLeftProjectionMatrix[i]));
+            CHECK(isNear(rightProjectionMatrix[i], expectedRightProjectionMatrix[i]));
+        }
+
+        for (size_t i = 0; i < 16; i++) {
+            CHECK(isNear(disparityToDepthMatrix[i], expectedDisparityToDepthMatrix[i]));
+        }
+    }
+}
+
+#pragma mark - Fused YUV
+
+// Pixels of a side-by-side YUV 4:2:2 frame
+static vector<uint8_t> syntheticYUV(const StereoDimensions& stereoDimensions) {
+    vector<uint8_t> source(stereoDimensions.width * stereoDimensions.height * 2);
+
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = uint8_t((i * 2654435761u) >> 13);
+    }
+
+    return source;
+}
+
+// Whether a plane holds the pixels of a rectangle of a packed image
+static bool planeMatches(const FramePlane& plane, const vector<uint8_t>& image, size_t imageRowBytes, size_t x, size_t y) {
+    for (size_t row = 0; row < plane.height; row++) {
+        if (memcmp(plane.data + row * plane.rowBytes, image.data() + (y + row) * imageRowBytes + x * plane.channels, plane.width * plane.channels) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void testFusedRectificationMatchesTwoPasses() {
+    CalibrationData calibrationData;
+    calibrationData.parse(syntheticCalibration());
+
+    for (Resolution resolution : {VGA, HD720}) {
+        StereoDimensions stereoDimensions(resolution);
+        size_t width = stereoDimensions.width;
+        size_t height = stereoDimensions.height;
+        size_t eyeWidth = width / 2;
+        vector<uint8_t> source = syntheticYUV(stereoDimensions);
+
+        for (size_t threadCount : {1, 3}) {
+            StereoRectifier stereoRectifier(calibrationData, stereoDimensions, threadCount);
+            ColorConverter colorConverter(1);
+
+            for (ColorSpace colorSpace : {GREYSCALE, RGB, BGR}) {
+                size_t channels = colorSpace == GREYSCALE ? 1 : 3;
+                size_t rowBytes = width * channels;
+
+                vector<uint8_t> converted(rowBytes * height);
+                vector<uint8_t> expected(rowBytes * height);
+                colorConverter.convert(source.data(), width * 2, converted.data(), rowBytes, height, width, colorSpace);
+                stereoRectifier.rectify(converted.data(), expected.data(), channels);
+
+                vector<uint8_t> fused(rowBytes * height);
+                stereoRectifier.rectifyYUV(source.data(), width * 2, fused.data(), rowBytes, colorSpace);
+                CHECK(fused == expected);
+
+                // Each eye on its own
+                shared_ptr<FramePool> framePool = FramePool::create(1, height, width, channels, SEPARATE_EYES);
+                Frame frame = framePool->acquire();
+                stereoRectifier.rectifyYUV(LEFT, source.data(), width * 2, frame, colorSpace);
+                stereoRectifier.rectifyYUV(RIGHT, source.data(), width * 2, frame, colorSpace);
+                CHECK(planeMatches(frame.getPlane(LEFT), expected, rowBytes, 0, 0));
+                CHECK(planeMatches(frame.getPlane(RIGHT), expected, rowBytes, eyeWidth, 0));
+
+                // A region of each eye
+                array<EyeRegion, 2> regions = {EyeRegion {10, 33, eyeWidth / 2, height / 2}, EyeRegion {eyeWidth / 2 - 10, 7, eyeWidth / 2, height / 2}};
+                shared_ptr<FramePool> regionFramePool = FramePool::create(1, height / 2, eyeWidth, channels, SEPARATE_EYES);
+                Frame regionFrame = regionFramePool->acquire();
+                stereoRectifier.rectifyYUV(source.data(), width * 2, regions, regionFrame, colorSpace);
+                CHECK(planeMatches(regionFrame.getPlane(LEFT), expected, rowBytes, regions[0].x, regions[0].y));
+                CHECK(planeMatches(regionFrame.getPlane(RIGHT), expected, rowBytes, eyeWidth + regions[1].x, regions[1].y));
+            }
+        }
+    }
+}
+
+int main() {
+    runTest("matrices match OpenCV", testMatricesMatchOpenCV);
+    runTest("fused rectification matches two passes", testFusedRectificationMatchesTwoPasses);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+//
+// zed_test.h
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#ifndef ZED_TEST_H
+#define ZED_TEST_H
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace filesystem;
+
+//
+// Checks for the unit tests, which stay on in release builds (unlike `assert`)
+//
+// Each test is an executable run by ctest that exits with an error on the first failed check
+//
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            cerr << format("{}:{}: check failed: {}", __FILE__, __LINE__, #condition) << endl; \
+            exit(EXIT_FAILURE);                                                                   \
+        }                                                                                         \
+    } while (false)
+
+#define CHECK_THROWS(statement)                                                                          \
+    do {                                                                                                 \
+        bool isThrown = false;                                                                           \
+        try {                                                                                            \
+            statement;                                                                                   \
+        }                                                                                                \
+        catch (const exception&) {                                                                       \
+            isThrown = true;                                                                             \
+        }                                                                                                \
+        if (!isThrown) {                                                                                 \
+            cerr << format("{}:{}: expected an exception from: {}", __FILE__, __LINE__, #statement) << endl; \
+            exit(EXIT_FAILURE);                                                                          \
+        }                                                                                                \
+    } while (false)
+
+// Runs one test case, naming it in the output so a failed check can be placed
+inline void runTest(const char* name, void (*test)()) {
+    cout << name << endl;
+    test();
+}
+
+// Empty directory for a test's files, removed with its contents once the test is done
+class TemporaryDirectory {
+
+public:
+    TemporaryDirectory() {
+        uint64_t suffix = chrono::steady_clock::now().time_since_epoch().count();
+        directory = temp_directory_path() / format("zed-test-{}", suffix);
+        create_directories(directory);
+    }
+
+    ~TemporaryDirectory() {
+        error_code error;
+        remove_all(directory, error);
+    }
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+    const path& getPath() const {
+        return directory;
+    }
+
+private:
+    path directory;
+};
+
+inline string readFile(const path& filepath) {
+    ifstream file(filepath, ios::binary);
+    stringstream contents;
+    contents << file.rdbuf();
+
+    return contents.str();
+}
+
+inline void writeFile(const path& filepath, const string& contents) {
+    create_directories(filepath.parent_path());
+
+    ofstream file(filepath, ios::binary);
+    file << contents;
+}
+
+#endif
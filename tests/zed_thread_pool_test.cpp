@@ -0,0 +1,86 @@
+//
+// zed_thread_pool_test.cpp
+// zed-open-capture-mac
+//
+// Created by Christian Bator on 10/16/2026
+//
+
+#include "zed_thread_pool.h"
+#include "zed_test.h"
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+using namespace zed;
+
+//
+// Splitting jobs across a thread pool, and tasks that throw
+//
+
+#define kThreadCount 4
+#define kTaskCount 1000
+
+static void testEveryIndexRunsOnce() {
+    ThreadPool threadPool(kThreadCount);
+    CHECK(threadPool.getThreadCount() == kThreadCount);
+
+    vector<atomic<int>> runCounts(kTaskCount);
+    threadPool.parallelFor(kTaskCount, [&](size_t index) { runCounts[index]++; });
+
+    for (atomic<int>& runCount : runCounts) {
+        CHECK(runCount == 1);
+    }
+}
+
+static void testThrowingTaskIsRethrown() {
+    ThreadPool threadPool(kThreadCount);
+
+    // Thrown by whichever thread runs the index, the caller or a worker
+    for (size_t failingIndex : {size_t(0), size_t(kTaskCount / 2), size_t(kTaskCount - 1)}) {
+        atomic<size_t> runCount = 0;
+        string message;
+
+        try {
+            threadPool.parallelFor(kTaskCount, [&](size_t index) {
+                runCount++;
+
+                if (index == failingIndex) {
+                    throw runtime_error("Task failed");
+                }
+            });
+        }
+        catch (const runtime_error& error) {
+            message = error.what();
+        }
+
+        CHECK(message == "Task failed");
+        CHECK(runCount <= kTaskCount);
+    }
+
+    // Every task throwing reports one exception
+    CHECK_THROWS(threadPool.parallelFor(kTaskCount, [](size_t) { throw bad_alloc(); }));
+
+    // The pool is still usable afterwards
+    atomic<size_t> runCount = 0;
+    threadPool.parallelFor(kTaskCount, [&](size_t) { runCount++; });
+    CHECK(runCount == kTaskCount);
+}
+
+static void testSingleThreadRethrows() {
+    ThreadPool threadPool(1);
+
+    CHECK_THROWS(threadPool.parallelFor(kTaskCount, [](size_t index) {
+        if (index == 3) {
+            throw runtime_error("Task failed");
+        }
+    }));
+}
+
+int main() {
+    runTest("every index runs once", testEveryIndexRunsOnce);
+    runTest("throwing task is rethrown", testThrowingTaskIsRethrown);
+    runTest("single thread rethrows", testSingleThreadRethrows);
+
+    return EXIT_SUCCESS;
+}